@@ -25,6 +25,7 @@
 #include "util_lib_proto.h"
 #include "condor_open.h"
 #include "generic_stats.h"
+#include "utc_time.h"
 
 #ifdef CONDOR_HAVE_EPOLL
 #include <sys/epoll.h>
@@ -38,6 +39,9 @@ struct CCBStats {
 	stats_entry_recent<int> CCBRequestsNotFound;
 	stats_entry_recent<int> CCBRequestsSucceeded;
 	stats_entry_recent<int> CCBRequestsFailed;
+	stats_entry_abs<int> CCBReconnectJournalRecords;
+	stats_entry_recent<int> CCBReconnectJournalCompactions;
+	stats_entry_abs<double> CCBReconnectJournalCompactionTime;
 
 	void AddStatsToPool(StatisticsPool& pool, int publevel)
 	{
@@ -48,6 +52,9 @@ struct CCBStats {
 		STATS_POOL_ADD(pool, "", CCBRequestsNotFound, publevel);
 		STATS_POOL_ADD(pool, "", CCBRequestsSucceeded, publevel);
 		STATS_POOL_ADD(pool, "", CCBRequestsFailed, publevel);
+		STATS_POOL_ADD(pool, "", CCBReconnectJournalRecords, publevel);
+		STATS_POOL_ADD(pool, "", CCBReconnectJournalCompactions, publevel);
+		STATS_POOL_ADD(pool, "", CCBReconnectJournalCompactionTime, publevel);
 	}
 };
 
@@ -101,6 +108,11 @@ CCBServer::CCBServer():
 	m_targets(ccbid_hash),
 	m_reconnect_info(ccbid_hash),
 	m_reconnect_fp(NULL),
+	m_reconnect_journal_records(0),
+	m_compaction_tid(-1),
+	m_compaction_reaper_id(-1),
+	m_compaction_records(0),
+	m_compaction_begin(0),
 	m_last_reconnect_info_sweep(0),
 	m_reconnect_info_sweep_interval(0),
 	m_reconnect_allowed_from_any_ip(false),
@@ -126,6 +138,10 @@ CCBServer::~CCBServer()
 		daemonCore->Cancel_Timer( m_polling_timer );
 		m_polling_timer = -1;
 	}
+	if( m_compaction_reaper_id != -1 ) {
+		daemonCore->Cancel_Reaper( m_compaction_reaper_id );
+		m_compaction_reaper_id = -1;
+	}
 	CCBTarget *target=NULL;
 	m_targets.startIterations();
 	while( m_targets.iterate(target) ) {
@@ -1328,24 +1344,50 @@ CCBServer::LoadReconnectInfo()
 	}
 
 	rewind(m_reconnect_fp);
+	m_reconnect_journal_records = 0;
 	char buf[128];
 	unsigned long line = 0;
+	unsigned long removed = 0;
 	while( fgets(buf,sizeof(buf),m_reconnect_fp) ) {
 		line++;
-		buf[sizeof(buf)-1] = '\0';
-
-		CCBID ccbid,cookie;
-		char ip[128],ccbid_str[128],cookie_str[128];
-		ip[127] = ccbid_str[127] = cookie_str[127] = '\0';
-		if( sscanf(buf,"%127s %127s %127s",ip,ccbid_str,cookie_str)!=3 ||
-			!CCBIDFromString( ccbid, ccbid_str) ||
-			!CCBIDFromString( cookie, cookie_str) )
-		{
-			dprintf(D_ALWAYS,"CCB: ERROR: line %lu is invalid in %s.", line,
+		m_reconnect_journal_records++;
+
+			// Each line is either "<ip> <ccbid> <cookie>" for a target
+			// that was added or "- <ccbid>" for one that was removed.
+			// This is parsed by hand, since there may be a great many.
+		char *ip = buf;
+		char *end = ip + strcspn(ip," \n");
+		bool is_removal = (end - ip == 1 && *ip == '-');
+		char *ccbid_str = NULL;
+		char *cookie_str = NULL;
+		CCBID ccbid = 0,cookie = 0;
+		if( *end == ' ' ) {
+			*end = '\0';
+			ccbid_str = end + 1;
+			ccbid = strtoul(ccbid_str,&end,10);
+			if( end != ccbid_str && *end == ' ' ) {
+				cookie_str = end + 1;
+				cookie = strtoul(cookie_str,&end,10);
+			}
+			if( *end != '\n' && *end != '\0' ) {
+				ccbid_str = NULL;
+			}
+		}
+		if( !ccbid_str || end == ccbid_str || (!is_removal && (!cookie_str || end == cookie_str)) ) {
+			dprintf(D_ALWAYS,"CCB: ERROR: line %lu is invalid in %s.\n", line,
 					m_reconnect_fname.Value());
 			continue;
 		}
 
+		if( is_removal ) {
+			CCBReconnectInfo *reconnect_info = GetReconnectInfo(ccbid);
+			if( reconnect_info ) {
+				RemoveReconnectInfo( reconnect_info );
+				removed++;
+			}
+			continue;
+		}
+
 		if( ccbid > m_next_ccbid ) {
 			m_next_ccbid = ccbid+1;
 		}
@@ -1353,18 +1395,21 @@ CCBServer::LoadReconnectInfo()
 		CCBReconnectInfo *reconnect_info = new CCBReconnectInfo(ccbid,cookie,ip);
 		AddReconnectInfo( reconnect_info );
 	}
+	ccb_stats.CCBReconnectJournalRecords = m_reconnect_journal_records;
 
 	// In case any reconnect records were not committed to disk in time
 	// before we restarted, jump ahead a bit to avoid handing out CCBIDs
 	// that may have been recently assigned.
 	m_next_ccbid += 100;
 
-	dprintf(D_ALWAYS,"CCB: loaded %d reconnect records from %s.\n",
-			m_reconnect_info.getNumElements(), m_reconnect_fname.Value());
+	dprintf(D_ALWAYS,"CCB: loaded %d reconnect records from %s "
+			"(%lu lines, %lu removals).\n",
+			m_reconnect_info.getNumElements(), m_reconnect_fname.Value(),
+			line, removed);
 }
 
 bool
-CCBServer::SaveReconnectInfo(CCBReconnectInfo *reconnect_info)
+CCBServer::AppendReconnectRecord(const std::string &line)
 {
 	if( !OpenReconnectFile() ) {
 		return false;
@@ -1377,62 +1422,187 @@ CCBServer::SaveReconnectInfo(CCBReconnectInfo *reconnect_info)
 		return false;
 	}
 
-	std::string ccbid_str,cookie_str;
-	rc = fprintf(m_reconnect_fp,"%s %s %s\n",
-		reconnect_info->getPeerIP(),
-		CCBIDToString(reconnect_info->getCCBID(),ccbid_str),
-		CCBIDToString(reconnect_info->getReconnectCookie(),cookie_str));
-	if( rc == -1 ) {
+	if( fputs(line.c_str(),m_reconnect_fp) == EOF ) {
 		dprintf(D_ALWAYS,"CCB: failed to write reconnect info in %s: %s\n",
 				m_reconnect_fname.Value(), strerror(errno));
 		return false;
 	}
+
+	m_reconnect_journal_records++;
+	ccb_stats.CCBReconnectJournalRecords = m_reconnect_journal_records;
+	if( m_compaction_tid != -1 ) {
+		m_compaction_tail.push_back(line);
+	}
 	return true;
 }
 
+bool
+CCBServer::SaveReconnectInfo(CCBReconnectInfo *reconnect_info)
+{
+	std::string line,ccbid_str,cookie_str;
+	formatstr(line,"%s %s %s\n",
+		reconnect_info->getPeerIP(),
+		CCBIDToString(reconnect_info->getCCBID(),ccbid_str),
+		CCBIDToString(reconnect_info->getReconnectCookie(),cookie_str));
+	return AppendReconnectRecord(line);
+}
+
+bool
+CCBServer::SaveReconnectRemoval(CCBID ccbid)
+{
+	std::string line,ccbid_str;
+	formatstr(line,"- %s\n",CCBIDToString(ccbid,ccbid_str));
+	return AppendReconnectRecord(line);
+}
+
+bool
+CCBServer::WriteReconnectFile(char const *fname)
+{
+	IGNORE_RETURN remove( fname );
+	FILE *fp = safe_fcreate_fail_if_exists(fname,"w",0600);
+	if( !fp ) {
+		dprintf(D_ALWAYS,"CCB: failed to create %s: %s\n",
+				fname, strerror(errno));
+		return false;
+	}
+
+	std::string ccbid_str,cookie_str;
+	CCBReconnectInfo *reconnect_info=NULL;
+	m_reconnect_info.startIterations();
+	while( m_reconnect_info.iterate(reconnect_info) ) {
+		if( fprintf(fp,"%s %s %s\n",
+				reconnect_info->getPeerIP(),
+				CCBIDToString(reconnect_info->getCCBID(),ccbid_str),
+				CCBIDToString(reconnect_info->getReconnectCookie(),cookie_str)) < 0 )
+		{
+			dprintf(D_ALWAYS,"CCB: failed to write %s: %s\n",
+					fname, strerror(errno));
+			fclose(fp);
+			return false;
+		}
+	}
+
+	if( fflush(fp) != 0 || fsync(fileno(fp)) != 0 ) {
+		dprintf(D_ALWAYS,"CCB: failed to write %s: %s\n",
+				fname, strerror(errno));
+		fclose(fp);
+		return false;
+	}
+	return fclose(fp) == 0;
+}
+
+int
+CCBServer::CompactReconnectFileThread(void *arg, Stream * /*sock*/)
+{
+	CCBServer *server = (CCBServer *)arg;
+	return server->WriteReconnectFile(server->m_compaction_fname.Value()) ? 0 : 1;
+}
+
 void
-CCBServer::SaveAllReconnectInfo()
+CCBServer::CompactReconnectFile()
 {
-	if( m_reconnect_fname.IsEmpty() ) {
+	if( m_reconnect_fname.IsEmpty() || m_compaction_tid != -1 ) {
 		return;
 	}
-	CloseReconnectFile();
 
 	if( m_reconnect_info.getNumElements()==0 ) {
+		CloseReconnectFile();
 		IGNORE_RETURN remove( m_reconnect_fname.Value() );
+		m_reconnect_journal_records = 0;
+		ccb_stats.CCBReconnectJournalRecords = 0;
 		return;
 	}
 
-	MyString orig_reconnect_fname = m_reconnect_fname;
-	m_reconnect_fname.formatstr_cat(".new");
+	m_compaction_fname = m_reconnect_fname;
+	m_compaction_fname.formatstr_cat(".new");
+	m_compaction_records = m_reconnect_info.getNumElements();
+	m_compaction_begin = condor_gettimestamp_double();
+	m_compaction_tail.clear();
+
+#ifdef WIN32
+		// Create_Thread() makes a real thread on Windows, which would
+		// race with changes to m_reconnect_info, so compact in the
+		// foreground there.
+	CompactReconnectFileReaper( 0, WriteReconnectFile(m_compaction_fname.Value()) ? 0 : 1 );
+#else
+		// The child writes out the records as of the fork.  Anything
+		// journaled after that is replayed into the new file when it
+		// is done.  Flush first so the child doesn't write our buffer
+		// into the old file a second time.
+	if( m_reconnect_fp ) {
+		fflush( m_reconnect_fp );
+	}
+	if( m_compaction_reaper_id == -1 ) {
+		m_compaction_reaper_id = daemonCore->Register_Reaper(
+			"CCBServer::CompactReconnectFileReaper",
+			(ReaperHandlercpp)&CCBServer::CompactReconnectFileReaper,
+			"CCBServer::CompactReconnectFileReaper",
+			this );
+	}
+	m_compaction_tid = daemonCore->Create_Thread(
+		&CCBServer::CompactReconnectFileThread,
+		this,
+		NULL,
+		m_compaction_reaper_id );
+	if( !m_compaction_tid ) {
+		dprintf(D_ALWAYS,"CCB: failed to start compaction of %s\n",
+				m_reconnect_fname.Value());
+		m_compaction_tid = -1;
+	}
+#endif
+}
 
-	if( !OpenReconnectFile() ) {
-		m_reconnect_fname = orig_reconnect_fname;
-		return;
+int
+CCBServer::CompactReconnectFileReaper(int /*tid*/, int exit_status)
+{
+	m_compaction_tid = -1;
+	std::vector<std::string> tail;
+	tail.swap(m_compaction_tail);
+
+	if( exit_status != 0 ) {
+		dprintf(D_ALWAYS,"CCB: failed to compact %s\n",
+				m_reconnect_fname.Value());
+		IGNORE_RETURN remove( m_compaction_fname.Value() );
+		return TRUE;
 	}
 
-	CCBReconnectInfo *reconnect_info=NULL;
-	m_reconnect_info.startIterations();
-	while( m_reconnect_info.iterate(reconnect_info) ) {
-		if( !SaveReconnectInfo(reconnect_info) ) {
-			CloseReconnectFile();
-			m_reconnect_fname = orig_reconnect_fname;
-			dprintf(D_ALWAYS,"CCB: aborting rewriting of %s\n",
-					m_reconnect_fname.Value());
-			return;
+	if( !tail.empty() ) {
+		FILE *fp = safe_fopen_no_create(m_compaction_fname.Value(),"a");
+		bool ok = fp != NULL;
+		for( size_t i = 0; ok && i < tail.size(); i++ ) {
+			ok = fputs(tail[i].c_str(),fp) != EOF;
+		}
+		if( fp && fclose(fp) != 0 ) {
+			ok = false;
+		}
+		if( !ok ) {
+			dprintf(D_ALWAYS,"CCB: failed to finish compacting %s: %s\n",
+					m_reconnect_fname.Value(), strerror(errno));
+			IGNORE_RETURN remove( m_compaction_fname.Value() );
+			return TRUE;
 		}
 	}
 
 	CloseReconnectFile();
-	int rc;
-	rc = rotate_file( m_reconnect_fname.Value(),orig_reconnect_fname.Value() );
-	if( rc < 0 ) {
+	if( rotate_file( m_compaction_fname.Value(),m_reconnect_fname.Value() ) < 0 ) {
 		dprintf(D_ALWAYS,"CCB: failed to rotate rewritten %s\n",
-				m_reconnect_fname.Value());
-	}
-	m_reconnect_fname = orig_reconnect_fname;
+				m_compaction_fname.Value());
+		return TRUE;
+	}
+
+	double elapsed = condor_gettimestamp_double() - m_compaction_begin;
+	m_reconnect_journal_records = m_compaction_records + (int)tail.size();
+	ccb_stats.CCBReconnectJournalRecords = m_reconnect_journal_records;
+	ccb_stats.CCBReconnectJournalCompactions += 1;
+	ccb_stats.CCBReconnectJournalCompactionTime = elapsed;
+	dprintf(D_ALWAYS,"CCB: compacted %s to %d records in %.3f seconds.\n",
+			m_reconnect_fname.Value(), m_reconnect_journal_records, elapsed);
+	return TRUE;
 }
 
+	// Don't bother compacting the reconnect file for fewer unneeded lines.
+static const int CCB_JOURNAL_MIN_GARBAGE = 1000;
+
 void
 CCBServer::SweepReconnectInfo()
 {
@@ -1466,6 +1636,7 @@ CCBServer::SweepReconnectInfo()
 	while( m_reconnect_info.iterate(reconnect_info) ) {
 		time_t last = reconnect_info->getLastAlive();
 		if( now - last > 2*m_reconnect_info_sweep_interval ) {
+			SaveReconnectRemoval( reconnect_info->getCCBID() );
 			RemoveReconnectInfo( reconnect_info );
 			removed++;
 		}
@@ -1474,8 +1645,17 @@ CCBServer::SweepReconnectInfo()
 	if( removed ) {
 		dprintf(D_ALWAYS,
 				"CCB: pruning %lu expired reconnect records.\n",removed);
+		if( m_reconnect_fp ) {
+			fflush( m_reconnect_fp );
+		}
+	}
 
-		// rewrite the file to save space, since some records were deleted
-		SaveAllReconnectInfo();
+	// Rewrite the file to save space once most of its lines are for
+	// targets that have since been removed.
+	int live = m_reconnect_info.getNumElements();
+	if( m_reconnect_journal_records > 2*live + CCB_JOURNAL_MIN_GARBAGE ||
+		(live == 0 && m_reconnect_journal_records > 0) )
+	{
+		CompactReconnectFile();
 	}
 }
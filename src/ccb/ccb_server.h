@@ -31,6 +31,9 @@
 #include "MyString.h"
 #include "dc_service.h"
 
+#include <vector>
+#include <string>
+
 class StatisticsPool;
 void AddCCBStatsToPool(StatisticsPool& pool, int publevel);
 
@@ -62,6 +65,17 @@ class CCBServer: Service {
 	MyString m_address;
 	MyString m_reconnect_fname;
 	FILE *m_reconnect_fp;
+		// The reconnect file is a journal: a line per target added and
+		// per target removed.  It is compacted by a child process when
+		// most of its lines are no longer needed.
+	int m_reconnect_journal_records;
+	int m_compaction_tid;
+	int m_compaction_reaper_id;
+	int m_compaction_records;
+	double m_compaction_begin;
+	MyString m_compaction_fname;
+		// lines journaled while a compaction is running
+	std::vector<std::string> m_compaction_tail;
 	time_t m_last_reconnect_info_sweep;
 	int m_reconnect_info_sweep_interval;
 	bool m_reconnect_allowed_from_any_ip;
@@ -118,7 +132,12 @@ class CCBServer: Service {
 	bool OpenReconnectFile(bool only_if_exists=false);
 	void LoadReconnectInfo();
 	bool SaveReconnectInfo(CCBReconnectInfo *reconnect_info);
-	void SaveAllReconnectInfo();
+	bool SaveReconnectRemoval(CCBID ccbid);
+	bool AppendReconnectRecord(const std::string &line);
+	bool WriteReconnectFile(char const *fname);
+	void CompactReconnectFile();
+	static int CompactReconnectFileThread(void *arg, Stream *sock);
+	int CompactReconnectFileReaper(int tid, int exit_status);
 	void SweepReconnectInfo();
 };
 
@@ -21,6 +21,7 @@
 
 #include "classad/exprTree.h"
 #include <string>
+#include <atomic>
 
 namespace classad {
 
@@ -38,7 +39,7 @@ public:
 
 	std::string szName;    // string space the names.
 	std::string szValue;   // reference back for cleanup
-	ExprTree * pData;
+	std::atomic<ExprTree *> pData; // parsed from szValue on first use, possibly by several threads at once
 };
 
 typedef classad_weak_ptr< CacheEntry > pCacheEntry;
@@ -342,7 +342,7 @@ CacheEntry::~CacheEntry()
 	if (_cache && _cache.use_count()) {
 		_cache->flush(szName, szValue);
 	}
-	delete pData;
+	delete pData.load();
 	pData = NULL;
 }
 
@@ -439,12 +439,19 @@ ExprTree * CachedExprEnvelope::get() const
 	
 	if (m_pLetter) {
 		CacheEntry * ptr = m_pLetter.get();
-		expr = ptr->pData;
+		expr = ptr->pData.load(std::memory_order_acquire);
 		if ( ! expr) {
+			// Ads may be unparsed on worker threads while the main thread
+			// evaluates them, so two threads can get here for the same
+			// entry.  The first to store its parse wins.
 			ClassAdParser parser;
 			parser.SetOldClassAd(true);
-			expr = parser.ParseExpression(ptr->szValue);
-			ptr->pData = expr;
+			ExprTree * parsed = parser.ParseExpression(ptr->szValue);
+			if (parsed && ! ptr->pData.compare_exchange_strong(expr, parsed, std::memory_order_acq_rel)) {
+				delete parsed;
+			} else {
+				expr = parsed;
+			}
 		}
 	}
 	
@@ -482,8 +489,9 @@ bool CachedExprEnvelope::SameAs(const ExprTree* tree) const
 	}
 
 	if (tree->GetKind() != EXPR_ENVELOPE) {
-		if (m_pLetter && m_pLetter->pData) {
-			return m_pLetter->pData->SameAs(tree);
+		ExprTree * letter = m_pLetter ? m_pLetter->pData.load(std::memory_order_acquire) : NULL;
+		if (letter) {
+			return letter->SameAs(tree);
 		}
 		return false;
 	}
@@ -35,6 +35,7 @@
 #include "ipv6_hostname.h"
 #include "condor_threads.h"
 #include "classad_helpers.h"
+#include "classad_unparse_pipeline.h"
 
 #include "condor_claimid_parser.h"
 #include "authentication.h"
@@ -78,6 +79,11 @@ int CollectorDaemon::__failed__;
 List<ClassAd>* CollectorDaemon::__ClassAdResultList__;
 std::string CollectorDaemon::__adType__;
 ExprTree *CollectorDaemon::__filter__;
+bool CollectorDaemon::__changelogQuery__;
+long long CollectorDaemon::__changelogSince__;
+long long CollectorDaemon::__changelogGeneration__;
+int CollectorDaemon::__changelogUnchanged__;
+std::vector<std::string> CollectorDaemon::__changelogRemoved__;
 
 TrackTotals* CollectorDaemon::normalTotals = NULL;
 int CollectorDaemon::submittorRunningJobs;
@@ -109,6 +115,8 @@ std::queue<CollectorDaemon::pending_query_entry_t *> CollectorDaemon::query_queu
 std::queue<CollectorDaemon::pending_query_entry_t *> CollectorDaemon::query_queue_low_prio;
 int CollectorDaemon::ReaperId = -1;
 int CollectorDaemon::max_query_workers = 4;
+int CollectorDaemon::query_unparse_threads = 0;
+bool CollectorDaemon::query_binary_classads = false;
 int CollectorDaemon::reserved_for_highprio_query_workers = 1;
 int CollectorDaemon::max_pending_query_workers = 50;
 int CollectorDaemon::max_query_worktime = 0;
@@ -318,6 +326,9 @@ void CollectorDaemon::Init()
 	collectorsToUpdate = NULL;
 	Config();
 
+	// export the collector statistics on the METRICS_PORT, if there is one
+	daemonCore->Register_Metrics_Pool(&collectorStats.global.Pool);
+
 	// install command handlers for queries
 	daemonCore->Register_CommandWithPayload(QUERY_STARTD_ADS,"QUERY_STARTD_ADS",
 		receive_query_cedar,"receive_query_cedar",READ);
@@ -901,6 +912,24 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 		evaluate_projection = true;
 	}
 
+		// incremental queries add the changelog key to each ad they send
+	if (__changelogQuery__ && ! proj.empty()) { proj.insert(ATTR_CHANGELOG_KEY); }
+	std::shared_ptr<const classad::References> whitelist;
+	if ( ! proj.empty()) { whitelist = std::make_shared<const classad::References>(proj); }
+
+		// the ads are unparsed (or encoded, for peers that said they can read
+		// binary ads) on worker threads if any, while this thread sends them;
+		// they don't change until the loop is done.
+	int put_options = filter_private_ads ? PUT_CLASSAD_NO_PRIVATE : 0;
+	int binary_version = 0;
+	if (query_binary_classads && cad->LookupInteger(ATTR_ACCEPT_BINARY_CLASSADS, binary_version) &&
+		binary_version >= BINARY_CLASSAD_VERSION) {
+		put_options |= PUT_CLASSAD_BINARY;
+	}
+	ClassAdUnparsePipeline pipeline(sock, put_options, query_unparse_threads, true);
+
+	float bytes_before = static_cast<ReliSock*>(sock)->get_bytes_sent();
+
 	while ( (curr_ad=results.Next()) )
 	{
 		// if querying collector ads, and the collectors own ad appears in this list.
@@ -933,14 +962,34 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 				StringTokenIterator list(projection);
 				const std::string * attr;
 				while ((attr = list.next_string())) { proj.insert(*attr); }
+				if (__changelogQuery__) { proj.insert(ATTR_CHANGELOG_KEY); }
 			}
+			whitelist.reset();
+			if ( ! proj.empty()) { whitelist = std::make_shared<const classad::References>(proj); }
 		}
 
-		bool send_failed = (!sock->code(more) || !putClassAd(sock, *curr_ad, filter_private_ads ? PUT_CLASSAD_NO_PRIVATE : 0, proj.empty() ? NULL : &proj));
-        
-		if (stats_ad) {
-			stats_ad->Unchain();
-			delete stats_ad;
+			// incremental queries need to know which cached ad this replaces
+		ClassAd * key_ad = NULL;
+		if (__changelogQuery__) {
+			std::string key;
+			if (collector.makeChangelogKey(*curr_ad, key)) {
+				if (stats_ad) {
+					stats_ad->Assign(ATTR_CHANGELOG_KEY, key);
+				} else {
+					key_ad = new ClassAd();
+					key_ad->Assign(ATTR_CHANGELOG_KEY, key);
+					key_ad->ChainToAd(curr_ad);
+					curr_ad = key_ad;
+				}
+			}
+		}
+
+			// the pipeline deletes the temporary ads once they are sent
+		bool send_failed;
+		if (stats_ad || key_ad) {
+			send_failed = ! pipeline.putTemporary(curr_ad, whitelist);
+		} else {
+			send_failed = ! pipeline.put(*curr_ad, whitelist);
 		}
 
 		if (send_failed)
@@ -960,6 +1009,56 @@ int CollectorDaemon::receive_query_cedar_worker_thread(void *in_query_entry, Str
 
 	} // end of while loop for next result ad to send
 
+	if ( ! pipeline.flush()) {
+		dprintf (D_ALWAYS, "Error sending query result to client -- aborting\n");
+		return_status = 0;
+		goto END;
+	}
+
+	// an incremental query ends with a summary of the changelog:
+	// the generation to ask for next time and the ads that went away
+	if (__changelogQuery__) {
+		float bytes_sent = static_cast<ReliSock*>(sock)->get_bytes_sent() - bytes_before;
+		ClassAd changelog_ad;
+		SetMyTypeName(changelog_ad, CHANGELOG_ADTYPE);
+		changelog_ad.Assign(ATTR_CHANGELOG_EPOCH, collector.changelogEpoch());
+		changelog_ad.Assign(ATTR_CHANGELOG_GENERATION, __changelogGeneration__);
+		changelog_ad.Assign(ATTR_CHANGELOG_FULL_REFRESH, __changelogSince__ < 0);
+		changelog_ad.Assign(ATTR_CHANGELOG_UNCHANGED_ADS, __changelogUnchanged__);
+		changelog_ad.Assign(ATTR_CHANGELOG_BYTES_SENT, (long long)bytes_sent);
+		std::vector<classad::ExprTree*> removed;
+		for (std::vector<std::string>::const_iterator it = __changelogRemoved__.begin(); it != __changelogRemoved__.end(); ++it) {
+			removed.push_back(classad::Literal::MakeString(*it));
+		}
+		changelog_ad.Insert(ATTR_CHANGELOG_REMOVED, classad::ExprList::MakeExprList(removed));
+
+		if (!sock->code(more) || !putClassAd(sock, changelog_ad)) {
+			dprintf (D_ALWAYS, "Error sending changelog summary to client -- aborting\n");
+			return_status = 0;
+			goto END;
+		}
+
+			// estimate what the unchanged ads would have cost from the
+			// average of the ones we did send
+		double send_time = condor_gettimestamp_double() - end_query;
+		double est_bytes_saved = 0.0, est_time_saved = 0.0;
+		if (__numAds__ > 0) {
+			est_bytes_saved = (double)bytes_sent / __numAds__ * __changelogUnchanged__;
+			est_time_saved = send_time / __numAds__ * __changelogUnchanged__;
+		}
+		dprintf (D_ALWAYS,
+				 "Changelog query: since=%lld; generation=%lld; full_refresh=%d; changed=%d; unchanged=%d; removed=%d; bytes_sent=%.0f; est_bytes_saved=%.0f; est_send_time_saved=%f\n",
+				 __changelogSince__,
+				 __changelogGeneration__,
+				 __changelogSince__ < 0,
+				 __numAds__,
+				 __changelogUnchanged__,
+				 (int)__changelogRemoved__.size(),
+				 bytes_sent,
+				 est_bytes_saved,
+				 est_time_saved);
+	}
+
 	// end of query response ...
 	more = 0;
 	if (!sock->code(more))
@@ -1484,6 +1583,15 @@ int CollectorDaemon::query_scanFunc (ClassAd *cad)
 		}
 	}
 
+		// For an incremental query, the client already has every ad that
+		// has not changed since the generation it last saw.
+	if ( __changelogSince__ >= 0 ) {
+		if ( collector.changelogAdGeneration( cad ) <= __changelogSince__ ) {
+			__changelogUnchanged__++;
+			return 1;
+		}
+	}
+
 	classad::Value result;
 	bool val;
 	if ( EvalExprTree( __filter__, cad, NULL, result ) &&
@@ -1496,6 +1604,12 @@ int CollectorDaemon::query_scanFunc (ClassAd *cad)
 		}
     } else {
 		__failed__++;
+			// The ad changed and no longer matches, so if the client had
+			// it, the client must drop it.
+		std::string key;
+		if ( __changelogSince__ >= 0 && collector.makeChangelogKey( *cad, key ) ) {
+			__changelogRemoved__.push_back( key );
+		}
 	}
 
     return 1;
@@ -1511,6 +1625,11 @@ void CollectorDaemon::process_query_public (AdTypes whichAds,
 	__numAds__ = 0;
 	__failed__ = 0;
 	__ClassAdResultList__ = results;
+	__changelogQuery__ = false;
+	__changelogSince__ = -1;
+	__changelogGeneration__ = collector.changelogGeneration();
+	__changelogUnchanged__ = 0;
+	__changelogRemoved__.clear();
 	// An empty adType means don't check the MyType of the ads.
 	// This means either the command indicates we're only checking one
 	// type of ad, or the query's TargetType is "Any" (match all ad types).
@@ -1533,6 +1652,22 @@ void CollectorDaemon::process_query_public (AdTypes whichAds,
 		__resultLimit__ = INT_MAX; // no limit
 	}
 
+	// A query that carries ChangelogGeneration wants only the ads that
+	// changed since then.  If we can't vouch for every removal since that
+	// generation (or the client's view came from another collector
+	// instance), we send everything and tell the client to start over.
+	__changelogQuery__ = query->Lookup( ATTR_CHANGELOG_GENERATION ) != NULL;
+	if ( __changelogQuery__ ) {
+		long long since = -1;
+		std::string epoch;
+		query->LookupInteger( ATTR_CHANGELOG_GENERATION, since );
+		query->LookupString( ATTR_CHANGELOG_EPOCH, epoch );
+		if ( __resultLimit__ == INT_MAX && collector.changelogCovers( epoch, since ) ) {
+			__changelogSince__ = since;
+			collector.changelogRemovedSince( since, whichAds == STARTD_PVT_AD, __changelogRemoved__ );
+		}
+	}
+
 	// See if we should exclude Collector Ads from generic queries.  Still
 	// give them out for specific collector queries, which is registered as
 	// ADMINISTRATOR when PROTECT_COLLECTOR_ADS is true.  This setting is
@@ -1838,6 +1973,7 @@ void CollectorDaemon::Config()
 	}
 
 	collector.m_allowOnlyOneNegotiator = param_boolean("COLLECTOR_ALLOW_ONLY_ONE_NEGOTIATOR", false);
+	collector.setChangelogSize(param_integer("COLLECTOR_CHANGELOG_SIZE", 100000, 0));
 	// This it temporary (for 8.7.0) just in case we need to turn off the new getClassAdEx options
 	collector.m_get_ad_options = param_integer("COLLECTOR_GETAD_OPTIONS", GET_CLASSAD_FAST | GET_CLASSAD_LAZY_PARSE);
 	collector.m_get_ad_options &= (GET_CLASSAD_LAZY_PARSE | GET_CLASSAD_FAST | GET_CLASSAD_NO_CACHE);
@@ -1953,6 +2089,8 @@ void CollectorDaemon::Config()
 	collectorStats.setGarbageCollectionInterval( garbage_interval );
 
     max_query_workers = param_integer ("COLLECTOR_QUERY_WORKERS", 4, 0);
+	query_unparse_threads = param_integer("COLLECTOR_QUERY_UNPARSE_THREADS", 0, 0);
+	query_binary_classads = param_boolean("ENABLE_BINARY_CLASSADS", false);
 	max_pending_query_workers = param_integer ("COLLECTOR_QUERY_WORKERS_PENDING", 50, 0);
 	max_query_worktime = param_integer("COLLECTOR_QUERY_MAX_WORKTIME",0,0);
 	reserved_for_highprio_query_workers = param_integer("COLLECTOR_QUERY_WORKERS_RESERVE_FOR_HIGH_PRIO",1,0);
@@ -161,6 +161,8 @@ public:
 	static int ReaperId;
 	static int QueryReaper(int pid, int exit_status);
 	static int max_query_workers;  // from config file
+	static int query_unparse_threads; // from config file
+	static bool query_binary_classads; // from config file
 	static int max_pending_query_workers;  // from config file
 	static int max_query_worktime;  // from config file
 	static int reserved_for_highprio_query_workers; // from config file
@@ -191,6 +193,11 @@ protected:
 	static int __failed__;
 	static std::string __adType__;
 	static ExprTree *__filter__;
+	static bool __changelogQuery__;
+	static long long __changelogSince__;	// -1 if the query gets a full refresh
+	static long long __changelogGeneration__;
+	static int __changelogUnchanged__;
+	static std::vector<std::string> __changelogRemoved__;
 
 	static TrackTotals* normalTotals;
 	static int submittorRunningJobs;
@@ -38,7 +38,6 @@ extern "C" void event_mgr (void);
 
 static void killHashTable (CollectorHashTable &);
 static int killGenericHashTable(CollectorHashTable *);
-static void purgeHashTable (CollectorHashTable &);
 
 int 	engine_clientTimeoutHandler (Service *);
 int 	engine_housekeepingHandler  (Service *);
@@ -72,6 +71,12 @@ CollectorEngine::CollectorEngine (CollectorStats *stats ) :
 	collectorStats = stats;
 	m_collector_requirements = NULL;
 	m_get_ad_options = 0;
+
+	m_changelogSize = 0;
+	m_generation = 0;
+	m_changelogFloor = 0;
+	formatstr( m_changelogEpoch, "%lld.%d.%u", (long long)time(NULL),
+	           (int)getpid(), get_random_uint_insecure() );
 }
 
 
@@ -235,6 +240,7 @@ CollectorEngine::invalidateAds(AdTypes adType, ClassAd &query)
 				dprintf(D_ALWAYS,
 						"\t\t**** Invalidating ad: \"%s\"\n",
 						hkString.Value());
+				noteChangelogRemoval(*table, ad);
 				delete ad;
 				count++;
 			}
@@ -957,6 +963,7 @@ int CollectorEngine::remove (AdTypes t_AddType, const ClassAd & c_query, bool *q
 				hk.sprint( hkString );
 				iRet = !table->remove(hk);
 				dprintf (D_ALWAYS,"\t\t**** Removed(%d) ad(s): \"%s\"\n", iRet, hkString.Value() );
+				noteChangelogRemoval(*table, pAd);
 				delete pAd;
 			}
 		}
@@ -981,6 +988,7 @@ int CollectorEngine::expire( AdTypes adType, const ClassAd & query, bool * query
                 cAd->Assign( ATTR_LAST_HEARD_FROM, 1 );
                 
                 if( CollectorDaemon::offline_plugin_.expire( * cAd ) == true ) {
+                    stampChangelogGeneration( cAd );
                     return rVal;
                 }
                 
@@ -995,6 +1003,7 @@ int CollectorEngine::expire( AdTypes adType, const ClassAd & query, bool * query
                 hKey.sprint( hkString );                
                 dprintf( D_ALWAYS, "\t\t**** Removed(%d) stale ad(s): \"%s\"\n", rVal, hkString.Value() );
 
+                noteChangelogRemoval( *hTable, cAd );
                 delete cAd;
             }
         }
@@ -1011,6 +1020,10 @@ remove (AdTypes adType, AdNameHashKey &hk)
 	if (!LookupByAdType(adType, table, func)) {
 		return 0;
 	}
+	ClassAd *ad = NULL;
+	if (table->lookup(hk, ad) != -1) {
+		noteChangelogRemoval(*table, ad);
+	}
 	return !table->remove(hk);
 }
 
@@ -1068,6 +1081,7 @@ updateClassAd (CollectorHashTable &hashTable,
 		{
 			EXCEPT ("Error inserting ad (out of memory)");
 		}
+		stampChangelogGeneration(new_ad);
 		
 		insert = 1;
 		
@@ -1094,6 +1108,7 @@ updateClassAd (CollectorHashTable &hashTable,
 		if (hashTable.insert(hk, new_ad) == -1) {
 			EXCEPT( "Error inserting ad" );
 		}
+		stampChangelogGeneration(new_ad);
 
 		if ( m_forwardFilteringEnabled && ( strcmp( label, "Start" ) == 0 || strcmp( label, "StartdPvt" ) == 0 || strcmp( label, "Submittor" ) == 0 ) ) {
 			bool forward = false;
@@ -1124,6 +1139,7 @@ updateClassAd (CollectorHashTable &hashTable,
 
 		if (isSelfAd(old_ad)) { __self_ad__ = new_ad; }
 
+		m_adGenerations.erase(old_ad);
 		delete old_ad;
 
 		insert = 0;
@@ -1168,6 +1184,7 @@ mergeClassAd (CollectorHashTable &hashTable,
 
 		// Now, finally, merge the new ClassAd into the old one
 		MergeClassAds(old_ad,&new_ad_copy,true);
+		stampChangelogGeneration(old_ad);
 	}
 	delete new_ad;
 	return old_ad;
@@ -1243,7 +1260,7 @@ housekeeper()
 }
 
 void CollectorEngine::
-cleanHashTable (CollectorHashTable &hashTable, time_t now, HashFunc makeKey) const
+cleanHashTable (CollectorHashTable &hashTable, time_t now, HashFunc makeKey)
 {
 	ClassAd  *ad;
 	int   	 timeStamp;
@@ -1285,6 +1302,7 @@ cleanHashTable (CollectorHashTable &hashTable, time_t now, HashFunc makeKey) con
 				   so then this ad should NOT be deleted. */
 				if ( CollectorDaemon::offline_plugin_.expire( *ad ) == true ) {
 					// plugin say to not delete this ad, so continue
+					stampChangelogGeneration( ad );
 					continue;
 				} else {
 					dprintf (D_ALWAYS,"\t\t**** Removing stale ad: \"%s\"\n", hkString.Value() );
@@ -1294,6 +1312,7 @@ cleanHashTable (CollectorHashTable &hashTable, time_t now, HashFunc makeKey) con
 			{
 				dprintf (D_ALWAYS, "\t\tError while removing ad\n");
 			}
+			noteChangelogRemoval (hashTable, ad);
 			delete ad;
 		}
 	}
@@ -1367,7 +1386,7 @@ CollectorEngine::LookupByAdType(AdTypes adType,
 }
 
 
-static void
+void CollectorEngine::
 purgeHashTable( CollectorHashTable &table )
 {
 	ClassAd* ad;
@@ -1377,10 +1396,106 @@ purgeHashTable( CollectorHashTable &table )
 		if( table.remove(hk) == -1 ) {
 			dprintf( D_ALWAYS, "\t\tError while removing ad\n" );
 		}		
+		noteChangelogRemoval( table, ad );
 		delete ad;
 	}
 }
 
+void CollectorEngine::
+setChangelogSize( int size )
+{
+	m_changelogSize = (size > 0) ? (size_t)size : 0;
+	while( m_changelog.size() > m_changelogSize ) {
+		m_changelogFloor = m_changelog.front().generation;
+		m_changelog.pop_front();
+	}
+	if( m_changelogSize == 0 ) {
+		m_changelogFloor = m_generation;
+	}
+}
+
+bool CollectorEngine::
+changelogCovers( const std::string &epoch, long long since ) const
+{
+	return m_changelogSize > 0 && epoch == m_changelogEpoch &&
+		since >= m_changelogFloor && since <= m_generation;
+}
+
+void CollectorEngine::
+changelogRemovedSince( long long since, bool private_ads, std::vector<std::string> &keys ) const
+{
+	std::deque<ChangelogEntry>::const_iterator it = m_changelog.end();
+	while( it != m_changelog.begin() ) {
+		--it;
+		if( it->generation <= since ) {
+			break;
+		}
+		if( it->private_ad == private_ads ) {
+			keys.push_back( it->key );
+		}
+	}
+}
+
+bool CollectorEngine::
+makeChangelogKey( const ClassAd &ad, std::string &key )
+{
+	const char *type = GetMyTypeName( ad );
+	if( !type ) {
+		return false;
+	}
+
+	CollectorHashTable *table;
+	HashFunc makeKey = makeGenericAdHashKey;
+	AdTypes adType = AdTypeFromString( type );
+	if( adType != GENERIC_AD && adType != NO_AD ) {
+		LookupByAdType( adType, table, makeKey );
+	}
+
+	AdNameHashKey hk;
+	if( !(*makeKey)( hk, &ad ) ) {
+		return false;
+	}
+	HashString hashString( hk );
+	key = type;
+	key += "/";
+	key += hashString.Value();
+	return true;
+}
+
+void CollectorEngine::
+stampChangelogGeneration( const ClassAd *ad )
+{
+	m_adGenerations[ad] = ++m_generation;
+}
+
+long long CollectorEngine::
+changelogAdGeneration( const ClassAd *ad ) const
+{
+	std::unordered_map<const ClassAd *, long long>::const_iterator it = m_adGenerations.find( ad );
+	return it == m_adGenerations.end() ? 0 : it->second;
+}
+
+void CollectorEngine::
+noteChangelogRemoval( CollectorHashTable &table, const ClassAd *ad )
+{
+	m_adGenerations.erase( ad );
+	++m_generation;
+	ChangelogEntry entry;
+	entry.generation = m_generation;
+	entry.private_ad = (&table == &StartdPrivateAds);
+	if( m_changelogSize == 0 || !makeChangelogKey( *ad, entry.key ) ) {
+			// Clients that have not seen this removal can't be told about
+			// it, so they will have to start over with a full query.
+		m_changelogFloor = m_generation;
+		return;
+	}
+	m_changelog.push_back( entry );
+	if( m_changelog.size() > m_changelogSize ) {
+		m_changelogFloor = m_changelog.front().generation;
+		m_changelog.pop_front();
+	}
+}
+
 static void
 killHashTable (CollectorHashTable &table)
 {
@@ -25,6 +25,9 @@
 #include "collector_stats.h"
 #include "hashkey.h"
 
+#include <deque>
+#include <unordered_map>
+
 class CollectorEngine : public Service
 {
   public:
@@ -109,6 +112,24 @@ class CollectorEngine : public Service
 		// returns true on success; false on failure (and sets error_desc)
 	bool setCollectorRequirements( char const *str, MyString &error_desc );
 
+	// Changelog for incremental queries.  Every insert, update or merge
+	// gives the stored ad a new generation number, kept beside the ad rather
+	// than in it so that clients never see it, and every removal
+	// is remembered (up to setChangelogSize() entries) so that a client
+	// which knows the generation of its last query can be sent just the
+	// ads that changed since then, plus the keys of the ads that went away.
+	void setChangelogSize( int size );
+	const std::string & changelogEpoch() const { return m_changelogEpoch; }
+	long long changelogGeneration() const { return m_generation; }
+		// generation of a stored ad, or 0 if it has none
+	long long changelogAdGeneration( const ClassAd *ad ) const;
+		// true if all removals after generation 'since' are still known
+	bool changelogCovers( const std::string &epoch, long long since ) const;
+		// append the keys of ads removed after generation 'since'
+	void changelogRemovedSince( long long since, bool private_ads, std::vector<std::string> &keys ) const;
+		// key that identifies an ad across changelog queries
+	bool makeChangelogKey( const ClassAd &ad, std::string &key );
+
   private:
 	typedef bool (*HashFunc) (AdNameHashKey &, const ClassAd *);
 
@@ -154,11 +175,15 @@ class CollectorEngine : public Service
 
 	void  housekeeper ();
 	int  housekeeperTimerID;
-	void cleanHashTable (CollectorHashTable &, time_t, HashFunc) const;
+	void cleanHashTable (CollectorHashTable &, time_t, HashFunc);
 	ClassAd* updateClassAd(CollectorHashTable&,const char*, const char *,
 						   ClassAd*,AdNameHashKey&, const MyString &, int &, 
 						   const condor_sockaddr& );
 
+	void stampChangelogGeneration( const ClassAd *ad );
+	void noteChangelogRemoval( CollectorHashTable &table, const ClassAd *ad );
+	void purgeHashTable( CollectorHashTable &table );
+
 	ClassAd * mergeClassAd (CollectorHashTable &hashTable,
 							const char *adType,
 							const char *label,
@@ -182,6 +207,18 @@ class CollectorEngine : public Service
 
 	ClassAd *m_collector_requirements;
 
+	struct ChangelogEntry {
+		long long generation;
+		bool private_ad;
+		std::string key;
+	};
+	std::deque<ChangelogEntry> m_changelog;
+	std::unordered_map<const ClassAd *, long long> m_adGenerations; // generation of each stored ad
+	size_t m_changelogSize;
+	long long m_generation;
+	long long m_changelogFloor; // removals at or before this generation may be forgotten
+	std::string m_changelogEpoch;
+
 	bool m_forwardFilteringEnabled;
 	StringList m_forwardWatchList;
 	int m_forwardInterval;
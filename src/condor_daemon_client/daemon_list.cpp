@@ -312,7 +312,8 @@ CollectorList::sendUpdates (int cmd, ClassAd * ad1, ClassAd* ad2, bool nonblocki
 }
 
 QueryResult
-CollectorList::query (CondorQuery & cQuery, bool (*callback)(void*, ClassAd *), void* pv, CondorError * errstack) {
+CollectorList::query (CondorQuery & cQuery, bool (*callback)(void*, ClassAd *), void* pv, CondorError * errstack,
+                      void (*on_retry)(void*, CondorQuery &)) {
 
 	int num_collectors = this->number();
 	if (num_collectors < 1) {
@@ -324,6 +325,7 @@ CollectorList::query (CondorQuery & cQuery, bool (*callback)(void*, ClassAd *),
 	QueryResult result = Q_COMMUNICATION_ERROR;
 
 	bool problems_resolving = false;
+	bool tried = false;
 	bool random_order = ! param_boolean("HAD_USE_PRIMARY", false);
 
 	// switch containers for easier random access.
@@ -359,6 +361,10 @@ CollectorList::query (CondorQuery & cQuery, bool (*callback)(void*, ClassAd *),
 				daemon->blacklistMonitorQueryStarted();
 			}
 
+			if( tried && on_retry ) {
+				on_retry( pv, cQuery );
+			}
+			tried = true;
 			result = cQuery.processAds (callback, pv, daemon->addr(), errstack);
 
 			if( num_collectors > 1 ) {
@@ -122,8 +122,12 @@ class CollectorList : public DaemonList {
 	bool hasAdSeq() { return adSeq != NULL; }
 	DCCollectorAdSequences & getAdSeq();
 	
-		// Try querying all the collectors until you get a good one
-	QueryResult query (CondorQuery & cQuery, bool (*callback)(void*, ClassAd *), void* pv, CondorError * errstack = 0);
+		// Try querying all the collectors until you get a good one.
+		// If a query fails after the callback was given some ads, and
+		// another collector is tried, on_retry is called first so that
+		// the caller can throw those ads away.
+	QueryResult query (CondorQuery & cQuery, bool (*callback)(void*, ClassAd *), void* pv, CondorError * errstack = 0,
+	                   void (*on_retry)(void*, CondorQuery &) = NULL);
 
 		// a common case is just wanting a list of ads back, so provide a ready-made callback that does that...
 	static bool fetchAds_callback(void* pv, ClassAd * ad) {
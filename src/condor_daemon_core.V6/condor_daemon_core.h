@@ -60,6 +60,8 @@
 #include "generic_stats.h"
 #include "filesystem_remap.h"
 #include "daemon_keep_alive.h"
+#include "daemon_metrics.h"
+#include "daemon_profiler.h"
 
 #include <vector>
 #include <memory>
@@ -342,6 +344,7 @@ class DaemonCore : public Service
   friend int dc_main(int, char**);
   friend class DaemonCommandProtocol;
   friend class DaemonKeepAlive;
+  friend class DaemonMetrics;
     
   public:
     
@@ -1582,6 +1585,16 @@ class DaemonCore : public Service
 
 	void InstallAuditingCallback( void (*fn)(int, Sock&, bool) ) { audit_log_callback_fn = fn; }
 
+		/** Also serve the probes in this pool from the METRICS_PORT
+			endpoint, along with the DaemonCore statistics.  flags
+			choose which probes, as for StatisticsPool::Publish().
+			The pool must be cancelled before it is destroyed.
+		*/
+	void Register_Metrics_Pool( StatisticsPool * pool, int flags = IF_HYPERPUB | IF_RECENTPUB | IF_NONZERO )
+		{ m_DaemonMetrics.AddPool(pool, flags); }
+	void Cancel_Metrics_Pool( StatisticsPool * pool )
+		{ m_DaemonMetrics.RemovePool(pool); }
+
 	//-----------------------------------------------------------------------------
 	/*
   	 Statistical values for the operation of DaemonCore, to be published in the
@@ -1611,6 +1624,8 @@ class DaemonCore : public Service
 	   stats_entry_recent<int> AsyncPipe;      //  number of times async_pipe was signalled
       #endif
 	   stats_entry_abs<int> UdpQueueDepth;  // Unread bytes for the UDP command port 
+	   stats_entry_hdr_histogram SocketWait; // time from select returning until a ready socket's handler is called
+	   stats_entry_hdr_histogram TimerLag;   // how late timers fire
 
 		
        stats_entry_recent<Probe> PumpCycle;   // count of pump cycles plus sum of cycle time with min/max/avg/std 
@@ -1646,9 +1661,13 @@ class DaemonCore : public Service
        double AddSample(const char * name, int as, double val);
        double AddRuntime(const char * name, double before); // returns current time.
        double AddRuntimeSample(const char * name, int as, double before);
+       void AddLatency(const char * category, const char * name, double sec);
 
 	} dc_stats;
 
+		// samples the cost of individual handler calls, see DAEMON_PROFILE_SAMPLE_RATE
+	DaemonProfiler dc_profiler;
+
 	bool wants_dc_udp_self() const { return m_wants_dc_udp_self;}
   private:      
 
@@ -1896,6 +1915,10 @@ class DaemonCore : public Service
 
 	bool m_fake_create_thread;
 
+		// how long the socket or pipe whose handler is being called
+		// waited after select() said it was ready, for the profiler
+	double m_handler_queue_wait;
+
 #if defined(WIN32)
 	typedef PipeEnd* PipeHandle;
 #else
@@ -2086,6 +2109,9 @@ class DaemonCore : public Service
 	// in the DaemonKeepAlive helper friend class.
 	DaemonKeepAlive m_DaemonKeepAlive;
 
+	// Serves the statistics over HTTP when METRICS_PORT is set.
+	DaemonMetrics m_DaemonMetrics;
+
 	// Method to check on and possibly recover from a bad connection
 	// to the procd. Suitable to be registered as a one-shot timer.
 	int CheckProcInterface();
@@ -2106,6 +2132,7 @@ class DaemonCore : public Service
 	void CallSocketHandler( int &i, bool default_to_HandleCommand );
 	static void CallSocketHandler_worker_demarshall(void *args);
 	void CallSocketHandler_worker( int i, bool default_to_HandleCommand, Stream* asock );
+	bool SocketDispatchesCommand( int i ) const;
 	
 
 		// Returns index of registered socket or -1 if not found.
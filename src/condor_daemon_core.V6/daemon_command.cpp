@@ -327,6 +327,7 @@ DaemonCommandProtocol::CommandProtocolResult DaemonCommandProtocol::AcceptUDPReq
 			}
 
 			session->renewLease();
+			SecMan::noteSessionResumed(session);
 
 			if (!session->key()) {
 				dprintf ( D_ALWAYS, "DC_AUTHENTICATE: session %s is missing the key! This session was requested by %s with return address %s\n", sess_id, m_sock->peer_description(), return_address_ss ? return_address_ss : "(none)");
@@ -420,6 +421,7 @@ DaemonCommandProtocol::CommandProtocolResult DaemonCommandProtocol::AcceptUDPReq
 			}
 
 			session->renewLease();
+			SecMan::noteSessionResumed(session);
 
 			if (!session->key()) {
 				dprintf ( D_ALWAYS, "DC_AUTHENTICATE: session %s is missing the key! This session was requested by %s with return address %s\n", sess_id, m_sock->peer_description(), return_address_ss ? return_address_ss : "(none)");
@@ -758,6 +760,7 @@ DaemonCommandProtocol::CommandProtocolResult DaemonCommandProtocol::ReadCommand(
 				}
 
 				session->renewLease();
+				SecMan::noteSessionResumed(session);
 
 				if (session->key()) {
 					// copy this to the HandleReq() scope
@@ -1583,6 +1586,7 @@ DaemonCommandProtocol::CommandProtocolResult DaemonCommandProtocol::SendResponse
 		m_sec_man->sec_copy_attribute( *m_policy, pa_ad, ATTR_SEC_USER );
 		m_sec_man->sec_copy_attribute( *m_policy, pa_ad, ATTR_SEC_SID );
 		m_sec_man->sec_copy_attribute( *m_policy, pa_ad, ATTR_SEC_VALID_COMMANDS );
+		m_policy->Assign( ATTR_SEC_NEGOTIATED_SESSION, true );
 		m_sock->setSessionID(m_sid);
 
 		// extract the session duration
@@ -1727,7 +1731,8 @@ DaemonCommandProtocol::CommandProtocolResult DaemonCommandProtocol::ExecCommand(
 
 		// update dc stats for number of commands handled, the time spent in this command handler
 		daemonCore->dc_stats.Commands += 1;
-		daemonCore->dc_stats.AddRuntime(getCommandStringSafe(m_req), begin_time);
+		double end_time = daemonCore->dc_stats.AddRuntime(getCommandStringSafe(m_req), begin_time);
+		daemonCore->dc_stats.AddLatency("CommandLatency", getCommandStringSafe(m_req), end_time - begin_time);
 	}
 
 	return CommandProtocolFinished;
@@ -459,6 +459,7 @@ DaemonCore::DaemonCore(int ComSize,int SigSize,
 #endif
 
 	m_fake_create_thread = false;
+	m_handler_queue_wait = 0;
 
 	m_refresh_dns_timer = -1;
 
@@ -1051,6 +1052,7 @@ int DaemonCore::Register_Command(int command, const char* command_descrip,
 	}
 
 	dc_stats.NewProbe("Command", getCommandStringSafe(command), AS_COUNT | IS_RCT | IF_NONZERO | IF_VERBOSEPUB);
+	dc_stats.NewProbe("CommandLatency", getCommandStringSafe(command), AS_RELTIME | IS_HDR_HISTOGRAM | IF_NONZERO | IF_VERBOSEPUB);
 
 	// Found a blank entry at index i. Now add in the new data.
 	comTable[i].num = command;
@@ -3092,6 +3094,8 @@ DaemonCore::reconfig(void) {
 #endif
 
 	m_DaemonKeepAlive.reconfig();
+	m_DaemonMetrics.reconfig();
+	dc_profiler.reconfig();
 
 	file_descriptor_safety_limit = 0; // 0 indicates: needs to be computed
 
@@ -3644,6 +3648,7 @@ void DaemonCore::Driver()
 		// update statistics on time spent waiting in select.
 		runtime = _condor_debug_get_time_double();
 		dc_stats.SelectWaittime += (runtime - group_runtime);
+		double select_done_time = runtime;
 		//dc_stats.StatsLifetime = now - dc_stats.InitTime;
 
 		tmpErrno = errno;
@@ -3905,6 +3910,9 @@ void DaemonCore::Driver()
 						// Update curr_dataptr for GetDataPtr()
 						curr_dataptr = &( (*pipeTable)[i].data_ptr);
 						recheck_status = true;
+						{
+						DaemonProfiler::Probe profile(dc_profiler, DaemonProfiler::Pipe,
+							(*pipeTable)[i].handler_descrip, NULL, runtime - select_done_time);
 						if ( (*pipeTable)[i].handler )
 							// a C handler
 							(*( (*pipeTable)[i].handler))(pipe_end);
@@ -3917,6 +3925,7 @@ void DaemonCore::Driver()
 							// no handler registered
 							EXCEPT("No pipe handler callback");
 						}
+						}
 
 						dprintf(D_COMMAND,"Return from pipe Handler\n");
 
@@ -3992,7 +4001,18 @@ void DaemonCore::Driver()
 						// ok, select says this socket table entry has new data.
 
 						recheck_status = true;
-						CallSocketHandler( i, true );
+						dc_stats.SocketWait += (runtime - select_done_time);
+						m_handler_queue_wait = runtime - select_done_time;
+						if ( SocketDispatchesCommand( i ) ) {
+								// the command handler is profiled by itself, so
+								// don't count the same call again as a socket
+							CallSocketHandler( i, true );
+						} else {
+							DaemonProfiler::Probe profile(dc_profiler, DaemonProfiler::Socket,
+								(*sockTable)[i].handler_descrip, (*sockTable)[i].iosock, m_handler_queue_wait);
+							CallSocketHandler( i, true );
+						}
+						m_handler_queue_wait = 0;
 
 						// update per-handler runtime statistics
 						runtime = dc_stats.AddRuntime((*sockTable)[i].handler_descrip, runtime);
@@ -4172,6 +4192,19 @@ DaemonCore::CallSocketHandler_worker_demarshall(void *arg)
 	delete args;
 }
 
+// True if calling the handler of socket table entry i means reading and
+// running a DaemonCore command, rather than calling a registered handler.
+bool
+DaemonCore::SocketDispatchesCommand( int i ) const
+{
+	const SockEnt & ent = (*sockTable)[i];
+	if ( ent.handler ) {
+		return false;
+	}
+	return ! ent.handlercpp ||
+		ent.handlercpp == (SocketHandlercpp) &DaemonCore::HandleReqPayloadReady;
+}
+
 void
 DaemonCore::CallSocketHandler_worker( int i, bool default_to_HandleCommand, Stream* asock )
 {
@@ -4438,6 +4471,10 @@ DaemonCore::CallCommandHandler(int req,Stream *stream,bool delete_stream,bool ch
 		// call the handler function; first curr_dataptr for GetDataPtr()
 		curr_dataptr = &(comTable[index].data_ptr);
 
+		{
+		// the command also waited on the security handshake and its payload
+		DaemonProfiler::Probe profile(dc_profiler, DaemonProfiler::Command, comTable[index].command_descrip,
+			stream, m_handler_queue_wait + time_spent_on_sec + time_spent_waiting_for_payload);
 		if ( comTable[index].is_cpp ) {
 			// the handler is c++ and belongs to a 'Service' class
 			if ( comTable[index].handlercpp )
@@ -4447,6 +4484,7 @@ DaemonCore::CallCommandHandler(int req,Stream *stream,bool delete_stream,bool ch
 			if ( comTable[index].handler )
 				result = (*(comTable[index].handler))(req,stream);
 		}
+		}
 
 		// clear curr_dataptr
 		curr_dataptr = NULL;
@@ -671,11 +671,45 @@ check_parent( )
 }
 #endif
 
-// This function clears expired sessions from the cache
+// Look up where incoming security sessions should be persisted; returns
+// false if SEC_SESSION_CACHE_FILE is not configured for this daemon.
+static bool
+get_session_cache_files( std::string &fname, std::string &key_fname )
+{
+	if ( ! param(fname, "SEC_SESSION_CACHE_FILE") || fname.empty()) {
+		return false;
+	}
+	if ( ! param(key_fname, "SEC_SESSION_CACHE_KEY_FILE") || key_fname.empty()) {
+		key_fname = fname + ".key";
+	}
+	return true;
+}
+
+static void
+save_session_cache( )
+{
+	std::string fname, key_fname;
+	if (daemonCore && get_session_cache_files(fname, key_fname)) {
+		daemonCore->getSecMan()->SaveSessionCache(fname.c_str(), key_fname.c_str());
+	}
+}
+
+static void
+restore_session_cache( )
+{
+	std::string fname, key_fname;
+	if (daemonCore && get_session_cache_files(fname, key_fname)) {
+		daemonCore->getSecMan()->RestoreSessionCache(fname.c_str(), key_fname.c_str());
+	}
+}
+
+// This function clears expired sessions from the cache, and checkpoints
+// the persistent session cache (if any) so a crash does not lose it all.
 void
 check_session_cache( )
 {
 	daemonCore->getSecMan()->invalidateExpiredCache();
+	save_session_cache();
 }
 
 bool global_dc_set_cookie(int len, unsigned char* data) {
@@ -806,6 +840,10 @@ DC_Exit( int status, const char *shutdown_program )
 	install_sig_handler(SIGUSR2,SIG_DFL);
 #endif /* ! WIN32 */
 
+		// Persist incoming security sessions so our peers need not
+		// authenticate again when we come back.
+	save_session_cache();
+
 		// Now, delete the daemonCore object, since we allocated it. 
 	unsigned long	pid = 0;
 	if (daemonCore) {
@@ -4243,6 +4281,12 @@ int dc_main( int argc, char** argv )
 								  handle_dc_query_instance,
 								  "handle_dc_query_instance()", ALLOW );
 
+		// DC_QUERY_PROFILE returns the handler samples taken when
+		// DAEMON_PROFILE_SAMPLE_RATE is set.
+	daemonCore->Register_Command( DC_QUERY_PROFILE, "DC_QUERY_PROFILE",
+								  (CommandHandlercpp)&DaemonProfiler::HandleQuery,
+								  "DaemonProfiler::HandleQuery()", &daemonCore->dc_profiler, READ );
+
 		//
 		// The time offset command is used to figure out what
 		// the range of the clock skew is between the daemon code and another
@@ -4333,6 +4377,10 @@ int dc_main( int argc, char** argv )
 	// in their environment
 	SetEnv( envName, daemonCore->sec_man->my_unique_id() );
 
+	// bring back the sessions our peers negotiated with our previous
+	// incarnation, so they can resume them without authenticating again
+	restore_session_cache();
+
 	// create a database connection object
 	//DBObj = createConnection();
 
@@ -0,0 +1,297 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "condor_common.h"
+#include "condor_daemon_core.h"
+#include "subsystem_info.h"
+#include "condor_config.h"
+#include "generic_stats.h"
+#include "condor_rw.h"
+#include "authentication.h"
+
+// Requests are read and replies written without blocking, so a client that
+// dribbles bytes or won't read costs us nothing but a socket table entry.
+// Scrapers send the whole request at once, so don't wait long for it, and
+// don't keep more than a few connections.
+static const int METRICS_DEADLINE = 10;
+static const size_t METRICS_MAX_REQUEST = 8 * 1024;
+static const size_t METRICS_MAX_CLIENTS = 16;
+
+DaemonMetrics::DaemonMetrics()
+	: m_listener(NULL)
+	, m_port(0)
+	, m_loopback_only(true)
+{
+}
+
+DaemonMetrics::~DaemonMetrics()
+{
+	CloseListener();
+	for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+		if (daemonCore) {
+			daemonCore->Cancel_Socket(it->first);
+		}
+		delete it->first;
+	}
+	m_clients.clear();
+}
+
+void
+DaemonMetrics::reconfig(void)
+{
+	// NOTE: this function is always called on initial startup, as well
+	// as at reconfig time.
+	int port = param_integer("METRICS_PORT", 0, 0, 65535);
+	bool loopback_only = param_boolean("METRICS_LOOPBACK_ONLY", true);
+
+	if (m_listener && port == m_port && loopback_only == m_loopback_only) {
+		return;
+	}
+	CloseListener();
+	m_port = port;
+	m_loopback_only = loopback_only;
+	if ( ! m_port) {
+		return;
+	}
+
+	condor_protocol proto = CP_IPV4;
+	if( param_false( "ENABLE_IPV4" ) ) { proto = CP_IPV6; }
+
+	m_listener = new ReliSock;
+	if ( ! m_listener->bind(proto, false, m_port, m_loopback_only)) {
+		dprintf(D_ALWAYS, "DaemonMetrics: couldn't bind to port %d: %s\n", m_port, strerror(errno));
+		CloseListener();
+		return;
+	}
+	if ( ! m_listener->listen()) {
+		dprintf(D_ALWAYS, "DaemonMetrics: couldn't listen on port %d: %s\n", m_port, strerror(errno));
+		CloseListener();
+		return;
+	}
+	daemonCore->Register_Socket(m_listener, "DaemonMetrics listen socket",
+		(SocketHandlercpp)&DaemonMetrics::HandleConnection,
+		"DaemonMetrics::HandleConnection", this);
+	dprintf(D_ALWAYS, "DaemonMetrics: serving statistics at http://%s:%d/metrics\n",
+		m_listener->my_ip_str(), m_listener->get_port());
+}
+
+void
+DaemonMetrics::CloseListener()
+{
+	if (m_listener) {
+		if (daemonCore) {
+			daemonCore->Cancel_Socket(m_listener);
+		}
+		m_listener->close();
+		delete m_listener;
+		m_listener = NULL;
+	}
+}
+
+void
+DaemonMetrics::AddPool(StatisticsPool * pool, int flags)
+{
+	RemovePool(pool);
+	m_pools.push_back(std::make_pair(pool, flags));
+}
+
+void
+DaemonMetrics::RemovePool(StatisticsPool * pool)
+{
+	for (auto it = m_pools.begin(); it != m_pools.end(); ++it) {
+		if (it->first == pool) {
+			m_pools.erase(it);
+			return;
+		}
+	}
+}
+
+int
+DaemonMetrics::HandleConnection(Stream * /*stream*/)
+{
+	ReliSock * client = m_listener->accept();
+	if ( ! client) {
+		dprintf(D_ALWAYS, "DaemonMetrics: couldn't accept connection: %s\n", strerror(errno));
+		return KEEP_STREAM;
+	}
+	if (m_clients.size() >= METRICS_MAX_CLIENTS) {
+		dprintf(D_FULLDEBUG, "DaemonMetrics: refusing connection from %s, already serving %d\n",
+			client->peer_ip_str(), (int)m_clients.size());
+		delete client;
+		return KEEP_STREAM;
+	}
+	// there is no authentication over plain HTTP, so the host alone must be allowed to READ
+	if (daemonCore->Verify("metrics request", READ, client->peer_addr(), UNAUTHENTICATED_FQU,
+			D_SECURITY|D_FULLDEBUG) != USER_AUTH_SUCCESS) {
+		delete client;
+		return KEEP_STREAM;
+	}
+	client->set_deadline_timeout(METRICS_DEADLINE);
+	if (daemonCore->Register_Socket(client, "DaemonMetrics client",
+			(SocketHandlercpp)&DaemonMetrics::HandleRequest,
+			"DaemonMetrics::HandleRequest", this) < 0) {
+		delete client;
+		return KEEP_STREAM;
+	}
+	m_clients[client].sent = 0;
+	return KEEP_STREAM;
+}
+
+void
+DaemonMetrics::WriteMetrics(std::string & body) const
+{
+	std::string labels;
+	formatstr(labels, "daemon=\"%s\"", get_mySubSystem()->getName());
+
+	const DaemonCore::Stats & dc_stats = daemonCore->dc_stats;
+	if (dc_stats.enabled) {
+		dc_stats.Pool.WriteMetrics(body, "condor_", labels.c_str(), IF_HYPERPUB | IF_RECENTPUB | IF_NONZERO);
+	}
+	for (auto it = m_pools.begin(); it != m_pools.end(); ++it) {
+		it->first->WriteMetrics(body, "condor_", labels.c_str(), it->second);
+	}
+	body += "# EOF\n";
+}
+
+// Reads what has arrived of an HTTP request, and answers it once the
+// headers are complete.
+int
+DaemonMetrics::HandleRequest(Stream * stream)
+{
+	ReliSock * client = (ReliSock *)stream;
+	auto it = m_clients.find(client);
+	if (it == m_clients.end()) {
+		return ~KEEP_STREAM;
+	}
+	Client & state = it->second;
+	if (client->deadline_expired()) {
+		dprintf(D_FULLDEBUG, "DaemonMetrics: gave up waiting for a request from %s\n", client->peer_ip_str());
+		m_clients.erase(it);
+		return ~KEEP_STREAM;
+	}
+
+	char buf[2048];
+	int len = condor_read(client->peer_description(), client->get_file_desc(), buf, sizeof(buf), 0, 0, true);
+	if (len < 0) {
+		m_clients.erase(it);
+		return ~KEEP_STREAM;
+	}
+	state.request.append(buf, len);
+	size_t header_end = state.request.find("\r\n\r\n");
+	if (header_end == std::string::npos) {
+		header_end = state.request.find("\n\n");
+	}
+	if (header_end == std::string::npos) {
+		if (state.request.size() > METRICS_MAX_REQUEST) {
+			dprintf(D_FULLDEBUG, "DaemonMetrics: request from %s is too long\n", client->peer_ip_str());
+			m_clients.erase(it);
+			return ~KEEP_STREAM;
+		}
+		return KEEP_STREAM;
+	}
+
+	// only the request line matters, the headers are ignored
+	char method[16], path[256];
+	if (sscanf(state.request.c_str(), "%15s %255s", method, path) != 2) {
+		method[0] = path[0] = 0;
+	}
+	char * query = strchr(path, '?');
+	if (query) { *query = 0; }
+
+	std::string body;
+	const char * status = "200 OK";
+	const char * content_type = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+	if (strcmp(method, "GET") != MATCH) {
+		status = "405 Method Not Allowed";
+	} else if (strcmp(path, "/metrics") != MATCH && strcmp(path, "/") != MATCH) {
+		status = "404 Not Found";
+	}
+	if (strcmp(status, "200 OK") == MATCH) {
+		WriteMetrics(body);
+	} else {
+		content_type = "text/plain; charset=utf-8";
+		body = status;
+		body += "\n";
+	}
+
+	formatstr(state.response,
+		"HTTP/1.0 %s\r\n"
+		"Content-Type: %s\r\n"
+		"Content-Length: %d\r\n"
+		"Connection: close\r\n"
+		"\r\n",
+		status, content_type, (int)body.size());
+	state.response += body;
+	state.request.clear();
+
+	if (SendResponse(client, state)) {
+		m_clients.erase(it);
+		return ~KEEP_STREAM;
+	}
+	// the rest goes out as the socket becomes writable
+	daemonCore->Cancel_Socket(client);
+	if (daemonCore->Register_Socket(client, "DaemonMetrics client",
+			(SocketHandlercpp)&DaemonMetrics::HandleWritable,
+			"DaemonMetrics::HandleWritable", this, ALLOW, HANDLE_WRITE) < 0) {
+		m_clients.erase(it);
+		delete client;
+	}
+	return KEEP_STREAM;
+}
+
+int
+DaemonMetrics::HandleWritable(Stream * stream)
+{
+	ReliSock * client = (ReliSock *)stream;
+	auto it = m_clients.find(client);
+	if (it == m_clients.end()) {
+		return ~KEEP_STREAM;
+	}
+	if (client->deadline_expired()) {
+		dprintf(D_FULLDEBUG, "DaemonMetrics: gave up sending a response to %s\n", client->peer_ip_str());
+		m_clients.erase(it);
+		return ~KEEP_STREAM;
+	}
+	if (SendResponse(client, it->second)) {
+		m_clients.erase(it);
+		return ~KEEP_STREAM;
+	}
+	return KEEP_STREAM;
+}
+
+// Writes as much of the response as the socket will take without blocking.
+// Returns true once the client is done with, whether or not that worked.
+bool
+DaemonMetrics::SendResponse(ReliSock * client, Client & state)
+{
+	while (state.sent < state.response.size()) {
+		int len = condor_write(client->peer_description(), client->get_file_desc(),
+			state.response.data() + state.sent, (int)(state.response.size() - state.sent), 0, 0, true);
+		if (len < 0) {
+			dprintf(D_FULLDEBUG, "DaemonMetrics: failed to send response to %s\n", client->peer_ip_str());
+			return true;
+		}
+		if (len == 0) {
+			return false;
+		}
+		state.sent += len;
+	}
+	return true;
+}
@@ -0,0 +1,75 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef _CONDOR_DAEMON_METRICS_H_
+#define _CONDOR_DAEMON_METRICS_H_
+
+#include <vector>
+#include <map>
+#include <string>
+
+class StatisticsPool;
+class ReliSock;
+
+/** This class serves the daemon's statistics as OpenMetrics text over
+	plain HTTP, so that Prometheus and similar tools can scrape a daemon
+	directly instead of querying its ad from the collector.  It listens
+	only when METRICS_PORT is set, and on the loopback interface unless
+	METRICS_LOOPBACK_ONLY is false, and answers only hosts allowed READ
+	access.  GET /metrics (or /) returns the
+	DaemonCore statistics plus any pools the daemon has registered with
+	DaemonCore::Register_Metrics_Pool().  Requests are read and replies
+	written without blocking, within a deadline.
+	Like DaemonKeepAlive, this class is only intended to be used by
+	DaemonCore.
+*/
+class DaemonMetrics: public Service {
+	friend class DaemonCore;
+
+protected:
+	DaemonMetrics();
+	~DaemonMetrics();
+
+	void reconfig(void);
+	void AddPool(StatisticsPool * pool, int flags);
+	void RemovePool(StatisticsPool * pool);
+
+private:
+	int HandleConnection(Stream * stream);
+	int HandleRequest(Stream * stream);
+	int HandleWritable(Stream * stream);
+	void WriteMetrics(std::string & body) const;
+	void CloseListener();
+
+	struct Client {
+		std::string request;  // what has arrived so far
+		std::string response;
+		size_t sent;          // bytes of the response written
+	};
+	bool SendResponse(ReliSock * client, Client & state);
+
+	ReliSock * m_listener;
+	int m_port;
+	bool m_loopback_only;
+	std::vector< std::pair<StatisticsPool*, int> > m_pools;
+	std::map<ReliSock*, Client> m_clients;
+};
+
+#endif
@@ -0,0 +1,281 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "condor_common.h"
+#include "condor_daemon_core.h"
+#include "condor_config.h"
+
+#include <map>
+#include <algorithm>
+
+DaemonProfiler::DaemonProfiler()
+	: m_next(0)
+	, m_count(0)
+	, m_sample_rate(0)
+	, m_calls(0)
+	, m_total_samples(0)
+{
+}
+
+void
+DaemonProfiler::reconfig(void)
+{
+	// NOTE: this function is always called on initial startup, as well
+	// as at reconfig time.
+	Configure(param_integer("DAEMON_PROFILE_SAMPLE_RATE", 0, 0),
+	          param_integer("DAEMON_PROFILE_HISTORY_SIZE", 1000, 1));
+}
+
+void
+DaemonProfiler::Configure(int sample_rate, int history_size)
+{
+	m_sample_rate = sample_rate;
+	if (m_sample_rate <= 0 || history_size <= 0) {
+		m_samples.clear();
+		m_next = m_count = 0;
+		return;
+	}
+	if ((size_t)history_size != m_samples.size()) {
+		// start over rather than trying to preserve the order of the old samples
+		m_samples.clear();
+		m_samples.resize(history_size);
+		m_next = m_count = 0;
+	}
+}
+
+void
+DaemonProfiler::Record(HandlerKind kind, const char * name, const char * peer,
+                       double queue_wait, double wall, double cpu)
+{
+	if (m_samples.empty()) {
+		return;
+	}
+	Sample & sample = m_samples[m_next];
+	sample.when = time(NULL);
+	sample.kind = kind;
+	sample.name = name ? name : "";
+	sample.peer = peer ? peer : "";
+	sample.queue_wait = queue_wait;
+	sample.wall = wall;
+	sample.cpu = cpu;
+
+	m_next = (m_next + 1) % m_samples.size();
+	if (m_count < m_samples.size()) {
+		++m_count;
+	}
+	++m_total_samples;
+}
+
+const char *
+DaemonProfiler::KindName(HandlerKind kind)
+{
+	switch (kind) {
+		case Command: return "Command";
+		case Timer:   return "Timer";
+		case Socket:  return "Socket";
+		case Pipe:    return "Pipe";
+	}
+	return "Unknown";
+}
+
+double
+DaemonProfiler::ThreadCpuTime()
+{
+#ifdef WIN32
+	FILETIME create_time, exit_time, kernel_time, user_time;
+	if ( ! GetThreadTimes(GetCurrentThread(), &create_time, &exit_time, &kernel_time, &user_time)) {
+		return 0.0;
+	}
+	ULARGE_INTEGER kernel, user;
+	kernel.LowPart = kernel_time.dwLowDateTime; kernel.HighPart = kernel_time.dwHighDateTime;
+	user.LowPart = user_time.dwLowDateTime; user.HighPart = user_time.dwHighDateTime;
+	return (double)(kernel.QuadPart + user.QuadPart) / 1e7; // 100ns units
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+	struct timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+		return 0.0;
+	}
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0.0;
+	}
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+	       (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+struct ProfileTotals {
+	ProfileTotals() : samples(0), wall(0), cpu(0), queue_wait(0), max_wall(0), max_queue_wait(0) {}
+	std::string kind, name, peer;
+	long samples;
+	double wall, cpu, queue_wait, max_wall, max_queue_wait;
+};
+
+static bool
+more_wall_time(const ProfileTotals * a, const ProfileTotals * b)
+{
+	return a->wall > b->wall;
+}
+
+void
+DaemonProfiler::Report(const char * group_by, std::vector<ClassAd> & ads) const
+{
+	bool by_peer = group_by && strcasecmp(group_by, "Peer") == MATCH;
+	bool by_sample = group_by && strcasecmp(group_by, "Sample") == MATCH;
+
+	// walk the ring from oldest to newest
+	size_t first = (m_next + m_samples.size() - m_count) % (m_samples.empty() ? 1 : m_samples.size());
+
+	if (by_sample) {
+		for (size_t ix = 0; ix < m_count; ++ix) {
+			const Sample & sample = m_samples[(first + ix) % m_samples.size()];
+			ads.push_back(ClassAd());
+			ClassAd & ad = ads.back();
+			ad.Assign("Time", sample.when);
+			ad.Assign("Kind", KindName(sample.kind));
+			ad.Assign("Name", sample.name);
+			ad.Assign("Peer", sample.peer);
+			ad.Assign("WallTime", sample.wall);
+			ad.Assign("CpuTime", sample.cpu);
+			ad.Assign("QueueTime", sample.queue_wait);
+		}
+		return;
+	}
+
+	std::map<std::string, ProfileTotals> totals;
+	for (size_t ix = 0; ix < m_count; ++ix) {
+		const Sample & sample = m_samples[(first + ix) % m_samples.size()];
+		std::string key;
+		if (by_peer) {
+			key = sample.peer;
+		} else {
+			formatstr(key, "%d:%s", (int)sample.kind, sample.name.c_str());
+		}
+		ProfileTotals & tot = totals[key];
+		if ( ! tot.samples) {
+			if (by_peer) {
+				tot.peer = sample.peer;
+			} else {
+				tot.kind = KindName(sample.kind);
+				tot.name = sample.name;
+			}
+		}
+		tot.samples += 1;
+		tot.wall += sample.wall;
+		tot.cpu += sample.cpu;
+		tot.queue_wait += sample.queue_wait;
+		tot.max_wall = MAX(tot.max_wall, sample.wall);
+		tot.max_queue_wait = MAX(tot.max_queue_wait, sample.queue_wait);
+	}
+
+	std::vector<const ProfileTotals *> sorted;
+	for (auto it = totals.begin(); it != totals.end(); ++it) {
+		sorted.push_back(&it->second);
+	}
+	std::sort(sorted.begin(), sorted.end(), more_wall_time);
+
+	for (auto it = sorted.begin(); it != sorted.end(); ++it) {
+		const ProfileTotals & tot = **it;
+		ads.push_back(ClassAd());
+		ClassAd & ad = ads.back();
+		if (by_peer) {
+			ad.Assign("Peer", tot.peer);
+		} else {
+			ad.Assign("Kind", tot.kind);
+			ad.Assign("Name", tot.name);
+		}
+		ad.Assign("Samples", tot.samples);
+		ad.Assign("WallTime", tot.wall);
+		ad.Assign("CpuTime", tot.cpu);
+		ad.Assign("QueueTime", tot.queue_wait);
+		ad.Assign("MaxWallTime", tot.max_wall);
+		ad.Assign("MaxQueueTime", tot.max_queue_wait);
+	}
+}
+
+// The request is a ClassAd with an optional GroupBy attribute.  The reply
+// is a summary ad, the number of result ads, and then the result ads.
+int
+DaemonProfiler::HandleQuery(int /*cmd*/, Stream * stream)
+{
+	ClassAd request;
+	stream->decode();
+	if ( ! getClassAd(stream, request) || ! stream->end_of_message()) {
+		dprintf(D_ALWAYS, "DaemonProfiler: failed to read query from %s\n", stream->peer_description());
+		return FALSE;
+	}
+	std::string group_by = "Handler";
+	request.LookupString("GroupBy", group_by);
+
+	std::vector<ClassAd> ads;
+	Report(group_by.c_str(), ads);
+
+	ClassAd summary;
+	summary.Assign("SampleRate", m_sample_rate);
+	summary.Assign("HistorySize", (long long)m_samples.size());
+	summary.Assign("Samples", (long long)m_count);
+	summary.Assign("TotalSamples", m_total_samples);
+	summary.Assign("GroupBy", group_by);
+
+	int num_ads = (int)ads.size();
+	stream->encode();
+	bool ok = putClassAd(stream, summary) && stream->code(num_ads);
+	for (auto it = ads.begin(); ok && it != ads.end(); ++it) {
+		ok = putClassAd(stream, *it);
+	}
+	if ( ! ok || ! stream->end_of_message()) {
+		dprintf(D_ALWAYS, "DaemonProfiler: failed to send profile to %s\n", stream->peer_description());
+		return FALSE;
+	}
+	return TRUE;
+}
+
+DaemonProfiler::Probe::Probe(DaemonProfiler & profiler, HandlerKind kind, const char * name,
+                             Stream * peer, double queue_wait)
+	: m_profiler(NULL)
+	, m_kind(kind)
+	, m_queue_wait(queue_wait)
+	, m_begin_time(0)
+	, m_begin_cpu(0)
+{
+	if ( ! profiler.ShouldSample()) {
+		return;
+	}
+	m_profiler = &profiler;
+	if (name) { m_name = name; }
+	if (peer) {
+		const char * ip = peer->peer_ip_str();
+		if (ip) { m_peer = ip; }
+	}
+	m_begin_cpu = ThreadCpuTime();
+	m_begin_time = _condor_debug_get_time_double();
+}
+
+DaemonProfiler::Probe::~Probe()
+{
+	if ( ! m_profiler) {
+		return;
+	}
+	double wall = _condor_debug_get_time_double() - m_begin_time;
+	double cpu = ThreadCpuTime() - m_begin_cpu;
+	m_profiler->Record(m_kind, m_name.c_str(), m_peer.c_str(), m_queue_wait, wall, cpu);
+}
@@ -0,0 +1,111 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef _CONDOR_DAEMON_PROFILER_H_
+#define _CONDOR_DAEMON_PROFILER_H_
+
+#include <string>
+#include <vector>
+
+class Stream;
+
+/** A sampling profiler for DaemonCore handlers.  When
+	DAEMON_PROFILE_SAMPLE_RATE is N, one of every N calls to a command,
+	timer, socket or pipe handler records the wall clock time it took,
+	the CPU time it used, how long it waited to be called, and the peer
+	it served.  The most recent DAEMON_PROFILE_HISTORY_SIZE samples are
+	kept in a ring buffer, which the DC_QUERY_PROFILE command returns
+	either as raw samples or totalled by handler or by peer
+	(condor_stats -profile).  A call that isn't sampled costs a counter
+	increment, so the profiler can be left on.
+*/
+class DaemonProfiler: public Service {
+public:
+	enum HandlerKind { Command, Timer, Socket, Pipe };
+
+	DaemonProfiler();
+
+	void reconfig(void);
+	void Configure(int sample_rate, int history_size);
+
+		/// True if the current handler call is one to be sampled.
+	bool ShouldSample() {
+		if (m_sample_rate <= 0 || ++m_calls < m_sample_rate) { return false; }
+		m_calls = 0;
+		return true;
+	}
+
+	void Record(HandlerKind kind, const char * name, const char * peer,
+	            double queue_wait, double wall, double cpu);
+
+		/** Fill ads with the samples in the ring buffer, one ad per
+			sample if group_by is "Sample", else totalled by "Handler"
+			or by "Peer", with the most expensive first.
+		*/
+	void Report(const char * group_by, std::vector<ClassAd> & ads) const;
+
+	int HandleQuery(int cmd, Stream * stream);
+
+	int SampleRate() const { return m_sample_rate; }
+	long long TotalSamples() const { return m_total_samples; }
+
+	static const char * KindName(HandlerKind kind);
+		/// CPU time used so far by the calling thread, in seconds.
+	static double ThreadCpuTime();
+
+		/// Profiles one handler call, from construction to destruction,
+		/// if the profiler chooses to sample it.
+	class Probe {
+	public:
+		Probe(DaemonProfiler & profiler, HandlerKind kind, const char * name,
+		      Stream * peer, double queue_wait);
+		~Probe();
+	private:
+		DaemonProfiler * m_profiler; // NULL if the call isn't sampled
+		HandlerKind m_kind;
+		std::string m_name;
+		std::string m_peer;
+		double m_queue_wait;
+		double m_begin_time;
+		double m_begin_cpu;
+
+		Probe(const Probe &);
+		Probe & operator=(const Probe &);
+	};
+
+private:
+	struct Sample {
+		time_t when;
+		HandlerKind kind;
+		std::string name;
+		std::string peer;
+		double queue_wait;
+		double wall;
+		double cpu;
+	};
+	std::vector<Sample> m_samples; // ring buffer of the newest samples
+	size_t m_next;                 // where the next sample goes
+	size_t m_count;                // number of valid samples
+	int m_sample_rate;
+	int m_calls;                   // calls since the last sample
+	long long m_total_samples;
+};
+
+#endif
@@ -56,6 +56,8 @@ SelfMonitorData::SelfMonitorData()
 	user_time = sys_time = -1;
 	registered_socket_count = 0;
 	cached_security_sessions = 0;
+	restored_security_sessions = 0;
+	resumed_security_sessions = 0;
     return;
 }
 
@@ -117,6 +119,8 @@ void SelfMonitorData::CollectData(void)
 	registered_socket_count = daemonCore->RegisteredSocketCount();
 
 	cached_security_sessions = daemonCore->getSecMan()->session_cache->count();
+	restored_security_sessions = SecMan::m_restored_session_count;
+	resumed_security_sessions = SecMan::m_resumed_session_count;
 
 	// collect data on the udp port depth
 	if (daemonCore->wants_dc_udp_self()) {
@@ -146,6 +150,10 @@ bool SelfMonitorData::ExportData(ClassAd *ad, bool verbose /*=false*/) const
         ad->Assign("MonitorSelfAge",             age);
         ad->Assign("MonitorSelfRegisteredSocketCount", registered_socket_count);
         ad->Assign("MonitorSelfSecuritySessions", cached_security_sessions);
+        if (restored_security_sessions) {
+            ad->Assign("MonitorSelfSecuritySessionsRestored", restored_security_sessions);
+            ad->Assign("MonitorSelfSecuritySessionsResumed", resumed_security_sessions);
+        }
         ad->Assign(ATTR_DETECTED_CPUS, param_integer("DETECTED_CORES", 0));
         ad->Assign(ATTR_DETECTED_MEMORY, param_integer("DETECTED_MEMORY", 0));
         if (verbose) {
@@ -239,6 +247,8 @@ void DaemonCore::Stats::Init(bool enable)
    STATS_POOL_ADD_VAL(Pool, "DC", UdpQueueDepth,  IF_BASICPUB);
    STATS_POOL_PUB_PEAK(Pool, "DC", UdpQueueDepth,  IF_BASICPUB);
    DC_STATS_ADD_DEF(Pool, Commands, IF_BASICPUB);
+   DC_STATS_ADD_DEF(Pool, SocketWait, IF_VERBOSEPUB);
+   DC_STATS_ADD_DEF(Pool, TimerLag,   IF_VERBOSEPUB);
 
    // insert entries that are stored in helper modules
    //
@@ -534,6 +544,19 @@ double DaemonCore::Stats::AddRuntimeSample(const char * name, int as, double bef
 
 #endif
 
+void DaemonCore::Stats::AddLatency(const char * category, const char * name, double sec)
+{
+   if ( ! this->enabled) return;
+
+   MyString attr;
+   attr.formatstr("DC%s_%s", category, name);
+   cleanStringForUseAsAttr(attr);
+
+   stats_entry_hdr_histogram * probe = Pool.GetProbe<stats_entry_hdr_histogram>(attr.Value());
+   if (probe)
+      probe->Add(sec);
+}
+
 void* DaemonCore::Stats::NewProbe(const char * category, const char * name, int as)
 {
    if ( ! this->enabled) return NULL;
@@ -631,6 +654,16 @@ void* DaemonCore::Stats::NewProbe(const char * category, const char * name, int
          }
          break;
 
+      case AS_RELTIME | IS_HDR_HISTOGRAM:
+         {
+         // keyed by attribute name, since the RCT probe for the same
+         // command or handler is already keyed by name.
+         stats_entry_hdr_histogram * probe =
+         Pool.NewProbe<stats_entry_hdr_histogram>(attr.Value(), attr.Value(), as);
+         ret = probe;
+         }
+         break;
+
       default:
          EXCEPT("unsupported probe type");
          break;
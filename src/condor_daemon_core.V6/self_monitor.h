@@ -75,6 +75,10 @@ public:
 	int           registered_socket_count;
 	// How many security sessions exist in the cache
 	int           cached_security_sessions;
+	// How many incoming sessions were restored from SEC_SESSION_CACHE_FILE
+	int           restored_security_sessions;
+	// How many of the restored sessions have been resumed by a peer
+	int           resumed_security_sessions;
 
 private:
     int           _timer_id;
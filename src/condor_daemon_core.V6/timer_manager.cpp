@@ -24,6 +24,7 @@
 #include "condor_debug.h"
 #include "condor_daemon_core.h"
 #include "condor_config.h"
+#include "utc_time.h"
 #include <unordered_set>
 
 static const char* DEFAULT_INDENT = "DaemonCore--> ";
@@ -461,10 +462,23 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 			in_timeout->timeslice->setStartTimeNow();
 		}
 
+		// How late the timer is firing.  when is wall clock time, unlike
+		// the monotonic runtime used for the handler runtime stats.
+		double lag = 0.0;
+		if (in_timeout->when != TIME_T_NEVER) {
+			lag = MAX(0.0, condor_gettimestamp_double() - (double)in_timeout->when);
+		}
+		if (daemonCore->dc_stats.enabled) {
+			daemonCore->dc_stats.TimerLag += lag;
+		}
+
 		// Now we call the registered handler.  If we were told that the handler
 		// is a c++ method, we call the handler from the c++ object referenced 
 		// by service*.  If we were told the handler is a c function, we call
 		// it and pass the service* as a parameter.
+		{
+		DaemonProfiler::Probe profile(daemonCore->dc_profiler, DaemonProfiler::Timer,
+			in_timeout->event_descrip, NULL, lag);
 		if ( in_timeout->handlercpp ) {
 			// typedef int (*TimerHandlercpp)()
 			((in_timeout->service)->*(in_timeout->handlercpp))();
@@ -472,6 +486,7 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 			// typedef int (*TimerHandler)()
 			(*(in_timeout->handler))();
 		}
+		}
 
 		if( in_timeout->timeslice ) {
 			in_timeout->timeslice->setFinishTimeNow();
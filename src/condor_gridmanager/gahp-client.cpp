@@ -4005,6 +4005,96 @@ GahpClient::blah_job_status(const char *job_id, ClassAd **status_ad)
 	return GAHPCLIENT_COMMAND_PENDING;
 }
 
+int
+GahpClient::blah_job_status_bulk(const std::vector<std::string> &job_ids,
+								 std::map<std::string, ClassAd *> &status_ads)
+{
+	static const char* command = "BLAH_JOB_STATUS_BULK";
+
+		// Check if this command is supported
+	if  (server->m_commands_supported->contains_anycase(command)==FALSE) {
+		return GAHPCLIENT_COMMAND_NOT_SUPPORTED;
+	}
+
+		// Generate request line
+	std::string reqline;
+	formatstr( reqline, "%d", (int)job_ids.size() );
+	for ( const auto &job_id : job_ids ) {
+		reqline += ' ';
+		reqline += escapeGahpString( job_id );
+	}
+	const char *buf = reqline.c_str();
+
+		// Check if this request is currently pending.  If not, make
+		// it the pending request.
+	if ( !is_pending(command,buf) ) {
+		// Command is not pending, so go ahead and submit a new one
+		// if our command mode permits.
+		if ( m_mode == results_only ) {
+			return GAHPCLIENT_COMMAND_NOT_SUBMITTED;
+		}
+		now_pending(command,buf,deleg_proxy);
+	}
+
+		// If we made it here, command is pending.
+
+		// Check first if command completed.
+		// The result is the request id, a return code, an error
+		// string and a job count, followed by the job id, return
+		// code, job status and status ad of each job.
+	Gahp_Args* result = get_pending_result(command,buf);
+	if ( result ) {
+		// command completed.
+		if ( result->argc < 4 ) {
+			EXCEPT("Bad %s Result",command);
+		}
+		int rc = atoi( result->argv[1] );
+		if ( strcasecmp(result->argv[2], NULLSTRING) ) {
+			error_string = result->argv[2];
+		} else {
+			error_string = "";
+		}
+		int cnt = atoi( result->argv[3] );
+		if ( cnt < 0 || result->argc != 4 + 4 * cnt ) {
+			EXCEPT("Bad %s Result",command);
+		}
+		classad::ClassAdParser parser;
+		for ( int i = 0; i < cnt; i++ ) {
+			const char *job_id = result->argv[4 + 4*i];
+			const char *ad_str = result->argv[4 + 4*i + 3];
+			if ( atoi( result->argv[4 + 4*i + 1] ) != 0 ||
+				 !strcasecmp( ad_str, NULLSTRING ) ) {
+				continue;
+			}
+			ClassAd *status_ad = new ClassAd;
+			if ( !parser.ParseClassAd( ad_str, *status_ad ) ) {
+				delete status_ad;
+				continue;
+			}
+			status_ad->Assign( ATTR_JOB_STATUS, atoi( result->argv[4 + 4*i + 2] ) );
+			auto it = status_ads.find( job_id );
+			if ( it != status_ads.end() ) {
+				delete it->second;
+				it->second = status_ad;
+			} else {
+				status_ads[job_id] = status_ad;
+			}
+		}
+		delete result;
+		return rc;
+	}
+
+		// Now check if pending command timed out.
+	if ( check_pending_timeout(command,buf) ) {
+		// pending command timed out.
+		formatstr( error_string, "%s timed out", command );
+		return GAHPCLIENT_COMMAND_TIMED_OUT;
+	}
+
+		// If we made it here, command is still pending...
+	return GAHPCLIENT_COMMAND_PENDING;
+}
+
 int
 GahpClient::blah_job_cancel(const char *job_id)
 {
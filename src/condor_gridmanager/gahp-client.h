@@ -495,6 +495,13 @@ class GahpClient : public GenericGahpClient {
 		int
 		blah_job_status(const char *job_id, ClassAd **status_ad);
 
+			// Status of many jobs in one request.  Jobs the server
+			// reported a status ad for are added to status_ads (the
+			// caller owns the ads); jobs it couldn't check are left out.
+		int
+		blah_job_status_bulk(const std::vector<std::string> &job_ids,
+							 std::map<std::string, ClassAd *> &status_ads);
+
 		int
 		blah_job_cancel(const char *job_id);
 
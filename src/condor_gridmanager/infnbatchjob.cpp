@@ -678,6 +678,11 @@ void INFNBatchJob::doEvaluateState()
 					pollNow = false;
 				}
 				int poll_interval = myResource->GetJobPollInterval();
+				if ( myResource->BulkStatusActive() ) {
+						// The resource polls for us. Only check on our
+						// own if it hasn't done so in a long while.
+					poll_interval *= 3;
+				}
 				if ( now >= lastPollTime + poll_interval ) {
 					gmState = GM_POLL_ACTIVE;
 					break;
@@ -1266,6 +1271,27 @@ void INFNBatchJob::SetRemoteIds( const char *sandbox_id, const char *job_id )
 	BaseJob::SetRemoteJobId( full_job_id.c_str() );
 }
 
+bool INFNBatchJob::WantsBulkStatus() const
+{
+	return gmState == GM_SUBMITTED && remoteJobId != NULL;
+}
+
+void INFNBatchJob::BulkStatusUpdate( const char *job_id, ClassAd *status_ad )
+{
+		// Ignore results for a remote job we're no longer waiting on
+	if ( !WantsBulkStatus() || strcmp( job_id, remoteJobId ) ) {
+		return;
+	}
+	if ( status_ad == NULL ) {
+		pollNow = true;
+	} else {
+		numStatusCheckAttempts = 0;
+		ProcessRemoteAd( status_ad );
+		lastPollTime = time(NULL);
+	}
+	SetEvaluateState();
+}
+
 void INFNBatchJob::ProcessRemoteAd( ClassAd *remote_ad )
 {
 	int new_remote_state;
@@ -88,6 +88,11 @@ class INFNBatchJob : public BaseJob
 
 	void ProcessRemoteAd( ClassAd *remote_ad );
 
+		// For status fetched by INFNBatchResource for many jobs at once.
+		// A NULL status_ad means this job should check on its own.
+	bool WantsBulkStatus() const;
+	void BulkStatusUpdate( const char *job_id, ClassAd *status_ad );
+
 	void SetRemoteSandboxId( const char *sandbox_id );
 	void SetRemoteJobId( const char *job_id );
 	void SetRemoteIds( const char *sandbox_id, const char *job_id );
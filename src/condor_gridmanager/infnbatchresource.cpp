@@ -21,6 +21,7 @@
 #include "condor_common.h"
 #include "condor_config.h"
 #include "string_list.h"
+#include "utc_time.h"
 
 #include "infnbatchresource.h"
 #include "gridmanager.h"
@@ -72,8 +73,16 @@ INFNBatchResource::INFNBatchResource( const char *batch_type,
 	const char *resource_name, const char *gahp_args )
 	: BaseResource( resource_name ),
 	  m_xfer_gahp( NULL ),
+	  status_gahp( NULL ),
 	  m_gahpCanRefreshProxy( false ),
-	  m_gahpRefreshProxyChecked( false )
+	  m_gahpRefreshProxyChecked( false ),
+	  m_bulkStatusSupported( false ),
+	  m_bulkStatusChecked( false ),
+	  m_bulkStatusNext( 0 ),
+	  m_bulkStatusBegin( 0 ),
+	  m_bulkStatusLastDuration( 0 ),
+	  m_bulkStatusLastJobs( 0 ),
+	  m_bulkStatusCycles( 0 )
 {
 	m_batchType = batch_type;
 	m_gahpArgs = gahp_args;
@@ -98,6 +107,13 @@ INFNBatchResource::INFNBatchResource( const char *batch_type,
 	gahp->setMode( GahpClient::normal );
 	gahp->setTimeout( INFNBatchJob::gahpCallTimeout );
 
+	StartBatchStatusTimer();
+
+	status_gahp = new GahpClient( gahp_name.c_str() );
+	status_gahp->setNotificationTimerId( BatchPollTid() );
+	status_gahp->setMode( GahpClient::normal );
+	status_gahp->setTimeout( INFNBatchJob::gahpCallTimeout );
+
 	if ( m_gahpIsRemote ) {
 		gahp_name.insert( 0, "xfer/" );
 		m_xfer_gahp = new GahpClient( gahp_name.c_str() );
@@ -115,6 +131,7 @@ INFNBatchResource::~INFNBatchResource()
 {
 	ResourcesByName.remove( HashName( m_batchType.c_str(), m_gahpArgs.c_str() ) );
 	if ( gahp ) delete gahp;
+	delete status_gahp;
 	delete m_xfer_gahp;
 }
 
@@ -123,6 +140,7 @@ void INFNBatchResource::Reconfig()
 {
 	BaseResource::Reconfig();
 	gahp->setTimeout( INFNBatchJob::gahpCallTimeout );
+	status_gahp->setTimeout( INFNBatchJob::gahpCallTimeout );
 }
 
 const char *INFNBatchResource::ResourceType()
@@ -140,6 +158,12 @@ void INFNBatchResource::PublishResourceAd( ClassAd *resource_ad )
 	BaseResource::PublishResourceAd( resource_ad );
 
 	gahp->PublishStats( resource_ad );
+
+	if ( m_bulkStatusSupported ) {
+		resource_ad->Assign( "BulkStatusCycles", m_bulkStatusCycles );
+		resource_ad->Assign( "BulkStatusLastJobs", m_bulkStatusLastJobs );
+		resource_ad->Assign( "BulkStatusLastDuration", m_bulkStatusLastDuration );
+	}
 }
 
 bool INFNBatchResource::GahpCanRefreshProxy()
@@ -182,3 +206,99 @@ void INFNBatchResource::DoPing( unsigned& ping_delay, bool& ping_complete, bool&
 
 	return;
 }
+
+bool INFNBatchResource::BulkStatusActive()
+{
+	if ( !m_bulkStatusChecked && status_gahp->isStarted() ) {
+		m_bulkStatusSupported = status_gahp->getCommands()->contains_anycase( "BLAH_JOB_STATUS_BULK" );
+		m_bulkStatusChecked = true;
+		dprintf( D_FULLDEBUG, "Batch gahp for %s %s bulk status requests\n",
+				 ResourceName(), m_bulkStatusSupported ? "supports" : "doesn't support" );
+	}
+	return m_bulkStatusSupported;
+}
+
+// Ask the gahp for the status of all of our submitted jobs with
+// BLAH_JOB_STATUS_BULK, at most BULK_STATUS_MAX_JOBS per request.
+// Jobs the gahp can't report on are told to check their own status.
+static const size_t BULK_STATUS_MAX_JOBS = 1000;
+
+INFNBatchResource::BatchStatusResult INFNBatchResource::StartBatchStatus()
+{
+	ASSERT( status_gahp );
+
+	if ( !BulkStatusActive() ) {
+		return BSR_DONE;
+	}
+
+	m_bulkStatusIds.clear();
+	m_bulkStatusJobs.clear();
+	m_bulkStatusNext = 0;
+	m_bulkStatusBegin = condor_gettimestamp_double();
+
+	BaseJob *base_job = NULL;
+	registeredJobs.Rewind();
+	while ( (base_job = registeredJobs.Next()) ) {
+		INFNBatchJob *job = dynamic_cast< INFNBatchJob * >( base_job );
+		ASSERT( job );
+		if ( job->WantsBulkStatus() ) {
+			m_bulkStatusIds.emplace_back( job->remoteJobId );
+			m_bulkStatusJobs[job->remoteJobId] = job->procID;
+		}
+	}
+
+	return FinishBatchStatus();
+}
+
+INFNBatchResource::BatchStatusResult INFNBatchResource::FinishBatchStatus()
+{
+	while ( m_bulkStatusNext < m_bulkStatusIds.size() ) {
+		size_t end = std::min( m_bulkStatusNext + BULK_STATUS_MAX_JOBS,
+		                       m_bulkStatusIds.size() );
+		std::vector<std::string> job_ids( m_bulkStatusIds.begin() + m_bulkStatusNext,
+		                                  m_bulkStatusIds.begin() + end );
+		std::map<std::string, ClassAd *> status_ads;
+
+		int rc = status_gahp->blah_job_status_bulk( job_ids, status_ads );
+		if ( rc == GAHPCLIENT_COMMAND_NOT_SUBMITTED ||
+			 rc == GAHPCLIENT_COMMAND_PENDING ) {
+			return BSR_PENDING;
+		}
+		if ( rc != 0 ) {
+			dprintf( D_ALWAYS, "Error doing bulk status query for %s: %s\n",
+					 ResourceName(), status_gahp->getErrorString() );
+		}
+
+		for ( const auto &job_id : job_ids ) {
+			BaseJob *base_job = NULL;
+			if ( BaseJob::JobsByProcId.lookup( m_bulkStatusJobs[job_id], base_job ) != 0 ) {
+				continue;
+			}
+			INFNBatchJob *job = dynamic_cast< INFNBatchJob * >( base_job );
+			ASSERT( job );
+			auto it = status_ads.find( job_id );
+			job->BulkStatusUpdate( job_id.c_str(),
+			                       it != status_ads.end() ? it->second : NULL );
+		}
+		for ( auto &entry : status_ads ) {
+			delete entry.second;
+		}
+
+		if ( rc != 0 ) {
+			m_bulkStatusIds.clear();
+			m_bulkStatusJobs.clear();
+			return BSR_ERROR;
+		}
+		m_bulkStatusNext = end;
+	}
+
+	m_bulkStatusCycles++;
+	m_bulkStatusLastJobs = (int)m_bulkStatusIds.size();
+	m_bulkStatusLastDuration = condor_gettimestamp_double() - m_bulkStatusBegin;
+	dprintf( D_FULLDEBUG, "Bulk status query for %s: %d jobs in %.3f seconds\n",
+			 ResourceName(), m_bulkStatusLastJobs, m_bulkStatusLastDuration );
+
+	m_bulkStatusIds.clear();
+	m_bulkStatusJobs.clear();
+	return BSR_DONE;
+}
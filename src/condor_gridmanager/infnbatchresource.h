@@ -63,6 +63,16 @@ public:
 	const char *RemoteHostname() { return m_remoteHostname.c_str(); };
 	bool GahpCanRefreshProxy();
 
+		// True if job status is being fetched for all jobs at once
+		// by the resource, rather than by each job.
+	bool BulkStatusActive();
+
+	BatchStatusResult StartBatchStatus();
+	BatchStatusResult FinishBatchStatus();
+	GahpClient * BatchGahp() { return status_gahp; }
+
+	GahpClient *status_gahp;
+
 private:
 	void DoPing(unsigned & ping_delay,
 				bool & ping_complete, 
@@ -74,6 +84,18 @@ private:
 	bool m_gahpCanRefreshProxy;
 	bool m_gahpRefreshProxyChecked;
 	std::string m_remoteHostname;
+
+	bool m_bulkStatusSupported;
+	bool m_bulkStatusChecked;
+		// blahp job ids of the current bulk status cycle, and the
+		// jobs they belong to
+	std::vector<std::string> m_bulkStatusIds;
+	std::map<std::string, PROC_ID> m_bulkStatusJobs;
+	size_t m_bulkStatusNext;
+	double m_bulkStatusBegin;
+	double m_bulkStatusLastDuration;
+	int m_bulkStatusLastJobs;
+	int m_bulkStatusCycles;
 };    
   
 #endif
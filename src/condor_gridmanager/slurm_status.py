@@ -500,17 +500,7 @@ def check_cache(jobid, cluster, recurse=True):
 
 job_status_re = re.compile(".*JobStatus=(\d+);.*")
 
-def main():
-    initLog()
-
-    # Accept the optional -w argument, but ignore it
-    if len(sys.argv) == 2:
-        jobid_arg = sys.argv[1]
-    elif len(sys.argv) == 3 and sys.argv[1] == "-w":
-        jobid_arg = sys.argv[2]
-    else:
-        print("1Usage: slurm_status.py slurm/<date>/<jobid>")
-        return 1
+def print_status(jobid_arg):
     jobid = jobid_arg.split("/")[-1]
     cluster = ""
     jobid_list = jobid.split("@")
@@ -545,6 +535,27 @@ def main():
             cache_contents.update(finished_job_stats)
             
         print("0%s" % job_dict_to_string(cache_contents))
+
+def main():
+    initLog()
+
+    # Accept the optional -w argument, but ignore it
+    args = sys.argv[1:]
+    if args and args[0] == "-w":
+        args = args[1:]
+    if not args:
+        print("1Usage: slurm_status.py slurm/<date>/<jobid> ...")
+        return 1
+
+    # With several job ids (as in a bulk status request), print one
+    # result line per job, in order.  They're all answered from the
+    # same cache fill, so SLURM is only queried once.
+    for jobid_arg in args:
+        try:
+            print_status(jobid_arg)
+        except Exception as e:
+            print("1ERROR: %s" % str(e).replace("\n", "\\n"))
+        sys.stdout.flush()
     return 0
 
 if __name__ == "__main__":
@@ -55,6 +55,10 @@ class KeyCacheEntry {
 	void                  setExpiration(int new_expiration);
 	void                  setLingerFlag(bool flag) { _lingering = flag; }
 	bool                  getLingerFlag() const { return _lingering; }
+	void                  setRestoredFlag(bool flag) { _restored = flag; }
+	bool                  getRestoredFlag() const { return _restored; }
+	int                   lifetimeExpiration() const { return _expiration; }
+	int                   leaseInterval() const { return _lease_interval; }
 
 	void                  renewLease();
  private:
@@ -71,6 +75,8 @@ class KeyCacheEntry {
 	time_t               _lease_expiration; // time of lease expiration
 	bool                 _lingering; // true if session only exists
 	                                 // to catch lingering communication
+	bool                 _restored;  // true if session was loaded from the
+	                                 // session cache file and not yet used
 };
 
 
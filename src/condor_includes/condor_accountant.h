@@ -30,6 +30,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 
 // this is the required minimum separation between two priorities for them
 // to be considered distinct values
@@ -77,7 +78,6 @@ public:
 
   float GetSlotWeight(ClassAd *candidate) const;
   void UpdatePriorities(); // update all the priorities
-  void UpdateOnePriority(int T, int TimePassed, float AgingFactor, const char *key, ClassAd *ad); // Help function for above
 
   void CheckMatches(ClassAdListDoesNotDeleteAds& ResourceList);  // Remove matches that are not claimed
 
@@ -104,6 +104,10 @@ public:
 
   bool UsingWeightedSlots() const;
 
+  // Compare the typed tables with the records in the log, for testing.
+  // Returns false and says why if they differ.
+  bool CheckTables(std::string& why);
+
   struct ci_less {
       bool operator()(const std::string& a, const std::string& b) const {
           return strcasecmp(a.c_str(), b.c_str()) < 0;
@@ -112,11 +116,81 @@ public:
 
 private:
 
+  //--------------------------------------------------------
+  // Typed copies of the accountant records
+  //--------------------------------------------------------
+
+  // The values in every customer and resource record are also kept here,
+  // indexed by name, so reading one doesn't mean building a key, finding
+  // the ClassAd and evaluating an attribute.  Every change is still
+  // written to AcctLog, which remains the persistent copy.
+
+  enum CustomerField {
+    CustPriority,
+    CustPriorityFactor,
+    CustCeiling,
+    CustResourcesUsed,
+    CustWeightedResourcesUsed,
+    CustHierWeightedResourcesUsed,
+    CustUnchargedTime,
+    CustWeightedUnchargedTime,
+    CustAccumulatedUsage,
+    CustWeightedAccumulatedUsage,
+    CustBeginUsageTime,
+    CustLastUsageTime,
+    NumCustomerFields
+  };
+
+  enum ResourceField {
+    ResStartTime,
+    ResSlotWeight,
+    ResNumCpMatches,
+    ResRemoteUser,          // kept in ResourceEntry::RemoteUser
+    ResMatchedLimits,       // kept in ResourceEntry::MatchedLimits
+    NumResourceFields
+  };
+
+  struct CustomerEntry {
+    CustomerEntry() : present(0) {}
+    unsigned int present;   // bit per field that has been set
+    double value[NumCustomerFields];
+  };
+
+  struct ResourceEntry {
+    ResourceEntry() : present(0), checked(0) {}
+    unsigned int present;   // bit per field that has been set
+    double value[NumResourceFields];
+    std::string RemoteUser;
+    std::string MatchedLimits;
+    unsigned int checked;   // last CheckMatches pass that saw this resource
+  };
+
+  typedef std::unordered_map<std::string, CustomerEntry> CustomerTable;
+  typedef std::unordered_map<std::string, ResourceEntry> ResourceTable;
+
+  void LoadTables();
+  void ReadTables(CustomerTable& customers, ResourceTable& resources);
+
+  bool GetCustomerInt(const std::string& CustomerName, CustomerField field, int& value);
+  bool GetCustomerFloat(const std::string& CustomerName, CustomerField field, float& value);
+  void SetCustomerInt(const std::string& CustomerName, CustomerField field, int value);
+  void SetCustomerFloat(const std::string& CustomerName, CustomerField field, float value);
+  void DeleteCustomer(const std::string& CustomerName);
+
+  bool GetResourceInt(const std::string& ResourceName, ResourceField field, int& value);
+  bool GetResourceFloat(const std::string& ResourceName, ResourceField field, float& value);
+  bool GetResourceString(const std::string& ResourceName, ResourceField field, std::string& value);
+  void SetResourceInt(const std::string& ResourceName, ResourceField field, int value);
+  void SetResourceFloat(const std::string& ResourceName, ResourceField field, float value);
+  void SetResourceString(const std::string& ResourceName, ResourceField field, const std::string& value);
+  void DeleteResource(const std::string& ResourceName);
+
   //--------------------------------------------------------
   // Private methods Methods
   //--------------------------------------------------------
   
   void RemoveMatch(const std::string& ResourceName, time_t T);
+  void UpdateOnePriority(int T, int TimePassed, float AgingFactor, const std::string& CustomerName, CustomerEntry& entry);
 
   void LoadLimits(ClassAdListDoesNotDeleteAds &resourceList);
   void ClearLimits();
@@ -153,6 +227,10 @@ private:
   ClassAdLog<std::string, ClassAd*> * AcctLog;
   int LastUpdateTime;
 
+  CustomerTable Customers;
+  ResourceTable Resources;
+  unsigned int CheckMatchesPass;
+
   HashTable<std::string, double> concurrencyLimits;
 
   GroupEntry* hgq_root_group;
@@ -179,9 +257,10 @@ private:
 
   bool DeleteClassAd(const std::string& Key);
 
-  void SetAttributeInt(const std::string& Key, const std::string& AttrName, int AttrValue);
-  void SetAttributeFloat(const std::string& Key, const std::string& AttrName, float AttrValue);
-  void SetAttributeString(const std::string& Key, const std::string& AttrName, const std::string& AttrValue);
+  // exists says the caller knows the record is already in the log
+  void SetAttributeInt(const std::string& Key, char const *AttrName, int AttrValue, bool exists = false);
+  double SetAttributeFloat(const std::string& Key, char const *AttrName, float AttrValue, bool exists = false);
+  void SetAttributeString(const std::string& Key, char const *AttrName, const std::string& AttrValue, bool exists = false);
 
   bool GetAttributeInt(const std::string& Key, const std::string& AttrName, int& AttrValue);
   bool GetAttributeFloat(const std::string& Key, const std::string& AttrName, float& AttrValue);
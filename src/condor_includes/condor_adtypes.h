@@ -51,6 +51,7 @@
 #define CLUSTER_ADTYPE	 		"Cluster"
 #define GRID_ADTYPE			"Grid"
 #define BOGUS_ADTYPE		"Bogus"
+#define CHANGELOG_ADTYPE		"CollectorChangelog"
 
 // Enumerated list of ad types (for the query object)
 enum AdTypes
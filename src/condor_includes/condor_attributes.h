@@ -38,6 +38,7 @@
 // all compilers!), but the bloat is in the text segment - shared on all processes!
 
 #define ATTR_ABSENT                    "Absent"
+#define ATTR_ACCEPT_BINARY_CLASSADS  "AcceptBinaryClassAds"
 #define ATTR_ACCT_GROUP  "AcctGroup"
 #define ATTR_ACCT_GROUP_USER  "AcctGroupUser"
 #define ATTR_ACCOUNTING_GROUP          "AccountingGroup"
@@ -88,6 +89,13 @@
 #define ATTR_CKPT_OPSYS  "CkptOpSys"
 #define ATTR_PAIRED_CLAIM_ID  "PairedClaimId"
 #define ATTR_CHECKPOINT_SIG  "CheckpointSig"
+#define ATTR_CHANGELOG_BYTES_SENT  "ChangelogBytesSent"
+#define ATTR_CHANGELOG_EPOCH  "ChangelogEpoch"
+#define ATTR_CHANGELOG_FULL_REFRESH  "ChangelogFullRefresh"
+#define ATTR_CHANGELOG_GENERATION  "ChangelogGeneration"
+#define ATTR_CHANGELOG_KEY  "ChangelogKey"
+#define ATTR_CHANGELOG_REMOVED  "ChangelogRemoved"
+#define ATTR_CHANGELOG_UNCHANGED_ADS  "ChangelogUnchangedAds"
 #define ATTR_CHILD_CLAIM_IDS "ChildClaimIds"
 #define ATTR_CLAIM_ID  "ClaimId"
 #define ATTR_CLAIM_IDS  "ClaimIds"
@@ -895,6 +903,7 @@
 #define ATTR_SEC_USER  "User"
 #define ATTR_SEC_MY_REMOTE_USER_NAME  "MyRemoteUserName"
 #define ATTR_SEC_NEW_SESSION  "NewSession"
+#define ATTR_SEC_NEGOTIATED_SESSION  "NegotiatedSession"
 #define ATTR_SEC_USE_SESSION  "UseSession"
 #define ATTR_SEC_COOKIE  "Cookie"
 extern const char ATTR_SEC_AUTHENTICATED_USER [];
@@ -1123,6 +1132,8 @@ extern const char ATTR_SEC_AUTHENTICATED_USER [];
 #define ATTR_TRANSFER_QUEUE_NUM_WAITING_TO_DOWNLOAD  "TransferQueueNumWaitingToDownload"
 #define ATTR_TRANSFER_QUEUE_UPLOAD_WAIT_TIME  "TransferQueueUploadWaitTime"
 #define ATTR_TRANSFER_QUEUE_DOWNLOAD_WAIT_TIME  "TransferQueueDownloadWaitTime"
+#define ATTR_TRANSFER_QUEUE_MAX_USER_BANDWIDTH_SHARE  "TransferQueueMaxUserBandwidthShare"
+#define ATTR_TRANSFER_QUEUE_NUM_USERS_OVER_BANDWIDTH_SHARE  "TransferQueueNumUsersOverBandwidthShare"
 #define ATTR_SANDBOX_SIZE "SandboxSize"
 #define ATTR_FILE_TRANSFER_UPLOAD_BYTES_PER_SECOND "FileTransferUploadBytesPerSecond"
 #define ATTR_FILE_TRANSFER_DOWNLOAD_BYTES_PER_SECOND "FileTransferDownloadBytesPerSecond"
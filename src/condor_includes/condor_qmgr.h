@@ -186,6 +186,13 @@ int SetAttributeExprByConstraint(const char *constraint, const char *attr,
 	@return -1 on failure; 0 on success
 */
 int SetAttribute(int cluster, int proc, const char *attr, const char *value, SetAttributeFlags_t flags=0, CondorError *err=nullptr );
+/** Set several attributes of one job in a single message; each pair is
+	(attr, value) and is applied as by SetAttribute, in order, stopping at
+	the first failure.  Only for use with a remote schedd that advertises
+	the SetAttributes capability.
+	@return -1 on failure; 0 on success
+*/
+int SetAttributes(int cluster, int proc, const std::vector<std::pair<std::string, std::string> > & attrs, SetAttributeFlags_t flags=0 );
 
 /** Set attr = value for job with specified cluster and proc.  The value
 	will be a ClassAd integer literal.
@@ -82,6 +82,11 @@ public:
 	static std::string m_tag_token_owner;
 	static HashTable<MyString, MyString> command_map;
 	static int sec_man_ref_count;
+
+	// Incoming sessions restored from the session cache file at startup,
+	// and how many of those a peer has since resumed (i.e. handshakes avoided).
+	static int m_restored_session_count;
+	static int m_resumed_session_count;
 	static std::set<std::string> m_not_my_family;
 
 	// Manage the pool password
@@ -281,6 +286,17 @@ public:
 		// that was originally created with no expiration time.
 	bool SetSessionExpiration(char const *session_id,time_t expiration_time);
 
+		// Save the incoming negotiated sessions in our session cache to
+		// an encrypted file, or restore them from one, so that peers can
+		// keep using their sessions across a restart of this daemon
+		// instead of authenticating again.  See SEC_SESSION_CACHE_FILE.
+	bool SaveSessionCache(const char *fname, const char *key_fname);
+	bool RestoreSessionCache(const char *fname, const char *key_fname);
+
+		// Called when a peer resumes a session; counts the first use
+		// of each session that was restored from the session cache file.
+	static void noteSessionResumed(KeyCacheEntry *session);
+
 		// This is used to mark a session as being in a state where it is
 		// just hanging around for a short period in case some pending
 		// communication is still in flight (not essential communication,
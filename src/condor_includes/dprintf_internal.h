@@ -45,6 +45,7 @@ typedef struct DebugHeaderInfo {
    int        backtrace_id;  // per-process unique identifier for this backtrace
    int        num_backtrace; // number of valid entries in the backtrace array
    void **    backtrace;     // if non null, pointer to an array of void* pointers containing the backtrace (set when D_BACKTRACE is specified)
+   int        tid;           // if non zero, thread id of the caller (set when the message was queued for the async writer)
 }  DebugHeaderInfo;
 
 typedef void (*DprintfFuncPtr)(int, int, DebugHeaderInfo &, const char*, DebugFileInfo*);
@@ -137,6 +138,13 @@ struct dprintf_output_settings
 
 void dprintf_set_outputs(const struct dprintf_output_settings *p_info, int c_info);
 
+// start or stop handing dprintf messages to a writer thread through a queue
+// of queue_size bytes.  messages that don't fit in the queue are dropped.
+void dprintf_set_async(bool enable, long long queue_size);
+
+// for tests: while hold is true, the writer thread leaves messages in the queue
+void dprintf_async_hold(bool hold);
+
 void * dprintf_get_onerror_data();
 
 const char* _format_global_header(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info);
@@ -44,6 +44,8 @@ const condor_mode_t NULL_FILE_PERMISSIONS = (condor_mode_t)0;
 
 #include "proc.h"
 
+class BinaryClassAdNames; // in classad_binary.h
+
 /** @name Special Types
     We need to define a special code() method for certain integer arguments.
     To take advantage of overloading, we need make these arguments have a
@@ -504,6 +506,13 @@ public:
 	/// Set the peer's version.
 	void set_peer_version(CondorVersionInfo const *version);
 
+	/// The attribute-name tokens used by binary ClassAds on this
+	/// connection (see classad_binary.h), created on first use.
+	BinaryClassAdNames & binary_classad_names();
+
+	/// Forget them, as when the connection is closed.
+	void clear_binary_classad_names();
+
 	/** Get this stream's type.
         @return the type of this stream
     */
@@ -587,6 +596,7 @@ protected:
 	int decrypt_buf_len;
 	char *m_peer_description_str;
 	CondorVersionInfo *m_peer_version;
+	BinaryClassAdNames *m_binary_classad_names;
 
 	time_t m_deadline_time;
 	static int timeout_multiplier;
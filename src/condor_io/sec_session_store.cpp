@@ -0,0 +1,334 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Persistence of incoming security sessions across daemon restarts.
+//
+// A daemon that restarts normally forgets every session its peers
+// negotiated with it, so each of them must authenticate again the next
+// time it connects.  For a collector with tens of thousands of startds,
+// that is a very expensive storm of SSL/IDTOKENS handshakes.  When
+// SEC_SESSION_CACHE_FILE is configured, the incoming negotiated sessions
+// are written to that file at shutdown (and periodically), and restored
+// at startup; peers then resume their existing sessions as if nothing
+// had happened.
+//
+// The file holds session keys, so it is written owner-only and its
+// contents are encrypted with AES-256-GCM under a random key kept in a
+// separate owner-only file (SEC_SESSION_CACHE_KEY_FILE).
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_attributes.h"
+#include "condor_secman.h"
+#include "KeyCache.h"
+#include "CryptKey.h"
+#include "condor_crypt.h"
+#include "condor_base64.h"
+#include "secure_file.h"
+#include "classad/classad_distribution.h"
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+int SecMan::m_restored_session_count = 0;
+int SecMan::m_resumed_session_count = 0;
+
+static const char SESSION_STORE_MAGIC[] = "HTCSESS1";
+static const int SESSION_STORE_MAGIC_LEN = 8;
+static const int SESSION_STORE_KEY_LEN = 32;
+static const int SESSION_STORE_IV_LEN = 12;
+static const int SESSION_STORE_TAG_LEN = 16;
+
+// attribute names used only within the session store file
+#define STORE_ATTR_KEY_DATA    "KeyData"
+#define STORE_ATTR_KEY_PROTO   "KeyProtocol"
+#define STORE_ATTR_KEY_DUR     "KeyDuration"
+#define STORE_ATTR_EXPIRATION  "Expiration"
+#define STORE_ATTR_LEASE       "LeaseInterval"
+#define STORE_ATTR_POLICY      "Policy"
+
+// Load the store encryption key, creating it if it does not exist yet
+// (but only when we are about to write).
+static bool
+get_store_key(const char *key_fname, bool create, std::string &key)
+{
+	void *buf = NULL;
+	size_t len = 0;
+	if (read_secure_file(key_fname, &buf, &len, true)) {
+		if (len == SESSION_STORE_KEY_LEN) {
+			key.assign((const char *)buf, len);
+			free(buf);
+			return true;
+		}
+		free(buf);
+		dprintf(D_ALWAYS, "SECMAN: session cache key %s has the wrong length (%d), ignoring it.\n",
+			key_fname, (int)len);
+	}
+	if ( ! create) {
+		return false;
+	}
+
+	unsigned char *keybuf = Condor_Crypt_Base::randomKey(SESSION_STORE_KEY_LEN);
+	if ( ! keybuf) {
+		return false;
+	}
+	key.assign((const char *)keybuf, SESSION_STORE_KEY_LEN);
+	free(keybuf);
+	if ( ! write_secure_file(key_fname, key.data(), key.size(), true)) {
+		dprintf(D_ALWAYS, "SECMAN: failed to write session cache key %s.\n", key_fname);
+		return false;
+	}
+	return true;
+}
+
+static bool
+seal_session_store(const std::string &key, const std::string &plain, std::string &sealed)
+{
+	unsigned char iv[SESSION_STORE_IV_LEN];
+	unsigned char tag[SESSION_STORE_TAG_LEN];
+	if (RAND_bytes(iv, sizeof(iv)) != 1) {
+		return false;
+	}
+
+	std::vector<unsigned char> cipher(plain.size() + SESSION_STORE_TAG_LEN);
+	int len = 0, total = 0;
+	bool ok = false;
+	EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+	if (ctx &&
+		EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, NULL, NULL) == 1 &&
+		EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, SESSION_STORE_IV_LEN, NULL) == 1 &&
+		EVP_EncryptInit_ex(ctx, NULL, NULL, (const unsigned char *)key.data(), iv) == 1 &&
+		EVP_EncryptUpdate(ctx, cipher.data(), &len, (const unsigned char *)plain.data(), (int)plain.size()) == 1)
+	{
+		total = len;
+		if (EVP_EncryptFinal_ex(ctx, cipher.data() + total, &len) == 1 &&
+			EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, SESSION_STORE_TAG_LEN, tag) == 1)
+		{
+			total += len;
+			ok = true;
+		}
+	}
+	if (ctx) { EVP_CIPHER_CTX_free(ctx); }
+	if ( ! ok) {
+		return false;
+	}
+
+	sealed.assign(SESSION_STORE_MAGIC, SESSION_STORE_MAGIC_LEN);
+	sealed.append((const char *)iv, sizeof(iv));
+	sealed.append((const char *)tag, sizeof(tag));
+	sealed.append((const char *)cipher.data(), total);
+	return true;
+}
+
+static bool
+open_session_store(const std::string &key, const unsigned char *data, size_t len, std::string &plain)
+{
+	const size_t header_len = SESSION_STORE_MAGIC_LEN + SESSION_STORE_IV_LEN + SESSION_STORE_TAG_LEN;
+	if (len < header_len || memcmp(data, SESSION_STORE_MAGIC, SESSION_STORE_MAGIC_LEN) != 0) {
+		return false;
+	}
+	const unsigned char *iv = data + SESSION_STORE_MAGIC_LEN;
+	const unsigned char *tag = iv + SESSION_STORE_IV_LEN;
+	const unsigned char *cipher = tag + SESSION_STORE_TAG_LEN;
+	int cipher_len = (int)(len - header_len);
+
+	std::vector<unsigned char> out(cipher_len + SESSION_STORE_TAG_LEN);
+	int outlen = 0, total = 0;
+	bool ok = false;
+	EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+	if (ctx &&
+		EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, NULL, NULL) == 1 &&
+		EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, SESSION_STORE_IV_LEN, NULL) == 1 &&
+		EVP_DecryptInit_ex(ctx, NULL, NULL, (const unsigned char *)key.data(), iv) == 1 &&
+		EVP_DecryptUpdate(ctx, out.data(), &outlen, cipher, cipher_len) == 1)
+	{
+		total = outlen;
+		if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, SESSION_STORE_TAG_LEN, (void *)tag) == 1 &&
+			EVP_DecryptFinal_ex(ctx, out.data() + total, &outlen) == 1)
+		{
+			total += outlen;
+			ok = true;
+		}
+	}
+	if (ctx) { EVP_CIPHER_CTX_free(ctx); }
+	if (ok) {
+		plain.assign((const char *)out.data(), total);
+	}
+	return ok;
+}
+
+bool
+SecMan::SaveSessionCache(const char *fname, const char *key_fname)
+{
+	if ( ! fname || ! key_fname || ! session_cache) {
+		return false;
+	}
+
+	std::string key;
+	if ( ! get_store_key(key_fname, true, key)) {
+		return false;
+	}
+
+	time_t now = time(NULL);
+	int saved = 0;
+	std::string plain;
+	classad::ClassAdUnParser unparser;
+	unparser.SetOldClassAd(false);
+
+	KeyCacheEntry *entry = NULL;
+	session_cache->key_table->startIterations();
+	while (session_cache->key_table->iterate(entry)) {
+			// Only incoming sessions that were negotiated with a peer
+			// are worth keeping.  Outgoing sessions are keyed by our
+			// peer's address and non-negotiated sessions (family,
+			// claim) are recreated by their owners on startup.
+		ClassAd *policy = entry->policy();
+		bool negotiated = false;
+		if (entry->addr() || ! entry->key() || ! policy || entry->getLingerFlag() ||
+			! policy->LookupBool(ATTR_SEC_NEGOTIATED_SESSION, negotiated) || ! negotiated) {
+			continue;
+		}
+		int expiration = entry->expiration();
+		if (expiration && expiration <= now) {
+			continue;
+		}
+
+		KeyInfo *ki = entry->key();
+		char *keydata = condor_base64_encode(ki->getKeyData(), ki->getKeyLength(), false);
+		if ( ! keydata) {
+			continue;
+		}
+
+		classad::ClassAd rec;
+		rec.InsertAttr(ATTR_SEC_SID, entry->id());
+		rec.InsertAttr(STORE_ATTR_KEY_DATA, keydata);
+		rec.InsertAttr(STORE_ATTR_KEY_PROTO, (int)ki->getProtocol());
+		rec.InsertAttr(STORE_ATTR_KEY_DUR, ki->getDuration());
+		rec.InsertAttr(STORE_ATTR_EXPIRATION, entry->lifetimeExpiration());
+		rec.InsertAttr(STORE_ATTR_LEASE, entry->leaseInterval());
+		rec.Insert(STORE_ATTR_POLICY, new ClassAd(*policy));
+		free(keydata);
+
+		unparser.Unparse(plain, &rec);
+		plain += "\n";
+		saved++;
+	}
+
+	std::string sealed;
+	if ( ! seal_session_store(key, plain, sealed)) {
+		dprintf(D_ALWAYS, "SECMAN: failed to encrypt session cache for %s.\n", fname);
+		return false;
+	}
+	if ( ! replace_secure_file(fname, ".tmp", sealed.data(), sealed.size(), true)) {
+		dprintf(D_ALWAYS, "SECMAN: failed to write session cache %s.\n", fname);
+		return false;
+	}
+	dprintf(D_SECURITY, "SECMAN: saved %d incoming security sessions to %s.\n", saved, fname);
+	return true;
+}
+
+bool
+SecMan::RestoreSessionCache(const char *fname, const char *key_fname)
+{
+	if ( ! fname || ! key_fname || ! session_cache) {
+		return false;
+	}
+
+	void *buf = NULL;
+	size_t len = 0;
+	if ( ! read_secure_file(fname, &buf, &len, true)) {
+		dprintf(D_SECURITY, "SECMAN: no saved session cache in %s.\n", fname);
+		return false;
+	}
+
+	std::string key;
+	std::string plain;
+	bool opened = get_store_key(key_fname, false, key) &&
+		open_session_store(key, (const unsigned char *)buf, len, plain);
+	free(buf);
+	if ( ! opened) {
+		dprintf(D_ALWAYS, "SECMAN: unable to decrypt session cache %s, ignoring it.\n", fname);
+		return false;
+	}
+
+	time_t now = time(NULL);
+	int restored = 0, expired = 0;
+	classad::ClassAdParser parser;
+	size_t pos = 0;
+	while (pos < plain.size()) {
+		size_t eol = plain.find('\n', pos);
+		if (eol == std::string::npos) { eol = plain.size(); }
+		std::string line = plain.substr(pos, eol - pos);
+		pos = eol + 1;
+		if (line.empty()) { continue; }
+
+		classad::ClassAd rec;
+		std::string sid, keydata;
+		int proto = 0, key_duration = 0, expiration = 0, lease = 0;
+		classad::ExprTree *policy_expr = NULL;
+		if ( ! parser.ParseClassAd(line, rec, true) ||
+			! rec.EvaluateAttrString(ATTR_SEC_SID, sid) ||
+			! rec.EvaluateAttrString(STORE_ATTR_KEY_DATA, keydata) ||
+			! rec.EvaluateAttrInt(STORE_ATTR_KEY_PROTO, proto) ||
+			! (policy_expr = rec.Lookup(STORE_ATTR_POLICY)) ||
+			policy_expr->GetKind() != classad::ExprTree::CLASSAD_NODE) {
+			dprintf(D_ALWAYS, "SECMAN: skipping malformed record in session cache %s.\n", fname);
+			continue;
+		}
+		rec.EvaluateAttrInt(STORE_ATTR_KEY_DUR, key_duration);
+		rec.EvaluateAttrInt(STORE_ATTR_EXPIRATION, expiration);
+		rec.EvaluateAttrInt(STORE_ATTR_LEASE, lease);
+		if (expiration && expiration <= now) {
+			expired++;
+			continue;
+		}
+
+		unsigned char *keybuf = NULL;
+		int keylen = 0;
+		condor_base64_decode(keydata.c_str(), &keybuf, &keylen, false);
+		if ( ! keybuf || keylen <= 0) {
+			free(keybuf);
+			continue;
+		}
+		KeyInfo ki(keybuf, keylen, (Protocol)proto, key_duration);
+		free(keybuf);
+
+		ClassAd policy(*static_cast<classad::ClassAd *>(policy_expr));
+		KeyCacheEntry entry(sid.c_str(), NULL, &ki, &policy, expiration, lease);
+		entry.setRestoredFlag(true);
+		if (session_cache->insert(entry)) {
+			restored++;
+		}
+	}
+
+	m_restored_session_count += restored;
+	dprintf(D_ALWAYS, "SECMAN: restored %d incoming security sessions from %s (%d had expired).\n",
+		restored, fname, expired);
+	return true;
+}
+
+void
+SecMan::noteSessionResumed(KeyCacheEntry *session)
+{
+	if (session && session->getRestoredFlag()) {
+		session->setRestoredFlag(false);
+		m_resumed_session_count++;
+	}
+}
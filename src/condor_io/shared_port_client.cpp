@@ -23,8 +23,11 @@
 #include "subsystem_info.h"
 #include "shared_port_client.h"
 #include "shared_port_endpoint.h"
+#include "utc_time.h"
 
 #include <sstream>
+#include <deque>
+#include <map>
 
 // Initialize static class members
 unsigned int SharedPortClient::m_currentPendingPassSocketCalls = 0;
@@ -32,6 +35,14 @@ unsigned int SharedPortClient::m_maxPendingPassSocketCalls = 0;
 unsigned int SharedPortClient::m_successPassSocketCalls = 0;
 unsigned int SharedPortClient::m_failPassSocketCalls = 0;
 unsigned int SharedPortClient::m_wouldBlockPassSocketCalls = 0;
+unsigned int SharedPortClient::m_currentQueuedPassSocketCalls = 0;
+unsigned int SharedPortClient::m_maxQueuedPassSocketCalls = 0;
+unsigned int SharedPortClient::m_queuedPassSocketCalls = 0;
+int SharedPortClient::m_maxQueuedPerTarget = 0;
+
+static const int pass_socket_latency_levels[] = { 1, 10, 100, 1000, 10000 };
+stats_histogram<int> SharedPortClient::m_passSocketLatency(
+	pass_socket_latency_levels, COUNTOF(pass_socket_latency_levels) );
 
 
 #ifdef HAVE_SCM_RIGHTS_PASSFD
@@ -46,12 +57,15 @@ class SharedPortState: Service {
 public:
 	SharedPortState(ReliSock *sock, const char *shared_port_id, const char *requested_by, bool non_blocking)
 		: m_sock(sock),
-		  m_shared_port_id(shared_port_id),
+		  m_shared_port_id(shared_port_id ? shared_port_id : ""),
 		  m_requested_by(requested_by ? requested_by : ""),
 		  m_sock_name("UNKNOWN"),
 		  m_state(UNBOUND),
 		  m_non_blocking(non_blocking),
-		  m_dealloc_sock(false)
+		  m_dealloc_sock(false),
+		  m_was_busy(false),
+		  m_retrying(false),
+		  m_begin(condor_gettimestamp_double())
 	{
 		// Ctor
 
@@ -74,20 +88,33 @@ public:
 		}
 	}
 
-	enum HandlerResult {FAILED, DONE, CONTINUE, WAIT};
+	enum HandlerResult {FAILED, DONE, CONTINUE, WAIT, BUSY};
 
 	int Handle(Stream *s=NULL);
 
+		// Called by SharedPortBusyTarget when it is this request's
+		// turn to try connecting to the target again.
+	void Retry();
+		// True if the request has waited for the target as long as it may.
+	bool Expired() const;
+		// Give up on a request that is waiting for the target.
+	void Abandon();
+
 private:
 
 	enum SPState {INVALID, UNBOUND, SEND_HEADER, SEND_FD, RECV_RESP};
 	ReliSock *m_sock;
-	const char * m_shared_port_id;
+	std::string m_shared_port_id;
 	std::string m_requested_by;
 	std::string m_sock_name;
 	SPState m_state;
 	bool m_non_blocking;
 	bool m_dealloc_sock;
+	bool m_was_busy;
+	bool m_retrying;
+	double m_begin;
+
+	bool WaitForTarget();
 
 	HandlerResult HandleUnbound(Stream *&s);
 	HandlerResult HandleHeader(Stream *&s);
@@ -95,6 +122,40 @@ private:
 	HandlerResult HandleResp(Stream *&s);
 };
 
+	// Requests waiting for a target daemon whose listen queue was full,
+	// in the order they arrived.  A timer retries the oldest one until
+	// the target accepts connections again, and then the rest.
+class SharedPortBusyTarget: Service {
+
+public:
+	static SharedPortBusyTarget *Find(const std::string &shared_port_id);
+	static SharedPortBusyTarget *FindOrCreate(const std::string &shared_port_id);
+
+		// A request to the target finished, so it may have room again.
+	static void Kick(const std::string &shared_port_id);
+
+	void Enqueue(SharedPortState *state, bool at_front);
+	size_t Length() const { return m_queue.size(); }
+
+private:
+	SharedPortBusyTarget(const std::string &shared_port_id)
+		: m_shared_port_id(shared_port_id), m_retry_tid(-1) {}
+
+	void Retry();
+	void ScheduleRetry(unsigned delay);
+
+	std::string m_shared_port_id;
+	std::deque<SharedPortState *> m_queue;
+	int m_retry_tid;
+
+	static std::map<std::string, SharedPortBusyTarget *> m_targets;
+};
+
+std::map<std::string, SharedPortBusyTarget *> SharedPortBusyTarget::m_targets;
+
+	// How long a request without a deadline may wait for a busy target.
+static const int SHARED_PORT_BUSY_WAIT_MAX = 20;
+
 #endif // of HAVE_SCM_RIGHTS_PASSFD
 
 bool
@@ -376,6 +437,16 @@ int
 SharedPortState::Handle(Stream *s)
 {
 	HandlerResult result = CONTINUE;
+
+		// Don't jump ahead of requests already waiting for this target.
+	if (m_state == UNBOUND && m_non_blocking && !m_retrying &&
+		SharedPortBusyTarget::Find(m_shared_port_id))
+	{
+		SharedPortClient::m_wouldBlockPassSocketCalls++;
+		m_was_busy = true;
+		result = BUSY;
+	}
+
 	while (result == CONTINUE || (!m_non_blocking && (result == WAIT))) {
 		switch (m_state)
 		{
@@ -413,9 +484,20 @@ SharedPortState::Handle(Stream *s)
 		}
 	}
 
+	if (result == BUSY) {
+		if (WaitForTarget()) {
+			m_dealloc_sock = true;
+			return KEEP_STREAM;
+		}
+		result = FAILED;
+	}
+
 	// Update result statistics
 	if (result == DONE) {
 		SharedPortClient::m_successPassSocketCalls++;
+		SharedPortClient::m_passSocketLatency.Add(
+			(int)((condor_gettimestamp_double() - m_begin) * 1000));
+		SharedPortBusyTarget::Kick(m_shared_port_id);
 	}
 	if (result == FAILED) {
 		SharedPortClient::m_failPassSocketCalls++;
@@ -446,11 +528,11 @@ SharedPortState::Handle(Stream *s)
 SharedPortState::HandlerResult
 SharedPortState::HandleUnbound(Stream *&s)
 {
-	if( !SharedPortClient::SharedPortIdIsValid(m_shared_port_id) ) {
+	if( !SharedPortClient::SharedPortIdIsValid(m_shared_port_id.c_str()) ) {
 			dprintf(D_ALWAYS,
 							"ERROR: SharedPortClient: refusing to connect to shared port"
 							"%s, because specified id is illegal! (%s)\n",
-							m_requested_by.c_str(), m_shared_port_id );
+							m_requested_by.c_str(), m_shared_port_id.c_str() );
 			return FAILED;
 	}
 
@@ -467,8 +549,7 @@ SharedPortState::HandleUnbound(Stream *&s)
 	ss.clear();
 	ss << alt_sock_name << DIR_DELIM_CHAR << m_shared_port_id;
 	alt_sock_name = ss.str();
-	m_shared_port_id = NULL;
-	
+
 
 	if( !m_requested_by.size() ) {
 		formatstr(m_requested_by,
@@ -601,10 +682,24 @@ SharedPortState::HandleUnbound(Stream *&s)
 		if ( connect_errno == EAGAIN || connect_errno == EWOULDBLOCK ||
 			 connect_errno == ETIMEDOUT || connect_errno == ECONNREFUSED )
 		{
-			SharedPortClient::m_wouldBlockPassSocketCalls++;
+			if ( !m_was_busy ) {
+				SharedPortClient::m_wouldBlockPassSocketCalls++;
+			}
+			m_was_busy = true;
 			server_busy = true;
 		}
 
+			// If the caller can't block, wait for the target to have room,
+			// rather than dropping the connection right away.
+		if ( server_busy && m_non_blocking &&
+			 SharedPortClient::m_maxQueuedPerTarget > 0 && !Expired() )
+		{
+			dprintf(D_FULLDEBUG, "SharedPortClient: %s is busy, will retry request%s\n",
+				m_sock_name.c_str(), m_requested_by.c_str());
+			delete named_sock;
+			return BUSY;
+		}
+
 		if( has_socket && has_alt_socket ) {
 			dprintf( D_ALWAYS, "SharedPortServer:%s failed to connect %s%s: "
 				"primary (%s): %s (%d); alt (%s): %s (%d)\n",
@@ -819,5 +914,159 @@ SharedPortState::HandleResp(Stream *&)
 
 	return DONE;
 }
+
+bool
+SharedPortState::WaitForTarget()
+{
+	if ( m_retrying ) {
+			// The target is still busy, so keep our place at the front.
+		SharedPortBusyTarget::FindOrCreate(m_shared_port_id)->Enqueue(this, true);
+		return true;
+	}
+
+	SharedPortBusyTarget *target = SharedPortBusyTarget::Find(m_shared_port_id);
+	int max_queued = SharedPortClient::m_maxQueuedPerTarget;
+	if ( max_queued <= 0 || Expired() ||
+		 (target && target->Length() >= (size_t)max_queued) )
+	{
+		dprintf(D_ALWAYS, "SharedPortServer: server was busy, failed to connect to %s%s "
+			"(%d requests already waiting for it)\n",
+			m_shared_port_id.c_str(),
+			m_requested_by.c_str(),
+			target ? (int)target->Length() : 0);
+		return false;
+	}
+
+	SharedPortBusyTarget::FindOrCreate(m_shared_port_id)->Enqueue(this, false);
+	SharedPortClient::m_queuedPassSocketCalls++;
+	return true;
+}
+
+void
+SharedPortState::Retry()
+{
+	m_retrying = true;
+	Handle();
+}
+
+bool
+SharedPortState::Expired() const
+{
+	time_t deadline = m_sock->get_deadline();
+	if ( !deadline ) {
+		deadline = (time_t)m_begin + SHARED_PORT_BUSY_WAIT_MAX;
+	}
+	return time(NULL) >= deadline;
+}
+
+void
+SharedPortState::Abandon()
+{
+	dprintf(D_ALWAYS, "SharedPortServer: gave up waiting for busy %s%s after %.1f seconds\n",
+		m_shared_port_id.c_str(),
+		m_requested_by.c_str(),
+		condor_gettimestamp_double() - m_begin);
+	SharedPortClient::m_failPassSocketCalls++;
+	delete this;
+}
+
+SharedPortBusyTarget *
+SharedPortBusyTarget::Find(const std::string &shared_port_id)
+{
+	auto it = m_targets.find(shared_port_id);
+	return it == m_targets.end() ? NULL : it->second;
+}
+
+SharedPortBusyTarget *
+SharedPortBusyTarget::FindOrCreate(const std::string &shared_port_id)
+{
+	SharedPortBusyTarget *target = Find(shared_port_id);
+	if ( !target ) {
+		target = new SharedPortBusyTarget(shared_port_id);
+		m_targets[shared_port_id] = target;
+	}
+	return target;
+}
+
+void
+SharedPortBusyTarget::Kick(const std::string &shared_port_id)
+{
+	SharedPortBusyTarget *target = Find(shared_port_id);
+	if ( target && target->m_retry_tid != -1 ) {
+		daemonCore->Reset_Timer(target->m_retry_tid, 0);
+	}
+}
+
+void
+SharedPortBusyTarget::Enqueue(SharedPortState *state, bool at_front)
+{
+	if ( at_front ) {
+		m_queue.push_front(state);
+	} else {
+		m_queue.push_back(state);
+	}
+
+	SharedPortClient::m_currentQueuedPassSocketCalls++;
+	if ( SharedPortClient::m_maxQueuedPassSocketCalls <
+		 SharedPortClient::m_currentQueuedPassSocketCalls )
+	{
+		SharedPortClient::m_maxQueuedPassSocketCalls =
+			SharedPortClient::m_currentQueuedPassSocketCalls;
+	}
+
+	if ( m_retry_tid == -1 ) {
+		ScheduleRetry(1);
+	}
+}
+
+void
+SharedPortBusyTarget::ScheduleRetry(unsigned delay)
+{
+	if ( m_retry_tid == -1 ) {
+		m_retry_tid = daemonCore->Register_Timer(
+			delay,
+			(TimerHandlercpp)&SharedPortBusyTarget::Retry,
+			"SharedPortBusyTarget::Retry",
+			this );
+	} else {
+		daemonCore->Reset_Timer(m_retry_tid, delay);
+	}
+}
+
+void
+SharedPortBusyTarget::Retry()
+{
+	m_retry_tid = -1;
+
+	while ( !m_queue.empty() ) {
+		SharedPortState *state = m_queue.front();
+		m_queue.pop_front();
+		SharedPortClient::m_currentQueuedPassSocketCalls--;
+
+		if ( state->Expired() ) {
+			state->Abandon();
+			continue;
+		}
+
+			// If the target is still busy, the request goes back to
+			// the front of the queue and we try again later.
+		size_t waiting = m_queue.size();
+		state->Retry();
+		if ( m_queue.size() > waiting ) {
+			break;
+		}
+	}
+
+	if ( m_queue.empty() ) {
+		if ( m_retry_tid != -1 ) {
+			daemonCore->Cancel_Timer(m_retry_tid);
+		}
+		m_targets.erase(m_shared_port_id);
+		delete this;
+		return;
+	}
+
+	ScheduleRetry(1);
+}
 #endif
 
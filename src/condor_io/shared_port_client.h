@@ -22,12 +22,15 @@
 
 #include "MyString.h"
 #include "reli_sock.h"
+#include "generic_stats.h"
 
 class SharedPortState;
+class SharedPortBusyTarget;
 
 class SharedPortClient {
 
 friend class SharedPortState;
+friend class SharedPortBusyTarget;
 
  public:
 	bool sendSharedPortID(char const *shared_port_id,Sock *sock);
@@ -47,6 +50,21 @@ friend class SharedPortState;
 		{return m_failPassSocketCalls;}
 	unsigned int get_wouldBlockPassSocketCalls() 
 		{return m_wouldBlockPassSocketCalls;}
+	unsigned int get_currentQueuedPassSocketCalls()
+		{return m_currentQueuedPassSocketCalls;}
+	unsigned int get_maxQueuedPassSocketCalls()
+		{return m_maxQueuedPassSocketCalls;}
+	unsigned int get_queuedPassSocketCalls()
+		{return m_queuedPassSocketCalls;}
+	const stats_histogram<int> & get_passSocketLatency()
+		{return m_passSocketLatency;}
+
+	// When a non-blocking PassSocket() finds the target daemon's listen
+	// queue full, it waits its turn behind other requests for the same
+	// target, as long as fewer than this many are already waiting.
+	// 0 means fail such requests right away.
+	static void set_maxQueuedPerTarget(int max_queued)
+		{m_maxQueuedPerTarget = max_queued;}
 
  private:
 	MyString myName();
@@ -64,6 +82,12 @@ friend class SharedPortState;
 	static unsigned int m_successPassSocketCalls;
 	static unsigned int m_failPassSocketCalls;
 	static unsigned int m_wouldBlockPassSocketCalls;
+	static unsigned int m_currentQueuedPassSocketCalls;
+	static unsigned int m_maxQueuedPassSocketCalls;
+	static unsigned int m_queuedPassSocketCalls;
+	static int m_maxQueuedPerTarget;
+		// milliseconds from PassSocket() until the socket was handed off
+	static stats_histogram<int> m_passSocketLatency;
 };
 
 #endif
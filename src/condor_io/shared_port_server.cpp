@@ -95,6 +95,9 @@ SharedPortServer::InitAndReconfig() {
 	forker.Initialize();
 	int max_workers = param_integer("SHARED_PORT_MAX_WORKERS",50,0);
 	forker.setMaxWorkers( max_workers );
+
+	SharedPortClient::set_maxQueuedPerTarget(
+		param_integer("SHARED_PORT_MAX_QUEUED_PER_TARGET",500,0) );
 }
 
 void
@@ -151,6 +154,11 @@ SharedPortServer::PublishAddress()
 	ad.Assign("RequestsSucceeded",m_shared_port_client.get_successPassSocketCalls());
 	ad.Assign("RequestsFailed",m_shared_port_client.get_failPassSocketCalls());
 	ad.Assign("RequestsBlocked",m_shared_port_client.get_wouldBlockPassSocketCalls());
+	ad.Assign("RequestsQueuedCurrent",m_shared_port_client.get_currentQueuedPassSocketCalls());
+	ad.Assign("RequestsQueuedPeak",m_shared_port_client.get_maxQueuedPassSocketCalls());
+	ad.Assign("RequestsQueued",m_shared_port_client.get_queuedPassSocketCalls());
+		// counts of handoffs taking <1ms, <10ms, <100ms, <1s, <10s, and longer
+	m_shared_port_client.get_passSocketLatency().Publish(ad,"RequestsLatencyHistogram",0);
 	ad.Assign("ForkedChildrenCurrent",forker.getNumWorkers());
 	ad.Assign("ForkedChildrenPeak",forker.getPeakWorkers());
 
@@ -1891,6 +1891,9 @@ int Sock::close()
 	setFullyQualifiedUser(NULL);
 	setTriedAuthentication(false);
 
+	// and the names the next peer has yet to learn
+	clear_binary_classad_names();
+
 	return TRUE;
 }
 
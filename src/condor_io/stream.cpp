@@ -25,6 +25,7 @@
 #include "condor_debug.h"
 #include "MyString.h"
 #include "utilfns.h"
+#include "classad_binary.h"
 
 // initialize static data members
 int Stream::timeout_multiplier = 0;
@@ -58,6 +59,7 @@ Stream :: Stream() :
 	decrypt_buf_len(0),
 	m_peer_description_str(NULL),
 	m_peer_version(NULL),
+	m_binary_classad_names(NULL),
 	m_deadline_time(0),
 	ignore_timeout_multiplier(false)
 {
@@ -91,6 +93,7 @@ Stream :: ~Stream()
 	if( m_peer_version ) {
 		delete m_peer_version;
 	}
+	delete m_binary_classad_names;
 }
 
 int 
@@ -1534,6 +1537,23 @@ Stream::set_peer_version(CondorVersionInfo const *version)
 	}
 }
 
+BinaryClassAdNames &
+Stream::binary_classad_names()
+{
+	if( !m_binary_classad_names ) {
+		m_binary_classad_names = new BinaryClassAdNames();
+	}
+	return *m_binary_classad_names;
+}
+
+void
+Stream::clear_binary_classad_names()
+{
+	if( m_binary_classad_names ) {
+		m_binary_classad_names->clear();
+	}
+}
+
 void
 Stream::set_deadline_timeout(int t)
 {
@@ -38,6 +38,8 @@
 #include "get_daemon_name.h"
 #include "filename_tools.h"
 #include "condor_holdcodes.h"
+#include "compat_classad_util.h"
+#include "utc_time.h"
 
 
 const char JR_ATTR_MAX_JOBS[] = "MaxJobs";
@@ -86,6 +88,16 @@ JobRouter::JobRouter(unsigned int as_tool)
 	m_routes = AllocateRoutingTable();
 	m_poll_count = 0;
 
+	m_need_full_scan = true;
+	m_last_full_scan = 0;
+	m_full_scan_interval = 300;
+	m_last_poll_duration = 0;
+	m_last_candidate_scan_duration = 0;
+	m_last_candidates_considered = 0;
+	m_last_routes_evaluated = 0;
+	m_full_scans = 0;
+	m_incremental_scans = 0;
+
 	m_router_lock_fd = -1;
 	m_router_lock = NULL;
 	m_max_jobs = -1;
@@ -318,6 +330,9 @@ JobRouter::config() {
 		}
 	}
 
+	m_full_scan_interval = param_integer("JOB_ROUTER_FULL_SCAN_INTERVAL", 300, 0);
+	m_need_full_scan = true;
+
 	char *constraint = param("JOB_ROUTER_SOURCE_JOB_CONSTRAINT");
 	if(!constraint) {
 		m_constraint = "";
@@ -1287,9 +1302,71 @@ void JobRouter::SetRoutingTable(RoutingTable *new_routes, HashTable<std::string,
 		dprintf(D_ALWAYS, "Routes will be matched in this order: %s\n", tmp.c_str());
 	}
 
+	BuildRouteIndex();
+	m_need_full_scan = true;
+
 	UpdateRouteStats();
 }
 
+void
+JobRouter::BuildRouteIndex()
+{
+	m_route_index.clear();
+	m_route_unindexed.assign(m_route_order.size(), true);
+
+	size_t pos = 0;
+	int num_indexed = 0;
+	for (auto it = m_route_order.begin(); it != m_route_order.end(); ++it, ++pos) {
+		JobRoute *route = safe_lookup_route(*it);
+		if ( ! route) continue;
+
+			// look for the first Attr == "string" clause at the top level of
+			// the requirements.  A job without a matching string value for
+			// Attr makes that clause, and thus the requirements, not true.
+		std::vector<classad::ExprTree*> clauses;
+		classad::ExprTree *req = route->RouteRequirementExpr();
+		if (req) clauses.push_back(req);
+		while ( ! clauses.empty()) {
+			classad::ExprTree *tree = SkipExprParens(clauses.back());
+			clauses.pop_back();
+			if (tree->GetKind() != classad::ExprTree::OP_NODE) continue;
+
+			classad::Operation::OpKind op;
+			classad::ExprTree *t1, *t2, *t3;
+			((const classad::Operation*)tree)->GetComponents(op, t1, t2, t3);
+			if (op == classad::Operation::LOGICAL_AND_OP) {
+				clauses.push_back(t2);
+				clauses.push_back(t1);
+				continue;
+			}
+
+			std::string attr, value;
+			classad::Value literal;
+			if ( ! ExprTreeIsAttrCmpLiteral(tree, op, attr, literal) ||
+				op != classad::Operation::EQUAL_OP ||
+				! literal.IsStringValue(value)) {
+				continue;
+			}
+
+			lower_case(attr);
+			lower_case(value);
+			size_t ix = 0;
+			while (ix < m_route_index.size() && m_route_index[ix].attr != attr) { ++ix; }
+			if (ix == m_route_index.size()) {
+				m_route_index.push_back(RouteIndex());
+				m_route_index.back().attr = attr;
+			}
+			m_route_index[ix].positions[value].push_back(pos);
+			m_route_unindexed[pos] = false;
+			++num_indexed;
+			break;
+		}
+	}
+
+	dprintf(D_FULLDEBUG, "JobRouter: %d of %d routes indexed on %d attributes\n",
+		num_indexed, (int)m_route_order.size(), (int)m_route_index.size());
+}
+
 
 void
 JobRouter::DeallocateRoutingTable(RoutingTable *routes) {
@@ -1341,6 +1418,8 @@ JobRouter::RemoveJob(RoutedJob *job) {
 	int success;
 	ASSERT(job);
 	success = m_jobs.remove(job->src_key);
+		// the job might be a candidate for routing again
+	m_candidate_keys.insert(job->src_key);
 	delete job;
 	return success != 0;
 }
@@ -1382,6 +1461,7 @@ JobRouter::NumManagedJobs() {
 void
 JobRouter::Poll() {
 	dprintf(D_FULLDEBUG,"JobRouter: polling state of (%d) managed jobs.\n",NumManagedJobs());
+	double poll_begin = condor_gettimestamp_double();
 
 	// Update our mirror(s) of the job queue(s).
 	m_scheduler->poll();
@@ -1413,6 +1493,17 @@ JobRouter::Poll() {
 		CleanupJob(job);
 		CleanupRetiredJob(job); //NOTE: this may delete job
 	}
+
+	m_last_poll_duration = condor_gettimestamp_double() - poll_begin;
+	if ( ! m_operate_as_tool) {
+		m_public_ad.Assign("LastPollDuration", m_last_poll_duration);
+		m_public_ad.Assign("LastCandidateScanDuration", m_last_candidate_scan_duration);
+		m_public_ad.Assign("LastCandidateJobsConsidered", m_last_candidates_considered);
+		m_public_ad.Assign("LastRouteRequirementsEvaluated", m_last_routes_evaluated);
+		m_public_ad.Assign("CandidateJobsPending", (long long)m_candidate_keys.size());
+		m_public_ad.Assign("CandidateFullScans", m_full_scans);
+		m_public_ad.Assign("CandidateIncrementalScans", m_incremental_scans);
+	}
 }
 
 void JobRouter::SimulateRouting()
@@ -1630,20 +1721,52 @@ JobRouter::AdoptOrphans() {
 	} while (query.Next(src_key));
 }
 
+// Evaluates a constraint against job ads the same way a
+// LocalCollectionQuery does, so that it can be applied to one job at a time.
+class CandidateConstraint {
+ public:
+	CandidateConstraint() : m_has_left(false) {}
+	~CandidateConstraint() {
+		if (m_has_left) { m_mad.RemoveLeftAd(); }
+	}
+
+	bool Init(const std::string &constraint) {
+		classad::ClassAdParser parser;
+		classad::ExprTree *tree = parser.ParseExpression(constraint);
+		if ( ! tree || ! m_constraint_ad.Insert(ATTR_REQUIREMENTS, tree)) {
+			return false;
+		}
+		m_has_left = m_mad.ReplaceLeftAd(&m_constraint_ad);
+		return m_has_left;
+	}
+
+	bool Matches(classad::ClassAd *ad) {
+		bool match = false;
+		m_mad.ReplaceRightAd(ad);
+		if ( ! m_mad.EvaluateAttrBool("RightMatchesLeft", match)) {
+			match = false;
+		}
+		m_mad.RemoveRightAd();
+		return match;
+	}
+
+ private:
+	classad::MatchClassAd m_mad;
+	classad::ClassAd m_constraint_ad;
+	bool m_has_left;
+};
+
 void
 JobRouter::GetCandidateJobs() {
 	if(!m_enable_job_routing) return;
 
     classad::LocalCollectionQuery query;
-	classad::ClassAdParser parser;
-	classad::ExprTree *constraint_tree;
     std::string key;
 	classad::ClassAd *ad;
 	classad::ClassAdCollection *ad_collection = m_scheduler->GetClassAds();
 	JobRoute *route;
 
 	HashTable<std::string,std::string> constraint_list(hashFunction);
-	std::string umbrella_constraint;
 
 	std::string dbuf("JobRouter: Checking for candidate jobs. routing table is:\n"
 		//123456789012345678901233 entries:001   1234567/1234567 1234567/1234567 
@@ -1682,15 +1805,25 @@ JobRouter::GetCandidateJobs() {
 	// Generate the list of routing constraints.
 	// Each route may have its own constraint, but in case many of them
 	// are the same, add only unique constraints to the list.
+	// route_constraints covers the routes that can take more jobs right
+	// now, and eligible_constraints covers all of them.
 	std::string route_constraints;
+	std::string eligible_constraints;
+	std::set<std::string> eligible_list;
 	for (auto it = m_routes->begin(); it != m_routes->end(); ++it) {
 		route = it->second;
+		std::string existing_constraint;
+		std::string this_constraint = route->RouteRequirementsString();
+		if(this_constraint.empty()) {
+			this_constraint = "True";
+		}
+		if(eligible_list.insert(this_constraint).second) {
+			if(!eligible_constraints.empty()) eligible_constraints += " || ";
+			eligible_constraints += "(";
+			eligible_constraints += this_constraint;
+			eligible_constraints += ")";
+		}
 		if(route->AcceptingMoreJobs()) {
-			std::string existing_constraint;
-			std::string this_constraint = route->RouteRequirementsString();
-			if(this_constraint.empty()) {
-				this_constraint = "True";
-			}
 			if(constraint_list.lookup(this_constraint,existing_constraint)==-1)
 			{
 				constraint_list.insert(this_constraint,this_constraint);
@@ -1702,105 +1835,102 @@ JobRouter::GetCandidateJobs() {
 		}
 	}
 
-	// The overall "umbrella" constraint matches the main JobRouter
-	// constraint (if any) and at least one constraint from an
-	// individual route.
-	if(!m_constraint.empty()) {
-		umbrella_constraint = "(";
-		umbrella_constraint += m_constraint;
-		umbrella_constraint += ")";
-	}
-
 	if(route_constraints.empty()) {
 		dprintf(D_FULLDEBUG,"JobRouter: no routes can accept more jobs at the moment.\n");
 		return; // No routes are accepting jobs.
 	}
 
-	if(!umbrella_constraint.empty()) {
-		umbrella_constraint += " && ";
-	}
-	umbrella_constraint += "( ";
-	umbrella_constraint += route_constraints;
-	umbrella_constraint += " )";
-
-	//Add on basic requirements to keep things sane.
-	umbrella_constraint += " && (target.ProcId >= 0 && target.JobStatus == 1 && (target.StageInStart is undefined || target.StageInFinish isnt undefined) && target.Managed isnt \"ScheddDone\" && target.Managed isnt \"External\" && target.Owner isnt Undefined && target.";
-	umbrella_constraint += JR_ATTR_ROUTED_BY;
-	umbrella_constraint += " isnt \"";
-	umbrella_constraint += m_job_router_name;
-	umbrella_constraint += "\")";
-
-	if (!can_switch_ids() && ! (m_operate_as_tool & JOB_ROUTER_TOOL_FLAG_CAN_SWITCH_IDS)) {
-			// We are not running as root.  Ensure that we only try to
-			// manage jobs submitted by the same user we are running as.
-
-		char *username = my_username();
-		char *domain = my_domainname();
-
-		ASSERT(username);
-
-		umbrella_constraint += " && (target.";
-		umbrella_constraint += ATTR_OWNER;
-		umbrella_constraint += " == \"";
-		umbrella_constraint += username;
-		umbrella_constraint += "\"";
-		if(domain) {
-			umbrella_constraint += " && target.";
-			umbrella_constraint += ATTR_NT_DOMAIN;
-			umbrella_constraint += " == \"";
-			umbrella_constraint += domain;
-			umbrella_constraint += "\"";
-		}
-		umbrella_constraint += ")";
-
-		free(username);
-		free(domain);
-	}
-
-	if (m_operate_as_tool & JOB_ROUTER_TOOL_FLAG_DEBUG_UMBRELLA) {
-		umbrella_constraint.insert(0, "debug(");
-		umbrella_constraint += ")";
-	}
-
+	std::string umbrella_constraint = MakeUmbrellaConstraint(route_constraints);
 	dprintf(D_FULLDEBUG,"JobRouter: Umbrella constraint: %s\n",umbrella_constraint.c_str());
 
-	constraint_tree = parser.ParseExpression(umbrella_constraint);
-	if(!constraint_tree) {
+	// When every route can take more jobs, the two constraints are the
+	// same and only one of them needs to be evaluated.
+	CandidateConstraint umbrella, eligible;
+	std::string eligible_constraint = MakeUmbrellaConstraint(eligible_constraints);
+	bool check_umbrella = eligible_constraint != umbrella_constraint;
+	if ( ! eligible.Init(eligible_constraint)) {
+		EXCEPT("JobRouter: Failed to parse umbrella constraint: %s",eligible_constraint.c_str());
+	}
+	if (check_umbrella && ! umbrella.Init(umbrella_constraint)) {
 		EXCEPT("JobRouter: Failed to parse umbrella constraint: %s",umbrella_constraint.c_str());
 	}
 
-    query.Bind(ad_collection);
-    if(!query.Query("root",constraint_tree)) {
-		dprintf(D_ALWAYS,"JobRouter: Error running query: %s\n",umbrella_constraint.c_str());
-		delete constraint_tree;
-		return;
+	// Decide which jobs to look at.  Normally that is just the jobs that
+	// changed since the last poll plus the ones left over from it, but
+	// every so often (and whenever the routes change) look at them all.
+	double scan_begin = condor_gettimestamp_double();
+	time_t now = time(NULL);
+	bool full_scan = m_need_full_scan || m_full_scan_interval <= 0 ||
+		now - m_last_full_scan >= m_full_scan_interval || now < m_last_full_scan;
+	if ( ! m_scheduler->TakeChangedJobs(m_candidate_keys)) {
+		full_scan = true;
 	}
-	delete constraint_tree;
 
-	int cJobsAdded = 0;
-    query.ToFirst();
-    if( query.Current(key) ) do {
-		if(!AcceptingMoreJobs()) {
-			dprintf(D_FULLDEBUG,"JobRouter: Reached maximum managed jobs (%d).  Skipping further searches for candidate jobs.\n",m_max_jobs);
-			return; //router is full
+	std::vector<std::string> keys;
+	if (full_scan) {
+		query.Bind(ad_collection);
+		if(!query.Query("root",NULL)) {
+			dprintf(D_ALWAYS,"JobRouter: Error running query: %s\n",umbrella_constraint.c_str());
+			return;
 		}
+		query.ToFirst();
+		if( query.Current(key) ) do {
+			keys.push_back(key);
+		} while (query.Next(key));
+		m_need_full_scan = false;
+		m_last_full_scan = now;
+		m_full_scans++;
+	} else {
+		keys.assign(m_candidate_keys.begin(), m_candidate_keys.end());
+		m_incremental_scans++;
+	}
+	m_candidate_keys.clear();
+	m_last_routes_evaluated = 0;
 
+	int cJobsAdded = 0;
+	int cJobsConsidered = 0;
+	bool router_full = false;
+	for (auto kit = keys.begin(); kit != keys.end(); ++kit) {
+		key = *kit;
 		if(LookupJobWithSrcKey(key)) {
 			// We are already managing this job.
 			continue;
 		}
 
 		ad = ad_collection->GetClassAd(key);
-		ASSERT(ad);
+		if ( ! ad || ! eligible.Matches(ad)) {
+			// No route will take this job unless it changes.
+			continue;
+		}
+		cJobsConsidered++;
+
+		// From here on, jobs that aren't routed are kept as candidates
+		// for the next poll.
+		if (router_full) {
+			m_candidate_keys.insert(key);
+			continue;
+		}
+		if(!AcceptingMoreJobs()) {
+			dprintf(D_FULLDEBUG,"JobRouter: Reached maximum managed jobs (%d).  Skipping further searches for candidate jobs.\n",m_max_jobs);
+			router_full = true;
+			m_candidate_keys.insert(key);
+			continue;
+		}
+		if (check_umbrella && ! umbrella.Matches(ad)) {
+			m_candidate_keys.insert(key);
+			continue;
+		}
 
 		if (m_operate_as_tool) { dprintf(D_FULLDEBUG, "JobRouter: Checking Job src=%s against all routes\n", key.c_str()); }
 
 		bool all_routes_full;
 		route = ChooseRoute(ad,&all_routes_full);
 		if(!route) {
+			m_candidate_keys.insert(key);
 			if(all_routes_full) {
 				dprintf(D_FULLDEBUG,"JobRouter: all routes are full (%d managed jobs).  Skipping further searches for candidate jobs.\n",NumManagedJobs());
-				break;
+				router_full = true;
+				continue;
 			}
 			dprintf(D_FULLDEBUG,"JobRouter: no route found for src=%s\n",key.c_str());
 			continue;
@@ -1814,6 +1944,7 @@ JobRouter::GetCandidateJobs() {
 
 		if(!job->SetSrcJobAd(key.c_str(),ad,ad_collection)) {
 			delete job;
+			m_candidate_keys.insert(key);
 			continue;
 		}
 		job->is_sandboxed = TestJobSandboxed(job);
@@ -1828,25 +1959,115 @@ JobRouter::GetCandidateJobs() {
 		dprintf(D_FULLDEBUG,"JobRouter: Found candidate job %s\n",job->JobDesc().c_str());
 		AddJob(job);
 		++cJobsAdded;
+	}
 
-    } while (query.Next(key));
+	m_last_candidates_considered = cJobsConsidered;
+	m_last_candidate_scan_duration = condor_gettimestamp_double() - scan_begin;
+	dprintf(D_FULLDEBUG, "JobRouter: %s scan of %d jobs found %d candidates and routed %d in %.3f seconds, %d left for later\n",
+		full_scan ? "full" : "incremental", (int)keys.size(), cJobsConsidered, cJobsAdded,
+		m_last_candidate_scan_duration, (int)m_candidate_keys.size());
 
 	if (m_operate_as_tool) {
 		dprintf(D_ALWAYS, "JobRouter: %d candidate jobs found\n", cJobsAdded);
 	}
 }
 
+std::string
+JobRouter::MakeUmbrellaConstraint(const std::string &route_constraints) {
+	std::string umbrella_constraint;
+
+	// The overall "umbrella" constraint matches the main JobRouter
+	// constraint (if any) and at least one constraint from an
+	// individual route.
+	if(!m_constraint.empty()) {
+		umbrella_constraint = "(";
+		umbrella_constraint += m_constraint;
+		umbrella_constraint += ")";
+	}
+
+	if(!umbrella_constraint.empty()) {
+		umbrella_constraint += " && ";
+	}
+	umbrella_constraint += "( ";
+	umbrella_constraint += route_constraints;
+	umbrella_constraint += " )";
+
+	//Add on basic requirements to keep things sane.
+	umbrella_constraint += " && (target.ProcId >= 0 && target.JobStatus == 1 && (target.StageInStart is undefined || target.StageInFinish isnt undefined) && target.Managed isnt \"ScheddDone\" && target.Managed isnt \"External\" && target.Owner isnt Undefined && target.";
+	umbrella_constraint += JR_ATTR_ROUTED_BY;
+	umbrella_constraint += " isnt \"";
+	umbrella_constraint += m_job_router_name;
+	umbrella_constraint += "\")";
+
+	if (!can_switch_ids() && ! (m_operate_as_tool & JOB_ROUTER_TOOL_FLAG_CAN_SWITCH_IDS)) {
+			// We are not running as root.  Ensure that we only try to
+			// manage jobs submitted by the same user we are running as.
+
+		char *username = my_username();
+		char *domain = my_domainname();
+
+		ASSERT(username);
+
+		umbrella_constraint += " && (target.";
+		umbrella_constraint += ATTR_OWNER;
+		umbrella_constraint += " == \"";
+		umbrella_constraint += username;
+		umbrella_constraint += "\"";
+		if(domain) {
+			umbrella_constraint += " && target.";
+			umbrella_constraint += ATTR_NT_DOMAIN;
+			umbrella_constraint += " == \"";
+			umbrella_constraint += domain;
+			umbrella_constraint += "\"";
+		}
+		umbrella_constraint += ")";
+
+		free(username);
+		free(domain);
+	}
+
+	if (m_operate_as_tool & JOB_ROUTER_TOOL_FLAG_DEBUG_UMBRELLA) {
+		umbrella_constraint.insert(0, "debug(");
+		umbrella_constraint += ")";
+	}
+
+	return umbrella_constraint;
+}
+
 JobRoute *
 JobRouter::ChooseRoute(classad::ClassAd *job_ad,bool *all_routes_full) {
 	std::vector<JobRoute *> matches;
 	JobRoute *route=NULL;
 	*all_routes_full = true;
-	for (auto it = m_route_order.begin(); it != m_route_order.end(); ++it) {
+
+	// Use the route index to rule out routes whose indexed clause
+	// can't be true for this job.
+	std::vector<bool> possible;
+	if (m_route_unindexed.size() == m_route_order.size()) {
+		possible = m_route_unindexed;
+		for (auto ri = m_route_index.begin(); ri != m_route_index.end(); ++ri) {
+			std::string value;
+			if ( ! job_ad->EvaluateAttrString(ri->attr, value)) continue;
+			lower_case(value);
+			auto found = ri->positions.find(value);
+			if (found == ri->positions.end()) continue;
+			for (auto pos = found->second.begin(); pos != found->second.end(); ++pos) {
+				possible[*pos] = true;
+			}
+		}
+	} else {
+		possible.assign(m_route_order.size(), true);
+	}
+
+	size_t pos = 0;
+	for (auto it = m_route_order.begin(); it != m_route_order.end(); ++it, ++pos) {
 		route = safe_lookup_route(*it);
 		if ( ! route) continue;
 #ifdef USE_XFORM_UTILS
 		if(!route->AcceptingMoreJobs()) continue;
 		*all_routes_full = false;
+		if ( ! possible[pos]) continue;
+		m_last_routes_evaluated++;
 		if (route->Matches(job_ad)) {
 			matches.push_back(route);
 			if (m_operate_as_tool) { dprintf(D_FULLDEBUG, "JobRouter: \tRoute Matches: %s\n", route->Name()); }
@@ -177,6 +177,36 @@ class JobRouter: public Service {
 
 	int m_poll_count;
 
+		// Jobs are only looked at again when the job queue mirror says
+		// they changed, except for a full scan of the job queue every
+		// m_full_scan_interval seconds or when the routes change.
+		// m_candidate_keys holds jobs that some route could take but
+		// which have not been routed yet.
+	std::set<std::string> m_candidate_keys;
+	bool m_need_full_scan;
+	time_t m_last_full_scan;
+	int m_full_scan_interval;
+
+		// Routes whose requirements have a top level Attr == "string"
+		// clause are indexed on that attribute and (lower-cased) value,
+		// so ChooseRoute only evaluates the requirements of routes
+		// the job could match.  Positions are in m_route_order.
+	struct RouteIndex {
+		std::string attr;
+		std::map<std::string, std::vector<size_t> > positions;
+	};
+	std::vector<RouteIndex> m_route_index;
+	std::vector<bool> m_route_unindexed;
+	void BuildRouteIndex();
+
+		// statistics about the last poll, published in the public ad
+	double m_last_poll_duration;
+	double m_last_candidate_scan_duration;
+	int m_last_candidates_considered;
+	int m_last_routes_evaluated;
+	int m_full_scans;
+	int m_incremental_scans;
+
 	int m_router_lock_fd;
 	class FileLock *m_router_lock;
 	std::string m_router_lock_fname;
@@ -270,6 +300,10 @@ private:
 	// Pick a matching route.
 	JobRoute *ChooseRoute(classad::ClassAd *job_ad,bool *all_routes_full);
 
+	// Wrap the given route requirements in the JobRouter's own
+	// constraint on which jobs may be routed.
+	std::string MakeUmbrellaConstraint(const std::string &route_constraints);
+
 	// Return true if job exit state indicates that it was a success.
 	bool TestJobSuccess(RoutedJob *job);
 
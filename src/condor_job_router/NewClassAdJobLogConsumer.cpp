@@ -28,11 +28,49 @@
 
 #include "classad/classad_distribution.h"
 
-NewClassAdJobLogConsumer::NewClassAdJobLogConsumer() : m_reader(0) { }
+NewClassAdJobLogConsumer::NewClassAdJobLogConsumer()
+	: m_reader(0)
+	, m_all_jobs_changed(true)
+{ }
+
+bool
+NewClassAdJobLogConsumer::TakeChangedJobs(std::set<std::string> &keys)
+{
+	bool incremental = ! m_all_jobs_changed;
+	if (incremental) {
+		keys.insert(m_changed_jobs.begin(), m_changed_jobs.end());
+	}
+	m_changed_jobs.clear();
+	m_all_jobs_changed = false;
+	return incremental;
+}
+
+void
+NewClassAdJobLogConsumer::JobChanged(const char *key)
+{
+	if (m_all_jobs_changed) {
+		return;
+	}
+	PROC_ID proc = getProcByString(key);
+	if (proc.proc >= 0) {
+		m_changed_jobs.insert(key);
+	} else {
+			// The jobs of this cluster see the change through their
+			// chained parent.
+		auto it = m_cluster_jobs.find(proc.cluster);
+		if (it != m_cluster_jobs.end()) {
+			m_changed_jobs.insert(it->second.begin(), it->second.end());
+		}
+	}
+}
 
 void
 NewClassAdJobLogConsumer::Reset()
 {
+	m_changed_jobs.clear();
+	m_cluster_jobs.clear();
+	m_all_jobs_changed = true;
+
 	classad::LocalCollectionQuery query;
 	std::string key;
 
@@ -98,8 +136,13 @@ NewClassAdJobLogConsumer::NewClassAd(const char *key,
 					m_reader ? m_reader->GetClassAdLogFileName() : "(null)",
 					key);
 				// XXX: why is this ok?
+			return true;
+		}
+		if (proc.proc >= 0) {
+			m_cluster_jobs[proc.cluster].insert(key);
 		}
 	}
+	JobChanged(key);
 
 	return true;
 }
@@ -107,6 +150,17 @@ NewClassAdJobLogConsumer::NewClassAd(const char *key,
 bool
 NewClassAdJobLogConsumer::DestroyClassAd(const char *key)
 {
+	PROC_ID proc = getProcByString(key);
+	if (proc.proc >= 0 && m_collection.GetClassAd(key)) {
+		auto it = m_cluster_jobs.find(proc.cluster);
+		if (it != m_cluster_jobs.end()) {
+			it->second.erase(key);
+			if (it->second.empty()) {
+				m_cluster_jobs.erase(it);
+			}
+		}
+	}
+	m_changed_jobs.erase(key);
 	m_collection.RemoveClassAd(key);
 
 	return true;
@@ -137,6 +191,7 @@ NewClassAdJobLogConsumer::SetAttribute(const char *key,
 		return true;
 	}
 	ad->Insert(name,expr);
+	JobChanged(key);
 
 	return true;
 }
@@ -155,6 +210,7 @@ NewClassAdJobLogConsumer::DeleteAttribute(const char *key,
 		return true;
 	}
 	ad->Delete(name);
+	JobChanged(key);
 
 		// The above will return false if the attribute doesn't exist
 		// in the ad.  However, this is expected, because the schedd
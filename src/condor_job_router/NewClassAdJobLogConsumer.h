@@ -24,6 +24,8 @@
 #include "ClassAdLogReader.h"
 
 #include <string>
+#include <set>
+#include <map>
 
 #include "classad/classad_distribution.h"
 
@@ -34,12 +36,28 @@ private:
 	classad::ClassAdCollection m_collection;
 	ClassAdLogReader *m_reader;
 
+		// keys of job ads created or changed since the last call to
+		// TakeChangedJobs(), and whether that isn't enough to know
+		// which jobs changed (because the collection was reloaded)
+	std::set<std::string> m_changed_jobs;
+	bool m_all_jobs_changed;
+		// cluster id -> keys of its job ads, which all change when
+		// the cluster ad they inherit from does
+	std::map<int,std::set<std::string> > m_cluster_jobs;
+
+	void JobChanged(const char *key);
+
 public:
 
 	NewClassAdJobLogConsumer();
 
 	classad::ClassAdCollection *GetClassAds() {return &m_collection;}
 
+		// Add the keys of the jobs that changed since the last call to
+		// keys.  Returns false if all jobs must be assumed to have
+		// changed.
+	bool TakeChangedJobs(std::set<std::string> &keys);
+
 	void Reset();
 
 	bool NewClassAd(const char *key,
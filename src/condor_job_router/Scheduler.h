@@ -21,6 +21,8 @@
 #define _SCHEDULER_H_
 
 #include "condor_common.h"
+#include <set>
+#include <string>
 
 #if 1
 
@@ -31,6 +33,9 @@ public:
 	Scheduler(char const *_alt_spool_param=NULL, int id=0);
 	~Scheduler();
 	classad::ClassAdCollection *GetClassAds() const;
+		// Add the keys of jobs that changed since the last call to keys.
+		// Returns false if every job must be assumed to have changed.
+	bool TakeChangedJobs(std::set<std::string> &keys);
 	void init();
 	void config();
 	void stop();
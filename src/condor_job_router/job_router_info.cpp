@@ -496,6 +496,11 @@ classad::ClassAdCollection *Scheduler::GetClassAds() const
 	return NULL;
 }
 
+bool Scheduler::TakeChangedJobs(std::set<std::string> & /*keys*/)
+{
+	return false; // the simulated job queue doesn't track changes
+}
+
 void Scheduler::init() {  m_mirror->init(); }
 void Scheduler::config() { m_mirror->config(); }
 void Scheduler::stop()  { m_mirror->stop(); }
@@ -52,6 +52,11 @@ classad::ClassAdCollection *Scheduler::GetClassAds() const
 	return m_consumer->GetClassAds();
 }
 
+bool Scheduler::TakeChangedJobs(std::set<std::string> &keys)
+{
+	return m_consumer->TakeChangedJobs(keys);
+}
+
 void Scheduler::init() { m_mirror->init(); }
 void Scheduler::config() { m_mirror->config(); }
 void Scheduler::stop()  { m_mirror->stop(); }
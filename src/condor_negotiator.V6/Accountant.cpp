@@ -34,6 +34,7 @@
 #include "string_list.h"
 #include "HashTable.h"
 #include "NegotiationUtils.h"
+#include "param_cache.h"
 #include "matchmaker.h"
 #include <string>
 #include <deque>
@@ -66,6 +67,39 @@ static char const *SlotWeightAttr=ATTR_SLOT_WEIGHT;
 
 static char const* NumCpMatches = "NumCpMatches";
 
+// Attribute behind each field of the typed tables, in enum order
+static char const *CustomerFieldAttrs[] = {
+	PriorityAttr,
+	PriorityFactorAttr,
+	CeilingAttr,
+	ResourcesUsedAttr,
+	WeightedResourcesUsedAttr,
+	HierWeightedResourcesUsedAttr,
+	UnchargedTimeAttr,
+	WeightedUnchargedTimeAttr,
+	AccumulatedUsageAttr,
+	WeightedAccumulatedUsageAttr,
+	BeginUsageTimeAttr,
+	LastUsageTimeAttr,
+};
+
+static char const *ResourceFieldAttrs[] = {
+	StartTimeAttr,
+	SlotWeightAttr,
+	NumCpMatches,
+	RemoteUserAttr,
+	ATTR_MATCHED_CONCURRENCY_LIMITS,
+};
+
+// Read one numeric field of a typed record, if it has been set
+template <class Entry, class T>
+static bool LookupField(const Entry& entry, int field, T& value)
+{
+	if ( ! (entry.present & (1 << field))) return false;
+	value = (T)entry.value[field];
+	return true;
+}
+
 /* Disable gcc warnings about floating point comparisons */
 GCC_DIAG_OFF(float-equal)
 
@@ -78,6 +112,7 @@ Accountant::Accountant():
 {
   MinPriority=0.5;
   AcctLog=NULL;
+  CheckMatchesPass = 0;
   DiscountSuspendedResources = false;
   UseSlotWeights = false;
   DefaultPriorityFactor = 1e3;
@@ -194,6 +229,7 @@ void Accountant::Initialize(GroupEntry* root_group)
     AcctLog=new ClassAdLog<std::string,ClassAd*>(LogFileName.c_str());
     dprintf(D_ACCOUNTANT,"Accountant::Initialize - LogFileName=%s\n",
 					LogFileName.c_str());
+    LoadTables();
   }
 
   // get last update time
@@ -204,9 +240,6 @@ void Accountant::Initialize(GroupEntry* root_group)
   // if at startup, do a sanity check to make certain number of resource
   // records for a user and what the user record says jives
   if ( first_time ) {
-	  std::string HK;
-	  ClassAd* ad;
-	  StringList users;
 	  int resources_used, resources_used_really;
 	  int total_overestimated_resources = 0;
 	  int total_overestimated_users = 0;
@@ -218,26 +251,48 @@ void Accountant::Initialize(GroupEntry* root_group)
 
 	  dprintf(D_ACCOUNTANT,"Sanity check on number of resources per user\n");
 
-		// first find all the users
-	  AcctLog->table.startIterations();
-	  while (AcctLog->table.iterate(HK,ad)) {
-		char const *key = HK.c_str();
-			// skip records that are not customer records...
-		if (strncmp(CustomerRecord.c_str(),key,CustomerRecord.length())) continue;
-		char const *thisUser = &(key[CustomerRecord.length()]);
-			// if we made it here, append to our list of users
-		users.append( thisUser );
+		// first total up what the resource records say each submitter
+		// and each group is using, the way CheckResources() counts it
+	  std::map<string, std::pair<int, float> > user_usage, group_usage;
+	  for (ResourceTable::iterator it = Resources.begin(); it != Resources.end(); ++it) {
+		  string rname;
+		  if (!GetResourceString(it->first,ResRemoteUser,rname)) continue;
+		  float SlotWeight = 1.0;
+		  GetResourceFloat(it->first,ResSlotWeight,SlotWeight);
+		  std::pair<int, float> &used = user_usage[rname];
+		  used.first += 1;
+		  used.second += SlotWeight;
+		  std::pair<int, float> &gused = group_usage[GetAssignedGroup(rname)->name];
+		  gused.first += 1;
+		  gused.second += SlotWeight;
 	  }
-		// ok, now StringList users has all the users.  for each user,
-		// compare what the customer record claims for usage -vs- actual
-		// number of resources
-	  users.rewind();
-	  while (char* next_user=users.next()) {
-		  string user = next_user;
+
+		// now, for each user, compare what the customer record claims
+		// for usage -vs- actual number of resources
+	  for (CustomerTable::iterator it = Customers.begin(); it != Customers.end(); ++it) {
+		  const string &user = it->first;
+		  const char *next_user = user.c_str();
 		  resources_used = GetResourcesUsed(user);
 		  resourcesRW_used = GetWeightedResourcesUsed(user);
 
-		  CheckResources(user, resources_used_really, resourcesRW_used_really);
+		  resources_used_really = 0;
+		  resourcesRW_used_really = 0;
+		  bool isGroup = false;
+		  string cgrp = GetAssignedGroup(user, isGroup)->name;
+		  std::map<string, std::pair<int, float> >::iterator used;
+		  if ( ! isGroup) {
+			  used = user_usage.find(user);
+			  if (used != user_usage.end()) {
+				  resources_used_really = used->second.first;
+				  resourcesRW_used_really = used->second.second;
+			  }
+		  } else if (cgrp == user) {
+			  used = group_usage.find(cgrp);
+			  if (used != group_usage.end()) {
+				  resources_used_really = used->second.first;
+				  resourcesRW_used_really = used->second.second;
+			  }
+		  }
 
 		  if ( resources_used == resources_used_really ) {
 			dprintf(D_ACCOUNTANT,"Customer %s using %d resources\n",next_user,
@@ -246,7 +301,7 @@ void Accountant::Initialize(GroupEntry* root_group)
 			dprintf(D_ALWAYS,
 				"FIXING - Customer %s using %d resources, but only found %d\n",
 				next_user,resources_used,resources_used_really);
-			SetAttributeInt(CustomerRecord+user,ResourcesUsedAttr,resources_used_really);
+			SetCustomerInt(user,CustResourcesUsed,resources_used_really);
 			if ( resources_used > resources_used_really ) {
 				total_overestimated_resources += 
 					( resources_used - resources_used_really );
@@ -260,7 +315,7 @@ void Accountant::Initialize(GroupEntry* root_group)
 			dprintf(D_ALWAYS,
 				"FIXING - Customer record %s using %f weighted resources, but found %f\n",
 				next_user,resourcesRW_used,resourcesRW_used_really);
-			SetAttributeFloat(CustomerRecord+user,WeightedResourcesUsedAttr,resourcesRW_used_really);
+			SetCustomerFloat(user,CustWeightedResourcesUsed,resourcesRW_used_really);
 			if ( resourcesRW_used > resourcesRW_used_really ) {
 				total_overestimated_resourcesRW += 
 					( resourcesRW_used - resourcesRW_used_really );
@@ -273,14 +328,14 @@ void Accountant::Initialize(GroupEntry* root_group)
 			  "FIXING - Overestimated %d resources across %d users "
 			  "(from a total of %d users)\n",
 			  total_overestimated_resources,total_overestimated_users,
-			  users.number() );
+			  (int)Customers.size() );
 	  }
 	  if ( total_overestimated_usersRW ) {
 		  dprintf( D_ALWAYS,
 			  "FIXING - Overestimated %f resources across %d users "
 			  "(from a total of %d users)\n",
 			  total_overestimated_resourcesRW,total_overestimated_users,
-			  users.number() );
+			  (int)Customers.size() );
 	  }
   }
 
@@ -389,7 +444,7 @@ bool Accountant::UsingWeightedSlots() const {
 int Accountant::GetResourcesUsed(const string& CustomerName) 
 {
   int ResourcesUsed=0;
-  GetAttributeInt(CustomerRecord+CustomerName,ResourcesUsedAttr,ResourcesUsed);
+  GetCustomerInt(CustomerName,CustResourcesUsed,ResourcesUsed);
   return ResourcesUsed;
 }
 
@@ -400,7 +455,7 @@ int Accountant::GetResourcesUsed(const string& CustomerName)
 float Accountant::GetWeightedResourcesUsed(const string& CustomerName)
 {
   float WeightedResourcesUsed=0.0;
-  GetAttributeFloat(CustomerRecord+CustomerName,WeightedResourcesUsedAttr,WeightedResourcesUsed);
+  GetCustomerFloat(CustomerName,CustWeightedResourcesUsed,WeightedResourcesUsed);
   return WeightedResourcesUsed;
 }
 
@@ -414,7 +469,7 @@ float Accountant::GetPriority(const string& CustomerName)
     // PriorityFactor.
   float PriorityFactor=GetPriorityFactor(CustomerName);
   float Priority=MinPriority;
-  GetAttributeFloat(CustomerRecord+CustomerName,PriorityAttr,Priority);
+  GetCustomerFloat(CustomerName,CustPriority,Priority);
   if (Priority<MinPriority) {
     Priority=MinPriority;
     // Warning!  This read function has a side effect of a write.
@@ -426,7 +481,7 @@ float Accountant::GetPriority(const string& CustomerName)
 int Accountant::GetCeiling(const string& CustomerName) 
 {
   int ceiling = -1; // Bogus value
-  GetAttributeInt(CustomerRecord+CustomerName,CeilingAttr,ceiling);
+  GetCustomerInt(CustomerName,CustCeiling,ceiling);
   if (ceiling < 0) {
     ceiling = -1 ; // Meaning unlimited
   }
@@ -453,7 +508,7 @@ float Accountant::getGroupPriorityFactor(const string& CustomerName)
 float Accountant::GetPriorityFactor(const string& CustomerName) 
 {
   float PriorityFactor=0;
-  GetAttributeFloat(CustomerRecord+CustomerName,PriorityFactorAttr,PriorityFactor);
+  GetCustomerFloat(CustomerName,CustPriorityFactor,PriorityFactor);
   if (PriorityFactor < MIN_PRIORITY_FACTOR) {
     PriorityFactor=DefaultPriorityFactor;
 	float groupPriorityFactor = 0.0;
@@ -488,19 +543,14 @@ void Accountant::ResetAllUsage()
 {
   dprintf(D_ACCOUNTANT,"Accountant::ResetAllUsage\n");
   time_t T=time(0);
-  std::string HK;
-  ClassAd* ad;
 
-  AcctLog->table.startIterations();
-  while (AcctLog->table.iterate(HK,ad)) {
-	char const *key = HK.c_str();
-	if (strncmp(CustomerRecord.c_str(),key,CustomerRecord.length())) continue;
-	AcctLog->BeginTransaction();
-    SetAttributeFloat(key,AccumulatedUsageAttr,0);
-    SetAttributeFloat(key,WeightedAccumulatedUsageAttr,0);
-    SetAttributeInt(key,BeginUsageTimeAttr,T);
-	AcctLog->CommitTransaction();
+  AcctLog->BeginTransaction();
+  for (CustomerTable::iterator it = Customers.begin(); it != Customers.end(); ++it) {
+    SetCustomerFloat(it->first,CustAccumulatedUsage,0);
+    SetCustomerFloat(it->first,CustWeightedAccumulatedUsage,0);
+    SetCustomerInt(it->first,CustBeginUsageTime,T);
   }
+  AcctLog->CommitTransaction();
   return;
 }
 
@@ -512,9 +562,9 @@ void Accountant::ResetAccumulatedUsage(const string& CustomerName)
 {
   dprintf(D_ACCOUNTANT,"Accountant::ResetAccumulatedUsage - CustomerName=%s\n",CustomerName.c_str());
   AcctLog->BeginTransaction();
-  SetAttributeFloat(CustomerRecord+CustomerName,AccumulatedUsageAttr,0);
-  SetAttributeFloat(CustomerRecord+CustomerName,WeightedAccumulatedUsageAttr,0);
-  SetAttributeInt(CustomerRecord+CustomerName,BeginUsageTimeAttr,time(0));
+  SetCustomerFloat(CustomerName,CustAccumulatedUsage,0);
+  SetCustomerFloat(CustomerName,CustWeightedAccumulatedUsage,0);
+  SetCustomerInt(CustomerName,CustBeginUsageTime,time(0));
   AcctLog->CommitTransaction();
 }
 
@@ -526,7 +576,7 @@ void Accountant::DeleteRecord(const string& CustomerName)
 {
   dprintf(D_ACCOUNTANT,"Accountant::DeleteRecord - CustomerName=%s\n",CustomerName.c_str());
   AcctLog->BeginTransaction();
-  DeleteClassAd(CustomerRecord+CustomerName);
+  DeleteCustomer(CustomerName);
   AcctLog->CommitTransaction();
 }
 
@@ -542,7 +592,7 @@ void Accountant::SetPriorityFactor(const string& CustomerName, float PriorityFac
       PriorityFactor = MIN_PRIORITY_FACTOR;
   }
   dprintf(D_ACCOUNTANT,"Accountant::SetPriorityFactor - CustomerName=%s, PriorityFactor=%8.3f\n",CustomerName.c_str(),PriorityFactor);
-  SetAttributeFloat(CustomerRecord+CustomerName,PriorityFactorAttr,PriorityFactor);
+  SetCustomerFloat(CustomerName,CustPriorityFactor,PriorityFactor);
 }
 
 //------------------------------------------------------------------
@@ -552,7 +602,7 @@ void Accountant::SetPriorityFactor(const string& CustomerName, float PriorityFac
 void Accountant::SetPriority(const string& CustomerName, float Priority) 
 {
   dprintf(D_ACCOUNTANT,"Accountant::SetPriority - CustomerName=%s, Priority=%8.3f\n",CustomerName.c_str(),Priority);
-  SetAttributeFloat(CustomerRecord+CustomerName,PriorityAttr,Priority);
+  SetCustomerFloat(CustomerName,CustPriority,Priority);
 }
 //
 //------------------------------------------------------------------
@@ -562,7 +612,7 @@ void Accountant::SetPriority(const string& CustomerName, float Priority)
 void Accountant::SetCeiling(const string& CustomerName, int ceiling) 
 {
   dprintf(D_ACCOUNTANT,"Accountant::SetCeiling - CustomerName=%s, Ceiling=%d\n",CustomerName.c_str(),ceiling);
-  SetAttributeInt(CustomerRecord+CustomerName,CeilingAttr,ceiling);
+  SetCustomerInt(CustomerName,CustCeiling,ceiling);
 }
 
 
@@ -573,7 +623,7 @@ void Accountant::SetCeiling(const string& CustomerName, int ceiling)
 void Accountant::SetAccumUsage(const string& CustomerName, float AccumulatedUsage) 
 {
   dprintf(D_ACCOUNTANT,"Accountant::SetAccumUsage - CustomerName=%s, Usage=%8.3f\n",CustomerName.c_str(),AccumulatedUsage);
-  SetAttributeFloat(CustomerRecord+CustomerName,WeightedAccumulatedUsageAttr,AccumulatedUsage);
+  SetCustomerFloat(CustomerName,CustWeightedAccumulatedUsage,AccumulatedUsage);
 }
 
 //------------------------------------------------------------------
@@ -583,7 +633,7 @@ void Accountant::SetAccumUsage(const string& CustomerName, float AccumulatedUsag
 void Accountant::SetBeginTime(const string& CustomerName, int BeginTime) 
 {
   dprintf(D_ACCOUNTANT,"Accountant::SetBeginTime - CustomerName=%s, BeginTime=%8d\n",CustomerName.c_str(),BeginTime);
-  SetAttributeInt(CustomerRecord+CustomerName,BeginUsageTimeAttr,BeginTime);
+  SetCustomerInt(CustomerName,CustBeginUsageTime,BeginTime);
 }
 
 //------------------------------------------------------------------
@@ -593,7 +643,7 @@ void Accountant::SetBeginTime(const string& CustomerName, int BeginTime)
 void Accountant::SetLastTime(const string& CustomerName, int LastTime) 
 {
   dprintf(D_ACCOUNTANT,"Accountant::SetLastTime - CustomerName=%s, LastTime=%8d\n",CustomerName.c_str(),LastTime);
-  SetAttributeInt(CustomerRecord+CustomerName,LastUsageTimeAttr,LastTime);
+  SetCustomerInt(CustomerName,CustLastUsageTime,LastTime);
 }
 
 
@@ -621,11 +671,11 @@ void Accountant::AddMatch(const string& CustomerName, ClassAd* ResourceAd)
 
       // For CP matches, maintain a count of matches during this negotiation cycle:
       int num_cp_matches = 0;
-      if (!GetAttributeInt(ResourceRecord+ResourceName, NumCpMatches, num_cp_matches)) num_cp_matches = 0;
+      if (!GetResourceInt(ResourceName,ResNumCpMatches,num_cp_matches)) num_cp_matches = 0;
       string suffix;
       formatstr(suffix, "_cp_match_%03d", num_cp_matches);
       num_cp_matches += 1;
-      SetAttributeInt(ResourceRecord+ResourceName, NumCpMatches, num_cp_matches);
+      SetResourceInt(ResourceName,ResNumCpMatches,num_cp_matches);
 
       // Now insert a match under a unique pseudonym for resource name,
       // and using match cost for slot weight:
@@ -634,7 +684,7 @@ void Accountant::AddMatch(const string& CustomerName, ClassAd* ResourceAd)
   } else {
       // Check if the resource is used
       string RemoteUser;
-      if (GetAttributeString(ResourceRecord+ResourceName,RemoteUserAttr,RemoteUser)) {
+      if (GetResourceString(ResourceName,ResRemoteUser,RemoteUser)) {
         if (CustomerName==RemoteUser) {
     	  dprintf(D_ACCOUNTANT,"Match already existed!\n");
           return;
@@ -645,27 +695,27 @@ void Accountant::AddMatch(const string& CustomerName, ClassAd* ResourceAd)
   }
 
   int ResourcesUsed=0;
-  GetAttributeInt(CustomerRecord+CustomerName,ResourcesUsedAttr,ResourcesUsed);
+  GetCustomerInt(CustomerName,CustResourcesUsed,ResourcesUsed);
   float WeightedResourcesUsed=0.0;
-  GetAttributeFloat(CustomerRecord+CustomerName,WeightedResourcesUsedAttr,WeightedResourcesUsed);
+  GetCustomerFloat(CustomerName,CustWeightedResourcesUsed,WeightedResourcesUsed);
   int UnchargedTime=0;
-  GetAttributeInt(CustomerRecord+CustomerName,UnchargedTimeAttr,UnchargedTime);
+  GetCustomerInt(CustomerName,CustUnchargedTime,UnchargedTime);
   float WeightedUnchargedTime=0.0;
-  GetAttributeFloat(CustomerRecord+CustomerName,WeightedUnchargedTimeAttr,WeightedUnchargedTime);
+  GetCustomerFloat(CustomerName,CustWeightedUnchargedTime,WeightedUnchargedTime);
 
 
   AcctLog->BeginTransaction(); 
   
   // Update customer's resource usage count
   ResourcesUsed += 1;
-  SetAttributeInt(CustomerRecord+CustomerName,ResourcesUsedAttr,ResourcesUsed);
+  SetCustomerInt(CustomerName,CustResourcesUsed,ResourcesUsed);
   WeightedResourcesUsed += SlotWeight;
-  SetAttributeFloat(CustomerRecord+CustomerName,WeightedResourcesUsedAttr,WeightedResourcesUsed);
+  SetCustomerFloat(CustomerName,CustWeightedResourcesUsed,WeightedResourcesUsed);
   // add negative "uncharged" time if match starts after last update
   UnchargedTime-=T-LastUpdateTime;
   WeightedUnchargedTime-=(T-LastUpdateTime)*SlotWeight;
-  SetAttributeInt(CustomerRecord+CustomerName,UnchargedTimeAttr,UnchargedTime);
-  SetAttributeFloat(CustomerRecord+CustomerName,WeightedUnchargedTimeAttr,WeightedUnchargedTime);
+  SetCustomerInt(CustomerName,CustUnchargedTime,UnchargedTime);
+  SetCustomerFloat(CustomerName,CustWeightedUnchargedTime,WeightedUnchargedTime);
 
   // Do everything we just to update the customer's record a second time if
   // there is a group record to update
@@ -679,31 +729,31 @@ void Accountant::AddMatch(const string& CustomerName, ClassAd* ResourceAd)
 
   dprintf(D_ACCOUNTANT, "Customername %s GroupName is: %s\n",CustomerName.c_str(), GroupName.c_str());
 
-  GetAttributeInt(CustomerRecord+GroupName,ResourcesUsedAttr,GroupResourcesUsed);
-  GetAttributeFloat(CustomerRecord+GroupName,WeightedResourcesUsedAttr,GroupWeightedResourcesUsed);
-  GetAttributeInt(CustomerRecord+GroupName,UnchargedTimeAttr,GroupUnchargedTime);
-  GetAttributeFloat(CustomerRecord+GroupName,WeightedUnchargedTimeAttr,WeightedGroupUnchargedTime);
+  GetCustomerInt(GroupName,CustResourcesUsed,GroupResourcesUsed);
+  GetCustomerFloat(GroupName,CustWeightedResourcesUsed,GroupWeightedResourcesUsed);
+  GetCustomerInt(GroupName,CustUnchargedTime,GroupUnchargedTime);
+  GetCustomerFloat(GroupName,CustWeightedUnchargedTime,WeightedGroupUnchargedTime);
 
   // Update customer's group resource usage count
   GroupWeightedResourcesUsed += SlotWeight;
   GroupResourcesUsed += 1;
 
   dprintf(D_ACCOUNTANT, "GroupWeightedResourcesUsed=%f SlotWeight=%f\n", GroupWeightedResourcesUsed,SlotWeight);
-  SetAttributeFloat(CustomerRecord+GroupName,WeightedResourcesUsedAttr,GroupWeightedResourcesUsed);
-  SetAttributeInt(CustomerRecord+GroupName,ResourcesUsedAttr,GroupResourcesUsed);
+  SetCustomerFloat(GroupName,CustWeightedResourcesUsed,GroupWeightedResourcesUsed);
+  SetCustomerInt(GroupName,CustResourcesUsed,GroupResourcesUsed);
   // add negative "uncharged" time if match starts after last update 
   GroupUnchargedTime-=T-LastUpdateTime;
   WeightedGroupUnchargedTime-=(T-LastUpdateTime)*SlotWeight;
-  SetAttributeInt(CustomerRecord+GroupName,UnchargedTimeAttr,GroupUnchargedTime);
-  SetAttributeFloat(CustomerRecord+GroupName,WeightedUnchargedTimeAttr,WeightedGroupUnchargedTime);
+  SetCustomerInt(GroupName,CustUnchargedTime,GroupUnchargedTime);
+  SetCustomerFloat(GroupName,CustWeightedUnchargedTime,WeightedGroupUnchargedTime);
 
   // If this is a nested group (group_a.b.c), update usage up the tree
   std::string GroupNamePart = GroupName;
   while (GroupNamePart.length() > 0) {
 	float GroupHierWeightedResourcesUsed = 0.0;
-  	GetAttributeFloat(CustomerRecord+GroupNamePart,HierWeightedResourcesUsedAttr,GroupHierWeightedResourcesUsed);
+  	GetCustomerFloat(GroupNamePart,CustHierWeightedResourcesUsed,GroupHierWeightedResourcesUsed);
 	GroupHierWeightedResourcesUsed += SlotWeight;
-  	SetAttributeFloat(CustomerRecord+GroupNamePart,HierWeightedResourcesUsedAttr,GroupHierWeightedResourcesUsed);
+  	SetCustomerFloat(GroupNamePart,CustHierWeightedResourcesUsed,GroupHierWeightedResourcesUsed);
 
   	size_t last_dot = GroupNamePart.find_last_of(".");
   	if (last_dot == std::string::npos) {
@@ -715,13 +765,13 @@ void Accountant::AddMatch(const string& CustomerName, ClassAd* ResourceAd)
 
 
   // Set resource's info: user, and start-time
-  SetAttributeString(ResourceRecord+ResourceName,RemoteUserAttr,CustomerName);
-  SetAttributeFloat(ResourceRecord+ResourceName,SlotWeightAttr,SlotWeight);
-  SetAttributeInt(ResourceRecord+ResourceName,StartTimeAttr,T);
+  SetResourceString(ResourceName,ResRemoteUser,CustomerName);
+  SetResourceFloat(ResourceName,ResSlotWeight,SlotWeight);
+  SetResourceInt(ResourceName,ResStartTime,T);
 
   string str;
   if (ResourceAd->LookupString(ATTR_MATCHED_CONCURRENCY_LIMITS, str)) {
-    SetAttributeString(ResourceRecord+ResourceName,ATTR_MATCHED_CONCURRENCY_LIMITS,str);
+    SetResourceString(ResourceName,ResMatchedLimits,str);
     IncrementLimits(str);
   }    
 
@@ -744,7 +794,7 @@ void Accountant::RemoveMatch(const string& ResourceName, time_t T)
   dprintf(D_ACCOUNTANT,"Accountant::RemoveMatch - ResourceName=%s\n",ResourceName.c_str());
 
   int num_cp_matches = 0;
-  if (GetAttributeInt(ResourceRecord+ResourceName, NumCpMatches, num_cp_matches)) {
+  if (GetResourceInt(ResourceName,ResNumCpMatches,num_cp_matches)) {
       // If this attribute is present, this p-slot match is a placeholder for one or more
       // pseudo-matches with resource name having a suffix of "_cp_match_xxx".   These
       // special matches are created to allow proper accounting for resources having a
@@ -754,29 +804,29 @@ void Accountant::RemoveMatch(const string& ResourceName, time_t T)
       // "traditional" p-slot record is removed and replaced by a d-slot match.
 
       // Delete the placeholder p-slot rec
-      DeleteClassAd(ResourceRecord+ResourceName);
+      DeleteResource(ResourceName);
       return;
   }
 
   string CustomerName;
-  if (!GetAttributeString(ResourceRecord+ResourceName,RemoteUserAttr,CustomerName)) {
-      DeleteClassAd(ResourceRecord+ResourceName);
+  if (!GetResourceString(ResourceName,ResRemoteUser,CustomerName)) {
+      DeleteResource(ResourceName);
       return;
   }
   int StartTime=0;
-  GetAttributeInt(ResourceRecord+ResourceName,StartTimeAttr,StartTime);
+  GetResourceInt(ResourceName,ResStartTime,StartTime);
   int ResourcesUsed=0;
-  GetAttributeInt(CustomerRecord+CustomerName,ResourcesUsedAttr,ResourcesUsed);
+  GetCustomerInt(CustomerName,CustResourcesUsed,ResourcesUsed);
   float WeightedResourcesUsed=0;
-  GetAttributeFloat(CustomerRecord+CustomerName,WeightedResourcesUsedAttr,WeightedResourcesUsed);
+  GetCustomerFloat(CustomerName,CustWeightedResourcesUsed,WeightedResourcesUsed);
   
   int UnchargedTime=0;
-  GetAttributeInt(CustomerRecord+CustomerName,UnchargedTimeAttr,UnchargedTime);
+  GetCustomerInt(CustomerName,CustUnchargedTime,UnchargedTime);
   float WeightedUnchargedTime=0.0;
-  GetAttributeFloat(CustomerRecord+CustomerName,WeightedUnchargedTimeAttr,WeightedUnchargedTime);
+  GetCustomerFloat(CustomerName,CustWeightedUnchargedTime,WeightedUnchargedTime);
   
   float SlotWeight=1.0;
-  GetAttributeFloat(ResourceRecord+ResourceName,SlotWeightAttr,SlotWeight);
+  GetResourceFloat(ResourceName,ResSlotWeight,SlotWeight);
   
   int GroupResourcesUsed=0;
   float GroupWeightedResourcesUsed=0.0;
@@ -787,27 +837,27 @@ void Accountant::RemoveMatch(const string& ResourceName, time_t T)
   string GroupName = GetAssignedGroup(CustomerName)->name;
   dprintf(D_ACCOUNTANT, "Customername %s GroupName is: %s\n",CustomerName.c_str(), GroupName.c_str());
   
-  GetAttributeInt(CustomerRecord+GroupName,ResourcesUsedAttr,GroupResourcesUsed);
-  GetAttributeFloat(CustomerRecord+GroupName,WeightedResourcesUsedAttr,GroupWeightedResourcesUsed);
-  GetAttributeInt(CustomerRecord+GroupName,UnchargedTimeAttr,GroupUnchargedTime);
-  GetAttributeFloat(CustomerRecord+GroupName,WeightedUnchargedTimeAttr,WeightedGroupUnchargedTime);
-  GetAttributeFloat(CustomerRecord+GroupName,HierWeightedResourcesUsedAttr,HierWeightedResourcesUsed);
+  GetCustomerInt(GroupName,CustResourcesUsed,GroupResourcesUsed);
+  GetCustomerFloat(GroupName,CustWeightedResourcesUsed,GroupWeightedResourcesUsed);
+  GetCustomerInt(GroupName,CustUnchargedTime,GroupUnchargedTime);
+  GetCustomerFloat(GroupName,CustWeightedUnchargedTime,WeightedGroupUnchargedTime);
+  GetCustomerFloat(GroupName,CustHierWeightedResourcesUsed,HierWeightedResourcesUsed);
   
   AcctLog->BeginTransaction();
   // Update customer's resource usage count
   if   (ResourcesUsed>0) ResourcesUsed -= 1;
-  SetAttributeInt(CustomerRecord+CustomerName,ResourcesUsedAttr,ResourcesUsed);
+  SetCustomerInt(CustomerName,CustResourcesUsed,ResourcesUsed);
   WeightedResourcesUsed -= SlotWeight;
   if( WeightedResourcesUsed < 0 ) {
       WeightedResourcesUsed = 0;
   }
-  SetAttributeFloat(CustomerRecord+CustomerName,WeightedResourcesUsedAttr,WeightedResourcesUsed);
+  SetCustomerFloat(CustomerName,CustWeightedResourcesUsed,WeightedResourcesUsed);
   // update uncharged time
   if (StartTime<LastUpdateTime) StartTime=LastUpdateTime;
   UnchargedTime+=T-StartTime;
   WeightedUnchargedTime+=(T-StartTime)*SlotWeight;
-  SetAttributeInt(CustomerRecord+CustomerName,UnchargedTimeAttr,UnchargedTime);
-  SetAttributeFloat(CustomerRecord+CustomerName,WeightedUnchargedTimeAttr,WeightedUnchargedTime);
+  SetCustomerInt(CustomerName,CustUnchargedTime,UnchargedTime);
+  SetCustomerFloat(CustomerName,CustWeightedUnchargedTime,WeightedUnchargedTime);
 
   // Do everything we just to update the customer's record a second time if
   // there is a group record to update
@@ -823,10 +873,10 @@ void Accountant::RemoveMatch(const string& ResourceName, time_t T)
   std::string GroupNamePart = GroupName;
   while (GroupNamePart.length() > 0) {
 	float GroupHierWeightedResourcesUsed = 0.0;
-  	GetAttributeFloat(CustomerRecord+GroupNamePart,HierWeightedResourcesUsedAttr,GroupHierWeightedResourcesUsed);
+  	GetCustomerFloat(GroupNamePart,CustHierWeightedResourcesUsed,GroupHierWeightedResourcesUsed);
 	GroupHierWeightedResourcesUsed -= SlotWeight;
 	if (GroupHierWeightedResourcesUsed < 0) GroupHierWeightedResourcesUsed = 0;
-  	SetAttributeFloat(CustomerRecord+GroupNamePart,HierWeightedResourcesUsedAttr,GroupHierWeightedResourcesUsed);
+  	SetCustomerFloat(GroupNamePart,CustHierWeightedResourcesUsed,GroupHierWeightedResourcesUsed);
 
   	size_t last_dot = GroupNamePart.find_last_of(".");
   	if (last_dot == std::string::npos) {
@@ -838,16 +888,16 @@ void Accountant::RemoveMatch(const string& ResourceName, time_t T)
   dprintf(D_ACCOUNTANT, "GroupResourcesUsed =%d GroupWeightedResourcesUsed= %f SlotWeight=%f\n",
           GroupResourcesUsed ,GroupWeightedResourcesUsed,SlotWeight);
 
-  SetAttributeFloat(CustomerRecord+GroupName,WeightedResourcesUsedAttr,GroupWeightedResourcesUsed);
+  SetCustomerFloat(GroupName,CustWeightedResourcesUsed,GroupWeightedResourcesUsed);
 
-  SetAttributeInt(CustomerRecord+GroupName,ResourcesUsedAttr,GroupResourcesUsed);
+  SetCustomerInt(GroupName,CustResourcesUsed,GroupResourcesUsed);
   // update uncharged time
   GroupUnchargedTime+=T-StartTime;
   WeightedGroupUnchargedTime+=(T-StartTime)*SlotWeight;
-  SetAttributeInt(CustomerRecord+GroupName,UnchargedTimeAttr,GroupUnchargedTime);
-  SetAttributeFloat(CustomerRecord+GroupName,WeightedUnchargedTimeAttr,WeightedGroupUnchargedTime);
+  SetCustomerInt(GroupName,CustUnchargedTime,GroupUnchargedTime);
+  SetCustomerFloat(GroupName,CustWeightedUnchargedTime,WeightedGroupUnchargedTime);
 
-  DeleteClassAd(ResourceRecord+ResourceName);
+  DeleteResource(ResourceName);
   AcctLog->CommitNondurableTransaction();
 
   dprintf(D_ACCOUNTANT, "(ACCOUNTANT) Removed match between customer %s and resource %s\n",
@@ -875,17 +925,8 @@ void Accountant::DisplayLog()
 
 void Accountant::DisplayMatches()
 {
-  std::string HK;
-  ClassAd* ad;
-  string ResourceName;
-  AcctLog->table.startIterations();
-  while (AcctLog->table.iterate(HK,ad)) {
-	char const *key = HK.c_str();
-    if (strncmp(ResourceRecord.c_str(),key,ResourceRecord.length())) continue;
-    ResourceName=key+ResourceRecord.length();
-    std::string RemoteUser;
-    ad->LookupString(RemoteUserAttr,RemoteUser);
-    printf("Customer=%s , Resource=%s\n",RemoteUser.c_str(),ResourceName.c_str());
+  for (ResourceTable::iterator it = Resources.begin(); it != Resources.end(); ++it) {
+    printf("Customer=%s , Resource=%s\n",it->second.RemoteUser.c_str(),it->first.c_str());
   }
 }
 
@@ -913,19 +954,16 @@ void Accountant::UpdatePriorities()
 
   dprintf(D_ACCOUNTANT,"(ACCOUNTANT) Updating priorities - AgingFactor=%8.3f , TimePassed=%d\n",AgingFactor,TimePassed);
 
-  std::string HK;
-  ClassAd* ad;
-
 	  // Each iteration of the loop should be atomic for consistency,
 	  // but instead of doing one transaction per iteration, wrap the
 	  // whole loop in one transaction for efficiency.
   AcctLog->BeginTransaction();
 
-  AcctLog->table.startIterations();
-  while (AcctLog->table.iterate(HK,ad)) {
-	char const *key = HK.c_str();
-	if (strncmp(CustomerRecord.c_str(),key,CustomerRecord.length())) continue;
-		UpdateOnePriority(T, TimePassed, AgingFactor, key, ad);
+  CustomerTable::iterator it = Customers.begin();
+  while (it != Customers.end()) {
+		// step past this one first, since it may be deleted
+	CustomerTable::iterator cur = it++;
+	UpdateOnePriority(T, TimePassed, AgingFactor, cur->first, cur->second);
   }
 
   AcctLog->CommitTransaction();
@@ -957,7 +995,7 @@ void Accountant::UpdatePriorities()
 }
 
 void
-Accountant::UpdateOnePriority(int T, int TimePassed, float AgingFactor, const char *key, ClassAd *ad) {
+Accountant::UpdateOnePriority(int T, int TimePassed, float AgingFactor, const string& CustomerName, CustomerEntry& entry) {
 
 	float Priority, OldPrio, PriorityFactor;
 	int UnchargedTime;
@@ -969,27 +1007,27 @@ Accountant::UpdateOnePriority(int T, int TimePassed, float AgingFactor, const ch
 	int ResourcesUsed;
 	float WeightedResourcesUsed;
 	int BeginUsageTime;
-    // lookup values in the ad
-	
-    if (ad->LookupFloat(PriorityAttr,Priority)==0) Priority=0;
+    // lookup values in the typed record
+
+    if (!LookupField(entry,CustPriority,Priority)) Priority=0;
 	if (Priority<MinPriority) Priority=MinPriority;
     OldPrio=Priority;
 
     // set_prio_factor indicates whether a priority factor has been explicitly set,
     // in which case the record should be kept to preserve the setting
     bool set_prio_factor = true;
-    if (ad->LookupFloat(PriorityFactorAttr,PriorityFactor)==0) {
+    if (!LookupField(entry,CustPriorityFactor,PriorityFactor)) {
 	   	PriorityFactor = DefaultPriorityFactor;
         set_prio_factor = false;
 	}
 
-    if (ad->LookupInteger(UnchargedTimeAttr,UnchargedTime)==0) UnchargedTime=0;
-    if (ad->LookupFloat(AccumulatedUsageAttr,AccumulatedUsage)==0) AccumulatedUsage=0;
-    if (ad->LookupFloat(WeightedUnchargedTimeAttr,WeightedUnchargedTime)==0) WeightedUnchargedTime=0;
-    if (ad->LookupFloat(WeightedAccumulatedUsageAttr,WeightedAccumulatedUsage)==0) WeightedAccumulatedUsage=AccumulatedUsage;
-    if (ad->LookupInteger(BeginUsageTimeAttr,BeginUsageTime)==0) BeginUsageTime=0;
-    if (ad->LookupInteger(ResourcesUsedAttr,ResourcesUsed)==0) ResourcesUsed=0;
-	if (ad->LookupFloat(WeightedResourcesUsedAttr,WeightedResourcesUsed)==0) WeightedResourcesUsed=0.0;
+    if (!LookupField(entry,CustUnchargedTime,UnchargedTime)) UnchargedTime=0;
+    if (!LookupField(entry,CustAccumulatedUsage,AccumulatedUsage)) AccumulatedUsage=0;
+    if (!LookupField(entry,CustWeightedUnchargedTime,WeightedUnchargedTime)) WeightedUnchargedTime=0;
+    if (!LookupField(entry,CustWeightedAccumulatedUsage,WeightedAccumulatedUsage)) WeightedAccumulatedUsage=AccumulatedUsage;
+    if (!LookupField(entry,CustBeginUsageTime,BeginUsageTime)) BeginUsageTime=0;
+    if (!LookupField(entry,CustResourcesUsed,ResourcesUsed)) ResourcesUsed=0;
+	if (!LookupField(entry,CustWeightedResourcesUsed,WeightedResourcesUsed)) WeightedResourcesUsed=0.0;
 
     RecentUsage=float(ResourcesUsed)+float(UnchargedTime)/TimePassed;
     WeightedRecentUsage=float(WeightedResourcesUsed)+float(WeightedUnchargedTime)/TimePassed;
@@ -997,7 +1035,7 @@ Accountant::UpdateOnePriority(int T, int TimePassed, float AgingFactor, const ch
 	// For groups that may have a hierarchy, use the sum of the usage in the hierarchy,
 	// not the usage at this one node in the group.
 	float HierWeightedResourcesUsed = 0.0;
-	if (ad->LookupFloat(HierWeightedResourcesUsedAttr,HierWeightedResourcesUsed)==0) HierWeightedResourcesUsed=0.0;
+	if (!LookupField(entry,CustHierWeightedResourcesUsed,HierWeightedResourcesUsed)) HierWeightedResourcesUsed=0.0;
 	if (HierWeightedResourcesUsed > 0.0) {
 				WeightedRecentUsage = HierWeightedResourcesUsed;
 	}
@@ -1016,48 +1054,51 @@ Accountant::UpdateOnePriority(int T, int TimePassed, float AgingFactor, const ch
     WeightedAccumulatedUsage+=WeightedResourcesUsed*TimePassed+WeightedUnchargedTime;
 
 	if (OldPrio != Priority) {
-    	SetAttributeFloat(key,PriorityAttr,Priority);
+    	SetCustomerFloat(CustomerName,CustPriority,Priority);
 	}
 
 	if (OldAccumulatedUsage != AccumulatedUsage) {
-    	SetAttributeFloat(key,AccumulatedUsageAttr,AccumulatedUsage);
+    	SetCustomerFloat(CustomerName,CustAccumulatedUsage,AccumulatedUsage);
 	}
 
 	if (OldWeightedAccumulatedUsage != WeightedAccumulatedUsage) {
-    	SetAttributeFloat(key,WeightedAccumulatedUsageAttr,WeightedAccumulatedUsage);
+    	SetCustomerFloat(CustomerName,CustWeightedAccumulatedUsage,WeightedAccumulatedUsage);
 	}
 
     if (AccumulatedUsage>0 && BeginUsageTime==0) {
-		SetAttributeInt(key,BeginUsageTimeAttr,T);
+		SetCustomerInt(CustomerName,CustBeginUsageTime,T);
 	}
 
     if (RecentUsage>0) {
-		SetAttributeInt(key,LastUsageTimeAttr,T);
+		SetCustomerInt(CustomerName,CustLastUsageTime,T);
 	}
 
 		// This attribute is almost always 0, so don't write it unless needed
 	int oldUnchargedTime = -1;
-	GetAttributeInt(key,UnchargedTimeAttr, oldUnchargedTime);
+	LookupField(entry,CustUnchargedTime,oldUnchargedTime);
 	if (oldUnchargedTime != 0) {
-    	SetAttributeInt(key,UnchargedTimeAttr,0);
+    	SetCustomerInt(CustomerName,CustUnchargedTime,0);
 	}
 
 	float oldWeightedUnchargedTime = -1.0;
-	GetAttributeFloat(key,WeightedUnchargedTimeAttr, oldWeightedUnchargedTime);
+	LookupField(entry,CustWeightedUnchargedTime,oldWeightedUnchargedTime);
 	if (oldWeightedUnchargedTime != 0.0) {
-    	SetAttributeFloat(key,WeightedUnchargedTimeAttr,0.0);
-	}
-
-    if (Priority<MinPriority && ResourcesUsed==0 && AccumulatedUsage==0 && !set_prio_factor) {
-		DeleteClassAd(key);
+    	SetCustomerFloat(CustomerName,CustWeightedUnchargedTime,0.0);
 	}
 
 	// This isn't logged, but clear out the submitterLimit and share
-	ad->Assign("SubmitterLimit", 0.0);
-	ad->Assign("SubmitterShare", 0.0);
-    dprintf(D_ACCOUNTANT,"CustomerName=%s , Old Priority=%5.3f , New Priority=%5.3f , ResourcesUsed=%d , WeightedResourcesUsed=%f\n",key,OldPrio,Priority,ResourcesUsed,WeightedResourcesUsed);
+	ClassAd *ad = GetClassAd(CustomerRecord+CustomerName);
+	if (ad) {
+		ad->Assign("SubmitterLimit", 0.0);
+		ad->Assign("SubmitterShare", 0.0);
+	}
+    dprintf(D_ACCOUNTANT,"CustomerName=%s , Old Priority=%5.3f , New Priority=%5.3f , ResourcesUsed=%d , WeightedResourcesUsed=%f\n",CustomerName.c_str(),OldPrio,Priority,ResourcesUsed,WeightedResourcesUsed);
     dprintf(D_ACCOUNTANT,"RecentUsage=%8.3f (unweighted %8.3f), UnchargedTime=%8.3f (unweighted %d), AccumulatedUsage=%5.3f (unweighted %5.3f), BeginUsageTime=%d\n",WeightedRecentUsage,RecentUsage,WeightedUnchargedTime,UnchargedTime,WeightedAccumulatedUsage,AccumulatedUsage,BeginUsageTime);
 
+		// Do this last, it frees entry (and CustomerName along with it)
+    if (Priority<MinPriority && ResourcesUsed==0 && AccumulatedUsage==0 && !set_prio_factor) {
+		DeleteCustomer(CustomerName);
+	}
 }
 
 //------------------------------------------------------------------
@@ -1070,43 +1111,42 @@ void Accountant::CheckMatches(ClassAdListDoesNotDeleteAds& ResourceList)
   dprintf(D_ACCOUNTANT,"(Accountant) Checking Matches\n");
 
   ClassAd* ResourceAd;
-  std::string HK;
-  ClassAd* ad;
   string ResourceName;
-  std::string CustomerName;
 
-	  // Create a hash table for speedier lookups of Resource ads.
-  HashTable<string,ClassAd *> resource_hash(hashFunction);
+	  // Stamp the resource records of the ads we have, and remove
+	  // matches with resources that are no longer claimed by the
+	  // customer who has them.
+  CheckMatchesPass++;
+  std::vector<string> broken;
   ResourceList.Open();
   while ((ResourceAd=ResourceList.Next())!=NULL) {
     ResourceName = GetResourceName(ResourceAd);
-    bool success = ( resource_hash.insert( ResourceName, ResourceAd ) == 0 );
-    if (!success) {
+    ResourceTable::iterator it = Resources.find(ResourceName);
+    if (it == Resources.end()) continue;
+    ResourceEntry &entry = it->second;
+    if (entry.checked == CheckMatchesPass) {
       dprintf(D_ALWAYS, "WARNING: found duplicate key: %s\n", ResourceName.c_str());
       dPrintAd(D_FULLDEBUG, *ResourceAd);
+      continue;
+    }
+    entry.checked = CheckMatchesPass;
+    if (!CheckClaimedOrMatched(ResourceAd, entry.RemoteUser)) {
+      dprintf(D_ACCOUNTANT,"Resource %s was not claimed by %s - removing match\n",ResourceName.c_str(),entry.RemoteUser.c_str());
+      broken.push_back(ResourceName);
     }
   }
   ResourceList.Close();
 
-  // Remove matches that were broken
-  AcctLog->table.startIterations();
-  while (AcctLog->table.iterate(HK,ad)) {
-    char const *key = HK.c_str();
-    if (strncmp(ResourceRecord.c_str(),key,ResourceRecord.length())) continue;
-    ResourceName=key+ResourceRecord.length();
-    if( resource_hash.lookup(ResourceName,ResourceAd) < 0 ) {
-      dprintf(D_ACCOUNTANT,"Resource %s class-ad wasn't found in the resource list.\n",ResourceName.c_str());
-      RemoveMatch(ResourceName);
-    }
-	else {
-		// Here we need to figure out the CustomerName.
-      ad->LookupString(RemoteUserAttr,CustomerName);
-      if (!CheckClaimedOrMatched(ResourceAd, CustomerName)) {
-        dprintf(D_ACCOUNTANT,"Resource %s was not claimed by %s - removing match\n",ResourceName.c_str(),CustomerName.c_str());
-        RemoveMatch(ResourceName);
-      }
+	  // Any record that didn't get stamped is for a resource that went away
+  for (ResourceTable::iterator it = Resources.begin(); it != Resources.end(); ++it) {
+    if (it->second.checked != CheckMatchesPass) {
+      dprintf(D_ACCOUNTANT,"Resource %s class-ad wasn't found in the resource list.\n",it->first.c_str());
+      broken.push_back(it->first);
     }
   }
+  for (size_t i = 0; i < broken.size(); i++) {
+    RemoveMatch(broken[i]);
+  }
 
   // Scan startd ads and add matches that are not registered
   ResourceList.Open();
@@ -1129,8 +1169,6 @@ void Accountant::CheckMatches(ClassAdListDoesNotDeleteAds& ResourceList)
 ClassAd* Accountant::ReportState(const string& CustomerName) {
     dprintf(D_ACCOUNTANT,"Reporting State for customer %s\n",CustomerName.c_str());
 
-    std::string HK;
-    ClassAd* ResourceAd;
     int StartTime;
 
     ClassAd* ad = new ClassAd();
@@ -1141,12 +1179,9 @@ ClassAd* Accountant::ReportState(const string& CustomerName) {
     if (isGroup && (cgrp != CustomerName)) return ad;
 
     int ResourceNum=1;
-    AcctLog->table.startIterations();
-    while (AcctLog->table.iterate(HK,ResourceAd)) {
-        if (strncmp(ResourceRecord.c_str(), HK.c_str(), ResourceRecord.length())) continue;
-
+    for (ResourceTable::iterator it = Resources.begin(); it != Resources.end(); ++it) {
         std::string rname;
-        if (ResourceAd->LookupString(RemoteUserAttr, rname)==0) continue;
+        if (!GetResourceString(it->first, ResRemoteUser, rname)) continue;
 
         if (isGroup) {
             string rgrp = GetAssignedGroup(rname)->name;
@@ -1157,9 +1192,9 @@ ClassAd* Accountant::ReportState(const string& CustomerName) {
 
             string tmp;
             formatstr(tmp, "Name%d", ResourceNum);
-            ad->Assign(tmp, HK.c_str()+ResourceRecord.length());
+            ad->Assign(tmp, it->first);
 
-            if (ResourceAd->LookupInteger(StartTimeAttr,StartTime)==0) StartTime=0;
+            if (!LookupField(it->second,ResStartTime,StartTime)) StartTime=0;
             formatstr(tmp, "StartTime%d", ResourceNum);
             ad->Assign(tmp, StartTime);
         }
@@ -1182,14 +1217,9 @@ void Accountant::CheckResources(const string& CustomerName, int& NumResources, f
     // This is a defunct group:
     if (isGroup && (cgrp != CustomerName)) return;
 
-    std::string HK;
-    ClassAd* ResourceAd;
-    AcctLog->table.startIterations();
-    while (AcctLog->table.iterate(HK, ResourceAd)) {
-        if (strncmp(ResourceRecord.c_str(), HK.c_str(), ResourceRecord.length())) continue;
-
+    for (ResourceTable::iterator it = Resources.begin(); it != Resources.end(); ++it) {
         string rname;
-        if (ResourceAd->LookupString(RemoteUserAttr, rname) == 0) continue;
+        if (!GetResourceString(it->first, ResRemoteUser, rname)) continue;
 
         if (isGroup) {
             if (cgrp != GetAssignedGroup(rname)->name) continue;
@@ -1199,7 +1229,7 @@ void Accountant::CheckResources(const string& CustomerName, int& NumResources, f
 
         NumResources += 1;
         float SlotWeight = 1.0;
-        ResourceAd->LookupFloat(SlotWeightAttr, SlotWeight);
+        LookupField(it->second, ResSlotWeight, SlotWeight);
         NumResourcesRW += SlotWeight;
     }
 }
@@ -1623,6 +1653,235 @@ int Accountant::CheckClaimedOrMatched(ClassAd* ResourceAd, const string& Custome
 
 }
 
+//------------------------------------------------------------------
+// Build the typed customer and resource tables from the log
+//------------------------------------------------------------------
+
+void Accountant::LoadTables()
+{
+  ReadTables(Customers,Resources);
+
+  dprintf(D_ACCOUNTANT,"Accountant::LoadTables - %d customer and %d resource records\n",
+          (int)Customers.size(),(int)Resources.size());
+}
+
+void Accountant::ReadTables(CustomerTable& customers, ResourceTable& resources)
+{
+  customers.clear();
+  resources.clear();
+
+  std::string HK;
+  ClassAd* ad;
+  AcctLog->table.startIterations();
+  while (AcctLog->table.iterate(HK,ad)) {
+    char const *key = HK.c_str();
+    if (strncmp(CustomerRecord.c_str(),key,CustomerRecord.length()) == 0) {
+      CustomerEntry &entry = customers[key+CustomerRecord.length()];
+      for (int field = 0; field < NumCustomerFields; field++) {
+        if (ad->LookupFloat(CustomerFieldAttrs[field],entry.value[field])) {
+          entry.present |= (1 << field);
+        }
+      }
+    } else if (strncmp(ResourceRecord.c_str(),key,ResourceRecord.length()) == 0) {
+      ResourceEntry &entry = resources[key+ResourceRecord.length()];
+      for (int field = 0; field < ResRemoteUser; field++) {
+        if (ad->LookupFloat(ResourceFieldAttrs[field],entry.value[field])) {
+          entry.present |= (1 << field);
+        }
+      }
+      if (ad->LookupString(RemoteUserAttr,entry.RemoteUser)) {
+        entry.present |= (1 << ResRemoteUser);
+      }
+      if (ad->LookupString(ATTR_MATCHED_CONCURRENCY_LIMITS,entry.MatchedLimits)) {
+        entry.present |= (1 << ResMatchedLimits);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------
+// Compare the typed tables with a fresh read of the log
+//------------------------------------------------------------------
+
+bool Accountant::CheckTables(string& why)
+{
+  CustomerTable customers;
+  ResourceTable resources;
+  ReadTables(customers,resources);
+
+  if (customers.size() != Customers.size()) {
+    formatstr(why,"%d customer records in the log, %d in the table",(int)customers.size(),(int)Customers.size());
+    return false;
+  }
+  for (CustomerTable::const_iterator it = customers.begin(); it != customers.end(); ++it) {
+    CustomerTable::const_iterator mine = Customers.find(it->first);
+    if (mine == Customers.end()) {
+      formatstr(why,"customer %s is not in the table",it->first.c_str());
+      return false;
+    }
+    if (mine->second.present != it->second.present) {
+      formatstr(why,"customer %s has fields %x in the log, %x in the table",
+                it->first.c_str(),it->second.present,mine->second.present);
+      return false;
+    }
+    for (int field = 0; field < NumCustomerFields; field++) {
+      if ((it->second.present & (1 << field)) && mine->second.value[field] != it->second.value[field]) {
+        formatstr(why,"customer %s has %s %.17g in the log, %.17g in the table",it->first.c_str(),
+                  CustomerFieldAttrs[field],it->second.value[field],mine->second.value[field]);
+        return false;
+      }
+    }
+  }
+
+  if (resources.size() != Resources.size()) {
+    formatstr(why,"%d resource records in the log, %d in the table",(int)resources.size(),(int)Resources.size());
+    return false;
+  }
+  for (ResourceTable::const_iterator it = resources.begin(); it != resources.end(); ++it) {
+    ResourceTable::const_iterator mine = Resources.find(it->first);
+    if (mine == Resources.end()) {
+      formatstr(why,"resource %s is not in the table",it->first.c_str());
+      return false;
+    }
+    if (mine->second.present != it->second.present) {
+      formatstr(why,"resource %s has fields %x in the log, %x in the table",
+                it->first.c_str(),it->second.present,mine->second.present);
+      return false;
+    }
+    for (int field = 0; field < ResRemoteUser; field++) {
+      if ((it->second.present & (1 << field)) && mine->second.value[field] != it->second.value[field]) {
+        formatstr(why,"resource %s has %s %.17g in the log, %.17g in the table",it->first.c_str(),
+                  ResourceFieldAttrs[field],it->second.value[field],mine->second.value[field]);
+        return false;
+      }
+    }
+    if (mine->second.RemoteUser != it->second.RemoteUser || mine->second.MatchedLimits != it->second.MatchedLimits) {
+      formatstr(why,"resource %s has user %s and limits %s in the log, %s and %s in the table",it->first.c_str(),
+                it->second.RemoteUser.c_str(),it->second.MatchedLimits.c_str(),
+                mine->second.RemoteUser.c_str(),mine->second.MatchedLimits.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------
+// Read and write the typed customer records.  Writes go to the log
+// as well, and keep the value exactly as the log will replay it.
+// A record is in the table exactly when it is in the log or the open
+// transaction, so the table says whether the log needs a new ClassAd;
+// asking the log means walking every change to the record in the
+// transaction, which grows with each match in a CheckMatches batch.
+//------------------------------------------------------------------
+
+bool Accountant::GetCustomerInt(const string& CustomerName, CustomerField field, int& value)
+{
+  CustomerTable::const_iterator it = Customers.find(CustomerName);
+  if (it == Customers.end()) return false;
+  return LookupField(it->second,field,value);
+}
+
+bool Accountant::GetCustomerFloat(const string& CustomerName, CustomerField field, float& value)
+{
+  CustomerTable::const_iterator it = Customers.find(CustomerName);
+  if (it == Customers.end()) return false;
+  return LookupField(it->second,field,value);
+}
+
+void Accountant::SetCustomerInt(const string& CustomerName, CustomerField field, int value)
+{
+  CustomerTable::iterator it = Customers.find(CustomerName);
+  bool exists = it != Customers.end();
+  SetAttributeInt(CustomerRecord+CustomerName,CustomerFieldAttrs[field],value,exists);
+  CustomerEntry &entry = exists ? it->second : Customers[CustomerName];
+  entry.value[field] = value;
+  entry.present |= (1 << field);
+}
+
+void Accountant::SetCustomerFloat(const string& CustomerName, CustomerField field, float value)
+{
+  CustomerTable::iterator it = Customers.find(CustomerName);
+  bool exists = it != Customers.end();
+  double logged = SetAttributeFloat(CustomerRecord+CustomerName,CustomerFieldAttrs[field],value,exists);
+  CustomerEntry &entry = exists ? it->second : Customers[CustomerName];
+  entry.value[field] = logged;
+  entry.present |= (1 << field);
+}
+
+void Accountant::DeleteCustomer(const string& CustomerName)
+{
+  DeleteClassAd(CustomerRecord+CustomerName);
+  CustomerTable::iterator it = Customers.find(CustomerName);
+  if (it != Customers.end()) Customers.erase(it);
+}
+
+//------------------------------------------------------------------
+// Read and write the typed resource records
+//------------------------------------------------------------------
+
+bool Accountant::GetResourceInt(const string& ResourceName, ResourceField field, int& value)
+{
+  ResourceTable::const_iterator it = Resources.find(ResourceName);
+  if (it == Resources.end()) return false;
+  return LookupField(it->second,field,value);
+}
+
+bool Accountant::GetResourceFloat(const string& ResourceName, ResourceField field, float& value)
+{
+  ResourceTable::const_iterator it = Resources.find(ResourceName);
+  if (it == Resources.end()) return false;
+  return LookupField(it->second,field,value);
+}
+
+bool Accountant::GetResourceString(const string& ResourceName, ResourceField field, string& value)
+{
+  ResourceTable::const_iterator it = Resources.find(ResourceName);
+  if (it == Resources.end() || ! (it->second.present & (1 << field))) return false;
+  value = (field == ResRemoteUser) ? it->second.RemoteUser : it->second.MatchedLimits;
+  return true;
+}
+
+void Accountant::SetResourceInt(const string& ResourceName, ResourceField field, int value)
+{
+  ResourceTable::iterator it = Resources.find(ResourceName);
+  bool exists = it != Resources.end();
+  SetAttributeInt(ResourceRecord+ResourceName,ResourceFieldAttrs[field],value,exists);
+  ResourceEntry &entry = exists ? it->second : Resources[ResourceName];
+  entry.value[field] = value;
+  entry.present |= (1 << field);
+}
+
+void Accountant::SetResourceFloat(const string& ResourceName, ResourceField field, float value)
+{
+  ResourceTable::iterator it = Resources.find(ResourceName);
+  bool exists = it != Resources.end();
+  double logged = SetAttributeFloat(ResourceRecord+ResourceName,ResourceFieldAttrs[field],value,exists);
+  ResourceEntry &entry = exists ? it->second : Resources[ResourceName];
+  entry.value[field] = logged;
+  entry.present |= (1 << field);
+}
+
+void Accountant::SetResourceString(const string& ResourceName, ResourceField field, const string& value)
+{
+  ResourceTable::iterator it = Resources.find(ResourceName);
+  bool exists = it != Resources.end();
+  SetAttributeString(ResourceRecord+ResourceName,ResourceFieldAttrs[field],value,exists);
+  ResourceEntry &entry = exists ? it->second : Resources[ResourceName];
+  if (field == ResRemoteUser) {
+    entry.RemoteUser = value;
+  } else {
+    entry.MatchedLimits = value;
+  }
+  entry.present |= (1 << field);
+}
+
+void Accountant::DeleteResource(const string& ResourceName)
+{
+  DeleteClassAd(ResourceRecord+ResourceName);
+  ResourceTable::iterator it = Resources.find(ResourceName);
+  if (it != Resources.end()) Resources.erase(it);
+}
+
 //------------------------------------------------------------------
 // Get Class Ad
 //------------------------------------------------------------------
@@ -1653,49 +1912,50 @@ bool Accountant::DeleteClassAd(const string& Key)
 // Set an Integer attribute
 //------------------------------------------------------------------
 
-void Accountant::SetAttributeInt(const string& Key, const string& AttrName, int AttrValue)
+void Accountant::SetAttributeInt(const string& Key, char const *AttrName, int AttrValue, bool exists)
 {
-  if (AcctLog->AdExistsInTableOrTransaction(Key) == false) {
+  if (!exists && AcctLog->AdExistsInTableOrTransaction(Key) == false) {
     LogNewClassAd* log=new LogNewClassAd(Key.c_str(),"*","*");
     AcctLog->AppendLog(log);
   }
   char value[50];
   sprintf(value,"%d",AttrValue);
-  LogSetAttribute* log=new LogSetAttribute(Key.c_str(),AttrName.c_str(),value);
+  LogSetAttribute* log=new LogSetAttribute(Key.c_str(),AttrName,value);
   AcctLog->AppendLog(log);
 }
   
 //------------------------------------------------------------------
-// Set a Float attribute
+// Set a Float attribute, returning the value as it was logged
 //------------------------------------------------------------------
 
-void Accountant::SetAttributeFloat(const string& Key, const string& AttrName, float AttrValue)
+double Accountant::SetAttributeFloat(const string& Key, char const *AttrName, float AttrValue, bool exists)
 {
-  if (AcctLog->AdExistsInTableOrTransaction(Key) == false) {
+  if (!exists && AcctLog->AdExistsInTableOrTransaction(Key) == false) {
     LogNewClassAd* log=new LogNewClassAd(Key.c_str(),"*","*");
     AcctLog->AppendLog(log);
   }
   
   char value[255];
   sprintf(value,"%f",AttrValue);
-  LogSetAttribute* log=new LogSetAttribute(Key.c_str(),AttrName.c_str(),value);
+  LogSetAttribute* log=new LogSetAttribute(Key.c_str(),AttrName,value);
   AcctLog->AppendLog(log);
+  return strtod(value, NULL);
 }
 
 //------------------------------------------------------------------
 // Set a String attribute
 //------------------------------------------------------------------
 
-void Accountant::SetAttributeString(const string& Key, const string& AttrName, const string& AttrValue)
+void Accountant::SetAttributeString(const string& Key, char const *AttrName, const string& AttrValue, bool exists)
 {
-  if (AcctLog->AdExistsInTableOrTransaction(Key) == false) {
+  if (!exists && AcctLog->AdExistsInTableOrTransaction(Key) == false) {
     LogNewClassAd* log=new LogNewClassAd(Key.c_str(),"*","*");
     AcctLog->AppendLog(log);
   }
   
   string value;
   formatstr(value,"\"%s\"",AttrValue.c_str());
-  LogSetAttribute* log=new LogSetAttribute(Key.c_str(),AttrName.c_str(),value.c_str());
+  LogSetAttribute* log=new LogSetAttribute(Key.c_str(),AttrName,value.c_str());
   AcctLog->AppendLog(log);
 }
 
@@ -1802,7 +2062,7 @@ void Accountant::LoadLimits(ClassAdListDoesNotDeleteAds &resourceList)
 		if (GetResourceState(resourceAd, state) && matched_state == state) {
 			string name = GetResourceName(resourceAd);
 			string str;
-			GetAttributeString(ResourceRecord+name,ATTR_MATCHED_CONCURRENCY_LIMITS,str);
+			GetResourceString(name,ResMatchedLimits,str);
 			IncrementLimits(str);
 		}
 	}
@@ -1830,7 +2090,7 @@ double Accountant::GetLimit(const string& limit)
 
 double Accountant::GetLimitMax(const string& limit)
 {
-    double deflim = param_double("CONCURRENCY_LIMIT_DEFAULT", 2308032);
+    double deflim = param_cached(PCD_CONCURRENCY_LIMIT_DEFAULT);
     string::size_type pos = limit.find_last_of('.');
     if (pos != string::npos) {
         string scopedef("CONCURRENCY_LIMIT_DEFAULT_");
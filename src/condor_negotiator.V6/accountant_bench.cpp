@@ -0,0 +1,170 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// test_accountant_bench - times the negotiator's accounting phase
+// (Accountant::UpdatePriorities and Accountant::CheckMatches) against a
+// synthetic pool, so changes to the accountant can be compared at scale.
+// The accountant log is written to a scratch SPOOL, which is wiped first.
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_attributes.h"
+#include "condor_classad.h"
+#include "condor_accountant.h"
+#include "utc_time.h"
+#include "GroupEntry.h"
+
+#include <vector>
+
+static void
+usage( const char *cmd )
+{
+	fprintf(stderr,"Usage: %s [options]\n",cmd);
+	fprintf(stderr,"Where options are:\n");
+	fprintf(stderr,"    -users <n>      Number of submitters (default 50000)\n");
+	fprintf(stderr,"    -slots <n>      Number of slots (default 200000)\n");
+	fprintf(stderr,"    -claimed <pct>  Percent of slots that are claimed (default 90)\n");
+	fprintf(stderr,"    -churn <pct>    Percent of claims that change each cycle (default 5)\n");
+	fprintf(stderr,"    -cycles <n>     Number of accounting cycles to time (default 5)\n");
+	fprintf(stderr,"    -spool <dir>    Scratch directory for the accountant log (default .)\n");
+	fprintf(stderr,"    -debug          Show accountant debugging info\n");
+}
+
+static void
+set_claim( ClassAd *slot, int user )
+{
+	if (user < 0) {
+		slot->Assign(ATTR_STATE, "Unclaimed");
+		slot->Assign(ATTR_ACTIVITY, "Idle");
+		slot->Delete(ATTR_REMOTE_USER);
+		return;
+	}
+	std::string name;
+	formatstr(name, "user%d@bench.example.org", user);
+	slot->Assign(ATTR_STATE, "Claimed");
+	slot->Assign(ATTR_ACTIVITY, "Busy");
+	slot->Assign(ATTR_REMOTE_USER, name);
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_users = 50000;
+	int num_slots = 200000;
+	int pct_claimed = 90;
+	int pct_churn = 5;
+	int num_cycles = 5;
+	const char *spool = ".";
+	bool debug = false;
+
+	for (int i = 1; i < argc; i++) {
+		bool has_arg = i + 1 < argc;
+		if (strcmp(argv[i], "-users") == 0 && has_arg) {
+			num_users = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-slots") == 0 && has_arg) {
+			num_slots = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-claimed") == 0 && has_arg) {
+			pct_claimed = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-churn") == 0 && has_arg) {
+			pct_churn = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-cycles") == 0 && has_arg) {
+			num_cycles = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-spool") == 0 && has_arg) {
+			spool = argv[++i];
+		} else if (strcmp(argv[i], "-debug") == 0) {
+			debug = true;
+		} else {
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+	if (num_users < 1 || num_slots < 1 || num_cycles < 1) {
+		usage(argv[0]);
+		exit(1);
+	}
+
+	set_priv_initialize();
+	config();
+	config_insert("SPOOL", spool);
+	if (debug) {
+		config_insert("TOOL_DEBUG", "D_ACCOUNTANT");
+		dprintf_set_tool_debug("TOOL", 0);
+	}
+
+	std::string log_file;
+	formatstr(log_file, "%s/Accountantnew.log", spool);
+	unlink(log_file.c_str());
+
+	GroupEntry root;
+	root.name = "<none>";
+
+	Accountant accountant;
+	double begin = condor_gettimestamp_double();
+	accountant.Initialize(&root);
+	printf("Initialize: %.3f seconds\n", condor_gettimestamp_double() - begin);
+
+	ClassAdList slots;
+	std::vector<ClassAd *> slot_ads;
+	for (int i = 0; i < num_slots; i++) {
+		ClassAd *slot = new ClassAd();
+		std::string name;
+		formatstr(name, "slot%d@node%d.bench.example.org", i % 64 + 1, i / 64);
+		slot->Assign(ATTR_NAME, name);
+		slot->Assign(ATTR_STARTD_IP_ADDR, "<10.0.0.1:9618>");
+		slot->Assign(ATTR_SLOT_WEIGHT, 1 + i % 4);
+		set_claim(slot, (i % 100) < pct_claimed ? i % num_users : -1);
+		slots.Insert(slot);
+		slot_ads.push_back(slot);
+	}
+
+	double total_update = 0, total_check = 0;
+	for (int cycle = 0; cycle <= num_cycles; cycle++) {
+		if (cycle > 0) {
+				// let some time pass, and move some of the claims around
+			sleep(1);
+			for (int i = 0; i < num_slots; i++) {
+				if (rand() % 100 < pct_churn) {
+					set_claim(slot_ads[i], (i % 100) < pct_claimed ? rand() % num_users : -1);
+				}
+			}
+		}
+
+		begin = condor_gettimestamp_double();
+		accountant.UpdatePriorities();
+		double checked = condor_gettimestamp_double();
+		accountant.CheckMatches(slots);
+		double done = condor_gettimestamp_double();
+
+			// the first cycle creates every record, so time it separately
+		printf("%s %d: UpdatePriorities %.3f seconds, CheckMatches %.3f seconds\n",
+		       cycle ? "Cycle" : "Initial load", cycle, checked - begin, done - checked);
+		if (cycle > 0) {
+			total_update += checked - begin;
+			total_check += done - checked;
+		}
+	}
+
+	printf("Average over %d cycles with %d users and %d slots: "
+	       "UpdatePriorities %.3f seconds, CheckMatches %.3f seconds\n",
+	       num_cycles, num_users, num_slots,
+	       total_update / num_cycles, total_check / num_cycles);
+
+	return 0;
+}
@@ -0,0 +1,303 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2026, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// test_accountant_tables - checks that the accountant's typed customer and
+// resource tables stay the same as the records in its ClassAd log.  A small
+// synthetic pool goes through several accounting cycles, with claims moving
+// around, slots disappearing and the Set* calls condor_userprio makes, and
+// the tables are compared with the log after each step.  Then the log is
+// replayed from disk, and must give the records the first accountant had,
+// and a second accountant that loads it must start with matching tables.
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_attributes.h"
+#include "condor_classad.h"
+#include "condor_accountant.h"
+#include "directory.h"
+#include "classad_log.h"
+#include "GroupEntry.h"
+
+#include <map>
+#include <vector>
+
+static const int NumUsers = 200;
+static const int NumSlots = 1000;
+static const char *Spool = "test_accountant_tables.spool";
+static const char *StartdAddr = "<10.0.0.1:9618>";
+
+static int failures = 0;
+
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf(stderr, "Failed %5d: %s\n", __LINE__, #condition); \
+		++failures; \
+	}
+
+static std::string
+user_name( int user )
+{
+	std::string name;
+	formatstr(name, "user%d@tables.example.org", user);
+	return name;
+}
+
+static std::string
+slot_name( int slot )
+{
+	std::string name;
+	formatstr(name, "slot%d@node%d.tables.example.org", slot % 8 + 1, slot / 8);
+	return name;
+}
+
+static void
+set_claim( ClassAd *slot, int user )
+{
+	if (user < 0) {
+		slot->Assign(ATTR_STATE, "Unclaimed");
+		slot->Assign(ATTR_ACTIVITY, "Idle");
+		slot->Delete(ATTR_REMOTE_USER);
+		return;
+	}
+	slot->Assign(ATTR_STATE, "Claimed");
+	slot->Assign(ATTR_ACTIVITY, "Busy");
+	slot->Assign(ATTR_REMOTE_USER, user_name(user));
+}
+
+static void
+check_tables( Accountant &accountant, const char *step )
+{
+	std::string why;
+	if ( ! accountant.CheckTables(why)) {
+		fprintf(stderr, "Tables differ from the log after %s: %s\n", step, why.c_str());
+		++failures;
+	}
+}
+
+	// the records and values that should survive a replay of the log.
+	// Initialize() charges usage for the time since the last update, so
+	// only the values it leaves alone are kept.
+struct Snapshot {
+	std::map<std::string, std::string> ads;		// printed, since replayed values are parsed lazily
+	std::map<std::string, std::vector<double> > values;
+};
+
+static std::vector<std::string>
+record_keys()
+{
+	std::vector<std::string> keys;
+	keys.push_back("Accountant.");
+	keys.push_back("Customer.<none>");		// the root group
+	for (int user = 0; user < NumUsers; user++) {
+		keys.push_back("Customer." + user_name(user));
+	}
+	for (int slot = 0; slot < NumSlots; slot++) {
+		keys.push_back("Resource." + slot_name(slot) + "@" + StartdAddr);
+		if (slot % 100 == 0) {
+			keys.push_back("Resource." + slot_name(slot) + "@" + StartdAddr + "_cp_match_000");
+		}
+	}
+	return keys;
+}
+
+static std::vector<double>
+customer_values( Accountant &accountant, const std::string &user )
+{
+	std::vector<double> values;
+	values.push_back(accountant.GetPriorityFactor(user));
+	values.push_back(accountant.GetCeiling(user));
+	values.push_back(accountant.GetResourcesUsed(user));
+	values.push_back(accountant.GetWeightedResourcesUsed(user));
+	return values;
+}
+
+	// the values first, since reading a customer's priority factor writes
+	// the default into a record that has none
+static void
+take_snapshot( Accountant &accountant, Snapshot &snap )
+{
+	for (int user = 0; user < NumUsers; user++) {
+		snap.values[user_name(user)] = customer_values(accountant, user_name(user));
+	}
+	std::vector<std::string> keys = record_keys();
+	for (size_t ix = 0; ix < keys.size(); ix++) {
+		ClassAd *ad = accountant.GetClassAd(keys[ix]);
+		if (ad) {
+			sPrintAd(snap.ads[keys[ix]], *ad);
+		}
+	}
+}
+
+	// the records in the log file, as the next accountant will read them
+static void
+compare_log( const std::string &log_file, const Snapshot &snap )
+{
+	ClassAdLog<std::string, ClassAd*> log(log_file.c_str());
+	REQUIRE(log.table.getNumElements() == (int)snap.ads.size());
+	std::vector<std::string> keys = record_keys();
+	for (size_t ix = 0; ix < keys.size(); ix++) {
+		ClassAd *ad = NULL;
+		bool found = log.table.lookup(keys[ix], ad) == 0;
+		std::map<std::string, std::string>::const_iterator it = snap.ads.find(keys[ix]);
+		if (found != (it != snap.ads.end())) {
+			fprintf(stderr, "Record %s %s after replay\n", keys[ix].c_str(), found ? "appeared" : "vanished");
+			++failures;
+			continue;
+		}
+		std::string printed;
+		if (found && sPrintAd(printed, *ad) && printed != it->second) {
+			fprintf(stderr, "Record %s changed after replay, from\n%sto\n%s", keys[ix].c_str(),
+			        it->second.c_str(), printed.c_str());
+			++failures;
+		}
+	}
+}
+
+static void
+compare_values( Accountant &accountant, const Snapshot &snap )
+{
+	for (int user = 0; user < NumUsers; user++) {
+		std::map<std::string, std::vector<double> >::const_iterator it = snap.values.find(user_name(user));
+		if (it == snap.values.end() || customer_values(accountant, user_name(user)) != it->second) {
+			fprintf(stderr, "Values for %s changed after replay\n", user_name(user).c_str());
+			++failures;
+		}
+	}
+		// the resource records aren't touched by Initialize()
+	std::vector<std::string> keys = record_keys();
+	for (size_t ix = 0; ix < keys.size(); ix++) {
+		if (keys[ix].compare(0, 9, "Resource.") != 0) {
+			continue;
+		}
+		ClassAd *ad = accountant.GetClassAd(keys[ix]);
+		std::map<std::string, std::string>::const_iterator it = snap.ads.find(keys[ix]);
+		std::string printed;
+		if ((ad != NULL) != (it != snap.ads.end()) ||
+		    (ad && sPrintAd(printed, *ad) && printed != it->second)) {
+			fprintf(stderr, "Resource %s changed after loading the log\n", keys[ix].c_str());
+			++failures;
+		}
+	}
+}
+
+int
+main( int /* argc */, char ** /* argv */ )
+{
+	set_priv_initialize();
+	config();
+	if (IsDirectory(Spool)) {
+		Directory dir(Spool);
+		dir.Remove_Entire_Directory();
+	} else {
+		mkdir(Spool, 0755);
+	}
+	config_insert("SPOOL", Spool);
+
+	GroupEntry root;
+	root.name = "<none>";
+
+	Accountant *accountant = new Accountant();
+	accountant->Initialize(&root);
+	check_tables(*accountant, "Initialize");
+
+	std::vector<ClassAd *> slot_ads;
+	for (int slot = 0; slot < NumSlots; slot++) {
+		ClassAd *ad = new ClassAd();
+		ad->Assign(ATTR_NAME, slot_name(slot));
+		ad->Assign(ATTR_STARTD_IP_ADDR, StartdAddr);
+		ad->Assign(ATTR_SLOT_WEIGHT, 1 + slot % 4);
+			// a few partitionable slots matched under a consumption policy
+		if (slot % 100 == 0) {
+			ad->Assign(CP_MATCH_COST, 2.5);
+		}
+		set_claim(ad, (slot % 10) < 8 ? slot % NumUsers : -1);
+		slot_ads.push_back(ad);
+	}
+
+	srand(1);
+	for (int cycle = 0; cycle < 4; cycle++) {
+		if (cycle > 0) {
+				// let some time pass, and move some of the claims around
+			sleep(1);
+			for (int slot = 0; slot < NumSlots; slot++) {
+				if (rand() % 100 < 20) {
+					set_claim(slot_ads[slot], (rand() % 10) < 8 ? rand() % NumUsers : -1);
+				}
+			}
+		}
+
+			// some slots are missing from each cycle's list
+		ClassAdListDoesNotDeleteAds slots;
+		for (int slot = 0; slot < NumSlots; slot++) {
+			if ((slot + cycle) % 37 != 0) {
+				slots.Insert(slot_ads[slot]);
+			}
+		}
+
+		accountant->UpdatePriorities();
+		check_tables(*accountant, "UpdatePriorities");
+		accountant->CheckMatches(slots);
+		check_tables(*accountant, "CheckMatches");
+
+			// and what condor_userprio does in between
+		std::string user = user_name(cycle * 10);
+		accountant->SetPriorityFactor(user, 20.0f + cycle);
+		accountant->SetCeiling(user_name(cycle * 10 + 1), 7 + cycle);
+		accountant->SetAccumUsage(user_name(cycle * 10 + 2), 123.25f * (cycle + 1));
+		accountant->SetBeginTime(user_name(cycle * 10 + 3), 1600000000 + cycle);
+		accountant->SetLastTime(user_name(cycle * 10 + 4), 1600000100 + cycle);
+		accountant->SetPriority(user_name(cycle * 10 + 5), 42.5f / (cycle + 1));
+		accountant->ResetAccumulatedUsage(user_name(cycle * 10 + 6));
+		accountant->DeleteRecord(user_name(cycle * 10 + 7));
+		check_tables(*accountant, "condor_userprio changes");
+	}
+
+	accountant->ResetAllUsage();
+	check_tables(*accountant, "ResetAllUsage");
+	ClassAdListDoesNotDeleteAds slots;
+	for (int slot = 0; slot < NumSlots; slot++) {
+		slots.Insert(slot_ads[slot]);
+	}
+	accountant->CheckMatches(slots);
+	check_tables(*accountant, "the last CheckMatches");
+
+		// replay the log, then load it into a new accountant
+	Snapshot snap;
+	take_snapshot(*accountant, snap);
+	REQUIRE(snap.ads.size() > (size_t)NumSlots / 2);
+	delete accountant;
+
+	std::string log_file(Spool);
+	log_file += "/Accountantnew.log";
+	compare_log(log_file, snap);
+
+	accountant = new Accountant();
+	accountant->Initialize(&root);
+	check_tables(*accountant, "loading the log");
+	compare_values(*accountant, snap);
+	delete accountant;
+
+	for (size_t ix = 0; ix < slot_ads.size(); ix++) { delete slot_ads[ix]; }
+
+	if (failures == 0) {
+		fprintf(stdout, "No failures detected.\n");
+	}
+	return failures;
+}
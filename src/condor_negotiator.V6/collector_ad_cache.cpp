@@ -0,0 +1,257 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_attributes.h"
+#include "condor_adtypes.h"
+#include "condor_classad.h"
+#include "utc_time.h"
+#include "collector_ad_cache.h"
+
+CollectorAdCache::CollectorAdCache(const char *name)
+	: m_name(name),
+	m_generation(0),
+	m_summary(NULL),
+	m_bytesPerAd(0.0),
+	m_secondsPerAd(0.0),
+	m_fullQueries(0),
+	m_incrementalQueries(0),
+	m_bytesSaved(0.0),
+	m_secondsSaved(0.0)
+{
+}
+
+CollectorAdCache::~CollectorAdCache()
+{
+	discardReceived();
+	clear();
+}
+
+void
+CollectorAdCache::clear()
+{
+	std::map<std::string, ClassAd *>::iterator it;
+	for (it = m_ads.begin(); it != m_ads.end(); ++it) {
+		delete it->second;
+	}
+	m_ads.clear();
+	m_epoch.clear();
+	m_generation = 0;
+}
+
+void
+CollectorAdCache::discardReceived()
+{
+	for (size_t i = 0; i < m_received.size(); i++) {
+		delete m_received[i].second;
+	}
+	m_received.clear();
+	delete m_summary;
+	m_summary = NULL;
+}
+
+bool
+CollectorAdCache::receiveAd(void *pv, ClassAd *ad)
+{
+	CollectorAdCache *cache = (CollectorAdCache *)pv;
+
+	const char *type = GetMyTypeName(*ad);
+	if (type && strcmp(type, CHANGELOG_ADTYPE) == 0) {
+		delete cache->m_summary;
+		cache->m_summary = ad;
+		return false;
+	}
+
+	std::string key;
+	ad->LookupString(ATTR_CHANGELOG_KEY, key);
+	ad->Delete(ATTR_CHANGELOG_KEY);
+	cache->m_received.push_back(std::make_pair(key, ad));
+	return false;
+}
+
+void
+CollectorAdCache::setQueryGeneration(CondorQuery &query) const
+{
+	std::string epoch;
+	formatstr(epoch, "\"%s\"", m_epoch.c_str());
+	query.addExtraAttribute(ATTR_CHANGELOG_EPOCH, epoch.c_str());
+	query.addExtraAttribute(ATTR_CHANGELOG_GENERATION, std::to_string(m_generation).c_str());
+}
+
+	// A collector failed partway through its reply and another is about
+	// to be asked.  What the first one sent can't be told apart from what
+	// the second sends, so throw it away, and ask for everything.
+void
+CollectorAdCache::failover(void *pv, CondorQuery &query)
+{
+	CollectorAdCache *cache = (CollectorAdCache *)pv;
+	dprintf(D_FULLDEBUG, "%s ad cache: failing over to another collector, starting over\n", cache->m_name.c_str());
+	cache->discardReceived();
+	cache->clear();
+	cache->setQueryGeneration(query);
+}
+
+QueryResult
+CollectorAdCache::fetch(CollectorList *collectors, CondorQuery &query,
+                        ClassAdList &adList, CondorError *errstack)
+{
+	double begin = condor_gettimestamp_double();
+
+		// The cached ads only answer the query they were fetched with.
+		// If the constraint or projection changed, start over.
+	ClassAd queryAd;
+	std::string queryStr;
+	query.getQueryAd(queryAd);
+	sPrintAd(queryStr, queryAd);
+	if (queryStr != m_query) {
+		clear();
+		m_query = queryStr;
+	}
+
+	setQueryGeneration(query);
+
+	discardReceived();
+	QueryResult result = collectors->query(query, receiveAd, this, errstack, failover);
+	if (result != Q_OK) {
+			// The cache still matches m_generation, so the next fetch
+			// can pick up where this one should have.
+		discardReceived();
+		return result;
+	}
+
+	if ( ! m_summary) {
+			// This collector doesn't keep a changelog, so what we
+			// got is just the result of an ordinary query.
+		dprintf(D_FULLDEBUG, "%s ad cache: collector sent no changelog, not caching\n", m_name.c_str());
+		clear();
+		for (size_t i = 0; i < m_received.size(); i++) {
+			adList.Insert(m_received[i].second);
+		}
+		m_received.clear();
+		return Q_OK;
+	}
+
+	bool full_refresh = true;
+	long long unchanged = 0;
+	long long bytes_sent = 0;
+	m_summary->LookupBool(ATTR_CHANGELOG_FULL_REFRESH, full_refresh);
+	m_summary->LookupInteger(ATTR_CHANGELOG_UNCHANGED_ADS, unchanged);
+	m_summary->LookupInteger(ATTR_CHANGELOG_BYTES_SENT, bytes_sent);
+
+	size_t removed = 0;
+	if (full_refresh) {
+		clear();
+	} else {
+		classad::ExprList *list = NULL;
+		classad::Value val;
+		if (m_summary->EvaluateAttr(ATTR_CHANGELOG_REMOVED, val) && val.IsListValue(list)) {
+			std::string key;
+			for (classad::ExprList::iterator it = list->begin(); it != list->end(); ++it) {
+				classad::Value item;
+				if ( ! (*it)->Evaluate(item) || ! item.IsStringValue(key)) {
+					continue;
+				}
+				std::map<std::string, ClassAd *>::iterator found = m_ads.find(key);
+				if (found != m_ads.end()) {
+					delete found->second;
+					m_ads.erase(found);
+					removed++;
+				}
+			}
+		}
+	}
+
+	bool keyless = false;
+	for (size_t i = 0; i < m_received.size(); i++) {
+		const std::string &key = m_received[i].first;
+		ClassAd *ad = m_received[i].second;
+		if (key.empty()) {
+				// can't be patched later, so hand it out this once
+				// and make sure the next fetch is a full one
+			adList.Insert(ad);
+			keyless = true;
+			continue;
+		}
+		ClassAd *&slot = m_ads[key];
+		delete slot;
+		slot = ad;
+	}
+	size_t changed = m_received.size();
+	m_received.clear();
+
+	m_summary->LookupString(ATTR_CHANGELOG_EPOCH, m_epoch);
+	m_summary->LookupInteger(ATTR_CHANGELOG_GENERATION, m_generation);
+	if (keyless) {
+		m_epoch.clear();
+	}
+	delete m_summary;
+	m_summary = NULL;
+
+		// The caller changes the ads it gets, so rather than copy each
+		// cached ad, hand out an empty ad chained to it.  Changes go into
+		// the empty ad, and the cached one stays as the collector sent it.
+	std::map<std::string, ClassAd *>::const_iterator it;
+	for (it = m_ads.begin(); it != m_ads.end(); ++it) {
+		ClassAd *ad = new ClassAd();
+		ad->ChainToAd(it->second);
+		adList.Insert(ad);
+	}
+
+	double elapsed = condor_gettimestamp_double() - begin;
+	if (full_refresh) {
+		m_fullQueries++;
+		if (changed > 0) {
+			m_bytesPerAd = (double)bytes_sent / changed;
+			m_secondsPerAd = elapsed / changed;
+		}
+		dprintf(D_ALWAYS, "%s ad cache: full fetch of %d ads, %lld bytes in %.3f seconds\n",
+		        m_name.c_str(), (int)changed, bytes_sent, elapsed);
+	} else {
+		m_incrementalQueries++;
+			// what a full fetch of the same ads would have cost, based
+			// on the last one we did
+		double bytes_saved = m_bytesPerAd * m_ads.size() - bytes_sent;
+		double seconds_saved = m_secondsPerAd * m_ads.size() - elapsed;
+		if (bytes_saved > 0) { m_bytesSaved += bytes_saved; }
+		if (seconds_saved > 0) { m_secondsSaved += seconds_saved; }
+		dprintf(D_ALWAYS, "%s ad cache: %d changed, %d removed, %lld unchanged ads; "
+		        "%lld bytes in %.3f seconds (saved about %.0f bytes and %.3f seconds)\n",
+		        m_name.c_str(), (int)changed, (int)removed, unchanged,
+		        bytes_sent, elapsed, MAX(bytes_saved, 0.0), MAX(seconds_saved, 0.0));
+	}
+
+	return Q_OK;
+}
+
+void
+CollectorAdCache::publish(ClassAd &ad) const
+{
+	std::string attr;
+	formatstr(attr, "%sAdCacheAds", m_name.c_str());
+	ad.Assign(attr, (long long)m_ads.size());
+	formatstr(attr, "%sAdCacheFullQueries", m_name.c_str());
+	ad.Assign(attr, m_fullQueries);
+	formatstr(attr, "%sAdCacheIncrementalQueries", m_name.c_str());
+	ad.Assign(attr, m_incrementalQueries);
+	formatstr(attr, "%sAdCacheBytesSaved", m_name.c_str());
+	ad.Assign(attr, m_bytesSaved);
+	formatstr(attr, "%sAdCacheSecondsSaved", m_name.c_str());
+	ad.Assign(attr, m_secondsSaved);
+}
@@ -0,0 +1,85 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _COLLECTOR_AD_CACHE_H
+#define _COLLECTOR_AD_CACHE_H
+
+#include "condor_query.h"
+#include "daemon_list.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Keeps the ads returned by a collector query from one negotiation cycle
+// to the next.  Each fetch asks the collector for only the ads that were
+// added, changed or removed since the generation of the previous fetch,
+// patches the cache with them, and hands back an ad chained to every
+// cached ad.
+// If the collector doesn't know our generation (it restarted, we failed
+// over to another collector, or its changelog wrapped) it sends all ads
+// and the cache starts over; collectors that predate the changelog just
+// get an ordinary query.
+class CollectorAdCache {
+
+ public:
+	CollectorAdCache(const char *name);
+	~CollectorAdCache();
+
+		// Query the collectors and append each matching ad to adList,
+		// which takes ownership of them.  Most are empty ads chained to
+		// the cached ones, so they must be deleted before the next call
+		// to fetch() or clear(); copy one with UpdateFromChain() to keep
+		// it longer.
+	QueryResult fetch(CollectorList *collectors, CondorQuery &query,
+	                  ClassAdList &adList, CondorError *errstack = NULL);
+
+		// Forget all cached ads; the next fetch will be a full one.
+	void clear();
+
+		// Publish the savings, as <name>AdCache* attributes.
+	void publish(ClassAd &ad) const;
+
+ private:
+	static bool receiveAd(void *pv, ClassAd *ad);
+	static void failover(void *pv, CondorQuery &query);
+	void setQueryGeneration(CondorQuery &query) const;
+	void discardReceived();
+
+	std::string m_name;
+	std::string m_query;	// the query the cached ads answer
+	std::string m_epoch;
+	long long m_generation;
+	std::map<std::string, ClassAd *> m_ads;
+
+		// ads from the fetch in progress, and its closing summary
+	std::vector<std::pair<std::string, ClassAd *> > m_received;
+	ClassAd *m_summary;
+
+		// cost of the last full fetch, for estimating savings
+	double m_bytesPerAd;
+	double m_secondsPerAd;
+
+	long long m_fullQueries;
+	long long m_incrementalQueries;
+	double m_bytesSaved;
+	double m_secondsSaved;
+};
+
+#endif
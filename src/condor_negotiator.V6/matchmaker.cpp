@@ -36,6 +36,8 @@
 #include "condor_netdb.h"
 #include "condor_claimid_parser.h"
 #include "misc_utils.h"
+#include "utc_time.h"
+#include "param_cache.h"
 #include "NegotiationUtils.h"
 #include "MyString.h"
 #include "condor_daemon_core.h"
@@ -362,7 +364,9 @@ get_rusage_utime()
 
 Matchmaker::
 Matchmaker ()
-   : strSlotConstraint(NULL)
+   : publicAdCache("Public")
+   , privateAdCache("Private")
+   , strSlotConstraint(NULL)
    , SlotPoolsizeConstraint(NULL)
 {
 	char buf[64];
@@ -771,6 +775,11 @@ reinitialize ()
 	PublishCrossSlotPrios = param_boolean("NEGOTIATOR_CROSS_SLOT_PRIOS", false);
 	ConsiderPreemption = param_boolean("NEGOTIATOR_CONSIDER_PREEMPTION",true);
 	ConsiderEarlyPreemption = param_boolean("NEGOTIATOR_CONSIDER_EARLY_PREEMPTION",false);
+	want_incremental_collector_query = param_boolean("NEGOTIATOR_INCREMENTAL_COLLECTOR_QUERY", false);
+	if ( ! want_incremental_collector_query) {
+		publicAdCache.clear();
+		privateAdCache.clear();
+	}
 	if( ConsiderEarlyPreemption && !ConsiderPreemption ) {
 		dprintf(D_ALWAYS,"WARNING: NEGOTIATOR_CONSIDER_EARLY_PREEMPTION=true will be ignored, because NEGOTIATOR_CONSIDER_PREEMPTION=false\n");
 	}
@@ -1323,6 +1332,14 @@ compute_significant_attrs(ClassAdListDoesNotDeleteAds & startdAds)
 		for ( attr_it = startd_ad->begin(); attr_it != startd_ad->end(); attr_it++ ) {
 			startd_ad->GetExternalReferences( attr_it->second, external_references, true );
 		}
+			// ads from the incremental collector query are chained to
+			// the cached ones
+		ClassAd *parent = startd_ad->GetChainedParentAd();
+		if ( parent ) {
+			for ( attr_it = parent->begin(); attr_it != parent->end(); attr_it++ ) {
+				startd_ad->GetExternalReferences( attr_it->second, external_references, true );
+			}
+		}
 	}	// while startd_ad
 
 	// Now add external attributes references from negotiator policy exprs; at
@@ -1615,8 +1632,15 @@ negotiationTime ()
 	job_attr_references = compute_significant_attrs(startdAds);
 
 	// ----- Recalculate priorities for schedds
+	double accounting_start = condor_gettimestamp_double();
 	accountant.UpdatePriorities();
+	double accounting_checked = condor_gettimestamp_double();
 	accountant.CheckMatches( startdAds );
+	double accounting_done = condor_gettimestamp_double();
+	dprintf( D_ALWAYS, "Accounting took %.3f seconds (UpdatePriorities %.3f, CheckMatches %.3f)\n",
+			 accounting_done - accounting_start,
+			 accounting_checked - accounting_start,
+			 accounting_done - accounting_checked );
 
 	if ( !groupQuotasHash ) {
 		groupQuotasHash = new groupQuotasHashType(hashFunction);
@@ -2956,7 +2980,11 @@ obtainAdsFromCollector (
 
 	dprintf(D_ALWAYS,"  Getting startd private ads ...\n");
 	ClassAdList startdPvtAdList;
-	result = collects->query (privateQuery, startdPvtAdList);
+	if (want_incremental_collector_query) {
+		result = privateAdCache.fetch(collects, privateQuery, startdPvtAdList);
+	} else {
+		result = collects->query (privateQuery, startdPvtAdList);
+	}
 	if( result!=Q_OK ) {
 		dprintf(D_ALWAYS, "Couldn't fetch ads: %s\n", getStrQueryResult(result));
 		return false;
@@ -2964,7 +2992,11 @@ obtainAdsFromCollector (
 
     CondorError errstack;
 	dprintf(D_ALWAYS, "  Getting Scheduler, Submitter and Machine ads ...\n");
-	result = collects->query (publicQuery, allAds, &errstack);
+	if (want_incremental_collector_query) {
+		result = publicAdCache.fetch(collects, publicQuery, allAds, &errstack);
+	} else {
+		result = collects->query (publicQuery, allAds, &errstack);
+	}
 	if( result!=Q_OK ) {
 		dprintf(D_ALWAYS, "Couldn't fetch ads: %s\n",
            errstack.code() ? errstack.getFullText(false).c_str() : getStrQueryResult(result)
@@ -3088,7 +3120,9 @@ obtainAdsFromCollector (
 					MapEntry *me = new MapEntry;
 					me->sequenceNum = newSequence;
 					me->remoteHost = strdup(remoteHost);
-					me->oldAd = new ClassAd(*ad);
+						// outlives this cycle, so don't copy the chain
+					me->oldAd = new ClassAd();
+					me->oldAd->UpdateFromChain(*ad);
 					stashedAds->insert(adID, me);
 				} else {
 					/*
@@ -3222,7 +3256,7 @@ obtainAdsFromCollector (
 
 	// Map slot names to slot Classads, used by pslotMultiMatch() to
 	// quickly find a given dslot ad.
-	if (param_boolean("ALLOW_PSLOT_PREEMPTION", false))  {
+	if (param_cached(PCB_ALLOW_PSLOT_PREEMPTION))  {
 		ClassAd *ad;
 		std::string name;
 		startdAds.Open();
@@ -3288,7 +3322,7 @@ Matchmaker::MakeClaimIdHash(ClassAdList &startdPvtAdList, ClaimIdHash &claimIds)
 	ClassAd *ad;
 	startdPvtAdList.Open();
 
-	bool pslotPreempt = param_boolean("ALLOW_PSLOT_PREEMPTION", false);
+	bool pslotPreempt = param_cached(PCB_ALLOW_PSLOT_PREEMPTION);
 	childClaimHash.clear();
 
 	while( (ad = startdPvtAdList.Next()) ) {
@@ -4212,7 +4246,7 @@ negotiate(char const* groupName, char const *submitterName, const ClassAd *submi
         }
         dprintf(D_FULLDEBUG, "Match completed, match cost= %g\n", match_cost);
 
-		if (param_boolean("NEGOTIATOR_DEPTH_FIRST", false)) {
+		if (param_cached(PCB_NEGOTIATOR_DEPTH_FIRST)) {
 			schedd_will_match = jobsInSlot(request, *offer);
 		}
 
@@ -4552,13 +4586,13 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, ClassAd
 	rejPreemptForRank = 0;
 	rejForSubmitterLimit = 0;
 
-	bool allow_pslot_preemption = param_boolean("ALLOW_PSLOT_PREEMPTION", false);
+	bool allow_pslot_preemption = param_cached(PCB_ALLOW_PSLOT_PREEMPTION);
 	double allocatedWeight = 0.0;
 		// Set up for parallel matchmaking, if enabled
 	std::vector<ClassAd *> par_candidates;
 	std::vector<ClassAd *> par_matches;
 
-	int num_threads =  param_integer("NEGOTIATOR_NUM_THREADS", 1);
+	int num_threads =  param_cached(PCI_NEGOTIATOR_NUM_THREADS);
 	if (num_threads > 1) {
 		startdAds.Open();
 		par_candidates.reserve(startdAds.Length());
@@ -5362,7 +5396,7 @@ Matchmaker::calculateSubmitterLimit(
 	submitterUsage = accountant.GetWeightedResourcesUsed( submitterName );
 	submitterShare = maxPrioValue/(submitterPrio*normalFactor);
 
-	if ( param_boolean("NEGOTIATOR_IGNORE_USER_PRIORITIES",false) ) {
+	if ( param_cached(PCB_NEGOTIATOR_IGNORE_USER_PRIORITIES) ) {
 		submitterLimit = DBL_MAX;
 	} else {
 		submitterLimit = (submitterShare*slotWeightTotal)-submitterUsage;
@@ -5614,7 +5648,8 @@ reeval(ClassAd *ad)
 	ad->Assign("CurMatches", cur_matches);
 	if(oldAdEntry) {
 		delete(oldAdEntry->oldAd);
-		oldAdEntry->oldAd = new ClassAd(*ad);
+		oldAdEntry->oldAd = new ClassAd();
+		oldAdEntry->oldAd->UpdateFromChain(*ad);
 	}
 }
 
@@ -6008,6 +6043,10 @@ Matchmaker::updateCollector() {
 
 	if( publicAd ) {
 		publishNegotiationCycleStats( publicAd );
+		if (want_incremental_collector_query) {
+			publicAdCache.publish( *publicAd );
+			privateAdCache.publish( *publicAd );
+		}
 
         daemonCore->dc_stats.Publish(*publicAd);
 		daemonCore->monitor_data.ExportData(publicAd);
@@ -28,6 +28,7 @@
 #include "dc_collector.h"
 #include "condor_ver_info.h"
 #include "matchmaker_negotiate.h"
+#include "collector_ad_cache.h"
 #include "GroupEntry.h"
 
 #include <vector>
@@ -329,6 +330,9 @@ class Matchmaker : public Service
 		bool PublishCrossSlotPrios; // value of knob NEGOTIATOR_CROSS_SLOT_PRIOS, default of false
 		bool ConsiderPreemption; // if false, negotiation is faster (default=true)
 		bool ConsiderEarlyPreemption; // if false, do not preempt slots that still have retirement time
+		bool want_incremental_collector_query; // value of knob NEGOTIATOR_INCREMENTAL_COLLECTOR_QUERY
+		CollectorAdCache publicAdCache;	// startd and submitter ads kept between cycles
+		CollectorAdCache privateAdCache;	// startd private ads kept between cycles
 		/// Should the negotiator inform startds of matches?
 		bool want_inform_startd;	
 		/// Should the negotiator use non-blocking connect to contact startds?
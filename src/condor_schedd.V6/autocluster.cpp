@@ -64,6 +64,7 @@ JobCluster::~JobCluster()
 void JobCluster::clear()
 {
 	cluster_map.clear();
+	cluster_index.clear();
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
 	cluster_use.clear();
 	cluster_gone.clear();
@@ -195,7 +196,7 @@ void JobCluster::collect_garbage(bool brute_force) // free the deleted clusters
 		}
 		// advance here so that we can erase the previous entry if needed.
 		JobSigidMap::iterator last = it++;
-		if (gone) { cluster_map.erase(last); }
+		if (gone) { erase_cluster(last); }
 	}
 	cluster_gone.clear();
 }
@@ -204,6 +205,75 @@ void JobCluster::collect_garbage(bool brute_force) // free the deleted clusters
 
 extern int    last_autocluster_classad_cache_hit;
 
+// Streaming 128 bit hash over the bytes of a signature.  Feeding it a
+// signature a piece at a time gives the same result as feeding it the
+// whole string, so the hash of a stored signature can be recomputed.
+class SigHasher {
+public:
+	SigHasher() : a(0xcbf29ce484222325ULL), b(0x6a09e667f3bcc909ULL) {}
+	void add(const char * p, size_t len) {
+		for (size_t i = 0; i < len; ++i) {
+			unsigned char c = (unsigned char)p[i];
+			a = (a ^ c) * 0x100000001b3ULL;
+			b = (b + c) * 0x9e3779b97f4a7c15ULL;
+			b ^= b >> 32;
+		}
+	}
+	void add(const std::string & str) { add(str.data(), str.size()); }
+	JobCluster::SigHash result() const {
+		JobCluster::SigHash h;
+		h.lo = fmix(a ^ (b << 23 | b >> 41));
+		h.hi = fmix(b + a);
+		return h;
+	}
+private:
+	static uint64_t fmix(uint64_t k) {
+		k ^= k >> 33; k *= 0xff51afd7ed558ccdULL;
+		k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ULL;
+		k ^= k >> 33;
+		return k;
+	}
+	uint64_t a, b;
+};
+
+// One "attr = value\n" line of a signature.  The value text is a span
+// of the scratch buffer the values were unparsed into.
+struct SigLine {
+	const std::string * attr;
+	size_t off, len;
+};
+
+static bool sig_lines_match(const std::string & sig, const std::vector<SigLine> & lines, const std::string & text)
+{
+	size_t pos = 0;
+	for (std::vector<SigLine>::const_iterator it = lines.begin(); it != lines.end(); ++it) {
+		size_t cch = it->attr->size() + 3 + it->len + 1;
+		if (sig.size() - pos < cch ||
+			sig.compare(pos, it->attr->size(), *it->attr) != 0 ||
+			sig.compare(pos + it->attr->size(), 3, " = ") != 0 ||
+			sig.compare(pos + it->attr->size() + 3, it->len, text, it->off, it->len) != 0 ||
+			sig[pos + cch - 1] != '\n') {
+			return false;
+		}
+		pos += cch;
+	}
+	return pos == sig.size();
+}
+
+void JobCluster::erase_cluster(JobSigidMap::iterator it)
+{
+	SigHasher hasher;
+	hasher.add(it->first);
+	std::pair<JobSighashMap::iterator, JobSighashMap::iterator> range = cluster_index.equal_range(hasher.result());
+	for (JobSighashMap::iterator hit = range.first; hit != range.second; ++hit) {
+		if (hit->second == it) {
+			cluster_index.erase(hit);
+			break;
+		}
+	}
+	cluster_map.erase(it);
+}
+
 int JobCluster::getClusterid(JobQueueJob & job, bool expand_refs, std::string * final_list)
 {
 	int cur_id = -1;
@@ -214,11 +284,14 @@ int JobCluster::getClusterid(JobQueueJob & job, bool expand_refs, std::string *
 	// the keys that the significant_attrs values refer to that are internal references.
 	// the order of the keys in the signature will be the same as the order specified in significant_attrs
 	// followed by the expanded keys in case-insensitive alpha order.
+	// Rather than building the signature, we hash it as we go, and only build it
+	// when there is no existing autocluster with the same signature.
 
 	// first put build a set of class ad values, one for each significant attribute
 	//
 	classad::References exattrs;   // expanded attribs if requested
 	std::vector<ExprTree*> sigset; // significant values, including expanded attribs if requested
+	std::vector<std::string> sigattrs; // names of the significant attributes, in order
 
 	// walk significant attributes list and fetch values for each attrib
 	// also fetch internal references if requested.
@@ -227,6 +300,7 @@ int JobCluster::getClusterid(JobQueueJob & job, bool expand_refs, std::string *
 	while ((attr = list.next_string())) {
 		ExprTree * tree = job.Lookup(*attr);
 		sigset.push_back(tree);
+		sigattrs.push_back(*attr);
 		if (expand_refs && tree) {
 			job.GetInternalReferences(tree, exattrs, false);
 		}
@@ -237,9 +311,8 @@ int JobCluster::getClusterid(JobQueueJob & job, bool expand_refs, std::string *
 	if (expand_refs) {
 		if ( ! exattrs.empty()) {
 			// remove expanded attrs that already appear in the significant_attrs list
-			list.rewind();
-			while ((attr = list.next_string())) {
-				classad::References::iterator it = exattrs.find(*attr);
+			for (size_t ix = 0; ix < sigattrs.size(); ++ix) {
+				classad::References::iterator it = exattrs.find(sigattrs[ix]);
 				if (it != exattrs.end()) {
 					exattrs.erase(it);
 				}
@@ -252,58 +325,72 @@ int JobCluster::getClusterid(JobQueueJob & job, bool expand_refs, std::string *
 	}
 
 	// sigset now contains the values of all the attributes we need,
-	// significant attibutes are first, followed by expanded attributes
-	// we build a signature essentially by printing it all out in one big string
+	// significant attibutes are first, followed by expanded attributes.
+	// now unparse each value into scratch.  we always unparse rather than
+	// use the text the classad cache keeps, because that is the text the
+	// value was parsed from, and signatures must not depend on spelling.
 	//
-	bool need_sep = false; // true after the first item, (when we need to print separators)
-	std::string signature;
-	signature.reserve(strlen(significant_attrs) + exattrs.size()*20 + sigset.size()*20); // make a guess as to how much space the signature will take.
+	std::vector<SigLine> lines;
+	lines.reserve(sigset.size());
+	std::string scratch;
 
 	classad::ClassAdUnParser unp;
 	unp.SetOldClassAd( true, true );
 
-	// first put the pre-defined significant attrs in the sig
-	list.rewind();
-	int ix = 0;
-	while ((attr = list.next_string())) {
+	classad::References::iterator xit = exattrs.begin();
+	for (size_t ix = 0; ix < sigset.size(); ++ix) {
+		SigLine line;
+		line.attr = (ix < sigattrs.size()) ? &sigattrs[ix] : &*(xit++);
 		ExprTree * tree = sigset[ix];
-		signature += *attr;
-		signature += " = ";
-		if (tree) { unp.Unparse(signature, tree); }
-		signature += '\n';
+		line.off = scratch.size();
+		if (tree) { unp.Unparse(scratch, tree); }
+		line.len = scratch.size() - line.off;
+		lines.push_back(line);
+
 		if (final_list) {
-			if (need_sep) { (*final_list) += ','; }
-			final_list->append(*attr);
-			need_sep = true;
+			if ( ! final_list->empty()) { (*final_list) += ','; }
+			final_list->append(*line.attr);
 		}
-		++ix;
 	}
 
-	// now put out the expanded attribs (if any)
-	for (classad::References::iterator it = exattrs.begin(); it != exattrs.end(); ++it) {
-		ExprTree * tree = sigset[ix];
-		signature += *it;
-		signature += " = ";
-		if (tree) { unp.Unparse(signature, tree); }
-		signature += '\n';
-		if (final_list) {
-			if (need_sep) { (*final_list) += ','; }
-			final_list->append(*it);
-			need_sep = true;
-		}
-		++ix;
+	SigHasher hasher;
+	size_t cch = 0;
+	for (std::vector<SigLine>::iterator it = lines.begin(); it != lines.end(); ++it) {
+		hasher.add(*it->attr);
+		hasher.add(" = ", 3);
+		hasher.add(scratch.data() + it->off, it->len);
+		hasher.add("\n", 1);
+		cch += it->attr->size() + 3 + it->len + 1;
 	}
+	SigHash hash = hasher.result();
 
 	// now check the signature against the current cluster map
 	// and either return the matching cluster id, or a new cluster id.
-	JobSigidMap::iterator it;
-	it = cluster_map.find(signature);
-	if (it != cluster_map.end()) {
-		cur_id = it->second;
+	std::pair<JobSighashMap::iterator, JobSighashMap::iterator> range = cluster_index.equal_range(hash);
+	for (JobSighashMap::iterator hit = range.first; hit != range.second; ++hit) {
+		if (sig_lines_match(hit->second->first, lines, scratch)) {
+			cur_id = hit->second->second;
+			break;
+		}
 	}
-	else {
+	if (cur_id < 0) {
+		std::string signature;
+		signature.reserve(cch);
+		for (std::vector<SigLine>::iterator it = lines.begin(); it != lines.end(); ++it) {
+			signature += *it->attr;
+			signature += " = ";
+			signature.append(scratch, it->off, it->len);
+			signature += '\n';
+		}
 		cur_id = next_id++;
-		cluster_map.insert(JobSigidMap::value_type(signature,cur_id));
+		std::pair<JobSigidMap::iterator, bool> ins = cluster_map.insert(JobSigidMap::value_type(signature,cur_id));
+		if (ins.second) {
+			cluster_index.insert(JobSighashMap::value_type(hash, ins.first));
+		} else {
+			// can only happen if the hash index lost track of a signature
+			cur_id = ins.first->second;
+			--next_id;
+		}
 	}
 
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
@@ -549,7 +636,7 @@ void AutoCluster::sweep()
 		if (in_use == cluster_in_use.end()) {
 				// found an entry to remove.
 			dprintf(D_FULLDEBUG,"removing auto cluster id %d\n",id);
-			cluster_map.erase( it );
+			erase_cluster( it );
 		}
 	}
 }
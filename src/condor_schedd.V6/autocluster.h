@@ -26,10 +26,12 @@
 
 #include "condor_classad.h"
 #include <generic_stats.h>
+#include <unordered_map>
 
 class JobIdSet;
 class JobAggregationResults;
 class JobQueueJob;
+class SigHasher;
 
 class JobCluster {
 public:
@@ -50,8 +52,22 @@ public:
 
 protected:
 	friend class JobAggregationResults;
+	friend class SigHasher;
 	typedef std::map<std::string,int> JobSigidMap;
 	JobSigidMap cluster_map;  // map of signature to a cluster id
+
+	// 128 bit hash of a signature, so that a job's cluster can be found
+	// without building its signature string.
+	struct SigHash {
+		uint64_t lo, hi;
+		bool operator==(const SigHash &rhs) const { return lo == rhs.lo && hi == rhs.hi; }
+	};
+	struct SigHashFn {
+		size_t operator()(const SigHash &h) const { return (size_t)h.lo; }
+	};
+	typedef std::unordered_multimap<SigHash, JobSigidMap::iterator, SigHashFn> JobSighashMap;
+	JobSighashMap cluster_index; // signature hash to cluster_map entry, verified on lookup
+	void erase_cluster(JobSigidMap::iterator it); // remove from both cluster_map and cluster_index
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
 	typedef std::map<int, JobIdSet> JobIdSetMap;
 	JobIdSetMap cluster_use; // map clusterId to a set of jobIds
@@ -55,6 +55,7 @@
 #include "classad_helpers.h"
 #include "iso_dates.h"
 #include "jobsets.h"
+#include "param_cache.h"
 #include <param_info.h>
 
 #if defined(HAVE_DLOPEN) || defined(WIN32)
@@ -483,6 +484,7 @@ int GetSchedulerCapabilities(int /*mask*/, ClassAd & reply)
 {
 	reply.Assign( "LateMaterialize", scheduler.getAllowLateMaterialize() );
 	reply.Assign("LateMaterializeVersion", 2);
+	reply.Assign("SetAttributes", true);
 	dprintf(D_ALWAYS, "GetSchedulerCapabilities called, returning\n");
 	dPrintAd(D_ALWAYS, reply);
 	return 0;
@@ -552,15 +554,25 @@ bool CheckMaterializePolicyExpression(JobQueueCluster * /*cad*/, int & /*retry_d
 }
 #endif
 
+schedd_runtime_probe JobMaterialize_runtime;
+
+// cluster to start with on the next pass of the materialize timer, so that when a pass
+// stops at SCHEDD_MATERIALIZE_BATCH_SIZE jobs, the clusters after it get their turn.
+static int next_cluster_to_materialize = 0;
+
 // This timer is after when we create a job factory, change the pause state of one or more job factories, or
 // remove a job that is part of a cluster with a job factory. What we want to do here
 // is either materialize a new job in that cluster, queue up a read of itemdata for the job factory
 // or schedule the cluster for removal.
+// Each pass materializes at most SCHEDD_MATERIALIZE_BATCH_SIZE jobs. If there is more to do
+// the timer is set to fire again right away, so the rest of the main loop gets to run between batches.
 // 
 void
 JobMaterializeTimerCallback()
 {
 	dprintf(D_MATERIALIZE | D_VERBOSE, "in JobMaterializeTimerCallback\n");
+	condor_auto_runtime rt(JobMaterialize_runtime);
+	bool batch_full = false;
 
 	bool allow_materialize = scheduler.getAllowLateMaterialize();
 	if ( ! allow_materialize || ! JobQueue) {
@@ -572,12 +584,27 @@ JobMaterializeTimerCallback()
 		system_limit = MIN(system_limit, scheduler.getMaxJobsPerOwner());
 		//system_limit = MIN(system_limit, scheduler.getMaxJobsRunning());
 
+		int batch_limit = scheduler.getMaterializeBatchSize();
+		if (batch_limit <= 0) { batch_limit = INT_MAX; }
+
+		// visit the clusters needing work starting where the last pass left off.
+		std::vector<int> work;
+		work.reserve(ClustersNeedingMaterialize.size());
+		auto start = ClustersNeedingMaterialize.lower_bound(next_cluster_to_materialize);
+		work.insert(work.end(), start, ClustersNeedingMaterialize.end());
+		work.insert(work.end(), ClustersNeedingMaterialize.begin(), start);
+
 		int total_new_jobs = 0;
 		// iterate the list of clusters needing work, removing them from the work list when they
 		// no longer need future materialization.
-		for (auto it = ClustersNeedingMaterialize.begin(); it != ClustersNeedingMaterialize.end(); /*next handled in loop*/) {
+		for (auto it = work.begin(); it != work.end(); ++it) {
 			int cluster_id = *it;
-			auto prev = it++;
+
+			if (total_new_jobs >= batch_limit) {
+				next_cluster_to_materialize = cluster_id;
+				batch_full = true;
+				break;
+			}
 
 			bool remove_entry = true;
 			JobQueueCluster * cad = GetClusterAd(cluster_id);
@@ -611,6 +638,11 @@ JobMaterializeTimerCallback()
 					int num_materialized = 0;
 					int cluster_size = cad->ClusterSize();
 					while ((cluster_size + num_materialized) < effective_limit) {
+						if (total_new_jobs + num_materialized >= batch_limit) {
+							// this cluster has more to do, pick up here on the next pass.
+							remove_entry = false;
+							break;
+						}
 						int retry_delay = 0; // will be set to non-zero when we should try again later.
 						int rv = 0;
 						if (CheckMaterializePolicyExpression(cad, num_materialized, retry_delay)) {
@@ -663,18 +695,27 @@ JobMaterializeTimerCallback()
 
 			// factory is paused or completed in some way, so take it out of the list of clusters to service.
 			if (remove_entry) {
-				ClustersNeedingMaterialize.erase(prev);
+				ClustersNeedingMaterialize.erase(cluster_id);
 			}
 		}
 		if (total_new_jobs > 0) {
+			scheduler.stats.JobsMaterialized += total_new_jobs;
 			scheduler.needReschedule();
 		}
+		if (total_new_jobs >= batch_limit && ! batch_full) {
+			// the last cluster visited used up the batch, start the next pass after it.
+			next_cluster_to_materialize = work.back() + 1;
+			batch_full = true;
+		}
 	}
 
 	if( ClustersNeedingMaterialize.empty() && job_materialize_timer_id > 0 ) {
 		dprintf(D_FULLDEBUG, "Cancelling job materialization timer\n");
 		daemonCore->Cancel_Timer(job_materialize_timer_id);
 		job_materialize_timer_id = -1;
+	} else if (batch_full && job_materialize_timer_id > 0) {
+		dprintf(D_MATERIALIZE | D_VERBOSE, "materialize batch is full, continuing with cluster %d\n", next_cluster_to_materialize);
+		daemonCore->Reset_Timer(job_materialize_timer_id, 0, 5);
 	}
 }
 
@@ -753,6 +794,7 @@ DeferredClusterCleanupTimerCallback()
 						}
 					}
 					total_new_jobs += num_materialized;
+					scheduler.stats.JobsMaterialized += num_materialized;
 					// PRAGMA_REMIND("TJ: should we do_cleanup here if the transaction failed to commit?");
 					do_cleanup = false;
 				} else {
@@ -3132,7 +3174,7 @@ int NewProcInternal(int cluster_id, int proc_id)
 	gjid += std::to_string( cluster_id );
 	gjid += ".";
 	gjid += std::to_string( proc_id );
-	if (param_boolean("GLOBAL_JOB_ID_WITH_TIME", true)) {
+	if (param_cached(PCB_GLOBAL_JOB_ID_WITH_TIME)) {
 		int now = (int)time(0);
 		gjid += "#";
 		gjid += std::to_string( now );
@@ -3640,7 +3682,7 @@ SetAttributeByConstraint(const char *constraint_str, const char *attr_name,
 
 	// if the only-my-jobs knob is off, strip the onlymyjobs flag and
 	// just let the transaction fail if they try and change something that they shouldn't
-	if ( ! param_boolean("CONDOR_Q_ONLY_MY_JOBS", true)) {
+	if ( ! param_cached(PCB_CONDOR_Q_ONLY_MY_JOBS)) {
 		flags &= ~SetAttribute_OnlyMyJobs;
 	}
 
@@ -7463,7 +7505,7 @@ SendSpoolFileIfNeeded(ClassAd& /*ad*/)
 	//
 	std::string owner;
 	std::string hash;
-	if (param_boolean("SHARE_SPOOLED_EXECUTABLES", true)) {
+	if (param_cached(PCB_SHARE_SPOOLED_EXECUTABLES)) {
 		if (!ad.LookupString(ATTR_OWNER, owner)) {
 			dprintf(D_ALWAYS,
 			        "SendSpoolFileIfNeeded: no %s attribute in ClassAd\n",
@@ -8375,7 +8417,7 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 				// the current match to reuse it.
 
 			std::string jobLimits, recordedLimits;
-			if (param_boolean("CLAIM_RECYCLING_CONSIDER_LIMITS", true)) {
+			if (param_cached(PCB_CLAIM_RECYCLING_CONSIDER_LIMITS)) {
 				ad->LookupString(ATTR_CONCURRENCY_LIMITS, jobLimits);
 				my_match_ad->LookupString(ATTR_MATCHED_CONCURRENCY_LIMITS,
 										  recordedLimits);
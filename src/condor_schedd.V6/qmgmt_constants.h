@@ -56,3 +56,4 @@
 #define CONDOR_SetJobFactory        10037 /* tj */
 #define CONDOR_SetMaterializeData   10038 /* tj - abandoned */
 #define CONDOR_SendMaterializeData  10039 /* tj */
+#define CONDOR_SetAttributes        10040
@@ -54,6 +54,50 @@ static bool QmgmtMayAccessAttribute( char const *attr_name ) {
 	// the client at attempted commit.
 static std::unique_ptr<CondorError> g_transaction_error;
 
+	// Apply one attribute sent by CONDOR_SetAttribute or CONDOR_SetAttributes.
+	// terrno is set to the errno of the attempt.
+static int
+set_attribute_from_client( ReliSock *syscall_sock, int cluster_id, int proc_id,
+	char const *attr_name, char const *attr_value, SetAttributeFlags_t flags, int &terrno )
+{
+	int rval;
+
+		// ckireyev:
+		// We do NOT want to include MyProxy password in the ClassAd (since it's a secret)
+		// I'm not sure if this is the best place to do this, but....
+	if (strcmp (attr_name, ATTR_MYPROXY_PASSWORD) == 0) {
+		dprintf( D_SYSCALLS, "Got MyProxyPassword, stashing...\n");
+		errno = 0;
+		rval = SetMyProxyPassword (cluster_id, proc_id, attr_value);
+		terrno = errno;
+		dprintf( D_SYSCALLS, "\trval = %d, errno = %d\n", rval, terrno );
+	}
+	else {
+		errno = 0;
+
+		rval = SetAttribute( cluster_id, proc_id, attr_name, attr_value, flags, g_transaction_error.get() );
+		terrno = errno;
+		dprintf( D_SYSCALLS, "\trval = %d, errno = %d\n", rval, terrno );
+			// If we're modifying a previously-submitted job AND either
+			// the client's username is not HTCondor's (i.e. not a
+			// daemon) OR the client says we should log...
+		if( ( IsDebugCategory( D_AUDIT ) ) &&
+		    ( cluster_id != active_cluster_num ) &&
+		    ( rval == 0 ) &&
+		    ( ( strcmp(syscall_sock->getOwner(), get_condor_username()) &&
+		        strcmp(syscall_sock->getFullyQualifiedUser(), CONDOR_CHILD_FQU) ) ||
+		      ( flags & SHOULDLOG ) ) ) {
+
+			dprintf( D_AUDIT, *syscall_sock, 
+					 "Set Attribute for job %d.%d, "
+					 "%s = %s\n",
+					 cluster_id, proc_id, attr_name, attr_value);
+		}
+	}
+
+	return rval;
+}
+
 int
 do_Q_request(QmgmtPeer &Q_PEER, bool &may_fork)
 {
@@ -406,39 +450,7 @@ do_Q_request(QmgmtPeer &Q_PEER, bool &may_fork)
 			return 0;
 		}
 
-		// ckireyev:
-		// We do NOT want to include MyProxy password in the ClassAd (since it's a secret)
-		// I'm not sure if this is the best place to do this, but....
-		if (!attr_name.empty() && strcmp (attr_name.c_str(), ATTR_MYPROXY_PASSWORD) == 0) {
-			dprintf( D_SYSCALLS, "Got MyProxyPassword, stashing...\n");
-			errno = 0;
-			rval = SetMyProxyPassword (cluster_id, proc_id, attr_value);
-			terrno = errno;
-			dprintf( D_SYSCALLS, "\trval = %d, errno = %d\n", rval, terrno );
-			
-		}
-		else {
-			errno = 0;
-
-			rval = SetAttribute( cluster_id, proc_id, attr_name.c_str(), attr_value, flags, g_transaction_error.get() );
-			terrno = errno;
-			dprintf( D_SYSCALLS, "\trval = %d, errno = %d\n", rval, terrno );
-				// If we're modifying a previously-submitted job AND either
-				// the client's username is not HTCondor's (i.e. not a
-				// daemon) OR the client says we should log...
-			if( ( IsDebugCategory( D_AUDIT ) ) &&
-			    ( cluster_id != active_cluster_num ) &&
-			    ( rval == 0 ) &&
-			    ( ( strcmp(syscall_sock->getOwner(), get_condor_username()) &&
-			        strcmp(syscall_sock->getFullyQualifiedUser(), CONDOR_CHILD_FQU) ) ||
-			      ( flags & SHOULDLOG ) ) ) {
-
-				dprintf( D_AUDIT, *syscall_sock, 
-						 "Set Attribute for job %d.%d, "
-						 "%s = %s\n",
-						 cluster_id, proc_id, attr_name.c_str(), attr_value);
-			}
-		}
+		rval = set_attribute_from_client( syscall_sock, cluster_id, proc_id, attr_name.c_str(), attr_value, flags, terrno );
 
 		free( (char *)attr_value );
 
@@ -462,6 +474,74 @@ do_Q_request(QmgmtPeer &Q_PEER, bool &may_fork)
 		return 0;
 	}
 
+	case CONDOR_SetAttributes:
+	  {
+		int cluster_id = -1;
+		int proc_id = -1;
+		int num_attrs = 0;
+		int terrno = 0;
+		SetAttributePublicFlags_t wflags = 0;
+
+		assert( syscall_sock->code(cluster_id) );
+		dprintf( D_SYSCALLS, "	cluster_id = %d\n", cluster_id );
+		assert( syscall_sock->code(proc_id) );
+		dprintf( D_SYSCALLS, "	proc_id = %d\n", proc_id );
+		assert( syscall_sock->code(wflags) );
+		assert( syscall_sock->code(num_attrs) );
+		dprintf( D_SYSCALLS, "	num_attrs = %d\n", num_attrs );
+		SetAttributeFlags_t flags = (SetAttributeFlags_t)(wflags & SetAttribute_PublicFlagsMask);
+		if (num_attrs < 0) {
+			// The rest of the message can't be read without a count, so
+			// throw it away and fail the request.
+			dprintf(D_ALWAYS, "SetAttributes got invalid attribute count %d\n", num_attrs);
+			syscall_sock->end_of_message();
+			errno = EINVAL;
+			if( flags & SetAttribute_NoAck ) {
+				return -1;
+			}
+			syscall_sock->encode();
+			rval = -1;
+			terrno = EINVAL;
+			assert( syscall_sock->code(rval) );
+			assert( syscall_sock->code(terrno) );
+			assert( syscall_sock->end_of_message() );
+			return -1;
+		}
+
+			// Apply the attributes as they are read, stopping at the first failure.
+			// The rest of the message must still be read, and a failure in NoAck
+			// mode is deferred to the commit, just as it is for CONDOR_SetAttribute.
+		rval = 0;
+		std::string attr_name, attr_value;
+		for (int ii = 0; ii < num_attrs; ++ii) {
+			assert( syscall_sock->code(attr_value) );
+			assert( syscall_sock->code(attr_name) );
+			if (rval < 0) {
+				continue;
+			}
+			if (g_transaction_error && !g_transaction_error->empty() &&
+				(flags & SetAttribute_NoAck))
+			{
+				dprintf( D_SYSCALLS, "\tIgnored due to previous error\n");
+				rval = -1;
+				continue;
+			}
+			dprintf( D_SYSCALLS, "\t%s = %s\n", attr_name.c_str(), attr_value.c_str() );
+			rval = set_attribute_from_client( syscall_sock, cluster_id, proc_id, attr_name.c_str(), attr_value.c_str(), flags, terrno );
+		}
+		assert( syscall_sock->end_of_message() );
+
+		if ( ! (flags & SetAttribute_NoAck)) {
+			syscall_sock->encode();
+			assert( syscall_sock->code(rval) );
+			if( rval < 0 ) {
+				assert( syscall_sock->code(terrno) );
+			}
+			assert( syscall_sock->end_of_message() );
+		}
+		return 0;
+	}
+
 	case CONDOR_SetJobFactory:
 	case CONDOR_SetMaterializeData:
 	{
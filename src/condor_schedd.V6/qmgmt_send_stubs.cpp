@@ -449,6 +449,47 @@ SetAttribute( int cluster_id, int proc_id, char const *attr_name, char const *at
 	return rval;
 }
 
+int
+SetAttributes( int cluster_id, int proc_id, const std::vector<std::pair<std::string, std::string> > & attrs, SetAttributeFlags_t flags_in )
+{
+	int	rval;
+
+	// only some of the flags can be sent on the wire, the upper bits are private to the schedd
+	SetAttributePublicFlags_t flags = (flags_in & SetAttribute_PublicFlagsMask);
+	int num_attrs = (int)attrs.size();
+
+		CurrentSysCall = CONDOR_SetAttributes;
+
+		qmgmt_sock->encode();
+		neg_on_error( qmgmt_sock->code(CurrentSysCall) );
+		neg_on_error( qmgmt_sock->code(cluster_id) );
+		neg_on_error( qmgmt_sock->code(proc_id) );
+		neg_on_error( qmgmt_sock->code(flags) );
+		neg_on_error( qmgmt_sock->code(num_attrs) );
+		for (auto it = attrs.begin(); it != attrs.end(); ++it) {
+			neg_on_error( qmgmt_sock->put(it->second) );
+			neg_on_error( qmgmt_sock->put(it->first) );
+		}
+		neg_on_error( qmgmt_sock->end_of_message() );
+
+		if( flags & SetAttribute_NoAck ) {
+			rval = 0;
+		}
+		else {
+			qmgmt_sock->decode();
+			neg_on_error( qmgmt_sock->code(rval) );
+			if( rval < 0 ) {
+				neg_on_error( qmgmt_sock->code(terrno) );
+				neg_on_error( qmgmt_sock->end_of_message() );
+				errno = terrno;
+				return rval;
+			}
+			neg_on_error( qmgmt_sock->end_of_message() );
+		}
+
+	return rval;
+}
+
 int
 SetTimerAttribute( int cluster_id, int proc_id, char const *attr_name, int duration )
 {
@@ -623,6 +623,7 @@ Scheduler::Scheduler() :
 	NonDurableLateMaterialize = false;
 	EnableJobQueueTimestamps = false;
 	MaxMaterializedJobsPerCluster = INT_MAX;
+	MaterializeBatchSize = 0;
 	MaxJobsSubmitted = INT_MAX;
 	MaxJobsPerOwner = INT_MAX;
 	MaxJobsPerSubmission = INT_MAX;
@@ -689,6 +690,8 @@ Scheduler::Scheduler() :
 	MaxFlockLevel = 0;
 	FlockLevel = 0;
 	StartJobTimer=-1;
+	ShadowIdleTimeout = 0;
+	IdleShadowTimer = -1;
 	timeoutid = -1;
 	startjobsid = -1;
 	periodicid = -1;
@@ -2263,6 +2266,9 @@ struct QueryJobAdsContinuation : Service {
 	JobQueueLogType::filter_iterator it;
 	int match_limit;
 	int match_count;
+	int timeslice;    // longest we will send ads for before returning to DaemonCore
+	int num_slices;
+	double begin_time;
 	bool summary_only;
 	bool unfinished_eom;
 	bool registered_socket;
@@ -2273,9 +2279,12 @@ struct QueryJobAdsContinuation : Service {
 
 QueryJobAdsContinuation::QueryJobAdsContinuation(classad_shared_ptr<classad::ExprTree> requirements_, int limit, int timeslice_ms, int iter_opts)
 	: requirements(requirements_),
-	  it(GetJobQueueIterator(*requirements, timeslice_ms)),
+	  it(GetJobQueueIterator(*requirements, timeslice_ms > 0 ? timeslice_ms : 1000)),
 	  match_limit(limit),
 	  match_count(0),
+	  timeslice(timeslice_ms),
+	  num_slices(0),
+	  begin_time(_condor_debug_get_time_double()),
 	  summary_only(false),
 	  unfinished_eom(false),
 	  registered_socket(false)
@@ -2292,6 +2301,9 @@ QueryJobAdsContinuation::finish(Stream *stream) {
 		it = end;
 	}
 	bool has_backlog = false;
+	Stopwatch slice;
+	slice.start();
+	num_slices++;
 
 	if (unfinished_eom) {
 		int retval = sock->finish_end_of_message();
@@ -2349,6 +2361,13 @@ QueryJobAdsContinuation::finish(Stream *stream) {
 		if (match_limit >= 0 && (match_count >= match_limit)) {
 			it = end;
 		}
+			// The cursor stays valid while we are away, so once our time
+			// is up let DaemonCore do other work and call us back when the
+			// socket is writable.  Checking the clock costs much less than
+			// serializing an ad, so it's done after every one.
+		if (timeslice > 0 && (it != end) && slice.get_ms() > timeslice) {
+			has_backlog = true;
+		}
 	}
 	if (has_backlog && !registered_socket) {
 		int retval = daemonCore->Register_Socket(stream, "Client Response",
@@ -2365,6 +2384,8 @@ QueryJobAdsContinuation::finish(Stream *stream) {
 		LiveJobCounters * mine = NULL;
 		if ( ! my_name.empty()) { me = my_name.c_str(); mine = &my_job_counts; }
 		int rval = sendDone(sock, true, &query_job_counts, me, mine);
+		dprintf(D_FULLDEBUG, "Answered job query matching %d ads in %d slices over %.3f seconds\n",
+			match_count, num_slices, _condor_debug_get_time_double() - begin_time);
 		delete this;
 		return rval;
 	}
@@ -2507,7 +2528,8 @@ int Scheduler::command_query_job_ads(int cmd, Stream* stream)
 		iter_options |= JOB_QUEUE_ITERATOR_OPT_INCLUDE_CLUSTERS;
 	}
 
-	QueryJobAdsContinuation *continuation = new QueryJobAdsContinuation(requirements_ptr, resultLimit, 1000, iter_options);
+	int timeslice_ms = param_integer("SCHEDD_QUERY_TIMESLICE", 5, 0);
+	QueryJobAdsContinuation *continuation = new QueryJobAdsContinuation(requirements_ptr, resultLimit, timeslice_ms, iter_options);
 	int proj_err = mergeProjectionFromQueryAd(queryAd, ATTR_PROJECTION, continuation->projection, true);
 	if (proj_err < 0) {
 		delete continuation;
@@ -2538,7 +2560,9 @@ int Scheduler::command_query_job_ads(int cmd, Stream* stream)
 	}
 	else if (fork_status == FORK_CHILD)
 	{ // Respond to the query from the child.
+		// Nothing else is waiting on this process, so don't bother yielding.
 		int retval;
+		continuation->timeslice = 0;
 		while ((retval = continuation->finish(stream)) == KEEP_STREAM) {}
 		_exit(!retval);
 		ASSERT( false );
@@ -8944,6 +8968,9 @@ Scheduler::StartJobHandler()
 			// if we got this far, we're definitely starting the job,
 			// so deal with the aboutToSpawnJobHandler hook...
 		int universe = srec->universe;
+		if( !srec->pid ) {
+			AdoptIdleShadow( srec );
+		}
 		callAboutToSpawnJobHandler( cluster, proc, srec );
 
 		bool wantPS = 0;
@@ -11178,6 +11205,22 @@ Scheduler::delete_shadow_rec( shadow_rec *rec )
 	int proc = rec->job_id.proc;
 	int pid = rec->pid;
 
+	if( !rec->idle_user.empty() ) {
+			// An idle shadow parked by ParkIdleShadow().  Its last job
+			// was cleaned up when it was parked, and it never counted
+			// as a running shadow, so only forget about the process.
+		dprintf( D_FULLDEBUG, "Deleting idle shadow rec for PID %d\n", pid );
+		IdleShadows.erase(std::remove(IdleShadows.begin(), IdleShadows.end(), rec), IdleShadows.end());
+		stats.ShadowsIdle = (int)IdleShadows.size();
+		delete rec->recycle_shadow_stream;
+		rec->recycle_shadow_stream = NULL;
+		if( pid ) {
+			shadowsByPid->remove(pid);
+		}
+		delete rec;
+		return;
+	}
+
 	if( pid ) {
 		dprintf( D_FULLDEBUG,
 				 "Deleting shadow rec for PID %d, job (%d.%d)\n",
@@ -11550,6 +11593,10 @@ Scheduler::preempt( int n, bool force_sched_jobs )
 	 * have previously told to preempt but are still waiting for them to exit.
 	 */
 	while (shadowsByPid->iterate(rec) == 1 && n > 0) {
+		if( !rec->idle_user.empty() ) {
+				// idle shadows have no job to preempt
+			continue;
+		}
 		if( is_alive(rec) ) {
 			if( rec->preempted ) {
 				if( ! ExitWhenDone ) {
@@ -13013,6 +13060,9 @@ Scheduler::Init()
 	WallClockCkptInterval = param_integer( "WALL_CLOCK_CKPT_INTERVAL",60*60 );
 
 	JobStartDelay = param_integer( "JOB_START_DELAY", 0 );
+
+		// the shadow gives up waiting for RECYCLE_SHADOW after 300 seconds
+	ShadowIdleTimeout = param_integer( "SHADOW_IDLE_TIMEOUT", 0, 0, 240 );
 	
 	JobStartCount =	param_integer(
 						"JOB_START_COUNT",			// name
@@ -13055,6 +13105,7 @@ Scheduler::Init()
 	AllowLateMaterialize = param_boolean("SCHEDD_ALLOW_LATE_MATERIALIZE", false);
 	MaxMaterializedJobsPerCluster = param_integer("MAX_MATERIALIZED_JOBS_PER_CLUSTER", MaxMaterializedJobsPerCluster);
 	NonDurableLateMaterialize = param_boolean("SCHEDD_NON_DURABLE_LATE_MATERIALIZE", true);
+	MaterializeBatchSize = param_integer("SCHEDD_MATERIALIZE_BATCH_SIZE", 1000, 0);
 
 	EnableJobQueueTimestamps = param_boolean("SCHEDD_JOB_QUEUE_TIMESTAMPS", false);
 
@@ -13847,6 +13898,8 @@ Scheduler::Register()
 
 	m_xfer_queue_mgr.RegisterHandlers();
 
+	// export the schedd statistics on the METRICS_PORT, if there is one
+	daemonCore->Register_Metrics_Pool(&stats.Pool);
 }
 
 void
@@ -14102,6 +14155,7 @@ Scheduler::shutdown_graceful()
  	 */
 	MaxJobsRunning = 0;
 	ExitWhenDone = TRUE;
+	ReleaseIdleShadows( true );
 	daemonCore->Register_Timer( 0, MAX(JobStopDelay,1), 
 					(TimerHandlercpp)&Scheduler::attempt_shutdown,
 					"attempt_shutdown()", this );
@@ -16968,7 +17022,13 @@ Scheduler::RecycleShadow(int /*cmd*/, Stream *stream)
 		mrec->idle_timer_deadline = time(NULL) + mrec->keep_while_idle;
 	}
 
+		// FindRunnableJobForClaim() may delete the match
+	std::string claim_user = mrec->user;
+
 	if( !FindRunnableJobForClaim(mrec,accept_std_univ) ) {
+		if( ParkIdleShadow(srec, stream, claim_user.c_str()) ) {
+			return KEEP_STREAM;
+		}
 		dprintf(D_FULLDEBUG,
 			"No runnable jobs for shadow pid %d (was running job %d.%d); shadow will exit.\n",
 			shadow_pid, prev_job_id.cluster, prev_job_id.proc);
@@ -17072,6 +17132,158 @@ Scheduler::finishRecycleShadow(shadow_rec *srec)
 	delete stream;
 }
 
+	// Called from RecycleShadow() when the shadow's claim has run out of
+	// jobs.  Instead of letting the shadow exit, hold on to its
+	// RECYCLE_SHADOW request for up to SHADOW_IDLE_TIMEOUT seconds, so
+	// that the next job of the same user to start on any claim can be
+	// handed to it rather than to a newly spawned shadow.  srec is
+	// deleted; the shadow is tracked by a new record that is only in
+	// shadowsByPid and IdleShadows, so that it neither holds on to the
+	// finished job nor counts against MAX_JOBS_RUNNING.
+bool
+Scheduler::ParkIdleShadow(shadow_rec *srec, Stream *stream, char const *user)
+{
+	if( ShadowIdleTimeout <= 0 || ExitWhenDone || !user || !*user ) {
+		return false;
+	}
+
+	match_rec *mrec = srec->match;
+	if( mrec ) {
+		if( mrec->m_paired_mrec ) {
+			return false;
+		}
+			// The claim is being kept idle for the next job of its own,
+			// so leave it waiting just as child_exit() would.
+		mrec->setStatus( M_CLAIMED );
+		mrec->shadowRec = NULL;
+		srec->match = NULL;
+	}
+
+	int shadow_pid = srec->pid;
+	shadow_rec *idle = new shadow_rec;
+	idle->pid = shadow_pid;
+	idle->universe = srec->universe;
+	idle->prev_job_id = srec->job_id;
+	idle->exit_already_handled = true;
+	idle->recycle_shadow_stream = stream;
+	idle->idle_user = user;
+	idle->idle_deadline = time(NULL) + ShadowIdleTimeout;
+
+	delete_shadow_rec( srec );
+	add_shadow_rec_pid( idle );
+	IdleShadows.push_back( idle );
+	stats.ShadowsIdle = (int)IdleShadows.size();
+	stats.ShadowsRunning = numShadows;
+
+	if( IdleShadowTimer < 0 ) {
+		int interval = MIN( ShadowIdleTimeout, 5 );
+		IdleShadowTimer = daemonCore->Register_Timer( interval, interval,
+			(TimerHandlercpp)&Scheduler::ReleaseIdleShadowsHandler,
+			"ReleaseIdleShadows", this );
+	}
+
+	dprintf( D_FULLDEBUG,
+		"No runnable jobs for claim of shadow pid %d; keeping it idle for "
+		"up to %d seconds for another job of %s.\n",
+		shadow_pid, ShadowIdleTimeout, user );
+	return true;
+}
+
+	// Called from StartJobHandler() before a shadow is spawned for srec.
+	// If an idle shadow of the same user is waiting, give it the job.
+bool
+Scheduler::AdoptIdleShadow(shadow_rec *srec)
+{
+	if( IdleShadows.empty() || srec->is_reconnect ||
+		!srec->match || !srec->match->user ||
+		(srec->universe != CONDOR_UNIVERSE_VANILLA &&
+		 srec->universe != CONDOR_UNIVERSE_JAVA &&
+		 srec->universe != CONDOR_UNIVERSE_VM) )
+	{
+		return false;
+	}
+
+	std::vector<shadow_rec*>::iterator it;
+	for( it = IdleShadows.begin(); it != IdleShadows.end(); ++it ) {
+		if( (*it)->idle_user == srec->match->user ) {
+			break;
+		}
+	}
+	if( it == IdleShadows.end() ) {
+		return false;
+	}
+
+	shadow_rec *idle = *it;
+	int shadow_pid = idle->pid;
+	PROC_ID prev_job_id = idle->prev_job_id;
+	Stream *stream = idle->recycle_shadow_stream;
+	idle->recycle_shadow_stream = NULL;
+	delete_shadow_rec( idle );
+
+		// what the new shadow would have cost, as far as we can tell
+	unsigned long rss = 0;
+	piPTR pi = NULL;
+	int status = 0;
+	if( ProcAPI::getProcInfo(shadow_pid, pi, status) == PROCAPI_SUCCESS && pi ) {
+		rss = pi->rssize;
+	}
+	delete pi;
+
+	dprintf( D_ALWAYS,
+		"Idle shadow pid %d switching to job %d.%d on %s instead of "
+		"spawning a new shadow (saves about %lu KiB).\n",
+		shadow_pid, srec->job_id.cluster, srec->job_id.proc,
+		srec->match->description(), rss );
+
+	srec->pid = shadow_pid;
+	srec->prev_job_id = prev_job_id;
+	srec->recycle_shadow_stream = stream;
+	add_shadow_rec( srec );
+	srec->match->setStatus( M_ACTIVE );
+
+	time_t now = stats.Tick();
+	stats.ShadowsRecycled += 1;
+	stats.ShadowsReused += 1;
+	stats.ShadowsReusedMemory += (int64_t)rss;
+	stats.ShadowsRunning = numShadows;
+	OtherPoolStats.Tick(now);
+	return true;
+}
+
+	// Tell idle shadows whose wait is over (or all of them) that there
+	// is no job for them, so that they exit.
+void
+Scheduler::ReleaseIdleShadows(bool all)
+{
+	time_t now = time(NULL);
+	std::vector<shadow_rec*>::iterator it = IdleShadows.begin();
+	while( it != IdleShadows.end() ) {
+		shadow_rec *srec = *it;
+		if( !all && srec->idle_deadline > now ) {
+			++it;
+			continue;
+		}
+		it = IdleShadows.erase( it );
+
+		dprintf( D_FULLDEBUG, "No job found for idle shadow pid %d; shadow will exit.\n",
+			srec->pid );
+		Stream *stream = srec->recycle_shadow_stream;
+		srec->recycle_shadow_stream = NULL;
+		if( stream ) {
+			stream->encode();
+			stream->put((int)0);
+			stream->end_of_message();
+			delete stream;
+		}
+	}
+	stats.ShadowsIdle = (int)IdleShadows.size();
+
+	if( IdleShadows.empty() && IdleShadowTimer >= 0 ) {
+		daemonCore->Cancel_Timer( IdleShadowTimer );
+		IdleShadowTimer = -1;
+	}
+}
+
 int
 Scheduler::FindGManagerPid(PROC_ID job_id)
 {
@@ -185,11 +185,15 @@ void ScheddStatistics::InitMain()
    JobsRestartReconnectsBadput.set_levels(default_job_hist_lifes, COUNTOF(default_job_hist_lifes));
 
    SCHEDD_STATS_ADD_RECENT(Pool, JobsSubmitted,        IF_BASICPUB);
+   SCHEDD_STATS_ADD_RECENT(Pool, JobsMaterialized,     IF_BASICPUB);
    SCHEDD_STATS_ADD_RECENT(Pool, Autoclusters,         IF_BASICPUB);
    SCHEDD_STATS_ADD_RECENT(Pool, ResourceRequestsSent,      IF_BASICPUB);
 
    SCHEDD_STATS_ADD_RECENT(Pool, ShadowsStarted,            IF_BASICPUB);
    SCHEDD_STATS_ADD_RECENT(Pool, ShadowsRecycled,           IF_VERBOSEPUB);
+   SCHEDD_STATS_ADD_RECENT(Pool, ShadowsReused,             IF_VERBOSEPUB);
+   SCHEDD_STATS_ADD_RECENT(Pool, ShadowsReusedMemory,       IF_VERBOSEPUB);
+   SCHEDD_STATS_ADD_VAL(Pool, ShadowsIdle,                  IF_VERBOSEPUB);
    SCHEDD_STATS_ADD_RECENT(Pool, ShadowsReconnections,      IF_VERBOSEPUB);
 
    SCHEDD_STATS_ADD_VAL(Pool, ShadowsRunning,               IF_BASICPUB);
@@ -221,6 +225,9 @@ void ScheddStatistics::InitMain()
    SCHEDD_STATS_ADD_EXTERN_RUNTIME(Pool, WalkJobQ_mark_idle,               IF_VERBOSEPUB);
    SCHEDD_STATS_ADD_EXTERN_RUNTIME(Pool, WalkJobQ_get_job_prio,            IF_VERBOSEPUB);
 
+   // time spent materializing jobs, JobsMaterialized divided by this is the materialization rate
+   SCHEDD_STATS_ADD_EXTERN_RUNTIME(Pool, JobMaterialize,   IF_VERBOSEPUB);
+
    // timings for the autocluster code
    SCHEDD_STATS_ADD_EXTERN_RUNTIME(Pool, GetAutoCluster,           IF_VERBOSEPUB);
    SCHEDD_STATS_ADD_EXTERN_RUNTIME(Pool, GetAutoCluster_hit,       IF_VERBOSEPUB);
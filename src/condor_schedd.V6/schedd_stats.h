@@ -33,6 +33,7 @@ typedef struct ScheddJobCounters {
    stats_histogram<time_t>  JobsRunningRuntimes;
 
    stats_entry_recent<int> JobsSubmitted;        // jobs submitted over lifetime of schedd
+   stats_entry_recent<int> JobsMaterialized;     // jobs materialized by job factories
    stats_entry_recent<int> JobsStarted;          // jobs started over schedd lifetime
    stats_entry_recent<int> JobsExited;           // jobs exited (success or failure) over schedd lifetime
    stats_entry_recent<int> JobsCompleted;        // jobs successfully completed over schedd lifetime
@@ -128,6 +129,9 @@ typedef struct ScheddStatistics : public ScheddJobCounters {
    stats_entry_abs<int> ShadowsRunning;          // current number of running shadows, also tracks the peak value.
    stats_entry_recent<int> ShadowsStarted;       // number of shadow processes that have been started
    stats_entry_recent<int> ShadowsRecycled;      // number of times shadows have been recycled
+   stats_entry_abs<int> ShadowsIdle;             // current number of recycled shadows waiting for a job from another claim
+   stats_entry_recent<int> ShadowsReused;        // number of jobs handed to an idle shadow instead of spawning a new one
+   stats_entry_recent<int64_t> ShadowsReusedMemory; // resident KiB of those idle shadows, i.e. memory not spent on new ones
    //stats_entry_recent<int> ShadowExceptions;     // number of times shadows have excepted
    stats_entry_recent<int> ShadowsReconnections; // number of times shadows have reconnected
 
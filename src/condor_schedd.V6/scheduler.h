@@ -143,6 +143,11 @@ struct shadow_rec
 	Stream*			recycle_shadow_stream;
 	bool			exit_already_handled;
 
+		// set while the shadow is parked waiting for a job from
+		// another claim of the same user (see SHADOW_IDLE_TIMEOUT)
+	std::string		idle_user;
+	time_t			idle_deadline;
+
 	shadow_rec();
 	~shadow_rec();
 }; 
@@ -579,6 +584,10 @@ class Scheduler : public Service
 	void			removeJobFromIndexes(const JOB_ID_KEY& job_id, int job_prio=0);
 	int				RecycleShadow(int cmd, Stream *stream);
 	void			finishRecycleShadow(shadow_rec *srec);
+	bool			ParkIdleShadow(shadow_rec *srec, Stream *stream, char const *user);
+	bool			AdoptIdleShadow(shadow_rec *srec);
+	void			ReleaseIdleShadows(bool all);
+	void			ReleaseIdleShadowsHandler() { ReleaseIdleShadows(false); }
 
 	int				requestSandboxLocation(int mode, Stream* s);
 	int			FindGManagerPid(PROC_ID job_id);
@@ -695,6 +704,7 @@ class Scheduler : public Service
 	int				getMaxMaterializedJobsPerCluster() const { return MaxMaterializedJobsPerCluster; }
 	bool			getAllowLateMaterialize() const { return AllowLateMaterialize; }
 	bool			getNonDurableLateMaterialize() const { return NonDurableLateMaterialize; }
+	int				getMaterializeBatchSize() const { return MaterializeBatchSize; }
 	bool			getEnableJobQueueTimestamps() const { return EnableJobQueueTimestamps; }
 	int				getMaxJobsRunning() const { return MaxJobsRunning; }
 	int				getJobsTotalAds() const { return JobsTotalAds; };
@@ -865,6 +875,7 @@ private:
 	bool			NonDurableLateMaterialize;	// for testing, use non-durable transactions when materializing new jobs
 	bool			EnableJobQueueTimestamps;	// for testing
 	int				MaxMaterializedJobsPerCluster;
+	int				MaterializeBatchSize;	// max jobs materialized per pass of the materialize timer
 	char*			StartLocalUniverse; // expression for local jobs
 	char*			StartSchedulerUniverse; // expression for scheduler jobs
 	int				MaxRunningSchedulerJobsPerOwner;
@@ -903,6 +914,9 @@ private:
 	int				ExitWhenDone;  // Flag set for graceful shutdown
 	std::queue<shadow_rec*> RunnableJobQueue;
 	int				StartJobTimer;
+	std::vector<shadow_rec*> IdleShadows;	// recycled shadows waiting for a job
+	int				ShadowIdleTimeout;
+	int				IdleShadowTimer;
 	int				timeoutid;		// daemoncore timer id for timeout()
 	int				startjobsid;	// daemoncore timer id for StartJobs()
 	int				jobThrottleNextJobDelay;	// used by jobThrottle()
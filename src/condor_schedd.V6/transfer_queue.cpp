@@ -33,6 +33,7 @@ TransferQueueRequest::TransferQueueRequest(ReliSock *sock,filesize_t sandbox_siz
 	m_queue_user(queue_user),
 	m_jobid(jobid),
 	m_sandbox_size_MB(sandbox_size/1024.0/1024.0),
+	m_MB_transferred(0),
 	m_fname(fname),
 	m_downloading(downloading),
 	m_max_queue_age(max_queue_age)
@@ -88,6 +89,17 @@ TransferQueueRequest::SinlessDescription() {
 	return s;
 }
 
+double
+TransferQueueRequest::RemainingMB() const {
+		// The sandbox size is only an estimate made when the request
+		// was queued, so never report less than nothing remaining.
+	double remaining = m_sandbox_size_MB - m_MB_transferred;
+	if( remaining < 0 ) {
+		remaining = 0;
+	}
+	return remaining;
+}
+
 bool
 TransferQueueRequest::SendGoAhead(XFER_QUEUE_ENUM go_ahead,char const *reason) {
 	ASSERT( m_sock );
@@ -139,6 +151,8 @@ TransferQueueManager::TransferQueueManager() {
 	m_update_iostats_interval = 0;
 	m_update_iostats_timer = -1;
 	m_publish_flags = 0;
+	m_prefer_small_transfers = false;
+	m_max_user_bandwidth_share = 0;
 
 	m_stat_pool.AddProbe(ATTR_TRANSFER_QUEUE_MAX_UPLOADING,&m_max_uploading_stat,NULL,IF_BASICPUB|m_max_uploading_stat.PubValue);
 	m_stat_pool.AddProbe(ATTR_TRANSFER_QUEUE_MAX_DOWNLOADING,&m_max_downloading_stat,NULL,IF_BASICPUB|m_max_downloading_stat.PubValue);
@@ -249,6 +263,18 @@ TransferQueueManager::InitAndReconfig() {
 		m_stat_pool.RemoveProbe(ATTR_FILE_TRANSFER_DISK_THROTTLE_SHORTFALL);
 	}
 
+	m_prefer_small_transfers = param_boolean("TRANSFER_QUEUE_PREFER_SMALL_TRANSFERS",false);
+	m_max_user_bandwidth_share = param_double("TRANSFER_QUEUE_MAX_USER_BANDWIDTH_SHARE",0.0,0.0,1.0);
+
+	if( m_max_user_bandwidth_share > 0 ) {
+		m_stat_pool.AddProbe(ATTR_TRANSFER_QUEUE_MAX_USER_BANDWIDTH_SHARE,&m_max_user_bandwidth_share_stat,NULL,IF_BASICPUB|m_max_user_bandwidth_share_stat.PubValue);
+		m_stat_pool.AddProbe(ATTR_TRANSFER_QUEUE_NUM_USERS_OVER_BANDWIDTH_SHARE,&m_users_over_bandwidth_share_stat,NULL,IF_BASICPUB|m_users_over_bandwidth_share_stat.PubValue);
+	}
+	else {
+		m_stat_pool.RemoveProbe(ATTR_TRANSFER_QUEUE_MAX_USER_BANDWIDTH_SHARE);
+		m_stat_pool.RemoveProbe(ATTR_TRANSFER_QUEUE_NUM_USERS_OVER_BANDWIDTH_SHARE);
+	}
+
 	m_update_iostats_interval = param_integer("TRANSFER_IO_REPORT_INTERVAL",10,0);
 	if( m_update_iostats_interval != 0 ) {
 		if( m_update_iostats_timer != -1 ) {
@@ -458,7 +484,7 @@ TransferQueueManager::HandleReport( Stream *sock )
 }
 
 bool
-TransferQueueRequest::ReadReport(TransferQueueManager *manager) const
+TransferQueueRequest::ReadReport(TransferQueueManager *manager)
 {
 	MyString report;
 	m_sock->decode();
@@ -504,6 +530,8 @@ TransferQueueRequest::ReadReport(TransferQueueManager *manager) const
 	iostats.net_read = (double)recent_usec_net_read/1000000;
 	iostats.net_write = (double)recent_usec_net_write/1000000;
 
+	m_MB_transferred += ((double)recent_bytes_sent + (double)recent_bytes_received)/1024.0/1024.0;
+
 	manager->AddRecentIOStats(iostats,m_up_down_queue_user);
 	return true;
 }
@@ -673,6 +701,14 @@ TransferQueueManager::RegisterStats(char const *user,IOStats &iostats,bool unreg
 		else {
 			m_stat_pool.AddProbe(attr.c_str(),&iostats.download_MB_waiting,NULL,flags|iostats.download_MB_waiting.PubValue);
 		}
+		formatstr(attr,"%s%s",user_attr.c_str(),"FileTransferMBDownloading");
+		if( unregister ) {
+			m_stat_pool.RemoveProbe(attr.c_str());
+			iostats.download_MB_running.Unpublish(*unpublish_ad,attr.c_str());
+		}
+		else {
+			m_stat_pool.AddProbe(attr.c_str(),&iostats.download_MB_running,NULL,flags|iostats.download_MB_running.PubValue);
+		}
 	}
 	if( uploading ) {
 		formatstr(attr,"%sFileTransferUploadBytes",user_attr.c_str());
@@ -707,6 +743,14 @@ TransferQueueManager::RegisterStats(char const *user,IOStats &iostats,bool unreg
 		else {
 			m_stat_pool.AddProbe(attr.c_str(),&iostats.upload_MB_waiting,NULL,flags|iostats.upload_MB_waiting.PubValue);
 		}
+		formatstr(attr,"%s%s",user_attr.c_str(),"FileTransferMBUploading");
+		if( unregister ) {
+			m_stat_pool.RemoveProbe(attr.c_str());
+			iostats.upload_MB_running.Unpublish(*unpublish_ad,attr.c_str());
+		}
+		else {
+			m_stat_pool.AddProbe(attr.c_str(),&iostats.upload_MB_running,NULL,flags|iostats.upload_MB_running.PubValue);
+		}
 	}
 }
 
@@ -728,6 +772,97 @@ TransferQueueManager::ClearTransferCounts()
 		itr->second.idle = 0;
 		itr->second.iostats.upload_MB_waiting = 0;
 		itr->second.iostats.download_MB_waiting = 0;
+		itr->second.over_bandwidth_share = false;
+	}
+}
+
+int
+TransferQueueManager::UpdateBandwidthShares()
+{
+		// Flag users whose recent throughput in one direction exceeds
+		// their configured share of the total throughput in that
+		// direction.  This only matters when some other user is
+		// waiting to transfer in the same direction, so users without
+		// competition are never flagged.  Requires the running/idle
+		// counts to be up to date.
+
+	if( m_max_user_bandwidth_share <= 0 ) {
+		return 0;
+	}
+	char const *ema_horizon = m_iostats.bytes_sent.ShortestHorizonEMAName();
+	if( !ema_horizon ) {
+		return 0;
+	}
+
+	int up_users_waiting = 0;
+	int down_users_waiting = 0;
+	QueueUserMap::iterator itr;
+	for( itr = m_queue_users.begin(); itr != m_queue_users.end(); itr++ ) {
+		if( itr->second.idle == 0 ) {
+			continue;
+		}
+		if( itr->first[0] == 'D' ) {
+			down_users_waiting++;
+		}
+		else {
+			up_users_waiting++;
+		}
+	}
+
+	double up_total = m_iostats.bytes_sent.EMAValue(ema_horizon);
+	double down_total = m_iostats.bytes_received.EMAValue(ema_horizon);
+
+	int num_over = 0;
+	for( itr = m_queue_users.begin(); itr != m_queue_users.end(); itr++ ) {
+		TransferQueueUser &user = itr->second;
+		bool downloading = itr->first[0] == 'D';
+		int others_waiting = (downloading ? down_users_waiting : up_users_waiting) - (user.idle ? 1 : 0);
+		double total = downloading ? down_total : up_total;
+		double rate = downloading ?
+			user.iostats.bytes_received.EMAValue(ema_horizon) :
+			user.iostats.bytes_sent.EMAValue(ema_horizon);
+
+		user.over_bandwidth_share = others_waiting > 0 && total > 0 &&
+			rate > m_max_user_bandwidth_share * total;
+		if( user.over_bandwidth_share ) {
+			dprintf(D_FULLDEBUG,"TransferQueueManager: %s is using %.0f of %.0f bytes/s, "
+					"more than TRANSFER_QUEUE_MAX_USER_BANDWIDTH_SHARE=%g\n",
+					itr->first.c_str(), rate, total, m_max_user_bandwidth_share);
+			num_over++;
+		}
+	}
+	return num_over;
+}
+
+void
+TransferQueueManager::CountMBRunning()
+{
+	m_iostats.upload_MB_running = 0;
+	m_iostats.download_MB_running = 0;
+	for( QueueUserMap::iterator itr = m_queue_users.begin();
+		 itr != m_queue_users.end();
+		 itr++ )
+	{
+		itr->second.iostats.upload_MB_running = 0;
+		itr->second.iostats.download_MB_running = 0;
+	}
+
+	TransferQueueRequest *client = NULL;
+	m_xfer_queue.Rewind();
+	while( m_xfer_queue.Next(client) ) {
+		if( !client->m_gave_go_ahead ) {
+			continue;
+		}
+		TransferQueueUser &user = GetUserRec(client->m_up_down_queue_user);
+		double remaining = client->RemainingMB();
+		if( client->m_downloading ) {
+			m_iostats.download_MB_running += remaining;
+			user.iostats.download_MB_running += remaining;
+		}
+		else {
+			m_iostats.upload_MB_running += remaining;
+			user.iostats.upload_MB_running += remaining;
+		}
 	}
 }
 
@@ -769,6 +904,8 @@ TransferQueueManager::CheckTransferQueue() {
 		}
 	}
 
+	m_users_over_bandwidth_share_stat = UpdateBandwidthShares();
+
 	if( m_throttle_disk_load ) {
 		int old_concurrency_limit = m_throttle_disk_load_max_concurrency;
 
@@ -827,6 +964,7 @@ TransferQueueManager::CheckTransferQueue() {
 		TransferQueueRequest *best_client = NULL;
 		int best_recency = 0;
 		unsigned int best_running_count = 0;
+		bool best_over_bandwidth_share = false;
 
 		if( m_throttle_disk_load && (uploading + downloading >= m_throttle_disk_load_max_concurrency) ) {
 			break;
@@ -856,10 +994,26 @@ TransferQueueManager::CheckTransferQueue() {
 						this_client_is_better = true;
 					}
 				}
-				else if( best_running_count > this_user_active_count ) {
+				else if( best_over_bandwidth_share != this_user.over_bandwidth_share ) {
+						// prefer users who are within their share of the bandwidth
+					if( !this_user.over_bandwidth_share ) {
+						this_client_is_better = true;
+					}
+				}
+				else if( best_running_count != this_user_active_count ) {
 						// prefer users with fewer active transfers
 						// (only counting transfers in one direction for this comparison)
-					this_client_is_better = true;
+					if( best_running_count > this_user_active_count ) {
+						this_client_is_better = true;
+					}
+				}
+				else if( m_prefer_small_transfers &&
+						 best_client->m_sandbox_size_MB != client->m_sandbox_size_MB )
+				{
+						// shortest expected transfer first
+					if( best_client->m_sandbox_size_MB > client->m_sandbox_size_MB ) {
+						this_client_is_better = true;
+					}
 				}
 				else if( best_recency > this_user_recency ) {
 						// if still tied: round robin
@@ -870,6 +1024,7 @@ TransferQueueManager::CheckTransferQueue() {
 					best_client = client;
 					best_running_count = this_user_active_count;
 					best_recency = this_user_recency;
+					best_over_bandwidth_share = this_user.over_bandwidth_share;
 				}
 			}
 		}
@@ -940,6 +1095,8 @@ TransferQueueManager::CheckTransferQueue() {
 	m_uploading = uploading;
 	m_downloading = downloading;
 
+	CountMBRunning();
+
 
 	if( clients_waiting ) {
 			// queue is full; check for ancient clients
@@ -1113,6 +1270,9 @@ TransferQueueManager::UpdateIOStats()
 	m_disk_throttle_low_stat = m_disk_load_low_throttle;
 	m_disk_throttle_high_stat = m_disk_load_high_throttle;
 	m_disk_throttle_limit_stat = m_throttle_disk_load_max_concurrency;
+	m_max_user_bandwidth_share_stat = m_max_user_bandwidth_share;
+
+	CountMBRunning();
 
 	double disk_load_short = m_iostats.file_read.EMAValue(m_disk_throttle_short_horizon.c_str()) +
 	                         m_iostats.file_write.EMAValue(m_disk_throttle_short_horizon.c_str());
@@ -1228,6 +1388,7 @@ TransferQueueManager::publish_user_stats(ClassAd * ad, const char *user, int fla
 		dn.iostats.file_write.Publish(*ad, "FileTransferFileWriteSeconds", ema_flags);
 		dn.iostats.net_read.Publish(*ad, "FileTransferNetReadSeconds", ema_flags);
 		dn.iostats.download_MB_waiting.Publish(*ad, "FileTransferMBWaitingToDownload", flags|dn.iostats.download_MB_waiting.PubValue);
+		dn.iostats.download_MB_running.Publish(*ad, "FileTransferMBDownloading", flags|dn.iostats.download_MB_running.PubValue);
 	} else {
 		// if there are now counters for this user, then remove the attributes
 		// we can use the overall stats to unpublish, since that have the same EMA config as the per-user stats.
@@ -1235,6 +1396,7 @@ TransferQueueManager::publish_user_stats(ClassAd * ad, const char *user, int fla
 		m_iostats.file_write.Unpublish(*ad, "FileTransferFileWriteSeconds");
 		m_iostats.net_read.Unpublish(*ad, "FileTransferNetReadSeconds");
 		m_iostats.download_MB_waiting.Unpublish(*ad, "FileTransferMBWaitingToDownload");
+		m_iostats.download_MB_running.Unpublish(*ad, "FileTransferMBDownloading");
 	}
 
 	up_down_user[0] = 'U';
@@ -1246,6 +1408,7 @@ TransferQueueManager::publish_user_stats(ClassAd * ad, const char *user, int fla
 		up.iostats.file_read.Publish(*ad,"FileTransferFileReadSeconds",ema_flags);
 		up.iostats.net_write.Publish(*ad,"FileTransferNetWriteSeconds",ema_flags);
 		up.iostats.upload_MB_waiting.Publish(*ad,"FileTransferMBWaitingToUpload", flags|up.iostats.upload_MB_waiting.PubValue);
+		up.iostats.upload_MB_running.Publish(*ad,"FileTransferMBUploading", flags|up.iostats.upload_MB_running.PubValue);
 	} else {
 		// if there are now counters for this user, then remove the attributes
 		// we can use the overall stats to unpublish, since that have the same EMA config as the per-user stats.
@@ -1253,5 +1416,6 @@ TransferQueueManager::publish_user_stats(ClassAd * ad, const char *user, int fla
 		m_iostats.file_read.Unpublish(*ad,"FileTransferFileReadSeconds");
 		m_iostats.net_write.Unpublish(*ad,"FileTransferNetWriteSeconds");
 		m_iostats.upload_MB_waiting.Unpublish(*ad,"FileTransferMBWaitingToUpload");
+		m_iostats.upload_MB_running.Unpublish(*ad,"FileTransferMBUploading");
 	}
 }
@@ -38,6 +38,8 @@ class IOStats {
 	stats_entry_sum_ema_rate<double> net_write;
 	stats_entry_abs<double> upload_MB_waiting;
 	stats_entry_abs<double> download_MB_waiting;
+	stats_entry_abs<double> upload_MB_running;   // MB not yet sent by active uploads
+	stats_entry_abs<double> download_MB_running; // MB not yet received by active downloads
 
 	void Add(IOStats &s);
 	void Clear();
@@ -55,7 +57,11 @@ class TransferQueueRequest {
 
 	bool SendGoAhead(XFER_QUEUE_ENUM go_ahead=XFER_QUEUE_GO_AHEAD,char const *reason=NULL);
 
-	bool ReadReport(class TransferQueueManager *manager) const;
+	bool ReadReport(class TransferQueueManager *manager);
+
+		// Estimate of how much of the sandbox is still to be transferred,
+		// based on the I/O reports received so far.
+	double RemainingMB() const;
 
 	ReliSock *m_sock;
 	MyString m_queue_user;   // Name of file transfer queue user. (TRANSFER_QUEUE_USER_EXPR)
@@ -63,6 +69,7 @@ class TransferQueueRequest {
 	MyString m_jobid;   // For information purposes, the job associated with
 	                    // this file transfer.
 	double m_sandbox_size_MB;
+	double m_MB_transferred; // sum of bytes reported by the transfer process
 	MyString m_fname;   // File this client originally requested to transfer.
 	                    // In current implementation, it may silently move on
 	                    // to a different file without notifying us.
@@ -154,15 +161,21 @@ class TransferQueueManager: public Service {
 	stats_entry_ema<double> m_disk_throttle_excess;
 	stats_entry_ema<double> m_disk_throttle_shortfall;
 
+	bool m_prefer_small_transfers;      // TRANSFER_QUEUE_PREFER_SMALL_TRANSFERS
+	double m_max_user_bandwidth_share;  // 0 if unlimited
+	stats_entry_abs<double> m_max_user_bandwidth_share_stat;
+	stats_entry_abs<int> m_users_over_bandwidth_share_stat;
+
 	unsigned int m_round_robin_counter; // increments each time we send GoAhead to a client
 
 	class TransferQueueUser {
 	public:
-		TransferQueueUser(): running(0), idle(0), recency(0) {}
+		TransferQueueUser(): running(0), idle(0), recency(0), over_bandwidth_share(false) {}
 		bool Stale(unsigned int stale_recency);
 		unsigned int running;
 		unsigned int idle;
 		unsigned int recency; // round robin counter at time of last GoAhead
+		bool over_bandwidth_share; // recent throughput exceeds MAX_USER_BANDWIDTH_SHARE
 		IOStats iostats;
 	};
 	typedef std::map< std::string,TransferQueueUser > QueueUserMap;
@@ -186,6 +199,8 @@ class TransferQueueManager: public Service {
 	void CollectUserRecGarbage(ClassAd *unpublish_ad);
 	void ClearRoundRobinRecency();
 	void ClearTransferCounts();
+	int UpdateBandwidthShares();
+	void CountMBRunning();
 	void UpdateIOStats();
 	void IOStatsChanged();
 	void RegisterStats(char const *user,IOStats &iostats,bool unregister=false,ClassAd *unpublish_ad=NULL);
@@ -3052,6 +3052,11 @@ static int MySendJobAttributes(const JOB_ID_KEY & key, const classad::ClassAd &
 		}
 	}
 
+	// In NoAck mode the attributes are collected and sent as a single batch. The ad passed
+	// here is only the delta from the cluster ad, so for procs this is usually a short list.
+	bool batch = (saflags & SetAttribute_NoAck) != 0;
+	std::vector<std::pair<std::string, std::string> > attrs;
+
 	// (shallow) iterate the attributes in this ad and send them to the schedd
 	//
 	for (auto it = ad.begin(); it != ad.end(); ++it) {
@@ -3074,6 +3079,11 @@ static int MySendJobAttributes(const JOB_ID_KEY & key, const classad::ClassAd &
 		rhs.clear();
 		unparser.Unparse(rhs, it->second);
 
+		if (batch) {
+			attrs.emplace_back(it->first, rhs);
+			continue;
+		}
+
 		if (MyQ->set_Attribute(key.cluster, key.proc, attr, rhs.c_str(), saflags) == -1) {
 			if (saflags & SetAttribute_NoAck) {
 				fprintf( stderr, "\nERROR: Failed submission for job %s - aborting entire submit\n", keystr);
@@ -3085,6 +3095,13 @@ static int MySendJobAttributes(const JOB_ID_KEY & key, const classad::ClassAd &
 		}
 	}
 
+	if (retval == 0 && ! attrs.empty()) {
+		if (MyQ->set_Attributes(key.cluster, key.proc, attrs, saflags) == -1) {
+			fprintf( stderr, "\nERROR: Failed submission for job %s - aborting entire submit\n", keystr);
+			retval = -1;
+		}
+	}
+
 	return retval;
 }
 
@@ -60,6 +60,7 @@ public:
 	virtual int destroy_Cluster(int cluster_id, const char *reason = NULL);
 	virtual int set_Attribute(int cluster, int proc, const char *attr, const char *value, SetAttributeFlags_t flags=0 );
 	virtual int set_AttributeInt(int cluster, int proc, const char *attr, int value, SetAttributeFlags_t flags = 0 );
+	virtual int set_Attributes(int cluster, int proc, const std::vector<std::pair<std::string, std::string> > & attrs, SetAttributeFlags_t flags = 0 );
 	virtual int send_SpoolFile(char const *filename);
 	virtual int send_SpoolFileBytes(char const *filename);
 	virtual bool disconnect(bool commit_transaction, CondorError & errstack);
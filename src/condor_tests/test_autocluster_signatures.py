@@ -0,0 +1,64 @@
+#!/usr/bin/env pytest
+
+# The schedd finds a job's autocluster by hashing the text of its
+# significant attribute values.  Values edited into the queue keep the
+# text they were written with, so make sure jobs whose values are equal
+# but spelled differently still share an autocluster, and that jobs with
+# different values do not.
+
+import logging
+
+import htcondor
+
+from ornithology import *
+
+logger = logging.getLogger(__name__)
+logger.setLevel(logging.DEBUG)
+
+# (job, MyValue, MyExpr) - jobs 0 to 2 are the same, job 3 differs in value
+SPELLINGS = [
+    (0, "1.0", "RequestMemory > 100"),
+    (1, "1.00", "RequestMemory  >  100"),
+    (2, "1.000", "RequestMemory>100"),
+    (3, "2.0", "RequestMemory > 100"),
+]
+
+
+@action
+def held_jobs(default_condor, path_to_sleep):
+    handle = default_condor.submit(
+        description={"executable": path_to_sleep, "arguments": "1", "hold": "true"},
+        count=len(SPELLINGS),
+    )
+    assert handle.wait(condition=ClusterState.all_held, timeout=60)
+
+    schedd = default_condor.get_local_schedd()
+    for proc, value, expr in SPELLINGS:
+        jid = "{}.{}".format(handle.clusterid, proc)
+        schedd.edit([jid], "MyValue", value)
+        schedd.edit([jid], "MyExpr", expr)
+    return handle
+
+
+@action
+def groups(default_condor, held_jobs):
+    schedd = default_condor.get_local_schedd()
+    return schedd.query(
+        constraint="ClusterId == {}".format(held_jobs.clusterid),
+        projection=["MyValue", "MyExpr"],
+        opts=htcondor.QueryOpts.GroupBy,
+    )
+
+
+class TestAutoclusterSignatures:
+    def test_two_groups(self, groups):
+        assert len(groups) == 2
+
+    def test_spellings_share_a_group(self, groups):
+        counts = sorted(ad["JobCount"] for ad in groups)
+        assert counts == [1, 3]
+
+    def test_different_value_has_own_group(self, groups):
+        single = [ad for ad in groups if ad["JobCount"] == 1]
+        assert len(single) == 1
+        assert single[0]["MyValue"] == 2.0
@@ -0,0 +1,133 @@
+#!/usr/bin/env pytest
+
+# With METRICS_PORT set, a daemon answers HTTP GET /metrics with its
+# statistics in OpenMetrics text format.  Scrape the schedd, check that the
+# reply is well formed and that command latencies come out as summaries,
+# and check that a daemon which denies the scraping host READ access
+# closes the connection without answering.
+
+import http.client
+import logging
+import re
+import socket
+import urllib.error
+import urllib.request
+
+from ornithology import *
+
+logger = logging.getLogger(__name__)
+logger.setLevel(logging.DEBUG)
+
+RE_SERVING = re.compile(r"^DaemonMetrics: serving statistics at http://[^:]+:(\d+)/metrics")
+
+
+def free_port():
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+SCHEDD_PORT = free_port()
+NEGOTIATOR_PORT = free_port()
+
+
+@standup
+def condor(test_dir):
+    with Condor(
+        local_dir=test_dir / "condor",
+        config={
+            "SCHEDD.METRICS_PORT": str(SCHEDD_PORT),
+            "NEGOTIATOR.METRICS_PORT": str(NEGOTIATOR_PORT),
+            # the scraper connects from loopback, which the negotiator denies
+            "NEGOTIATOR.DENY_READ": "127.0.0.1",
+        },
+    ) as condor:
+        yield condor
+
+
+def wait_for_listener(daemon_log, port):
+    def match(msg):
+        m = RE_SERVING.match(msg.message)
+        return m is not None and int(m.group(1)) == port
+
+    assert daemon_log.open().wait(condition=match, timeout=60)
+
+
+def scrape(port, path="/metrics"):
+    url = "http://127.0.0.1:{}{}".format(port, path)
+    try:
+        with urllib.request.urlopen(url, timeout=30) as response:
+            return response.status, response.headers, response.read().decode()
+    except urllib.error.HTTPError as e:
+        return e.code, e.headers, e.read().decode()
+
+
+@action
+def schedd_metrics(condor):
+    wait_for_listener(condor.schedd_log, SCHEDD_PORT)
+    # make sure the schedd has handled a command, so it has latencies to report
+    condor.query()
+    return scrape(SCHEDD_PORT)
+
+
+@action
+def not_found(condor, schedd_metrics):
+    return scrape(SCHEDD_PORT, "/nothing-here")
+
+
+@action
+def negotiator_scrape_error(condor):
+    wait_for_listener(condor.negotiator_log, NEGOTIATOR_PORT)
+    try:
+        scrape(NEGOTIATOR_PORT)
+    except (http.client.HTTPException, OSError) as e:
+        return e
+    return None
+
+
+class TestDaemonMetrics:
+    def test_status_and_content_type(self, schedd_metrics):
+        status, headers, _ = schedd_metrics
+        assert status == 200
+        assert headers["Content-Type"].startswith("application/openmetrics-text")
+
+    def test_ends_with_eof(self, schedd_metrics):
+        _, _, body = schedd_metrics
+        assert body.endswith("# EOF\n")
+        assert body.count("# EOF") == 1
+
+    def test_every_sample_has_a_type(self, schedd_metrics):
+        _, _, body = schedd_metrics
+        typed = set(re.findall(r"^# TYPE (\S+) ", body, re.MULTILINE))
+        assert len(typed) > 0
+        for line in body.splitlines():
+            if line.startswith("#"):
+                continue
+            name = re.match(r"^([A-Za-z_:][A-Za-z0-9_:]*)", line).group(1)
+            base = re.sub(r"_(sum|count)$", "", name)
+            assert name in typed or base in typed, line
+            assert 'daemon="SCHEDD"' in line
+
+    def test_command_latency_summary(self, schedd_metrics):
+        _, _, body = schedd_metrics
+        names = set(
+            re.findall(r"^# TYPE (condor_DCCommandLatency_\w+) summary$", body, re.MULTILINE)
+        )
+        assert len(names) > 0
+        for name in names:
+            for q in ("0.5", "0.99", "0.999"):
+                assert re.search(
+                    r'^{}\{{daemon="SCHEDD",quantile="{}"\}} \S+$'.format(name, re.escape(q)),
+                    body,
+                    re.MULTILINE,
+                )
+            count = re.search(r'^{}_count\{{daemon="SCHEDD"\}} (\d+)$'.format(name), body, re.MULTILINE)
+            assert count is not None and int(count.group(1)) > 0
+
+    def test_unknown_path(self, not_found):
+        status, _, body = not_found
+        assert status == 404
+        assert body == "404 Not Found\n"
+
+    def test_read_denied_host_gets_no_answer(self, negotiator_scrape_error):
+        assert negotiator_scrape_error is not None
@@ -0,0 +1,117 @@
+#!/usr/bin/env pytest
+
+# The job router indexes routes whose requirements have a top level
+# Attr == "string" clause, and only evaluates the requirements of the
+# routes a job could match.  Match a set of jobs against indexed and
+# unindexed routes with condor_job_router_info, and check that each job
+# gets the route it would get by evaluating every route in order.
+
+import logging
+import re
+
+from ornithology import *
+
+logger = logging.getLogger(__name__)
+logger.setLevel(logging.DEBUG)
+
+ROUTES = {
+    # indexed on Site
+    "SiteAlpha": 'Site == "alpha" && ProcId >= 0',
+    # indexed on Site, the value is matched without regard to case
+    "SiteBeta": 'Site == "BETA"',
+    # indexed on Queue
+    "QueueShort": '(Queue == "short")',
+    # not indexed, the top level is an ||
+    "Special": 'Site == "alpha" || Special',
+    # not indexed, the clause is not a string compare
+    "BigMemory": "RequestMemory > 4096",
+}
+
+JOBS = {
+    # ProcId: (attributes, expected route)
+    0: ({"Site": '"Alpha"'}, "SiteAlpha"),
+    1: ({"Site": '"beta"'}, "SiteBeta"),
+    2: ({"Queue": '"SHORT"'}, "QueueShort"),
+    # a job with values for both indexed attributes takes the first route
+    3: ({"Site": '"beta"', "Queue": '"short"'}, "SiteBeta"),
+    # the indexed clause is false, an unindexed route later on matches
+    4: ({"Site": '"gamma"', "Special": "true"}, "Special"),
+    5: ({"Queue": '"long"', "RequestMemory": "8192"}, "BigMemory"),
+    # no route matches
+    6: ({"Site": '"gamma"'}, None),
+    7: ({}, None),
+}
+
+
+@standup
+def config():
+    lines = [
+        "JOB_ROUTER_ROUTE_NAMES = {}".format(" ".join(ROUTES)),
+        "JOB_ROUTER_ROUND_ROBIN_SELECTION = false",
+    ]
+    for name, requirements in ROUTES.items():
+        lines += [
+            "JOB_ROUTER_ROUTE_{} @=rt".format(name),
+            "  UNIVERSE vanilla",
+            "  REQUIREMENTS {}".format(requirements),
+            "@rt",
+        ]
+    return "\n".join(lines) + "\n"
+
+
+@standup
+def condor(test_dir, config):
+    with Condor(
+        local_dir=test_dir / "condor",
+        raw_config=config,
+    ) as condor:
+        yield condor
+
+
+@standup
+def job_ads(test_dir):
+    path = test_dir / "job_ads"
+    ads = []
+    for proc, (attrs, _) in JOBS.items():
+        lines = [
+            "ClusterId = 1",
+            "ProcId = {}".format(proc),
+            'Owner = "tester"',
+            "JobUniverse = 5",
+            "JobStatus = 1",
+            "RequestMemory = 128",
+        ]
+        lines = [line for line in lines if line.split(" = ")[0] not in attrs]
+        lines += ["{} = {}".format(name, value) for name, value in attrs.items()]
+        ads.append("\n".join(lines))
+    path.write_text("\n\n".join(ads) + "\n")
+    return path
+
+
+@action
+def match_output(condor, job_ads):
+    # -diagnostic prints the route index summary and each match
+    p = condor.run_command(
+        ["condor_job_router_info", "-diagnostic", "-match-jobs", "-ignore-prior-routing", "-jobads", job_ads]
+    )
+    assert p.returncode == 0
+    return p.stdout
+
+
+@action
+def routes_chosen(match_output):
+    chosen = {}
+    for line in match_output.splitlines():
+        m = re.search(r"Found candidate job src=1\.(\d+),route=(\w+)", line)
+        if m:
+            chosen[int(m.group(1))] = m.group(2)
+    return chosen
+
+
+class TestJobRouterRouteIndex:
+    def test_routes_are_indexed(self, match_output):
+        assert "3 of 5 routes indexed on 2 attributes" in match_output
+
+    def test_each_job_gets_the_first_matching_route(self, routes_chosen):
+        expected = {proc: route for proc, (_, route) in JOBS.items() if route is not None}
+        assert routes_chosen == expected
@@ -0,0 +1,95 @@
+#!/usr/bin/env pytest
+
+# The schedd materializes late materialization jobs in batches of at most
+# SCHEDD_MATERIALIZE_BATCH_SIZE jobs, and each batch starts with the factory
+# after the one the last batch stopped in.  Submit two factories together
+# with a small batch size and make sure they take turns, rather than the
+# first one materializing all of its jobs before the second gets any.
+
+import logging
+import re
+import time
+
+import htcondor
+
+from ornithology import *
+
+logger = logging.getLogger(__name__)
+logger.setLevel(logging.DEBUG)
+
+BATCH_SIZE = 2
+MAX_MATERIALIZE = 6
+
+RE_INVOKED = re.compile(r"^cluster (\d+) job factory invoked, (\d+) jobs materialized")
+
+
+@standup
+def condor(test_dir):
+    with Condor(
+        local_dir=test_dir / "condor",
+        config={
+            "SCHEDD_MATERIALIZE_BATCH_SIZE": str(BATCH_SIZE),
+            "SCHEDD_DEBUG": "D_MATERIALIZE D_CAT $(SCHEDD_DEBUG)",
+        },
+    ) as condor:
+        yield condor
+
+
+@action
+def factories(condor, path_to_sleep):
+    description = {
+        "executable": path_to_sleep,
+        "arguments": "1",
+        # held jobs still count against max_materialize, and never run
+        "hold": "true",
+        "max_materialize": str(MAX_MATERIALIZE),
+    }
+    schedd = condor.get_local_schedd()
+    # one transaction, so that both factories are waiting for the same pass
+    with schedd.transaction() as txn:
+        first = htcondor.Submit(description).queue(txn, 20)
+        second = htcondor.Submit(description).queue(txn, 20)
+    return first, second
+
+
+@action
+def materialized(condor, factories):
+    counts = {}
+    for _ in range(60):
+        counts = {
+            cluster: len(condor.query(constraint="ClusterId == {}".format(cluster), projection=["ProcId"]))
+            for cluster in factories
+        }
+        if all(n >= MAX_MATERIALIZE for n in counts.values()):
+            break
+        time.sleep(1)
+    return counts
+
+
+@action
+def passes(condor, factories, materialized):
+    # the factory invocations that materialized something, in order
+    found = []
+    for msg in condor.schedd_log.open().read():
+        m = RE_INVOKED.match(msg.message)
+        if m and int(m.group(1)) in factories and int(m.group(2)) > 0:
+            found.append((int(m.group(1)), int(m.group(2))))
+    return found
+
+
+class TestMaterializeBatch:
+    def test_both_factories_finished(self, factories, materialized):
+        assert materialized == {cluster: MAX_MATERIALIZE for cluster in factories}
+
+    def test_batches_are_limited(self, passes):
+        assert len(passes) > 0
+        assert all(count <= BATCH_SIZE for _, count in passes)
+
+    def test_factories_take_turns(self, factories, passes):
+        first, second = factories
+        clusters = [cluster for cluster, _ in passes]
+        # the second factory gets a batch before the first one is done
+        assert second in clusters
+        assert clusters.index(second) < len(clusters) - 1 - clusters[::-1].index(first)
+        for ix in range(1, len(clusters)):
+            assert clusters[ix] != clusters[ix - 1]
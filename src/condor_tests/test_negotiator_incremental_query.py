@@ -0,0 +1,81 @@
+#!/usr/bin/env pytest
+
+# With NEGOTIATOR_INCREMENTAL_COLLECTOR_QUERY, the negotiator keeps the
+# collector's ads between cycles and only fetches the ones that changed.
+# Make sure jobs still match, and that later cycles really are incremental.
+
+import logging
+import time
+
+import htcondor
+
+from ornithology import *
+
+logger = logging.getLogger(__name__)
+logger.setLevel(logging.DEBUG)
+
+NUM_JOBS = 8
+CACHE_ATTRS = [
+    "PublicAdCacheAds",
+    "PublicAdCacheFullQueries",
+    "PublicAdCacheIncrementalQueries",
+    "PrivateAdCacheFullQueries",
+    "PrivateAdCacheIncrementalQueries",
+]
+
+
+@standup
+def condor(test_dir):
+    with Condor(
+        local_dir=test_dir / "condor",
+        config={
+            "NUM_CPUS": "4",
+            "NEGOTIATOR_INCREMENTAL_COLLECTOR_QUERY": "true",
+            "NEGOTIATOR_INTERVAL": "2",
+            "NEGOTIATOR_CYCLE_DELAY": "1",
+            "NEGOTIATOR_UPDATE_INTERVAL": "2",
+        },
+    ) as condor:
+        yield condor
+
+
+@action
+def finished_jobs(condor, path_to_sleep):
+    handle = condor.submit(
+        description={"executable": path_to_sleep, "arguments": "1"},
+        count=NUM_JOBS,
+    )
+    assert handle.wait(condition=ClusterState.all_complete, timeout=180)
+    return handle
+
+
+@action
+def negotiator_ad(condor, finished_jobs):
+    # Wait for the negotiator to publish a cycle that reused its cache.
+    deadline = time.time() + 60
+    ad = {}
+    while time.time() < deadline:
+        ads = condor.status(ad_type=htcondor.AdTypes.Negotiator, projection=CACHE_ATTRS)
+        if len(ads) > 0:
+            ad = ads[0]
+            if ad.get("PublicAdCacheIncrementalQueries", 0) > 0:
+                break
+        time.sleep(1)
+    logger.info("negotiator ad cache stats: {}".format(dict(ad)))
+    return ad
+
+
+class TestNegotiatorIncrementalQuery:
+    def test_all_jobs_ran(self, finished_jobs):
+        assert finished_jobs.state.all_complete()
+
+    def test_first_query_was_full(self, negotiator_ad):
+        assert negotiator_ad["PublicAdCacheFullQueries"] >= 1
+        assert negotiator_ad["PrivateAdCacheFullQueries"] >= 1
+
+    def test_later_queries_were_incremental(self, negotiator_ad):
+        assert negotiator_ad["PublicAdCacheIncrementalQueries"] >= 1
+        assert negotiator_ad["PrivateAdCacheIncrementalQueries"] >= 1
+
+    def test_cache_holds_slots(self, negotiator_ad):
+        assert negotiator_ad["PublicAdCacheAds"] >= 4
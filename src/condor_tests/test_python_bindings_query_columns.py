@@ -0,0 +1,91 @@
+#!/usr/bin/env pytest
+
+# Compare the columnar query results against the per-ClassAd query path,
+# and log how long each took so regressions in either are easy to spot.
+
+import logging
+import time
+
+import htcondor
+
+from ornithology import *
+
+logger = logging.getLogger(__name__)
+logger.setLevel(logging.DEBUG)
+
+NUM_JOBS = 2000
+PROJECTION = ["ClusterId", "ProcId", "Owner", "JobStatus", "JobPrio", "NoSuchAttribute"]
+
+
+@standup
+def condor(test_dir):
+    with Condor(local_dir=test_dir / "condor") as condor:
+        yield condor
+
+
+@action
+def held_jobs(condor, path_to_sleep):
+    handle = condor.submit(
+        description={"executable": path_to_sleep, "arguments": "0", "hold": "true"},
+        count=NUM_JOBS,
+    )
+    return handle
+
+
+@action
+def ad_rows(condor, held_jobs):
+    schedd = condor.get_local_schedd()
+    start = time.time()
+    rows = []
+    for ad in schedd.xquery(projection=PROJECTION):
+        rows.append(tuple(ad.get(attr) for attr in PROJECTION))
+    logger.info("xquery of {} ads took {:.3f}s".format(len(rows), time.time() - start))
+    return sorted(rows, key=lambda row: (row[0], row[1]))
+
+
+@action
+def column_rows(condor, held_jobs):
+    schedd = condor.get_local_schedd()
+    start = time.time()
+    columns = dict((attr, []) for attr in PROJECTION)
+    chunks = 0
+    it = schedd.xquery(projection=PROJECTION)
+    while True:
+        try:
+            chunk = it.nextColumns(PROJECTION, max_ads=500)
+        except StopIteration:
+            break
+        chunks += 1
+        for attr in PROJECTION:
+            columns[attr].extend(chunk[attr])
+    rows = list(zip(*[columns[attr] for attr in PROJECTION]))
+    logger.info(
+        "nextColumns of {} ads in {} chunks took {:.3f}s".format(
+            len(rows), chunks, time.time() - start
+        )
+    )
+    return sorted(rows, key=lambda row: (row[0], row[1]))
+
+
+@action
+def collector_columns(condor):
+    collector = condor.get_local_collector()
+    return collector.queryColumns(
+        htcondor.AdTypes.Schedd, "true", ["Name", "MyType", "NoSuchAttribute"]
+    )
+
+
+class TestQueryColumns:
+    def test_all_jobs_returned(self, column_rows):
+        assert len(column_rows) == NUM_JOBS
+
+    def test_columns_match_classads(self, ad_rows, column_rows):
+        assert ad_rows == column_rows
+
+    def test_missing_attribute_is_none(self, column_rows):
+        assert all(row[-1] is None for row in column_rows)
+
+    def test_collector_columns(self, collector_columns):
+        assert len(collector_columns["Name"]) == 1
+        assert collector_columns["MyType"] == ["Scheduler"]
+        assert collector_columns["NoSuchAttribute"] == [None]
@@ -0,0 +1,103 @@
+#!/usr/bin/env pytest
+
+# With SHADOW_IDLE_TIMEOUT, a shadow whose claim has run out of jobs waits
+# for the next job of the same user instead of exiting.  Make sure a parked
+# shadow does not count against MAX_JOBS_RUNNING, that it is handed the
+# next job, and that it is let go once nothing else turns up.
+
+import logging
+import re
+
+from ornithology import *
+
+logger = logging.getLogger(__name__)
+logger.setLevel(logging.DEBUG)
+
+IDLE_TIMEOUT = 10
+
+RE_PARKED = re.compile(r"^No runnable jobs for claim of shadow pid (\d+); keeping it idle")
+RE_ADOPTED = re.compile(r"^Idle shadow pid (\d+) switching to job (\d+)\.(\d+) ")
+RE_RELEASED = re.compile(r"^No job found for idle shadow pid (\d+); shadow will exit\.")
+RE_DELETED = re.compile(r"^Deleting idle shadow rec for PID (\d+)")
+
+
+@standup
+def condor(test_dir):
+    with Condor(
+        local_dir=test_dir / "condor",
+        config={
+            "NUM_CPUS": "1",
+            "MAX_JOBS_RUNNING": "1",
+            "SHADOW_IDLE_TIMEOUT": str(IDLE_TIMEOUT),
+            "SCHEDD_DEBUG": "D_FULLDEBUG",
+            "NEGOTIATOR_INTERVAL": "2",
+            "NEGOTIATOR_CYCLE_DELAY": "1",
+        },
+    ) as condor:
+        yield condor
+
+
+def submit_and_wait(condor, path_to_sleep):
+    handle = condor.submit(
+        description={"executable": path_to_sleep, "arguments": "1"}, count=1,
+    )
+    assert handle.wait(
+        condition=ClusterState.all_complete,
+        fail_condition=ClusterState.any_held,
+        timeout=120,
+    )
+    return handle
+
+
+def wait_for(schedd_log, regex, timeout=120):
+    found = []
+
+    def match(msg):
+        m = regex.match(msg.message)
+        if m:
+            found.append(m)
+        return m is not None
+
+    assert schedd_log.wait(condition=match, timeout=timeout)
+    return found[0]
+
+
+@action
+def schedd_log(condor):
+    return condor.schedd_log.open()
+
+
+@action
+def parked_pid(condor, path_to_sleep, schedd_log):
+    submit_and_wait(condor, path_to_sleep)
+    return int(wait_for(schedd_log, RE_PARKED).group(1))
+
+
+@action
+def adopted(condor, path_to_sleep, schedd_log, parked_pid):
+    # With MAX_JOBS_RUNNING = 1, this job can only start if the parked
+    # shadow is not counted as running.
+    handle = submit_and_wait(condor, path_to_sleep)
+    m = wait_for(schedd_log, RE_ADOPTED)
+    return handle, m
+
+
+@action
+def released_pid(schedd_log, adopted):
+    pid = int(wait_for(schedd_log, RE_RELEASED, timeout=IDLE_TIMEOUT + 60).group(1))
+    assert int(wait_for(schedd_log, RE_DELETED).group(1)) == pid
+    return pid
+
+
+class TestShadowIdleReuse:
+    def test_shadow_adopted_next_job(self, parked_pid, adopted):
+        handle, m = adopted
+        assert int(m.group(1)) == parked_pid
+        assert int(m.group(2)) == handle.clusterid
+
+    def test_adopted_job_completed(self, adopted):
+        handle, _ = adopted
+        assert handle.state.all_complete()
+
+    def test_idle_shadow_released(self, parked_pid, released_pid):
+        assert released_pid == parked_pid
@@ -0,0 +1,632 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// condor_collector_bench - a load generator for measuring the capacity
+// of a condor_collector.  It sends synthetic (or replayed) startd,
+// schedd and submitter ads at a fixed rate while forked children run
+// condor_status style queries, then reports ingest throughput, query
+// latency percentiles and the collector's own view of the load.
+
+#include "condor_common.h"
+#include "condor_classad.h"
+#include "condor_version.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "command_strings.h"
+#include "daemon.h"
+#include "condor_distribution.h"
+#include "condor_query.h"
+#include "condor_attributes.h"
+#include "ipv6_hostname.h"
+
+#include <vector>
+#include <algorithm>
+
+struct BenchOptions {
+	const char *pool;
+	bool use_tcp;
+	int num_startds;
+	int num_schedds;
+	int num_submitters;
+	int extra_attrs;
+	double rate;         // updates per second, 0 for as fast as possible
+	int duration;        // seconds
+	int num_queriers;
+	double query_interval; // seconds between queries in each querier
+	const char *replay_file;
+};
+
+void
+usage( const char *cmd )
+{
+	fprintf(stderr,"Usage: %s [options]\n",cmd);
+	fprintf(stderr,"Where options are:\n");
+	fprintf(stderr,"    -help               Display options\n");
+	fprintf(stderr,"    -version            Display Condor version\n");
+	fprintf(stderr,"    -pool <hostname>    Use this central manager\n");
+	fprintf(stderr,"    -debug              Show extra debugging info\n");
+	fprintf(stderr,"    -tcp                Send updates via TCP (default)\n");
+	fprintf(stderr,"    -udp                Send updates via UDP\n");
+	fprintf(stderr,"    -startds <n>        Number of distinct startd ads (default 1000)\n");
+	fprintf(stderr,"    -schedds <n>        Number of distinct schedd ads (default 10)\n");
+	fprintf(stderr,"    -submitters <n>     Number of distinct submitter ads (default 100)\n");
+	fprintf(stderr,"    -attrs <n>          Extra attributes to pad each startd ad with (default 50)\n");
+	fprintf(stderr,"    -rate <n>           Updates per second to send, 0 for unlimited (default 100)\n");
+	fprintf(stderr,"    -duration <sec>     How long to send updates (default 60)\n");
+	fprintf(stderr,"    -queriers <n>       Number of concurrent query processes (default 2)\n");
+	fprintf(stderr,"    -query-interval <sec> Time between queries in each process (default 1)\n");
+	fprintf(stderr,"    -replay <file>      Replay the ads in <file> (separated by blank lines)\n"
+	               "                        instead of synthesizing them\n");
+	fprintf(stderr,"\nThe results are printed as a ClassAd on standard output.\n");
+	fprintf(stderr,"Example: %s -pool localhost:9618 -startds 10000 -rate 2000 -duration 120\n\n",cmd);
+}
+
+void
+version()
+{
+	printf( "%s\n%s\n", CondorVersion(), CondorPlatform() );
+}
+
+// One ad to send, along with the command that sends it.
+struct BenchAd {
+	int command;
+	ClassAd ad;
+	ClassAd *pvt_ad; // only for startd ads
+	BenchAd() : command(-1), pvt_ad(NULL) {}
+	~BenchAd() { delete pvt_ad; }
+};
+
+static void
+makeStartdAd( BenchAd &b, int n, int extra_attrs, const std::string &my_address )
+{
+	std::string name;
+	formatstr(name, "slot1@bench%d.example.org", n);
+	std::string machine(name.c_str() + strlen("slot1@"));
+
+	b.command = UPDATE_STARTD_AD;
+	ClassAd &ad = b.ad;
+	SetMyTypeName(ad, STARTD_ADTYPE);
+	SetTargetTypeName(ad, JOB_ADTYPE);
+	ad.Assign(ATTR_NAME, name);
+	ad.Assign(ATTR_MACHINE, machine);
+	ad.Assign(ATTR_MY_ADDRESS, my_address);
+	ad.Assign(ATTR_SLOT_ID, 1);
+	ad.Assign(ATTR_OPSYS, "LINUX");
+	ad.Assign(ATTR_ARCH, "X86_64");
+	ad.Assign(ATTR_STATE, (n % 3) ? "Claimed" : "Unclaimed");
+	ad.Assign(ATTR_ACTIVITY, (n % 3) ? "Busy" : "Idle");
+	ad.Assign(ATTR_CPUS, 1 + (n % 16));
+	ad.Assign(ATTR_MEMORY, 1024 * (1 + (n % 64)));
+	ad.Assign(ATTR_DISK, 1000000 + n);
+	ad.Assign(ATTR_LOAD_AVG, 0.0);
+	ad.Assign(ATTR_UPDATE_SEQUENCE_NUMBER, 0);
+	ad.Assign(ATTR_DAEMON_START_TIME, (long long)time(NULL));
+	ad.AssignExpr(ATTR_REQUIREMENTS, "START && (TARGET.RequestMemory <= MY.Memory)");
+	ad.AssignExpr(ATTR_START, "true");
+	ad.AssignExpr(ATTR_RANK, "0");
+	for( int i = 0; i < extra_attrs; i++ ) {
+		std::string attr;
+		formatstr(attr, "BenchAttr%d", i);
+		if( i % 2 ) {
+			ad.Assign(attr, i * n);
+		}
+		else {
+			std::string val;
+			formatstr(val, "bench value %d for %s", i, name.c_str());
+			ad.Assign(attr, val);
+		}
+	}
+
+	b.pvt_ad = new ClassAd();
+	SetMyTypeName(*b.pvt_ad, STARTD_ADTYPE);
+	b.pvt_ad->Assign(ATTR_NAME, name);
+	b.pvt_ad->Assign(ATTR_MY_ADDRESS, my_address);
+	std::string capability;
+	formatstr(capability, "%s#%d#1#...", my_address.c_str(), n);
+	b.pvt_ad->Assign(ATTR_CAPABILITY, capability);
+}
+
+static void
+makeScheddAd( BenchAd &b, int n, const std::string &my_address )
+{
+	std::string name;
+	formatstr(name, "bench-schedd%d.example.org", n);
+
+	b.command = UPDATE_SCHEDD_AD;
+	ClassAd &ad = b.ad;
+	SetMyTypeName(ad, SCHEDD_ADTYPE);
+	SetTargetTypeName(ad, "");
+	ad.Assign(ATTR_NAME, name);
+	ad.Assign(ATTR_MACHINE, name);
+	ad.Assign(ATTR_MY_ADDRESS, my_address);
+	ad.Assign(ATTR_TOTAL_RUNNING_JOBS, 100 * n);
+	ad.Assign(ATTR_TOTAL_IDLE_JOBS, 10 * n);
+	ad.Assign(ATTR_TOTAL_HELD_JOBS, n);
+	ad.Assign(ATTR_UPDATE_SEQUENCE_NUMBER, 0);
+	ad.Assign(ATTR_DAEMON_START_TIME, (long long)time(NULL));
+}
+
+static void
+makeSubmitterAd( BenchAd &b, int n, int num_schedds, const std::string &my_address )
+{
+	std::string schedd_name;
+	formatstr(schedd_name, "bench-schedd%d.example.org", num_schedds > 0 ? n % num_schedds : 0);
+	std::string name;
+	formatstr(name, "benchuser%d@example.org", n);
+
+	b.command = UPDATE_SUBMITTOR_AD;
+	ClassAd &ad = b.ad;
+	SetMyTypeName(ad, SUBMITTER_ADTYPE);
+	SetTargetTypeName(ad, "");
+	ad.Assign(ATTR_NAME, name);
+	ad.Assign(ATTR_SCHEDD_NAME, schedd_name);
+	ad.Assign(ATTR_MY_ADDRESS, my_address);
+	ad.Assign(ATTR_RUNNING_JOBS, n % 100);
+	ad.Assign(ATTR_IDLE_JOBS, n % 37);
+	ad.Assign(ATTR_HELD_JOBS, 0);
+	ad.Assign(ATTR_UPDATE_SEQUENCE_NUMBER, 0);
+}
+
+static bool
+loadReplayAds( const char *filename, std::vector<BenchAd*> &ads )
+{
+	FILE *file = safe_fopen_wrapper_follow(filename, "r");
+	if( !file ) {
+		fprintf(stderr, "couldn't open %s: %s\n", filename, strerror(errno));
+		return false;
+	}
+
+	CondorClassAdFileIterator iter;
+	if( !iter.begin(file, true, CondorClassAdFileParseHelper::Parse_long) ) {
+		fprintf(stderr, "couldn't read ads from %s\n", filename);
+		return false;
+	}
+
+	for(;;) {
+		BenchAd *b = new BenchAd();
+		if( iter.next(b->ad) <= 0 ) {
+			delete b;
+			break;
+		}
+
+		std::string my_type;
+		b->ad.LookupString(ATTR_MY_TYPE, my_type);
+		if( my_type.empty() ) {
+			fprintf(stderr, "MyType not set in ad %d of %s, skipping.\n", (int)ads.size() + 1, filename);
+			delete b;
+			continue;
+		}
+		std::transform(my_type.begin(), my_type.end(), my_type.begin(), toupper);
+
+		std::string command_str;
+		if( my_type == "GENERIC" ) {
+			command_str = "UPDATE_AD_GENERIC";
+		} else {
+			formatstr(command_str, "UPDATE_%s_AD", my_type.c_str());
+		}
+		b->command = getCommandNum(command_str.c_str());
+		if( b->command == -1 ) {
+			b->command = UPDATE_AD_GENERIC;
+		}
+		ads.push_back(b);
+	}
+
+	if( ads.empty() ) {
+		fprintf(stderr, "%s contains no ads\n", filename);
+		return false;
+	}
+	return true;
+}
+
+// Send one update, reusing the given sock when possible.
+// Returns false (and deletes the sock) on failure.
+static bool
+sendUpdate( Daemon *collector, Sock *&sock, bool use_tcp, BenchAd &b, int seq )
+{
+	b.ad.Assign(ATTR_UPDATE_SEQUENCE_NUMBER, seq);
+
+	if( !sock || !use_tcp ) {
+		delete sock;
+		sock = collector->startCommand(b.command,
+			use_tcp ? Stream::reli_sock : Stream::safe_sock, 20);
+		if( !sock ) {
+			return false;
+		}
+	}
+	else {
+		sock->encode();
+		if( !sock->put(b.command) ) {
+			delete sock;
+			sock = NULL;
+			return false;
+		}
+	}
+
+	bool ok = putClassAd(sock, b.ad);
+	if( ok && b.pvt_ad ) {
+		ok = putClassAd(sock, *b.pvt_ad);
+	}
+	if( !ok || !sock->end_of_message() ) {
+		delete sock;
+		sock = NULL;
+		return false;
+	}
+	return true;
+}
+
+static void
+hangup( Sock *&sock )
+{
+	if( sock && sock->type() == Stream::reli_sock ) {
+			// graceful hangup so the collector knows we are done
+		sock->encode();
+		int hangup_cmd = DC_NOP;
+		sock->put(hangup_cmd);
+		sock->end_of_message();
+	}
+	delete sock;
+	sock = NULL;
+}
+
+static bool
+countAd( void *pv, ClassAd * /*ad*/ )
+{
+	(*(int *)pv)++;
+	return true; // tell the query code to delete the ad
+}
+
+// Body of each forked querier: alternate between querying startd,
+// schedd and submitter ads until the deadline, then write the latency
+// of each query (in seconds) to fd, one per line.
+static void
+runQuerier( int id, const char *addr, time_t deadline, double interval, int fd )
+{
+	static const AdTypes types[] = { STARTD_AD, SCHEDD_AD, SUBMITTOR_AD };
+	std::vector<double> latencies;
+	int failures = 0;
+
+	for( int n = id; time(NULL) < deadline; n++ ) {
+		CondorQuery query(types[n % COUNTOF(types)]);
+		if( (n / COUNTOF(types)) % 2 ) {
+				// like condor_status without -long
+			std::vector<std::string> attrs;
+			attrs.push_back(ATTR_NAME);
+			attrs.push_back(ATTR_STATE);
+			attrs.push_back(ATTR_ACTIVITY);
+			attrs.push_back(ATTR_MEMORY);
+			attrs.push_back(ATTR_CPUS);
+			query.setDesiredAttrs(attrs);
+		}
+
+		int count = 0;
+		CondorError errstack;
+		double begin = _condor_debug_get_time_double();
+		QueryResult result = query.processAds(countAd, &count, addr, &errstack);
+		double elapsed = _condor_debug_get_time_double() - begin;
+		if( result == Q_OK ) {
+			latencies.push_back(elapsed);
+		}
+		else {
+			failures++;
+			dprintf(D_ALWAYS, "querier %d: query failed: %s\n", id, getStrQueryResult(result));
+		}
+
+		if( interval > elapsed ) {
+			usleep((useconds_t)((interval - elapsed) * 1000000));
+		}
+	}
+
+	FILE *out = fdopen(fd, "w");
+	if( !out ) {
+		return;
+	}
+	fprintf(out, "failures %d\n", failures);
+	for( size_t i = 0; i < latencies.size(); i++ ) {
+		fprintf(out, "%f\n", latencies[i]);
+	}
+	fclose(out);
+}
+
+static double
+percentile( const std::vector<double> &sorted, double p )
+{
+	if( sorted.empty() ) {
+		return 0.0;
+	}
+	size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+	return sorted[MIN(idx, sorted.size() - 1)];
+}
+
+// Fetch the collector's own ad, which carries fresh statistics.
+static bool
+fetchCollectorAd( const char *addr, ClassAd &result )
+{
+	CondorQuery query(COLLECTOR_AD);
+	ClassAdList ads;
+	if( query.fetchAds(ads, addr) != Q_OK ) {
+		return false;
+	}
+	ads.Rewind();
+	ClassAd *ad = ads.Next();
+	if( !ad ) {
+		return false;
+	}
+	result = *ad;
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	BenchOptions opts;
+	opts.pool = NULL;
+	opts.num_startds = 1000;
+	opts.num_schedds = 10;
+	opts.num_submitters = 100;
+	opts.extra_attrs = 50;
+	opts.rate = 100;
+	opts.duration = 60;
+	opts.num_queriers = 2;
+	opts.query_interval = 1.0;
+	opts.replay_file = NULL;
+
+	myDistro->Init( argc, argv );
+	set_priv_initialize(); // allow uid switching if root
+	config();
+
+	opts.use_tcp = param_boolean( "UPDATE_COLLECTOR_WITH_TCP", true );
+
+	for( int i=1; i<argc; i++ ) {
+		bool needs_arg = false;
+		if(!strcmp(argv[i],"-help") || !strcmp(argv[i],"--help")) {
+			usage(argv[0]);
+			exit(0);
+		} else if(!strcmp(argv[i],"-version")) {
+			version();
+			exit(0);
+		} else if(!strcmp(argv[i],"-debug")) {
+				// dprintf to console
+			dprintf_set_tool_debug("TOOL", 0);
+		} else if(!strcmp(argv[i],"-tcp")) {
+			opts.use_tcp = true;
+		} else if(!strcmp(argv[i],"-udp")) {
+			opts.use_tcp = false;
+		} else {
+			needs_arg = true;
+		}
+		if( !needs_arg ) {
+			continue;
+		}
+
+		if( !argv[i+1] ) {
+			fprintf(stderr,"%s requires an argument.\n\n",argv[i]);
+			usage(argv[0]);
+			exit(1);
+		}
+		const char *arg = argv[++i];
+		if(!strcmp(argv[i-1],"-pool")) {
+			opts.pool = arg;
+		} else if(!strcmp(argv[i-1],"-startds")) {
+			opts.num_startds = atoi(arg);
+		} else if(!strcmp(argv[i-1],"-schedds")) {
+			opts.num_schedds = atoi(arg);
+		} else if(!strcmp(argv[i-1],"-submitters")) {
+			opts.num_submitters = atoi(arg);
+		} else if(!strcmp(argv[i-1],"-attrs")) {
+			opts.extra_attrs = atoi(arg);
+		} else if(!strcmp(argv[i-1],"-rate")) {
+			opts.rate = atof(arg);
+		} else if(!strcmp(argv[i-1],"-duration")) {
+			opts.duration = atoi(arg);
+		} else if(!strcmp(argv[i-1],"-queriers")) {
+			opts.num_queriers = atoi(arg);
+		} else if(!strcmp(argv[i-1],"-query-interval")) {
+			opts.query_interval = atof(arg);
+		} else if(!strcmp(argv[i-1],"-replay")) {
+			opts.replay_file = arg;
+		} else {
+			fprintf(stderr,"Unknown argument: %s\n\n",argv[i-1]);
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+
+	if( opts.duration <= 0 || opts.rate < 0 || opts.num_queriers < 0 ||
+		opts.num_startds < 0 || opts.num_schedds < 0 || opts.num_submitters < 0 )
+	{
+		fprintf(stderr,"Invalid arguments.\n\n");
+		usage(argv[0]);
+		exit(1);
+	}
+
+	Daemon *collector = NULL;
+	if( opts.pool ) {
+		collector = new Daemon( DT_COLLECTOR, opts.pool, 0 );
+	} else {
+		collector = new Daemon( DT_COLLECTOR, 0, 0 );
+	}
+	if( !collector->locate(Daemon::LOCATE_FOR_LOOKUP) ) {
+		fprintf(stderr,"couldn't locate collector: %s\n",collector->error());
+		return 1;
+	}
+	std::string addr = collector->addr();
+
+	std::vector<BenchAd*> ads;
+	if( opts.replay_file ) {
+		if( !loadReplayAds(opts.replay_file, ads) ) {
+			return 1;
+		}
+	}
+	else {
+		condor_protocol proto = CP_IPV4;
+		if( param_false( "ENABLE_IPV4" ) ) { proto = CP_IPV6; }
+		std::string my_address;
+		formatstr(my_address, "<%s:0>", get_local_ipaddr(proto).to_ip_string(true).Value());
+
+			// interleave the ad types, the way updates arrive in a real pool
+		int total = opts.num_startds + opts.num_schedds + opts.num_submitters;
+		int startds = 0, schedds = 0, submitters = 0;
+		for( int n = 0; n < total; n++ ) {
+			BenchAd *b = new BenchAd();
+			if( schedds < opts.num_schedds && (long long)schedds * total <= (long long)n * opts.num_schedds ) {
+				makeScheddAd(*b, schedds++, my_address);
+			}
+			else if( submitters < opts.num_submitters && (long long)submitters * total <= (long long)n * opts.num_submitters ) {
+				makeSubmitterAd(*b, submitters++, opts.num_schedds, my_address);
+			}
+			else if( startds < opts.num_startds ) {
+				makeStartdAd(*b, startds++, opts.extra_attrs, my_address);
+			}
+			else if( submitters < opts.num_submitters ) {
+				makeSubmitterAd(*b, submitters++, opts.num_schedds, my_address);
+			}
+			else {
+				makeScheddAd(*b, schedds++, my_address);
+			}
+			ads.push_back(b);
+		}
+		if( ads.empty() ) {
+			fprintf(stderr,"Nothing to send.\n");
+			return 1;
+		}
+	}
+
+	ClassAd before;
+	bool have_before = fetchCollectorAd(addr.c_str(), before);
+
+	time_t deadline = time(NULL) + opts.duration;
+
+	std::vector<pid_t> querier_pids;
+	std::vector<int> querier_fds;
+	for( int q = 0; q < opts.num_queriers; q++ ) {
+		int fds[2];
+		if( pipe(fds) != 0 ) {
+			fprintf(stderr,"pipe() failed: %s\n",strerror(errno));
+			return 1;
+		}
+		pid_t pid = fork();
+		if( pid < 0 ) {
+			fprintf(stderr,"fork() failed: %s\n",strerror(errno));
+			return 1;
+		}
+		if( pid == 0 ) {
+			close(fds[0]);
+			runQuerier(q, addr.c_str(), deadline, opts.query_interval, fds[1]);
+			_exit(0);
+		}
+		close(fds[1]);
+		querier_pids.push_back(pid);
+		querier_fds.push_back(fds[0]);
+	}
+
+		// send updates at the requested rate until the deadline
+	Sock *sock = NULL;
+	long long sent = 0;
+	long long failed = 0;
+	double begin = _condor_debug_get_time_double();
+	while( time(NULL) < deadline ) {
+		BenchAd &b = *ads[sent % ads.size()];
+		int seq = (int)(sent / ads.size()) + 1;
+		if( !sendUpdate(collector, sock, opts.use_tcp, b, seq) ) {
+			failed++;
+			dprintf(D_ALWAYS, "failed to send update to %s\n", addr.c_str());
+		}
+		sent++;
+
+		if( opts.rate > 0 ) {
+			double due = begin + sent / opts.rate;
+			double now = _condor_debug_get_time_double();
+			if( due > now ) {
+				usleep((useconds_t)((due - now) * 1000000));
+			}
+		}
+	}
+	double elapsed = _condor_debug_get_time_double() - begin;
+	hangup(sock);
+
+		// gather query latencies from the children
+	std::vector<double> latencies;
+	int query_failures = 0;
+	for( size_t q = 0; q < querier_fds.size(); q++ ) {
+		FILE *in = fdopen(querier_fds[q], "r");
+		if( !in ) {
+			close(querier_fds[q]);
+			continue;
+		}
+		int child_failures = 0;
+		if( fscanf(in, "failures %d\n", &child_failures) == 1 ) {
+			query_failures += child_failures;
+		}
+		double latency;
+		while( fscanf(in, "%lf\n", &latency) == 1 ) {
+			latencies.push_back(latency);
+		}
+		fclose(in);
+		int status = 0;
+		waitpid(querier_pids[q], &status, 0);
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	ClassAd after;
+	bool have_after = fetchCollectorAd(addr.c_str(), after);
+
+	ClassAd summary;
+	summary.Assign("Collector", addr);
+	summary.Assign("Protocol", opts.use_tcp ? "TCP" : "UDP");
+	summary.Assign("DistinctAds", (long long)ads.size());
+	summary.Assign("DurationSeconds", elapsed);
+	summary.Assign("UpdatesSent", sent - failed);
+	summary.Assign("UpdatesFailed", failed);
+	summary.Assign("UpdatesPerSecond", elapsed > 0 ? (sent - failed) / elapsed : 0.0);
+	summary.Assign("Queries", (long long)latencies.size());
+	summary.Assign("QueriesFailed", query_failures);
+	summary.Assign("QueryLatencyP50", percentile(latencies, 0.50));
+	summary.Assign("QueryLatencyP90", percentile(latencies, 0.90));
+	summary.Assign("QueryLatencyP99", percentile(latencies, 0.99));
+	summary.Assign("QueryLatencyMax", latencies.empty() ? 0.0 : latencies.back());
+
+	if( have_before && have_after ) {
+		long long total_before = 0, total_after = 0, lost_before = 0, lost_after = 0;
+		before.LookupInteger("UpdatesTotal", total_before);
+		after.LookupInteger("UpdatesTotal", total_after);
+		before.LookupInteger("UpdatesLost", lost_before);
+		after.LookupInteger("UpdatesLost", lost_after);
+		summary.Assign("CollectorUpdatesReceived", total_after - total_before);
+		summary.Assign("CollectorUpdatesLost", lost_after - lost_before);
+		summary.Assign("CollectorIngestPerSecond", elapsed > 0 ? (total_after - total_before) / elapsed : 0.0);
+	}
+	if( have_after ) {
+		long long rss = 0;
+		if( after.LookupInteger("MonitorSelfResidentSetSize", rss) ) {
+			summary.Assign("CollectorResidentSetSizeKB", rss);
+		}
+		double cpu = 0;
+		if( after.LookupFloat("MonitorSelfCPUUsage", cpu) ) {
+			summary.Assign("CollectorCPUUsage", cpu);
+		}
+	}
+
+	fPrintAd(stdout, summary);
+
+	for( size_t i = 0; i < ads.size(); i++ ) {
+		delete ads[i];
+	}
+	delete collector;
+
+	return (failed || query_failures) ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// condor_match_bench - times matchmaking of synthetic job ads against
+// synthetic slot ads whose START expressions check the job owner against
+// a list of allowed users with stringListMember(), the way many pools
+// restrict who may use a machine.
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_attributes.h"
+#include "condor_adtypes.h"
+#include "condor_classad.h"
+#include "compat_classad_util.h"
+#include "utc_time.h"
+
+static void
+usage( const char *cmd )
+{
+	fprintf(stderr,"Usage: %s [options]\n",cmd);
+	fprintf(stderr,"Where options are:\n");
+	fprintf(stderr,"    -slots <n>      Number of slot ads (default 1000)\n");
+	fprintf(stderr,"    -jobs <n>       Number of job ads (default 100)\n");
+	fprintf(stderr,"    -users <n>      Number of users in each allowed list (default 2000)\n");
+	fprintf(stderr,"    -lists <n>      Number of different allowed lists among the slots (default 1)\n");
+	fprintf(stderr,"    -anycase        Use stringListIMember instead of stringListMember\n");
+	fprintf(stderr,"    -in-start       Put the list in the START expression rather than a slot attribute\n");
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_slots = 1000;
+	int num_jobs = 100;
+	int num_users = 2000;
+	int num_lists = 1;
+	bool anycase = false;
+	bool in_start = false;
+
+	for (int i = 1; i < argc; i++) {
+		bool has_arg = i + 1 < argc;
+		if (strcmp(argv[i], "-slots") == 0 && has_arg) {
+			num_slots = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-jobs") == 0 && has_arg) {
+			num_jobs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-users") == 0 && has_arg) {
+			num_users = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-lists") == 0 && has_arg) {
+			num_lists = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-anycase") == 0) {
+			anycase = true;
+		} else if (strcmp(argv[i], "-in-start") == 0) {
+			in_start = true;
+		} else {
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+	if (num_slots < 1 || num_jobs < 1 || num_users < 1 || num_lists < 1) {
+		usage(argv[0]);
+		exit(1);
+	}
+
+	set_priv_initialize();
+	config();
+
+		// each list allows a different, overlapping, range of users
+	std::vector<std::string> lists;
+	for (int list = 0; list < num_lists; list++) {
+		std::string users;
+		for (int user = 0; user < num_users; user++) {
+			formatstr_cat(users, "%suser%d@bench.example.org", user ? ", " : "", user + list * 10);
+		}
+		lists.push_back(users);
+	}
+
+	const char *func = anycase ? "stringListIMember" : "stringListMember";
+	std::vector<ClassAd *> slots;
+	for (int i = 0; i < num_slots; i++) {
+		ClassAd *slot = new ClassAd();
+		SetMyTypeName(*slot, STARTD_ADTYPE);
+		SetTargetTypeName(*slot, JOB_ADTYPE);
+		std::string name;
+		formatstr(name, "slot%d@node%d.bench.example.org", i % 64 + 1, i / 64);
+		slot->Assign(ATTR_NAME, name);
+		slot->Assign(ATTR_MEMORY, 4096);
+		std::string start;
+		if (in_start) {
+			formatstr(start, "%s(TARGET.Owner, \"%s\")", func, lists[i % num_lists].c_str());
+		} else {
+			slot->Assign("AllowedUsers", lists[i % num_lists]);
+			formatstr(start, "%s(TARGET.Owner, MY.AllowedUsers)", func);
+		}
+		slot->AssignExpr(ATTR_START, start.c_str());
+		slot->AssignExpr(ATTR_REQUIREMENTS, "START");
+		slots.push_back(slot);
+	}
+
+	std::vector<ClassAd *> jobs;
+	for (int i = 0; i < num_jobs; i++) {
+		ClassAd *job = new ClassAd();
+		SetMyTypeName(*job, JOB_ADTYPE);
+		SetTargetTypeName(*job, STARTD_ADTYPE);
+		std::string owner;
+			// about one job in four has an owner that isn't in any list
+		formatstr(owner, "user%d@bench.example.org", (i * 7919) % (num_users + num_users / 3));
+		job->Assign(ATTR_OWNER, owner);
+		job->Assign(ATTR_REQUEST_MEMORY, 1024);
+		job->AssignExpr(ATTR_REQUIREMENTS, "TARGET.Memory >= MY.RequestMemory");
+		jobs.push_back(job);
+	}
+
+	double begin = condor_gettimestamp_double();
+	long matches = 0;
+	for (size_t job = 0; job < jobs.size(); job++) {
+		for (size_t slot = 0; slot < slots.size(); slot++) {
+			if (IsAMatch(jobs[job], slots[slot])) {
+				matches++;
+			}
+		}
+	}
+	double elapsed = condor_gettimestamp_double() - begin;
+	long pairs = (long)num_jobs * num_slots;
+	printf("%ld matches of %ld job/slot pairs in %.3f seconds (%.2f usec per pair)\n",
+	       matches, pairs, elapsed, elapsed * 1e6 / pairs);
+
+	for (size_t ix = 0; ix < slots.size(); ix++) { delete slots[ix]; }
+	for (size_t ix = 0; ix < jobs.size(); ix++) { delete jobs[ix]; }
+	return 0;
+}
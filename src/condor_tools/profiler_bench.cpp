@@ -0,0 +1,122 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// condor_profiler_bench - measures what the DaemonCore handler profiler
+// adds to each handler call, with the profiler off and at several sample
+// rates, so that DAEMON_PROFILE_SAMPLE_RATE can be chosen with the cost
+// in mind.  The "handler" is a loop that runs for about -work microseconds.
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_daemon_core.h"
+
+static void
+usage( const char *cmd )
+{
+	fprintf(stderr,"Usage: %s [options]\n",cmd);
+	fprintf(stderr,"Where options are:\n");
+	fprintf(stderr,"    -calls <n>      Number of handler calls per run (default 1000000)\n");
+	fprintf(stderr,"    -work <usec>    How long each handler call runs (default 0)\n");
+	fprintf(stderr,"    -history <n>    Number of samples the profiler keeps (default 1000)\n");
+}
+
+static volatile unsigned int bench_sink = 0;
+
+static void
+fake_handler( int spins )
+{
+	unsigned int val = bench_sink;
+	for (int ii = 0; ii < spins; ++ii) {
+		val = val * 1103515245 + 12345;
+	}
+	bench_sink = val;
+}
+
+// returns the seconds taken by num_calls handler calls at the given sample rate,
+// or with no profiler probe at all when sample_rate is negative
+static double
+time_calls( DaemonProfiler &profiler, int sample_rate, int history, int num_calls, int spins )
+{
+	profiler.Configure(sample_rate < 0 ? 0 : sample_rate, history);
+	double begin = _condor_debug_get_time_double();
+	for (int ii = 0; ii < num_calls; ++ii) {
+		if (sample_rate < 0) {
+			fake_handler(spins);
+		} else {
+			DaemonProfiler::Probe profile(profiler, DaemonProfiler::Command, "BENCH_COMMAND", NULL, 0.0);
+			fake_handler(spins);
+		}
+	}
+	return _condor_debug_get_time_double() - begin;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_calls = 1000000;
+	int work_usec = 0;
+	int history = 1000;
+
+	for (int i = 1; i < argc; i++) {
+		bool has_arg = i + 1 < argc;
+		if (strcmp(argv[i], "-calls") == 0 && has_arg) {
+			num_calls = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-work") == 0 && has_arg) {
+			work_usec = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-history") == 0 && has_arg) {
+			history = atoi(argv[++i]);
+		} else {
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+	if (num_calls < 1 || work_usec < 0 || history < 1) {
+		usage(argv[0]);
+		exit(1);
+	}
+
+	set_priv_initialize();
+	config();
+
+		// calibrate the fake handler to take about work_usec
+	int spins = 0;
+	if (work_usec > 0) {
+		const int calibrate = 10000000;
+		double begin = _condor_debug_get_time_double();
+		fake_handler(calibrate);
+		double elapsed = _condor_debug_get_time_double() - begin;
+		spins = (int)(calibrate * (work_usec * 1e-6) / (elapsed > 0 ? elapsed : 1e-6));
+	}
+
+	DaemonProfiler profiler;
+	double baseline = time_calls(profiler, -1, history, num_calls, spins);
+	printf("%d calls without a probe: %.3f seconds (%.1f ns/call)\n",
+	       num_calls, baseline, baseline * 1e9 / num_calls);
+
+	const int rates[] = { 0, 1000, 100, 10, 1 };
+	for (size_t ix = 0; ix < sizeof(rates)/sizeof(rates[0]); ++ix) {
+		long long before = profiler.TotalSamples();
+		double elapsed = time_calls(profiler, rates[ix], history, num_calls, spins);
+		printf("Sample rate %4d: %.3f seconds, %.1f ns/call overhead, %lld samples\n",
+		       rates[ix], elapsed, (elapsed - baseline) * 1e9 / num_calls, profiler.TotalSamples() - before);
+	}
+
+	return 0;
+}
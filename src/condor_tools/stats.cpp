@@ -29,6 +29,7 @@
 #include "condor_commands.h"
 #include "condor_io.h"
 #include "daemon.h"
+#include "daemon_types.h"
 #include "condor_distribution.h"
 #define NUM_ELEMENTS(_ary)   (sizeof(_ary) / sizeof((_ary)[0]))
 
@@ -36,12 +37,14 @@
 
 static int CalcTime(int,int,int);
 static int TimeLine(const MyString& Name,int FromDate, int ToDate, int Res);
+static int QueryProfile(const char* Daemon, const char* Name, const char* Pool, const char* GroupBy);
 
 //------------------------------------------------------------------------
 
 static void Usage(char* name) 
 {
   fprintf(stderr, "Usage: %s [-f filename] [-orgformat] [-pool hostname] [-lastday | -lastweek | -lastmonth | -lasthours h | -from m d y [-to m d y]] {-resourcequery <name> | -resourcelist | -resgroupquery <name> | -resgrouplist | -userquery <name> | -userlist | -usergroupquery <name> | -usergrouplist | -ckptquery | -ckptlist}\n",name);
+  fprintf(stderr, "       %s [-pool hostname] [-name daemon-name] [-groupby handler | peer | sample] -profile <daemon-type>\n",name);
   exit(1);
 }
 
@@ -115,6 +118,9 @@ int main(int argc, char* argv[])
   MyString FileName;
   MyString TimeFileName;
   char* pool = NULL;
+  const char* ProfileDaemon = NULL;
+  const char* ProfileName = NULL;
+  const char* ProfileGroupBy = "Handler";
 
   myDistro->Init( argc, argv );
 
@@ -228,11 +234,35 @@ int main(int argc, char* argv[])
 	  pool=argv[i+1];
       i++;
     }
+
+    // handler profile of a daemon
+
+    else if (strcmp(argv[i],"-profile")==0) {
+      if (argc-i<=1) Usage(argv[0]);
+      ProfileDaemon=argv[i+1];
+      i++;
+    }
+    else if (strcmp(argv[i],"-name")==0) {
+      if (argc-i<=1) Usage(argv[0]);
+      ProfileName=argv[i+1];
+      i++;
+    }
+    else if (strcmp(argv[i],"-groupby")==0) {
+      if (argc-i<=1) Usage(argv[0]);
+      ProfileGroupBy=argv[i+1];
+      i++;
+    }
     else {
       Usage(argv[0]);
     }
   }
 
+  if (ProfileDaemon) {
+    set_priv_initialize(); // allow uid switching if root
+    config();
+    return QueryProfile(ProfileDaemon, ProfileName, pool, ProfileGroupBy);
+  }
+
   // Check validity or arguments
   if (QueryType==-1 || FromDate<0 || FromDate>Now || ToDate<FromDate) Usage(argv[0]);
   // if (ToDate>Now) ToDate=Now;
@@ -358,3 +388,99 @@ int TimeLine(const MyString& TimeFileName,int FromDate, int ToDate, int Res)
   fclose(TimeFile);
   return 0;
 }
+
+// Fetch and print the handler samples taken by a daemon's profiler
+int QueryProfile(const char* DaemonType, const char* Name, const char* Pool, const char* GroupBy)
+{
+  daemon_t type = stringToDaemonType(DaemonType);
+  if (type == DT_NONE) {
+    fprintf(stderr, "Unknown daemon type: %s\n", DaemonType);
+    return 1;
+  }
+  if (strcasecmp(GroupBy,"handler")!=0 && strcasecmp(GroupBy,"peer")!=0 && strcasecmp(GroupBy,"sample")!=0) {
+    fprintf(stderr, "-groupby must be handler, peer or sample\n");
+    return 1;
+  }
+
+  Daemon d(type, Name, Pool);
+  if (!d.locate()) {
+    fprintf(stderr, "%s\n", d.error());
+    return 1;
+  }
+
+  CondorError errstack;
+  ReliSock sock;
+  if (!d.connectSock(&sock, 0, &errstack) ||
+      !d.startCommand(DC_QUERY_PROFILE, &sock, 0, &errstack)) {
+    fprintf(stderr, "failed to send DC_QUERY_PROFILE to %s: %s\n", d.idStr(), errstack.getFullText().c_str());
+    return 1;
+  }
+
+  ClassAd request;
+  request.Assign("GroupBy", GroupBy);
+  if (!putClassAd(&sock, request) || !sock.end_of_message()) {
+    fprintf(stderr, "failed to send profile query to %s\n", d.idStr());
+    return 1;
+  }
+
+  ClassAd summary;
+  int NumAds = 0;
+  sock.decode();
+  if (!getClassAd(&sock, summary) || !sock.code(NumAds)) {
+    fprintf(stderr, "failed to receive the profile from %s\n", d.idStr());
+    return 1;
+  }
+
+  int SampleRate = 0;
+  long long Samples = 0, TotalSamples = 0;
+  summary.LookupInteger("SampleRate", SampleRate);
+  summary.LookupInteger("Samples", Samples);
+  summary.LookupInteger("TotalSamples", TotalSamples);
+  if (SampleRate <= 0) {
+    printf("The profiler is off in %s, set DAEMON_PROFILE_SAMPLE_RATE to turn it on.\n", d.idStr());
+  } else {
+    printf("%lld of %lld samples from %s, 1 of every %d handler calls.\n", Samples, TotalSamples, d.idStr(), SampleRate);
+  }
+
+  bool bySample = strcasecmp(GroupBy,"sample")==0;
+  bool byPeer = strcasecmp(GroupBy,"peer")==0;
+  if (bySample) {
+    printf("%-19s %-7s %-40s %-16s %10s %10s %10s\n", "Time", "Kind", "Name", "Peer", "Wall", "CPU", "Queue");
+  } else {
+    printf("%-7s %-40s %8s %10s %10s %10s %10s %10s\n", byPeer ? "" : "Kind", byPeer ? "Peer" : "Name",
+           "Samples", "Wall", "CPU", "Queue", "MaxWall", "MaxQueue");
+  }
+
+  for (int ix = 0; ix < NumAds; ++ix) {
+    ClassAd ad;
+    if (!getClassAd(&sock, ad)) {
+      fprintf(stderr, "failed to receive the profile from %s\n", d.idStr());
+      return 1;
+    }
+    std::string Kind, Name, Peer;
+    double Wall = 0, Cpu = 0, Queue = 0, MaxWall = 0, MaxQueue = 0;
+    long long Count = 0;
+    ad.LookupString("Kind", Kind);
+    ad.LookupString("Name", Name);
+    ad.LookupString("Peer", Peer);
+    ad.LookupFloat("WallTime", Wall);
+    ad.LookupFloat("CpuTime", Cpu);
+    ad.LookupFloat("QueueTime", Queue);
+    if (bySample) {
+      time_t When = 0;
+      ad.LookupInteger("Time", When);
+      char TimeStr[32];
+      strftime(TimeStr, sizeof(TimeStr), "%Y-%m-%d %H:%M:%S", localtime(&When));
+      printf("%-19s %-7s %-40s %-16s %10.6f %10.6f %10.6f\n", TimeStr, Kind.c_str(), Name.c_str(), Peer.c_str(), Wall, Cpu, Queue);
+    } else {
+      ad.LookupInteger("Samples", Count);
+      ad.LookupFloat("MaxWallTime", MaxWall);
+      ad.LookupFloat("MaxQueueTime", MaxQueue);
+      printf("%-7s %-40s %8lld %10.6f %10.6f %10.6f %10.6f %10.6f\n", Kind.c_str(), byPeer ? Peer.c_str() : Name.c_str(),
+             Count, Wall, Cpu, Queue, MaxWall, MaxQueue);
+    }
+  }
+  sock.end_of_message();
+
+  return 0;
+}
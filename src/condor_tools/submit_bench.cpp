@@ -0,0 +1,228 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// condor_submit_bench - writes a submit file with a large queue statement
+// whose items vary a few attributes of each job, runs condor_submit on it
+// and reports how long the submit took.  The jobs are submitted on hold and
+// removed again afterwards, unless -keep is given.
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_distribution.h"
+#include "condor_arglist.h"
+#include "my_popen.h"
+#include "utc_time.h"
+
+void
+usage( const char *cmd )
+{
+	fprintf(stderr,"Usage: %s [options]\n",cmd);
+	fprintf(stderr,"Where options are:\n");
+	fprintf(stderr,"    -help               Display options\n");
+	fprintf(stderr,"    -jobs <n>           Number of jobs to queue (default 10000)\n");
+	fprintf(stderr,"    -vars <n>           Number of per-job item variables (default 4)\n");
+	fprintf(stderr,"    -attrs <n>          Number of custom attributes common to all jobs (default 20)\n");
+	fprintf(stderr,"    -runs <n>           Number of times to run condor_submit (default 1)\n");
+	fprintf(stderr,"    -file <path>        Where to write the submit file (default submit_bench.sub)\n");
+	fprintf(stderr,"    -name <schedd>      Submit to this schedd\n");
+	fprintf(stderr,"    -dry-run            Only expand the jobs, don't send them to the schedd\n");
+	fprintf(stderr,"    -factory            Submit as a late materialization factory\n");
+	fprintf(stderr,"    -keep               Don't remove the submitted jobs\n");
+	fprintf(stderr,"    -generate           Only write the submit file\n");
+}
+
+static bool
+write_submit_file( const char *path, int num_jobs, int num_vars, int num_attrs )
+{
+	FILE *fp = safe_fopen_wrapper_follow(path, "w");
+	if ( ! fp) {
+		fprintf(stderr, "ERROR: can't write %s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	fprintf(fp, "# generated by condor_submit_bench\n");
+	fprintf(fp, "universe = vanilla\n");
+	fprintf(fp, "executable = /bin/true\n");
+	fprintf(fp, "transfer_executable = false\n");
+	fprintf(fp, "should_transfer_files = NO\n");
+	fprintf(fp, "hold = true\n");
+	fprintf(fp, "request_memory = 1024 + $(Step) %% 4 * 256\n");
+	fprintf(fp, "arguments = $(Process) $(Item)\n");
+	for (int ii = 0; ii < num_attrs; ++ii) {
+		fprintf(fp, "My.BenchAttr%d = \"the same value in every job, number %d\"\n", ii, ii);
+	}
+	for (int ii = 0; ii < num_vars; ++ii) {
+		fprintf(fp, "My.BenchVar%d = \"$(v%d)\"\n", ii, ii);
+	}
+
+	fprintf(fp, "queue Item");
+	for (int ii = 0; ii < num_vars; ++ii) {
+		fprintf(fp, ",v%d", ii);
+	}
+	fprintf(fp, " from (\n");
+	for (int job = 0; job < num_jobs; ++job) {
+		fprintf(fp, "item%d", job);
+		for (int ii = 0; ii < num_vars; ++ii) {
+			fprintf(fp, ",value%d_%d", ii, (job * (ii + 7)) % 1009);
+		}
+		fprintf(fp, "\n");
+	}
+	fprintf(fp, ")\n");
+
+	if (fclose(fp) != 0) {
+		fprintf(stderr, "ERROR: can't write %s: %s\n", path, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+// run condor_submit, returning the cluster id it reported, 0 for a dry run, or -1 on failure
+static int
+run_submit( const char *path, const char *schedd, bool dry_run, bool factory )
+{
+	ArgList args;
+	args.AppendArg("condor_submit");
+	if (schedd) {
+		args.AppendArg("-name");
+		args.AppendArg(schedd);
+	}
+	if (dry_run) {
+		args.AppendArg("-dry-run");
+		args.AppendArg(NULL_FILE);
+	}
+	if (factory) {
+		args.AppendArg("-factory");
+	}
+	args.AppendArg(path);
+
+	FILE *fp = my_popen(args, "r", MY_POPEN_OPT_WANT_STDERR);
+	if ( ! fp) {
+		fprintf(stderr, "ERROR: can't run condor_submit: %s\n", strerror(errno));
+		return -1;
+	}
+	int cluster = dry_run ? 0 : -1;
+	char line[1024];
+	while (fgets(line, sizeof(line), fp)) {
+		const char *pos = strstr(line, "submitted to cluster ");
+		if (pos) {
+			cluster = atoi(pos + strlen("submitted to cluster "));
+		}
+	}
+	int status = my_pclose(fp);
+	if (status != 0) {
+		fprintf(stderr, "ERROR: condor_submit exited with status %d\n", status);
+		return -1;
+	}
+	return cluster;
+}
+
+static void
+remove_cluster( int cluster, const char *schedd )
+{
+	ArgList args;
+	args.AppendArg("condor_rm");
+	if (schedd) {
+		args.AppendArg("-name");
+		args.AppendArg(schedd);
+	}
+	args.AppendArg(std::to_string(cluster));
+	my_system(args);
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_jobs = 10000;
+	int num_vars = 4;
+	int num_attrs = 20;
+	int num_runs = 1;
+	const char *path = "submit_bench.sub";
+	const char *schedd = NULL;
+	bool dry_run = false;
+	bool factory = false;
+	bool keep = false;
+	bool generate_only = false;
+
+	myDistro->Init( argc, argv );
+	set_priv_initialize();
+	config();
+
+	for (int i = 1; i < argc; i++) {
+		bool has_arg = i + 1 < argc;
+		if (strcmp(argv[i], "-jobs") == 0 && has_arg) {
+			num_jobs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-vars") == 0 && has_arg) {
+			num_vars = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-attrs") == 0 && has_arg) {
+			num_attrs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-runs") == 0 && has_arg) {
+			num_runs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-file") == 0 && has_arg) {
+			path = argv[++i];
+		} else if (strcmp(argv[i], "-name") == 0 && has_arg) {
+			schedd = argv[++i];
+		} else if (strcmp(argv[i], "-dry-run") == 0) {
+			dry_run = true;
+		} else if (strcmp(argv[i], "-factory") == 0) {
+			factory = true;
+		} else if (strcmp(argv[i], "-keep") == 0) {
+			keep = true;
+		} else if (strcmp(argv[i], "-generate") == 0) {
+			generate_only = true;
+		} else {
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+	if (num_jobs < 1 || num_vars < 0 || num_attrs < 0 || num_runs < 1) {
+		usage(argv[0]);
+		exit(1);
+	}
+
+	double begin = condor_gettimestamp_double();
+	if ( ! write_submit_file(path, num_jobs, num_vars, num_attrs)) {
+		exit(1);
+	}
+	printf("Generated %s with %d jobs in %.3f seconds\n", path, num_jobs, condor_gettimestamp_double() - begin);
+	if (generate_only) {
+		return 0;
+	}
+
+	double total = 0;
+	for (int run = 1; run <= num_runs; ++run) {
+		begin = condor_gettimestamp_double();
+		int cluster = run_submit(path, schedd, dry_run, factory);
+		double elapsed = condor_gettimestamp_double() - begin;
+		if (cluster < 0) {
+			exit(1);
+		}
+		printf("Run %d: %d jobs in %.3f seconds (%.0f jobs/sec)\n",
+		       run, num_jobs, elapsed, elapsed > 0 ? num_jobs / elapsed : 0.0);
+		total += elapsed;
+		if (cluster > 0 && ! keep) {
+			remove_cluster(cluster, schedd);
+		}
+	}
+
+	printf("Average over %d runs: %.3f seconds (%.0f jobs/sec)\n",
+	       num_runs, total / num_runs, total > 0 ? num_jobs * num_runs / total : 0.0);
+
+	return 0;
+}
@@ -0,0 +1,430 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// condor_unparse_bench - measures how fast a query reply of startd ads
+// can be written to a socket, first with putClassAd() one ad at a time as
+// the collector used to, then through a ClassAdUnparsePipeline with an
+// increasing number of unparse threads.  The ads are a corpus captured
+// with condor_status -long, or synthetic ones, and are stored the way the
+// collector stores them: expressions go through the ClassAd cache and are
+// parsed lazily.  A thread on the other end of a loopback connection
+// reads and discards what is sent.
+//
+// With -binary it instead compares the text and binary forms of ClassAds
+// on the wire.  For each form it times putClassAd() sending the reply to
+// a thread that throws it away (the encode rate), then getClassAdEx()
+// reading the same reply sent by another thread (the decode rate).  Each
+// form gets its own connection, so the binary form spells out each
+// attribute name once, as it would in a real reply.
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_attributes.h"
+#include "condor_adtypes.h"
+#include "condor_classad.h"
+#include "classad_unparse_pipeline.h"
+#include "reli_sock.h"
+#include "utc_time.h"
+
+#include <thread>
+
+static void
+usage( const char *cmd )
+{
+	fprintf(stderr,"Usage: %s [options]\n",cmd);
+	fprintf(stderr,"Where options are:\n");
+	fprintf(stderr,"    -file <ads>     Send the ads in <file> (condor_status -long output)\n");
+	fprintf(stderr,"    -ads <n>        Number of synthetic startd ads to send (default 20000)\n");
+	fprintf(stderr,"    -attrs <n>      Extra attributes in each synthetic ad (default 50)\n");
+	fprintf(stderr,"    -threads <n>    Most unparse threads to try (default 4)\n");
+	fprintf(stderr,"    -projection <attrs> Send only these attributes, as condor_status -af does\n");
+	fprintf(stderr,"    -no-private     Leave out private attributes\n");
+	fprintf(stderr,"    -repeat <n>     Number of times to send the ads in each run (default 1)\n");
+	fprintf(stderr,"    -binary         Compare the text and binary forms instead of unparse threads\n");
+	fprintf(stderr,"    -no-cache       With -binary, read the ads without the ClassAd cache\n");
+}
+
+// Store the ad the way getClassAd() does in the collector: literals as
+// they are, everything else through the cache, to be parsed when needed.
+static ClassAd *
+collector_copy( const ClassAd &in )
+{
+	ClassAd *out = new ClassAd();
+	classad::ClassAdUnParser unp;
+	unp.SetOldClassAd(true, true);
+	for (auto it = in.begin(); it != in.end(); ++it) {
+		if (it->second->GetKind() == classad::ExprTree::LITERAL_NODE) {
+			out->Insert(it->first, it->second->Copy());
+		} else {
+			std::string name = it->first;
+			std::string rhs;
+			unp.Unparse(rhs, it->second);
+			out->InsertViaCache(name, rhs, true);
+		}
+	}
+	return out;
+}
+
+static void
+make_startd_ad( ClassAd &ad, int i, int extra_attrs )
+{
+	int node = i / 16;
+	std::string machine, name, addr;
+	formatstr(machine, "node%04d.bench.example.org", node);
+	formatstr(name, "slot%d@%s", i % 16 + 1, machine.c_str());
+	formatstr(addr, "<10.%d.%d.%d:9618?addrs=10.%d.%d.%d-9618&noUDP&sock=startd_%d_%04x>",
+	          node / 65536, node / 256 % 256, node % 256, node / 65536, node / 256 % 256, node % 256, 1000 + node, node * 7919 % 65536);
+
+	SetMyTypeName(ad, STARTD_ADTYPE);
+	SetTargetTypeName(ad, JOB_ADTYPE);
+	ad.Assign(ATTR_NAME, name);
+	ad.Assign(ATTR_MACHINE, machine);
+	ad.Assign(ATTR_MY_ADDRESS, addr);
+	ad.Assign(ATTR_ARCH, "X86_64");
+	ad.Assign(ATTR_OPSYS, "LINUX");
+	ad.Assign("OpSysAndVer", "CentOS7");
+	ad.Assign(ATTR_CPUS, 1);
+	ad.Assign(ATTR_MEMORY, 2048 + 1024 * (i % 4));
+	ad.Assign(ATTR_DISK, 40000000 + i * 37 % 100000);
+	ad.Assign(ATTR_LOAD_AVG, (i % 100) / 100.0);
+	ad.Assign(ATTR_KEYBOARD_IDLE, 10000 + i * 13 % 5000);
+	ad.Assign(ATTR_STATE, (i % 3) ? "Claimed" : "Unclaimed");
+	ad.Assign(ATTR_ACTIVITY, (i % 3) ? "Busy" : "Idle");
+	ad.Assign(ATTR_ENTERED_CURRENT_STATE, 1600000000 + i * 61 % 86400);
+	ad.Assign(ATTR_CAPABILITY, addr + "#1600000000#" + std::to_string(i) + "#...");
+	ad.AssignExpr(ATTR_START, "(TARGET.RequestMemory <= MY.Memory) && (KeyboardIdle > 15 * 60) && "
+	                          "(stringListMember(TARGET.Owner, \"alice,bob,carol,dave\") || TARGET.AcctGroup =?= \"physics\")");
+	ad.AssignExpr(ATTR_REQUIREMENTS, "START && IsValidCheckpointPlatform && WithinResourceLimits");
+	ad.AssignExpr("IsValidCheckpointPlatform", "(TARGET.JobUniverse =!= 1 || ((MY.CheckpointPlatform =!= undefined) && "
+	              "((TARGET.LastCheckpointPlatform =?= MY.CheckpointPlatform) || (TARGET.NumCkpts == 0))))");
+	ad.AssignExpr("WithinResourceLimits", "(MY.Cpus > 0 && TARGET.RequestCpus <= MY.Cpus && "
+	              "TARGET.RequestMemory <= MY.Memory && TARGET.RequestDisk <= MY.Disk)");
+	ad.AssignExpr(ATTR_RANK, "TARGET.JobPrio * 10");
+	for (int ix = 0; ix < extra_attrs; ++ix) {
+		std::string attr;
+		formatstr(attr, "BenchAttr%d", ix);
+		switch (ix % 4) {
+			case 0: ad.Assign(attr, i * 31 + ix); break;                           // differs in every ad
+			case 1: ad.Assign(attr, "shared value"); break;
+			case 2: ad.AssignExpr(attr, "ifThenElse(MY.Memory > 4096, \"large\", \"small\")"); break;
+			case 3: {
+				std::string expr;
+				formatstr(expr, "MY.LoadAvg * %d + %d", ix, node);                   // differs by node
+				ad.AssignExpr(attr, expr.c_str());
+				break;
+			}
+		}
+	}
+}
+
+// a loopback connection
+struct Connection {
+	ReliSock listener;
+	ReliSock sender;
+	ReliSock *receiver;
+
+	Connection() : receiver(NULL) {
+		if ( ! listener.bind(CP_IPV4, false, 0, true) || ! listener.listen()) {
+			fprintf(stderr, "Can't listen on a loopback port\n");
+			exit(1);
+		}
+		sender.timeout(60);
+		if ( ! sender.connect(listener.get_sinful())) {
+			fprintf(stderr, "Can't connect to %s\n", listener.get_sinful());
+			exit(1);
+		}
+		receiver = listener.accept();
+		if ( ! receiver) {
+			fprintf(stderr, "Can't accept the connection to %s\n", listener.get_sinful());
+			exit(1);
+		}
+	}
+	~Connection() { delete receiver; }
+};
+
+// reads and throws away everything sent on the connection
+static void
+drain( int fd )
+{
+	char buf[64 * 1024];
+	while (recv(fd, buf, sizeof(buf), 0) > 0) {}
+}
+
+struct RunResult {
+	double seconds;
+	float bytes;
+	long long cache_hits;
+	long long cache_misses;
+};
+
+static RunResult
+run( ReliSock &sock, const std::vector<ClassAd *> &ads, int options,
+     const std::shared_ptr<const classad::References> &whitelist, int threads, int repeat )
+{
+	RunResult result;
+	result.cache_hits = result.cache_misses = 0;
+	float bytes_before = sock.get_bytes_sent();
+	double begin = condor_gettimestamp_double();
+	int more = 1;
+	sock.encode();
+	if (threads < 0) {
+		for (int rep = 0; rep < repeat; ++rep) {
+			for (size_t ix = 0; ix < ads.size(); ++ix) {
+				if ( ! sock.code(more) || ! putClassAd(&sock, *ads[ix], options, whitelist.get())) {
+					fprintf(stderr, "Failed to send ad\n");
+					exit(1);
+				}
+			}
+		}
+	} else {
+		ClassAdUnparsePipeline pipeline(&sock, options, threads, true);
+		for (int rep = 0; rep < repeat; ++rep) {
+			for (size_t ix = 0; ix < ads.size(); ++ix) {
+				if ( ! pipeline.put(*ads[ix], whitelist)) {
+					fprintf(stderr, "Failed to send ad\n");
+					exit(1);
+				}
+			}
+		}
+		if ( ! pipeline.flush()) {
+			fprintf(stderr, "Failed to send ad\n");
+			exit(1);
+		}
+		result.cache_hits = pipeline.Cache().Hits();
+		result.cache_misses = pipeline.Cache().Misses();
+	}
+	sock.end_of_message();
+	result.seconds = condor_gettimestamp_double() - begin;
+	result.bytes = sock.get_bytes_sent() - bytes_before;
+	return result;
+}
+
+// sends the ads as a query reply, returning the seconds taken
+static double
+send_ads( ReliSock *sock, const std::vector<ClassAd *> *ads, int options, int repeat )
+{
+	double begin = condor_gettimestamp_double();
+	int more = 1;
+	sock->encode();
+	for (int rep = 0; rep < repeat; ++rep) {
+		for (size_t ix = 0; ix < ads->size(); ++ix) {
+			if ( ! sock->code(more) || ! putClassAd(sock, *(*ads)[ix], options)) {
+				fprintf(stderr, "Failed to send ad\n");
+				exit(1);
+			}
+		}
+	}
+	more = 0;
+	if ( ! sock->code(more) || ! sock->end_of_message()) {
+		fprintf(stderr, "Failed to send end of reply\n");
+		exit(1);
+	}
+	return condor_gettimestamp_double() - begin;
+}
+
+// reads a query reply, returning the seconds taken
+static double
+receive_ads( ReliSock *sock, int get_options, long long &num_ads, long long &num_attrs )
+{
+	num_ads = num_attrs = 0;
+	double begin = condor_gettimestamp_double();
+	sock->decode();
+	for (;;) {
+		int more = 0;
+		if ( ! sock->code(more)) {
+			fprintf(stderr, "Failed to read reply\n");
+			exit(1);
+		}
+		if ( ! more) {
+			break;
+		}
+		ClassAd ad;
+		if ( ! getClassAdEx(sock, ad, get_options)) {
+			fprintf(stderr, "Failed to read ad %lld\n", num_ads);
+			exit(1);
+		}
+		++num_ads;
+		num_attrs += ad.size();
+	}
+	sock->end_of_message();
+	return condor_gettimestamp_double() - begin;
+}
+
+// times encoding and decoding the ads in text form, then in binary form
+static void
+compare_forms( const std::vector<ClassAd *> &ads, int options, int get_options, int repeat )
+{
+	long long total_ads = (long long)ads.size() * repeat;
+	printf("Sending %lld ads each way\n", total_ads);
+
+	double text_encode = 0, text_decode = 0;
+	for (int binary = 0; binary < 2; ++binary) {
+		const char *form = binary ? "binary" : "text";
+		int put_options = options | (binary ? PUT_CLASSAD_BINARY : 0);
+
+		Connection out;
+		std::thread drainer(drain, out.receiver->get_file_desc());
+		float bytes_before = out.sender.get_bytes_sent();
+		double encode = send_ads(&out.sender, &ads, put_options, repeat);
+		float bytes = out.sender.get_bytes_sent() - bytes_before;
+		out.sender.close();
+		drainer.join();
+
+		Connection in;
+		in.receiver->timeout(60);
+		long long got_ads = 0, got_attrs = 0;
+		std::thread sender(send_ads, &in.sender, &ads, put_options, repeat);
+		double decode = receive_ads(in.receiver, get_options, got_ads, got_attrs);
+		sender.join();
+
+		if (binary) {
+			printf("%-6s encode: %7.3f seconds, %9.0f ads/sec, %7.1f MB, %.2fx\n",
+			       form, encode, total_ads / encode, bytes / 1e6, text_encode / encode);
+			printf("%-6s decode: %7.3f seconds, %9.0f ads/sec, %lld attributes, %.2fx\n",
+			       form, decode, got_ads / decode, got_attrs, text_decode / decode);
+		} else {
+			text_encode = encode;
+			text_decode = decode;
+			printf("%-6s encode: %7.3f seconds, %9.0f ads/sec, %7.1f MB\n",
+			       form, encode, total_ads / encode, bytes / 1e6);
+			printf("%-6s decode: %7.3f seconds, %9.0f ads/sec, %lld attributes\n",
+			       form, decode, got_ads / decode, got_attrs);
+		}
+	}
+}
+
+int
+main( int argc, char *argv[] )
+{
+	const char *file = NULL;
+	int num_ads = 20000;
+	int extra_attrs = 50;
+	int max_threads = 4;
+	int repeat = 1;
+	const char *projection = NULL;
+	int options = 0;
+	bool binary = false;
+	int get_options = GET_CLASSAD_FAST;
+
+	for (int i = 1; i < argc; i++) {
+		bool has_arg = i + 1 < argc;
+		if (strcmp(argv[i], "-file") == 0 && has_arg) {
+			file = argv[++i];
+		} else if (strcmp(argv[i], "-ads") == 0 && has_arg) {
+			num_ads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-attrs") == 0 && has_arg) {
+			extra_attrs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-threads") == 0 && has_arg) {
+			max_threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-projection") == 0 && has_arg) {
+			projection = argv[++i];
+		} else if (strcmp(argv[i], "-repeat") == 0 && has_arg) {
+			repeat = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-no-private") == 0) {
+			options |= PUT_CLASSAD_NO_PRIVATE;
+		} else if (strcmp(argv[i], "-binary") == 0) {
+			binary = true;
+		} else if (strcmp(argv[i], "-no-cache") == 0) {
+			get_options |= GET_CLASSAD_NO_CACHE;
+		} else {
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+	if (num_ads < 1 || extra_attrs < 0 || max_threads < 0 || repeat < 1) {
+		usage(argv[0]);
+		exit(1);
+	}
+
+	set_priv_initialize();
+	config();
+	classad::ClassAdSetExpressionCaching(true);
+
+	std::vector<ClassAd *> ads;
+	if (file) {
+		FILE *fp = safe_fopen_wrapper_follow(file, "r");
+		if ( ! fp) {
+			fprintf(stderr, "Can't open %s: %s\n", file, strerror(errno));
+			exit(1);
+		}
+		CondorClassAdFileIterator iter;
+		if ( ! iter.begin(fp, true, CondorClassAdFileParseHelper::Parse_long)) {
+			fprintf(stderr, "Can't read ads from %s\n", file);
+			exit(1);
+		}
+		ClassAd ad;
+		while (iter.next(ad) > 0) {
+			ads.push_back(collector_copy(ad));
+			ad.Clear();
+		}
+		if (ads.empty()) {
+			fprintf(stderr, "No ads in %s\n", file);
+			exit(1);
+		}
+	} else {
+		for (int ix = 0; ix < num_ads; ++ix) {
+			ClassAd ad;
+			make_startd_ad(ad, ix, extra_attrs);
+			ads.push_back(collector_copy(ad));
+		}
+	}
+
+	if (binary) {
+		compare_forms(ads, options, get_options, repeat);
+		for (size_t ix = 0; ix < ads.size(); ++ix) { delete ads[ix]; }
+		return 0;
+	}
+
+	std::shared_ptr<const classad::References> whitelist;
+	if (projection) {
+		classad::References attrs;
+		StringTokenIterator list(projection);
+		const std::string *attr;
+		while ((attr = list.next_string())) { attrs.insert(*attr); }
+		whitelist = std::make_shared<const classad::References>(attrs);
+	}
+
+	Connection conn;
+	std::thread drainer(drain, conn.receiver->get_file_desc());
+
+	long long total_ads = (long long)ads.size() * repeat;
+	printf("Sending %lld ads%s%s\n", total_ads, projection ? " projected to " : "", projection ? projection : "");
+
+		// -1 is putClassAd() without a pipeline
+	double serial_seconds = 0;
+	for (int threads = -1; threads <= max_threads; threads = (threads < 1) ? threads + 1 : threads * 2) {
+		RunResult res = run(conn.sender, ads, options, whitelist, threads, repeat);
+		if (threads < 0) {
+			serial_seconds = res.seconds;
+			printf("putClassAd:          %7.3f seconds, %9.0f ads/sec, %7.1f MB/sec\n",
+			       res.seconds, total_ads / res.seconds, res.bytes / 1e6 / res.seconds);
+		} else {
+			long long lookups = res.cache_hits + res.cache_misses;
+			printf("pipeline, %2d threads: %7.3f seconds, %9.0f ads/sec, %7.1f MB/sec, %.2fx, cache hit rate %.1f%%\n",
+			       threads, res.seconds, total_ads / res.seconds, res.bytes / 1e6 / res.seconds,
+			       serial_seconds / res.seconds, lookups ? 100.0 * res.cache_hits / lookups : 0.0);
+		}
+	}
+
+	conn.sender.close();
+	drainer.join();
+	for (size_t ix = 0; ix < ads.size(); ++ix) { delete ads[ix]; }
+	return 0;
+}
@@ -29,6 +29,9 @@
 #include "unit_test_utils.h"
 #include "emit.h"
 
+#include <string>
+#include <vector>
+
 // variable declaration
 static HashTable< int, int >* table;
 static HashTable< int, short int >* table_two;
@@ -59,8 +62,11 @@ static bool test_clear_normal(void);
 static bool test_auto_resize_normal(void);
 static bool test_auto_resize_sizes(void);
 static bool test_auto_resize_check_numelems(void);
+static bool test_lookup_pointer_after_resize(void);
+static bool test_remove_while_iterating(void);
 static bool test_auto_resize_timing(void);
 static bool test_iterate_timing(void);
+static bool test_string_key_timing(void);
 
 bool OTEST_HashTable(void) {
 		// beginning junk
@@ -92,8 +98,11 @@ bool OTEST_HashTable(void) {
 	driver.register_function(test_auto_resize_normal);
 	driver.register_function(test_auto_resize_sizes);
 	driver.register_function(test_auto_resize_check_numelems);
+	driver.register_function(test_lookup_pointer_after_resize);
+	driver.register_function(test_remove_while_iterating);
 	driver.register_function(test_auto_resize_timing);
 	driver.register_function(test_iterate_timing);
+	driver.register_function(test_string_key_timing);
 	//driver.register_function(cleanup);
 	
 		// run the tests
@@ -433,6 +442,71 @@ static bool test_auto_resize_check_numelems() {
 	PASS;
 }
 
+static bool test_lookup_pointer_after_resize() {
+	emit_test("Is a pointer from lookup() still good after the table has been resized?");
+	int *before = NULL;
+	int *after = NULL;
+	int lookup_result = table->lookup(237, before);
+	int insert_result = 0;
+	for(int i = 1000; i < 5000; i++) {
+		insert_result |= table->insert(i, i);
+	}
+	table->lookup(237, after);
+	int tableSize = table->getTableSize();
+	emit_input_header();
+	emit_param("Index", "237");
+	emit_output_expected_header();
+	emit_param("tableSize", ">%d", 1023);
+	emit_param("Value", "237");
+	emit_param("Same pointer", "true");
+	emit_output_actual_header();
+	emit_param("tableSize", "%d", tableSize);
+	emit_param("Value", "%d", before ? *before : -1);
+	emit_param("Same pointer", "%s", tfstr(before == after));
+	if(!(lookup_result == 0 && insert_result == 0 && tableSize > 1023 &&
+		 before && *before == 237 && before == after)) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_remove_while_iterating() {
+	emit_test("Can the current entry be removed while iterating, without skipping any others?");
+	int numElems = table->getNumElements();
+	int num_seen = 0;
+	int num_removed = 0;
+	int key;
+	int value;
+	table->startIterations();
+	while(table->iterate(value)) {
+		num_seen++;
+		if(table->getCurrentKey(key) == 0 && key % 2 == 1) {
+			table->remove(key);
+			num_removed++;
+		}
+	}
+	int numLeft = table->getNumElements();
+	int odd_left = 0;
+	table->startIterations();
+	while(table->iterate(key, value)) {
+		if(key % 2 == 1) {
+			odd_left++;
+		}
+	}
+	emit_output_expected_header();
+	emit_param("num_seen", "%d", numElems);
+	emit_param("numElems", "%d", numElems - num_removed);
+	emit_param("odd_left", "%d", 0);
+	emit_output_actual_header();
+	emit_param("num_seen", "%d", num_seen);
+	emit_param("numElems", "%d", numLeft);
+	emit_param("odd_left", "%d", odd_left);
+	if(!(num_seen == numElems && numLeft == numElems - num_removed && odd_left == 0)) {
+		FAIL;
+	}
+	PASS;
+}
+
 static bool test_auto_resize_timing() {
 	emit_test("How long does it take to add five million entries into the table?");
 	table_two = new HashTable<int, short int>(intHash);
@@ -517,6 +591,57 @@ static bool test_iterate_timing() {
 	PASS;
 }
 
+static bool test_string_key_timing() {
+	emit_test("How long does it take to insert, look up and iterate a million string keys?");
+	const int num_keys = 1000000;
+	std::vector<std::string> keys;
+	keys.reserve(num_keys);
+	for(int i = 0; i < num_keys; i++) {
+		keys.push_back(std::string());
+		formatstr(keys.back(), "slot%d@node%d.example.org", i % 64 + 1, i / 64);
+	}
+	HashTable<std::string, int> strings(hashFunction);
+
+	struct timeval time;
+	gettimeofday(&time, NULL);
+	double starttime = time.tv_sec + (time.tv_usec / 1000000.0);
+	for(int i = 0; i < num_keys; i++) {
+		strings.insert(keys[i], i);
+	}
+	gettimeofday(&time, NULL);
+	double inserttime = time.tv_sec + (time.tv_usec / 1000000.0);
+	int num_found = 0;
+	int value;
+	for(int i = 0; i < num_keys; i++) {
+		if(strings.lookup(keys[i], value) == 0 && value == i) {
+			num_found++;
+		}
+	}
+	gettimeofday(&time, NULL);
+	double lookuptime = time.tv_sec + (time.tv_usec / 1000000.0);
+	int num_iterated = 0;
+	strings.startIterations();
+	while(strings.iterate(value)) {
+		num_iterated++;
+	}
+	gettimeofday(&time, NULL);
+	double endtime = time.tv_sec + (time.tv_usec / 1000000.0);
+
+	emit_output_expected_header();
+	emit_param("num_found", "%d", num_keys);
+	emit_param("num_iterated", "%d", num_keys);
+	emit_output_actual_header();
+	emit_param("num_found", "%d", num_found);
+	emit_param("num_iterated", "%d", num_iterated);
+	emit_param("Insert Time", "%f", inserttime - starttime);
+	emit_param("Lookup Time", "%f", lookuptime - inserttime);
+	emit_param("Iterate Time", "%f", endtime - lookuptime);
+	if(!(num_found == num_keys && num_iterated == num_keys)) {
+		FAIL;
+	}
+	PASS;
+}
+
 static bool cleanup() {
 	delete table;
 	delete table_two;
@@ -27,6 +27,7 @@
 #include "function_test_driver.h"
 #include "emit.h"
 #include "unit_test_utils.h"
+#include "classad_binary.h"
 
 #ifdef WIN32
 	#define strcasecmp _stricmp
@@ -179,6 +180,8 @@ static bool test_string_list_avg_error_all(void);
 static bool test_string_list_avg_error_middle(void);
 static bool test_string_list_member(void);
 static bool test_string_list_member_case(void);
+static bool test_string_list_member_delims(void);
+static bool test_string_list_member_long(void);
 static bool test_string_negative_int(void);
 static bool test_string_positive_int(void);
 static bool test_strcat_short(void);
@@ -301,6 +304,7 @@ static bool test_size_positive(void);
 static bool test_size_zero(void);
 static bool test_size_undefined(void);
 static bool test_nested_ads(void);
+static bool test_binary_roundtrip(void);
 
 
 bool OTEST_Old_Classads(void) {
@@ -454,6 +458,8 @@ bool OTEST_Old_Classads(void) {
 	driver.register_function(test_string_list_avg_error_middle);
 	driver.register_function(test_string_list_member);
 	driver.register_function(test_string_list_member_case);
+	driver.register_function(test_string_list_member_delims);
+	driver.register_function(test_string_list_member_long);
 	driver.register_function(test_string_negative_int);
 	driver.register_function(test_string_positive_int);
 	driver.register_function(test_strcat_short);
@@ -576,6 +582,7 @@ bool OTEST_Old_Classads(void) {
 	driver.register_function(test_size_zero);
 	driver.register_function(test_size_undefined);
 	driver.register_function(test_nested_ads);
+	driver.register_function(test_binary_roundtrip);
 
 	return driver.do_all_functions();
 }
@@ -4610,6 +4617,76 @@ static bool test_string_list_member_case() {
 	PASS;
 }
 
+static bool test_string_list_member_delims() {
+	emit_test("Test that stringlistmember() trims whitespace around items, "
+		"skips empty items and only splits on the given delimiters.");
+	const char* classad_string = "\tA1=stringlistmember(\"light blue\", \" red ;; "
+		"light blue ;green\", \";\")\n\t"
+		"A2=stringlistmember(\"blue\", \"red, light blue\", \";\")\n\t"
+		"A3=stringlistsize(\" red ;; light blue ;green; \", \";\")";
+	ClassAd classad;
+	initAdFromString(classad_string, classad);
+	bool a1 = false, a2 = true;
+	int a3 = 0;
+	int retVal = classad.LookupBool("A1", a1) && classad.LookupBool("A2", a2) &&
+		classad.LookupInteger("A3", a3);
+	emit_input_header();
+	emit_param("ClassAd", classad_string);
+	emit_output_expected_header();
+	emit_retval("1");
+	emit_param("A1", "true");
+	emit_param("A2", "false");
+	emit_param("A3", "3");
+	emit_output_actual_header();
+	emit_retval("%d", retVal);
+	emit_param("A1", "%s", a1?"true":"false");
+	emit_param("A2", "%s", a2?"true":"false");
+	emit_param("A3", "%d", a3);
+	if(retVal != 1 || !a1 || a2 || a3 != 3) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_string_list_member_long() {
+	emit_test("Test that stringlistmember() and stringlistimember() give the "
+		"same answers each time they are evaluated against a long list, "
+		"which is hashed after the first lookup.");
+	std::string list;
+	for (int ii = 0; ii < 500; ++ii) {
+		formatstr_cat(list, "%suser%d@Example.org", ii ? ", " : "", ii);
+	}
+	std::string classad_string;
+	formatstr(classad_string, "\tList=\"%s\"\n\t"
+		"A1=stringlistmember(\"user321@Example.org\", List)\n\t"
+		"A2=stringlistmember(\"user321@example.org\", List)\n\t"
+		"A3=stringlistimember(\"USER499@example.ORG\", List)\n\t"
+		"A4=stringlistimember(\"user500@example.org\", List)", list.c_str());
+	ClassAd classad;
+	initAdFromString(classad_string.c_str(), classad);
+	int retVal = 1;
+	bool a1 = false, a2 = true, a3 = false, a4 = true;
+	bool ok = true;
+	for (int ii = 0; ii < 3 && ok; ++ii) {
+		retVal = classad.LookupBool("A1", a1) && classad.LookupBool("A2", a2) &&
+			classad.LookupBool("A3", a3) && classad.LookupBool("A4", a4);
+		ok = retVal == 1 && a1 && !a2 && a3 && !a4;
+	}
+	emit_input_header();
+	emit_param("List", "500 items");
+	emit_output_expected_header();
+	emit_retval("1");
+	emit_param("A1 A2 A3 A4", "true false true false");
+	emit_output_actual_header();
+	emit_retval("%d", retVal);
+	emit_param("A1 A2 A3 A4", "%s %s %s %s", a1?"true":"false", a2?"true":"false",
+		a3?"true":"false", a4?"true":"false");
+	if(retVal != 1 || !a1 || a2 || !a3 || a4) {
+		FAIL;
+	}
+	PASS;
+}
+
 static bool test_string_negative_int() {
 	emit_test("Test that LookupString() returns 1 for an attribute using "
 		"string() with a negative int.");
@@ -7842,3 +7919,54 @@ static bool test_nested_ads()
 	PASS;
 }
 
+static bool test_binary_roundtrip() {
+	emit_test("Test that an ad sent in binary form twice on one connection, "
+		"the second time with attribute-name tokens, reads back the same, "
+		"and that a truncated body is rejected.");
+	const char* classad_string = "\tA=1\n\tB=-2.5\n\tC=\"one\\\"two\"\n\t"
+		"D=undefined\n\tE=error\n\tF=true\n\t"
+		"G=ifThenElse(MY.A > 0, { 1, \"x\", [ Y = 1; Z = A; ] }, TARGET.B)\n\t"
+		"H=strcat(C, \"!\") =?= \"one\\\"two!\" && -(A + B * 2) < 7 ? A : B";
+	ClassAd classad;
+	initAdFromString(classad_string, classad);
+
+	BinaryClassAd binary;
+	for (auto itr = classad.begin(); itr != classad.end(); ++itr) {
+		binary.add(itr->first, itr->second);
+	}
+	BinaryClassAdNames out_names, in_names;
+	std::string body[2];
+	ClassAd result[2];
+	bool ok = true;
+	for (int ii = 0; ii < 2; ++ii) {
+		int secrets = -1;
+		binary.makeBody(body[ii], out_names);
+		ok = ok && decodeBinaryClassAd(body[ii].data(), body[ii].size(), result[ii],
+			in_names, false, secrets) && secrets == 0;
+	}
+	bool same = ok && classad.SameAs(&result[0]) && classad.SameAs(&result[1]);
+	bool shorter = body[1].size() < body[0].size();
+	bool truncated = false;
+	for (size_t len = 0; len < body[0].size(); ++len) {
+		BinaryClassAdNames names;
+		ClassAd ad;
+		int secrets = 0;
+		if (decodeBinaryClassAd(body[0].data(), len, ad, names, false, secrets)) {
+			truncated = true;
+		}
+	}
+	emit_input_header();
+	emit_param("ClassAd", classad_string);
+	emit_output_expected_header();
+	emit_param("Same", "true");
+	emit_param("Second Body Shorter", "true");
+	emit_param("Truncated Body Accepted", "false");
+	emit_output_actual_header();
+	emit_param("Same", "%s", same?"true":"false");
+	emit_param("Second Body Shorter", "%s", shorter?"true":"false");
+	emit_param("Truncated Body Accepted", "%s", truncated?"true":"false");
+	if(!same || !shorter || truncated) {
+		FAIL;
+	}
+	PASS;
+}
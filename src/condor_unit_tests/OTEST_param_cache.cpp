@@ -0,0 +1,163 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2026, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+/*
+	Test the typed param cache.
+ */
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "function_test_driver.h"
+#include "unit_test_utils.h"
+#include "emit.h"
+#include "param_cache.h"
+
+static bool test_insert_int(void);
+static bool test_insert_bool(void);
+static bool test_insert_double(void);
+static bool test_read_does_not_reload(void);
+static bool test_insert_reloads_once(void);
+
+bool OTEST_param_cache(void) {
+	emit_object("param_cache");
+	emit_comment("Typed cache of hot configuration values, reloaded in "
+		"place whenever the configuration changes.");
+
+	FunctionDriver driver;
+	driver.register_function(test_insert_int);
+	driver.register_function(test_insert_bool);
+	driver.register_function(test_insert_double);
+	driver.register_function(test_read_does_not_reload);
+	driver.register_function(test_insert_reloads_once);
+
+	return driver.do_all_functions();
+}
+
+static bool test_insert_int() {
+	emit_test("Test that param_cached() returns an int knob set by "
+		"param_insert().");
+	emit_input_header();
+	emit_param("NEGOTIATOR_NUM_THREADS", "7");
+	emit_output_expected_header();
+	emit_retval("%d", 7);
+	param_insert("NEGOTIATOR_NUM_THREADS", "7");
+	int val = param_cached(PCI_NEGOTIATOR_NUM_THREADS);
+	emit_output_actual_header();
+	emit_retval("%d", val);
+	if (val != 7) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_insert_bool() {
+	emit_test("Test that param_cached() returns a bool knob set by "
+		"param_insert(), both ways.");
+	emit_input_header();
+	emit_param("CONDOR_Q_ONLY_MY_JOBS", "false, then true");
+	emit_output_expected_header();
+	emit_retval("%s", "false true");
+	param_insert("CONDOR_Q_ONLY_MY_JOBS", "false");
+	bool first = param_cached(PCB_CONDOR_Q_ONLY_MY_JOBS);
+	param_insert("CONDOR_Q_ONLY_MY_JOBS", "true");
+	bool second = param_cached(PCB_CONDOR_Q_ONLY_MY_JOBS);
+	emit_output_actual_header();
+	emit_retval("%s %s", first ? "true" : "false", second ? "true" : "false");
+	if (first || ! second) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_insert_double() {
+	emit_test("Test that param_cached() returns a double knob set by "
+		"param_insert().");
+	emit_input_header();
+	emit_param("CONCURRENCY_LIMIT_DEFAULT", "12");
+	emit_output_expected_header();
+	emit_retval("%g", 12.0);
+	param_insert("CONCURRENCY_LIMIT_DEFAULT", "12");
+	double val = param_cached(PCD_CONCURRENCY_LIMIT_DEFAULT);
+	emit_output_actual_header();
+	emit_retval("%g", val);
+	if (val != 12) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_read_does_not_reload() {
+	emit_test("Test that reading the cache when nothing has changed does "
+		"not reload it.");
+	emit_input_header();
+	emit_param("Reads", "1000");
+	emit_output_expected_header();
+	emit_retval("%d", 0);
+	param_insert("NEGOTIATOR_NUM_THREADS", "3");
+	int before = param_cache_reload_count();
+	for (int i = 0; i < 1000; ++i) {
+		if (param_cached(PCI_NEGOTIATOR_NUM_THREADS) != 3) {
+			emit_alert("Read the wrong value");
+			FAIL;
+		}
+	}
+	int loads = param_cache_reload_count() - before;
+	emit_output_actual_header();
+	emit_retval("%d", loads);
+	if (loads != 0) {
+		FAIL;
+	}
+	PASS;
+}
+
+static bool test_insert_reloads_once() {
+	emit_test("Test that each param_insert() and config_insert() reloads the "
+		"cache once, before it returns, and that reads after it see the new "
+		"value without reloading.");
+	emit_input_header();
+	emit_param("Inserts", "100");
+	emit_output_expected_header();
+	emit_retval("%d %d", 100, 99);
+	int before = param_cache_reload_count();
+	for (int i = 0; i < 100; ++i) {
+		std::string val = std::to_string(i);
+		if (i & 1) {
+			param_insert("NEGOTIATOR_NUM_THREADS", val.c_str());
+		} else {
+			config_insert("NEGOTIATOR_NUM_THREADS", val.c_str());
+		}
+		if (param_cache_reload_count() - before != i + 1) {
+			emit_alert("Insert did not reload the cache exactly once");
+			FAIL;
+		}
+		if (param_cached(PCI_NEGOTIATOR_NUM_THREADS) != i) {
+			emit_alert("Read a stale value");
+			FAIL;
+		}
+	}
+	int val = param_cached(PCI_NEGOTIATOR_NUM_THREADS);
+	int loads = param_cache_reload_count() - before;
+	emit_output_actual_header();
+	emit_retval("%d %d", loads, val);
+	if (loads != 100 || val != 99) {
+		FAIL;
+	}
+	PASS;
+}
@@ -0,0 +1,321 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2026, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// stand-alone tests of asynchronous dprintf (<SUBSYS>_LOG_ASYNC).  each test
+// writes numbered messages to a log file in the current directory, turns
+// the writer thread off again, and reads the log back.
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "dprintf_internal.h"
+
+#include <string>
+#include <vector>
+
+extern int log_keep_open;
+
+int num_tests = 0;
+int tests_failed = 0;
+int total_fail_count = 0;
+int step_fail_count = 0;
+bool verbose = false;
+
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		if (verbose && ! step_fail_count) fprintf(stdout, "\n"); \
+		fprintf( verbose ? stdout : stderr, "Failed %5d: %s\n", __LINE__, #condition ); \
+		++step_fail_count; ++total_fail_count; \
+	}
+
+static void begin_test(const char * name)
+{
+	++num_tests;
+	step_fail_count = 0;
+	if (verbose) { fprintf(stdout, "%s: ", name); fflush(stdout); }
+}
+
+static void end_test()
+{
+	if (step_fail_count) { ++tests_failed; }
+	if (verbose) { fprintf(stdout, "%s\n", step_fail_count ? "FAILED" : "ok"); }
+}
+
+static const char * LogName = "dprintf_async_tests.log";
+
+	// log to LogName only, starting from an empty file
+static void
+setup_log(long long max_log)
+{
+	std::string old(LogName); old += ".old";
+	unlink(LogName);
+	unlink(old.c_str());
+
+	dprintf_output_settings out;
+	out.logPath = LogName;
+	out.choice = (1<<D_ALWAYS);
+	out.accepts_all = true;
+	out.logMax = max_log;
+	out.maxLogNum = 1;
+	dprintf_set_outputs(&out, 1);
+}
+
+struct LogContents {
+	std::vector<int> seqs;		// the numbers of the "seq" messages, in file order
+	long long dropped;			// sum of the counts in "dropped" messages
+	int child_lines;			// "child" messages
+	LogContents() : dropped(0), child_lines(0) {}
+};
+
+static void
+read_log(const std::string & path, LogContents & lc)
+{
+	FILE * fp = safe_fopen_wrapper_follow(path.c_str(), "r");
+	if ( ! fp) {
+		return;
+	}
+	char line[1024];
+	while (fgets(line, sizeof(line), fp)) {
+		const char * p;
+		int seq;
+		long long dropped;
+		if ((p = strstr(line, "test seq ")) && sscanf(p, "test seq %d", &seq) == 1) {
+			lc.seqs.push_back(seq);
+		} else if ((p = strstr(line, "dprintf: dropped ")) && sscanf(p, "dprintf: dropped %lld", &dropped) == 1) {
+			lc.dropped += dropped;
+		} else if (strstr(line, "test child ")) {
+			++lc.child_lines;
+		}
+	}
+	fclose(fp);
+}
+
+	// the rotated file first, then the current one
+static LogContents
+read_logs()
+{
+	LogContents lc;
+	read_log(std::string(LogName) + ".old", lc);
+	read_log(LogName, lc);
+	return lc;
+}
+
+	// wait up to 10 seconds for the writer thread to write count messages
+static void
+wait_for_seqs(size_t count)
+{
+	for (int ii = 0; ii < 100; ++ii) {
+		LogContents lc;
+		read_log(LogName, lc);
+		if (lc.seqs.size() >= count) {
+			break;
+		}
+		usleep(100000);
+	}
+}
+
+static bool
+in_order(const std::vector<int> & seqs, int first, int count)
+{
+	if ((int)seqs.size() != count) {
+		return false;
+	}
+	for (int ix = 0; ix < count; ++ix) {
+		if (seqs[ix] != first + ix) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void
+log_seqs(int first, int count, int pad = 0)
+{
+	for (int seq = first; seq < first + count; ++seq) {
+		dprintf(D_ALWAYS, "test seq %d %*s\n", seq, pad, "");
+	}
+}
+
+	// messages come out in the order they were queued, including ones that
+	// take more than one queue slot
+static void
+test_ordering()
+{
+	begin_test("ordering");
+	setup_log(0);
+	dprintf_set_async(true, 1024*1024);
+	log_seqs(0, 2000);
+		// long enough to take several queue slots
+	log_seqs(2000, 100, 700);
+	dprintf_set_async(false, 0);
+
+	LogContents lc = read_logs();
+	REQUIRE(in_order(lc.seqs, 0, 2100));
+	REQUIRE(lc.dropped == 0);
+	end_test();
+}
+
+	// a full queue drops messages, counts them, and reports the count
+static void
+test_overflow()
+{
+	begin_test("overflow");
+	setup_log(0);
+		// the smallest queue, 64 slots
+	dprintf_set_async(true, 0);
+	dprintf_async_hold(true);
+	log_seqs(0, 200);
+	dprintf_async_hold(false);
+		// once the writer has made room, messages are queued again
+	wait_for_seqs(64);
+	log_seqs(200, 1);
+	dprintf_set_async(false, 0);
+
+	LogContents lc = read_logs();
+	std::vector<int> expected;
+	for (int seq = 0; seq < 64; ++seq) { expected.push_back(seq); }
+	expected.push_back(200);
+	if (verbose) {
+		fprintf(stdout, "%d messages written, %lld dropped ", (int)lc.seqs.size(), lc.dropped);
+	}
+	REQUIRE(lc.seqs == expected);
+	REQUIRE(lc.dropped == 200 - 64);
+	end_test();
+}
+
+	// a log that fills up while messages are queued is rotated without
+	// losing or reordering any of them
+static void
+test_rotation_while_queued()
+{
+	begin_test("rotation while queued");
+	const long long max_log = 20000;
+	setup_log(max_log);
+	dprintf_set_async(true, 1024*1024);
+	dprintf_async_hold(true);
+	log_seqs(0, 300, 80);
+	dprintf_async_hold(false);
+
+		// wait for the writer to get the queued messages out, so that the
+		// next dprintf() is the one asked to rotate
+	wait_for_seqs(300);
+	log_seqs(300, 50);
+	dprintf_set_async(false, 0);
+
+	std::string old(LogName); old += ".old";
+	struct stat sb;
+	REQUIRE(stat(old.c_str(), &sb) == 0);
+	LogContents lc = read_logs();
+	REQUIRE(in_order(lc.seqs, 0, 350));
+	REQUIRE(lc.dropped == 0);
+	end_test();
+}
+
+	// a forked child has no writer thread, and logs synchronously without
+	// deadlocking on the parent's lock
+static void
+test_fork()
+{
+	begin_test("fork");
+	setup_log(0);
+	dprintf_set_async(true, 1024*1024);
+	log_seqs(0, 500);
+	pid_t pid = fork();
+	if (pid == 0) {
+		dprintf(D_ALWAYS, "test child %d\n", (int)getpid());
+		_exit(0);
+	}
+	REQUIRE(pid > 0);
+	log_seqs(500, 500);
+
+	int status = -1;
+	pid_t rc = 0;
+	for (int ii = 0; ii < 100 && pid > 0; ++ii) {
+		rc = waitpid(pid, &status, WNOHANG);
+		if (rc != 0) {
+			break;
+		}
+		usleep(100000);
+	}
+	if (pid > 0 && rc == 0) {
+		kill(pid, SIGKILL);
+		waitpid(pid, &status, 0);
+	}
+	REQUIRE(rc == pid);
+	REQUIRE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	dprintf_set_async(false, 0);
+
+	LogContents lc = read_logs();
+	REQUIRE(in_order(lc.seqs, 0, 1000));
+	REQUIRE(lc.child_lines == 1);
+	REQUIRE(lc.dropped == 0);
+	end_test();
+}
+
+	// turning the writer on and off repeatedly loses nothing, and leaves
+	// the log settings the way they were
+static void
+test_enable_disable_cycles()
+{
+	begin_test("enable/disable cycles");
+	setup_log(0);
+	int keep_open = log_keep_open;
+	int seq = 0;
+	for (int cycle = 0; cycle < 20; ++cycle) {
+		dprintf_set_async(true, (cycle & 1) ? 1024*1024 : 64*1024);
+		log_seqs(seq, 50);
+		seq += 50;
+		dprintf_set_async(false, 0);
+		REQUIRE(log_keep_open == keep_open);
+			// and some written synchronously in between
+		log_seqs(seq, 5);
+		seq += 5;
+	}
+		// turning it off twice is harmless
+	dprintf_set_async(false, 0);
+
+	LogContents lc = read_logs();
+	REQUIRE(in_order(lc.seqs, 0, seq));
+	REQUIRE(lc.dropped == 0);
+	end_test();
+}
+
+int main(int argc, const char * argv[])
+{
+	for (int ixarg = 1; ixarg < argc; ++ixarg) {
+		if (strcmp(argv[ixarg], "-v") == 0) {
+			verbose = true;
+		} else {
+			fprintf(stderr, "unrecognised argument '%s'\n", argv[ixarg]);
+			return 1;
+		}
+	}
+
+	test_ordering();
+	test_overflow();
+	test_rotation_while_queued();
+	test_fork();
+	test_enable_disable_cycles();
+
+	if ( ! tests_failed) {
+		fprintf(stdout, "all %d tests pass\n", num_tests);
+	} else {
+		fprintf(stdout, "Out of %d tests, %d failed a total %d test steps\n", num_tests, tests_failed, total_fail_count);
+	}
+	return tests_failed;
+}
@@ -373,6 +373,124 @@ BOOST_AUTO_TEST_CASE(SetSize_random) {
     }
 }
 
+// the hdr histogram keeps its counts in log-linear buckets; each bucket's
+// limit must be the last value that maps to it.
+BOOST_AUTO_TEST_CASE(hdr_histogram_buckets) {
+    typedef stats_entry_hdr_histogram H;
+
+    // small values each get their own bucket
+    for (int ix = 0; ix < 2*H::SUB_BUCKETS; ++ix) {
+        BOOST_CHECK_EQUAL(H::BucketOf((uint64_t)ix), ix);
+        BOOST_CHECK_EQUAL(H::BucketLimit(ix), (uint64_t)ix);
+    }
+
+    for (int ix = 0; ix < H::NUM_BUCKETS; ++ix) {
+        uint64_t limit = H::BucketLimit(ix);
+        BOOST_CHECK_EQUAL(H::BucketOf(limit), ix);
+        if (ix + 1 < H::NUM_BUCKETS) {
+            BOOST_CHECK_EQUAL(H::BucketOf(limit + 1), ix + 1);
+        }
+        if (ix >= 2*H::SUB_BUCKETS) {
+            // past the exact buckets, a bucket is never wider than
+            // 1/SUB_BUCKETS of its values
+            uint64_t width = limit - H::BucketLimit(ix - 1);
+            BOOST_CHECK(width * H::SUB_BUCKETS <= limit + 1);
+        }
+    }
+
+    // values too large for the table land in the last bucket
+    uint64_t top = (uint64_t)1 << H::MAX_BITS;
+    BOOST_CHECK_EQUAL(H::BucketLimit(H::NUM_BUCKETS - 1), top - 1);
+    BOOST_CHECK_EQUAL(H::BucketOf(top - 1), H::NUM_BUCKETS - 1);
+    BOOST_CHECK_EQUAL(H::BucketOf(top), H::NUM_BUCKETS - 1);
+    BOOST_CHECK_EQUAL(H::BucketOf(~(uint64_t)0), H::NUM_BUCKETS - 1);
+}
+
+
+// quantiles come from the top of a bucket, so they may be high by up to
+// the width of a bucket, but never more than the largest sample.
+static bool near_quantile(double q, double expected) {
+    return q >= expected * 0.999 && q <= expected * (1.0 + 1.0/stats_entry_hdr_histogram::SUB_BUCKETS);
+}
+
+BOOST_AUTO_TEST_CASE(hdr_histogram_quantiles) {
+    stats_entry_hdr_histogram h;
+
+    BOOST_CHECK_EQUAL(h.Quantile(0.5), 0.0);
+    BOOST_CHECK(h.counts == NULL);
+
+    // a single sample is every quantile
+    h.Add(0.25);
+    BOOST_CHECK_EQUAL(h.Count, 1);
+    BOOST_CHECK_EQUAL(h.Quantile(0.0), 0.25);
+    BOOST_CHECK_EQUAL(h.Quantile(0.5), 0.25);
+    BOOST_CHECK_EQUAL(h.Quantile(1.0), 0.25);
+
+    // 1 to 1000 milliseconds
+    h.Clear();
+    BOOST_CHECK_EQUAL(h.Count, 0);
+    BOOST_CHECK_EQUAL(h.Quantile(0.5), 0.0);
+    for (int ms = 1000; ms >= 1; --ms) {
+        h += ms / 1000.0;
+    }
+    BOOST_CHECK_EQUAL(h.Count, 1000);
+    BOOST_CHECK_EQUAL(h.Max, 1.0);
+    BOOST_CHECK(h.Sum > 500.49 && h.Sum < 500.51);
+    BOOST_CHECK(near_quantile(h.Quantile(0.001), 0.001));
+    BOOST_CHECK(near_quantile(h.Quantile(0.5), 0.5));
+    BOOST_CHECK(near_quantile(h.Quantile(0.9), 0.9));
+    BOOST_CHECK(near_quantile(h.Quantile(0.99), 0.99));
+    BOOST_CHECK(near_quantile(h.Quantile(0.999), 0.999));
+    BOOST_CHECK_EQUAL(h.Quantile(1.0), 1.0);
+
+    // a few very slow samples move the tail, not the median
+    for (int ii = 0; ii < 2; ++ii) {
+        h.Add(3600.0);
+    }
+    BOOST_CHECK(near_quantile(h.Quantile(0.5), 0.501));
+    BOOST_CHECK(near_quantile(h.Quantile(0.99), 0.992));
+    BOOST_CHECK_EQUAL(h.Quantile(0.999), 3600.0);
+    BOOST_CHECK_EQUAL(h.Quantile(1.0), 3600.0);
+
+    // negative times count as zero
+    stats_entry_hdr_histogram z;
+    z.Add(-1.0);
+    BOOST_CHECK_EQUAL(z.Max, 0.0);
+    BOOST_CHECK_EQUAL(z.Quantile(0.5), 0.0);
+
+    // and copies carry the counts along
+    stats_entry_hdr_histogram copy(h);
+    BOOST_CHECK_EQUAL(copy.Count, h.Count);
+    BOOST_CHECK_EQUAL(copy.Quantile(0.99), h.Quantile(0.99));
+    copy = z;
+    BOOST_CHECK_EQUAL(copy.Count, 1);
+    BOOST_CHECK_EQUAL(copy.Quantile(0.99), 0.0);
+}
+
+
+BOOST_AUTO_TEST_CASE(hdr_histogram_publish) {
+    stats_entry_hdr_histogram h;
+    ClassAd ad;
+
+    h.Publish(ad, "Runtime", IF_NONZERO);
+    BOOST_CHECK(ad.size() == 0);
+
+    for (int ms = 1; ms <= 100; ++ms) {
+        h.Add(ms / 1000.0);
+    }
+    h.Publish(ad, "Runtime", 0);
+    long long count = 0;
+    double max = 0, p50 = 0, p99 = 0, p999 = 0;
+    BOOST_CHECK(ad.LookupInteger("RuntimeCount", count) && count == 100);
+    BOOST_CHECK(ad.LookupFloat("RuntimeMax", max) && max == 0.1);
+    BOOST_CHECK(ad.LookupFloat("RuntimeP50", p50) && near_quantile(p50, 0.05));
+    BOOST_CHECK(ad.LookupFloat("RuntimeP99", p99) && near_quantile(p99, 0.099));
+    BOOST_CHECK(ad.LookupFloat("RuntimeP999", p999) && p999 == 0.1);
+
+    h.Unpublish(ad, "Runtime");
+    BOOST_CHECK(ad.size() == 0);
+}
+
 #if 1 // no boost
 int main( int /*argc*/, const char ** /*argv*/) {
 
@@ -389,6 +507,9 @@ int main( int /*argc*/, const char ** /*argv*/) {
 	test_ring_buffer_SetSize_larger();
 	test_ring_buffer_SetSize_smaller();
 	test_ring_buffer_SetSize_random();
+	test_ring_buffer_hdr_histogram_buckets();
+	test_ring_buffer_hdr_histogram_quantiles();
+	test_ring_buffer_hdr_histogram_publish();
 	return fail_count;
 }
 #endif
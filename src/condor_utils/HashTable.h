@@ -25,16 +25,7 @@
 #include "MyString.h"
 
 #include <utility>
-
-// a generic hash bucket class
-
-template <class Index, class Value>
-class HashBucket {
- public:
-  Index       index;                         // stored index
-  Value      value;                          // associated value
-  HashBucket<Index, Value> *next;            // next node in the hash table
-};
+#include <vector>
 
 template <class Index, class Value> class HashTable;
 
@@ -47,7 +38,6 @@ public:
 	HashIterator(const HashIterator &original) {
 		m_parent = original.m_parent;
 		m_idx = original.m_idx;
-		m_cur = original.m_cur;
 		m_parent->register_iterator(this);
 	}
 
@@ -56,11 +46,15 @@ public:
 	}
 
 	std::pair<Index, Value> operator *() const {
-		return std::pair<Index, Value>(m_cur ? m_cur->index : NULL, m_cur ? m_cur->value : NULL);
+		if (m_idx == -1) {
+			return std::pair<Index, Value>(NULL, NULL);
+		}
+		const typename HashTable<Index, Value>::Entry &e = m_parent->entryAt(m_idx);
+		return std::pair<Index, Value>(e.index, e.value);
 	}
 
 	std::pair<Index, Value> operator ->() const {
-		return std::pair<Index, Value>(m_cur ? m_cur->index : NULL, m_cur ? m_cur->value : NULL);
+		return **this;
 	}
 
 	/*
@@ -70,15 +64,7 @@ public:
 	 */
 	void advance() {
 		if (m_idx == -1) { return; }
-		if (m_cur) m_cur = m_cur->next;
-		while (!m_cur) {
-			if (m_idx == m_parent->tableSize-1) {
-				m_idx = -1;
-				break;
-			} else {
-				m_cur = m_parent->ht[++m_idx];
-			}
-		}
+		m_idx = m_parent->nextLive(m_idx);
 	}
 
 	HashIterator operator++(int) {
@@ -97,9 +83,6 @@ public:
 		if (this->m_idx != rhs.m_idx) {
 			return false;
 		}
-		if (this->m_cur != rhs.m_cur) {
-			return false;
-		}
 		return true;
 	}
 
@@ -107,30 +90,30 @@ private:
 	friend class HashTable<Index, Value>;
 
 	HashIterator(HashTable<Index, Value> *parent, int idx)
-	  : m_parent(parent), m_idx(idx), m_cur(NULL)
+	  : m_parent(parent), m_idx(idx)
 	{
 		if (idx == -1) return;
-		m_cur = m_parent->ht[m_idx];
-		while (!m_cur) {
-			if (m_idx == m_parent->tableSize-1) {
-				m_idx = -1;
-				break;
-			} else {
-				m_cur = m_parent->ht[++m_idx];
-			}
-		}
+		m_idx = m_parent->nextLive(-1);
 		m_parent->register_iterator(this);
 	}
 
 	HashTable<Index, Value> *m_parent;
-	int m_idx;
-	HashBucket<Index, Value> *m_cur;
+	int m_idx;	// position of the current entry, or -1 at the end
 };
 
 // a generic hash table class
 
 // IMPORTANT NOTE: Index must be a class on which == works.
 
+// The table uses open addressing.  Entries live in chunks that are never
+// moved, so pointers returned by lookup() and iterate_nocopy() stay valid
+// until that entry is removed, and iteration walks the entries in order
+// of position, so removing entries (including the current one) while
+// iterating is safe.  A separate array of 2*(getTableSize()+1) slots,
+// probed linearly, holds each entry's position along with 32 bits of its hash,
+// so most mismatches and all resizing are done without touching the
+// entries or calling the hash function again.
+
 template <class Index, class Value>
 class HashTable {
  public:
@@ -173,11 +156,39 @@ class HashTable {
 
 
  private:
+  struct Entry {
+    Entry() : live(false) {}
+    Index index;
+    Value value;
+    bool  live;                                 // false if on the free list
+  };
+  struct Slot {
+    unsigned int entry;                         // position + 1, or 0 if empty
+    unsigned int tag;                           // high bits of the mixed hash
+  };
+
+  // Entry chunks hold 8, 16, 32 and 64 entries, then 128 each.
+  static const int FIRST_CHUNK_SIZE = 8;
+  static const int FIXED_CHUNK_START = 120;
+  static const int FIXED_CHUNK_SHIFT = 7;
+
   void register_iterator(iterator* it);
   void remove_iterator(iterator* it);
 
+  Entry &entryAt(int pos) const;
+  int nextLive(int pos) const;
+  int newEntry();
+  static unsigned int hashTag(size_t hash) {
+    return (unsigned int)(((unsigned long long)hash * 0x9E3779B97F4A7C15ULL) >> 32);
+  }
+  unsigned int homeSlot(unsigned int tag) const { return tag >> slotShift; }
+  unsigned int slotMask() const { return 2 * (unsigned int)tableSize + 1; }
+  int findSlot(const Index &index, unsigned int tag) const;
+
   /* Deeply copy the hash table. */
   void copy_deep(const HashTable<Index, Value> &copy);
+  /* Release the entries and slots. */
+  void free_storage();
   /*
   Determines if the table needs to be resized based on the current load factor.
   */
@@ -186,27 +197,23 @@ class HashTable {
   Resize the hash table to the given size, or a default of the next (2^n)-1.
   */
   void resize_hash_table(int newsize = -1);
-#ifdef DEBUGHASH
-  void dump();                                  // dump contents of hash table
-#endif
 
-  int tableSize;                                // size of hash table
+  int tableSize;                                // size of hash table, a 2^n-1
   int numElems; // number of elements in the hashtable
-  HashBucket<Index, Value> **ht;                // actual hash table
+  Slot *slots;                                  // 2*(tableSize+1) of them
+  int slotShift;                                // 32 - (n+1)
+  std::vector<Entry*> chunks;
+  int numEntries;                               // positions ever handed out
+  std::vector<int> freeEntries;                 // removed positions, for reuse
   size_t (*hashfcn)(const Index &index);  // user-provided hash function
-  double maxLoadFactor;			// average number of elements per bucket list
-  int currentBucket;
-  HashBucket<Index, Value> *currentItem;
+  double maxLoadFactor;			// average number of elements per slot
+  int currentPos;                               // iterate() position
+  int currentSlot;                              // iterate_stats() position
   std::vector<iterator*> activeIterators;
 };
 
-// The two normal hash table constructors call initialize() to set everything up
-// In the first constructor, tableSz is ignored as it is no longer used, it is
-// left in for compatability reasons.
 template <class Index, class Value>
 HashTable<Index,Value>::HashTable( size_t (*hashF)( const Index &index ) ) {
-  int i;
-
   hashfcn = hashF;
 
   maxLoadFactor = 0.8;		// default "table density"
@@ -216,19 +223,16 @@ HashTable<Index,Value>::HashTable( size_t (*hashF)( const Index &index ) ) {
   // or hashFunction(<string type>)
   ASSERT(hashfcn != 0);
 
-  // if the value for maxLoadFactor is negative or 0, use the default of 50
-
-  // set tableSize before everything else b/c it's needed for the array declarations
   tableSize = 7;
+  slotShift = 32 - 4;
 
-  if (!(ht = new HashBucket<Index, Value>* [tableSize])) {
+  if (!(slots = new Slot[slotMask() + 1])) {
     EXCEPT("Insufficient memory for hash table");
   }
-  for(i = 0; i < tableSize; i++) {
-    ht[i] = NULL;
-  }
-  currentBucket = -1; // no current bucket
-  currentItem = 0; // no current item
+  memset(slots, 0, sizeof(Slot) * (slotMask() + 1));
+  numEntries = 0;
+  currentPos = -1; // no current item
+  currentSlot = -1;
   numElems = 0;
 }
 
@@ -246,7 +250,7 @@ const HashTable<Index,Value>& HashTable<Index,Value>::operator=( const HashTable
   // don't copy ourself!
   if (this != &copy) {
     clear();
-    delete [] ht;
+    free_storage();
     copy_deep(copy);
   }
 
@@ -274,54 +278,115 @@ HashTable<Index,Value>::remove_iterator(typename HashTable<Index,Value>::iterato
 			break;
 		}
 	}
-	if(needs_resizing()) {
-		resize_hash_table();
-	}
+}
+
+template <class Index, class Value>
+typename HashTable<Index,Value>::Entry &
+HashTable<Index,Value>::entryAt(int pos) const {
+  if (pos >= FIXED_CHUNK_START) {
+    pos -= FIXED_CHUNK_START;
+    return chunks[4 + (pos >> FIXED_CHUNK_SHIFT)][pos & ((1 << FIXED_CHUNK_SHIFT) - 1)];
+  }
+  int chunk = 0;
+  int size = FIRST_CHUNK_SIZE;
+  while (pos >= size) {
+    pos -= size;
+    size <<= 1;
+    chunk++;
+  }
+  return chunks[chunk][pos];
+}
+
+// Position of the first live entry after pos, or -1 if there is none.
+template <class Index, class Value>
+int HashTable<Index,Value>::nextLive(int pos) const {
+  while (++pos < numEntries) {
+    if (entryAt(pos).live) {
+      return pos;
+    }
+  }
+  return -1;
+}
+
+template <class Index, class Value>
+int HashTable<Index,Value>::newEntry() {
+  if ( ! freeEntries.empty()) {
+    int pos = freeEntries.back();
+    freeEntries.pop_back();
+    return pos;
+  }
+  int pos = numEntries++;
+  int chunk_start = FIXED_CHUNK_START + ((int)chunks.size() - 4) * (1 << FIXED_CHUNK_SHIFT);
+  int chunk_size = 1 << FIXED_CHUNK_SHIFT;
+  if (chunks.size() < 4) {
+    chunk_start = FIRST_CHUNK_SIZE * ((1 << chunks.size()) - 1);
+    chunk_size = FIRST_CHUNK_SIZE << chunks.size();
+  }
+  if (pos == chunk_start) {
+    Entry *chunk = new Entry[chunk_size];
+    if ( ! chunk) {
+      EXCEPT("Insufficient memory");
+    }
+    chunks.push_back(chunk);
+  }
+  return pos;
+}
+
+// Returns the slot holding index, or -1.
+
+template <class Index, class Value>
+int HashTable<Index,Value>::findSlot(const Index &index, unsigned int tag) const {
+  unsigned int mask = slotMask();
+  unsigned int ix = homeSlot(tag);
+  while (slots[ix].entry) {
+    if (slots[ix].tag == tag && entryAt(slots[ix].entry - 1).index == index) {
+      return (int)ix;
+    }
+    ix = (ix + 1) & mask;
+  }
+  return -1;
 }
 
 // Do a deep copy into ourself
 
 template <class Index, class Value>
 void HashTable<Index,Value>::copy_deep( const HashTable<Index,Value>& copy ) {
-  // we don't need to verify that tableSize is valid and prime, as this will
-  // already have been taken care of when the copy was constructed.
   tableSize = copy.tableSize;
+  slotShift = copy.slotShift;
 
-  if (!(ht = new HashBucket<Index, Value>* [tableSize])) {
+  if (!(slots = new Slot[slotMask() + 1])) {
     EXCEPT("Insufficient memory for hash table");
   }
-  currentItem = 0; // Ensure set, even if unset/invalid in source copy.
-  for(int i = 0; i < tableSize; i++) {
-    // duplicate this chain
-    HashBucket<Index, Value> **our_next = &ht[i];
-    HashBucket<Index, Value> *copy_next = copy.ht[i];
-    while (copy_next) {
-      // copy this bucket
-      *our_next = new HashBucket<Index, Value>(*copy_next);
-
-      // if this is the copy's current item, make it ours as well,
-	  // but point to _our_ bucket, not the copy's.
-      if (copy_next == copy.currentItem) {
-        currentItem = *our_next;
-      }
-
-      // move to the next item
-      our_next = &((*our_next)->next);
-      copy_next = copy_next->next;
-    }
-
-    // terminate the chain
-    *our_next = NULL;
+  memcpy(slots, copy.slots, sizeof(Slot) * (slotMask() + 1));
 
+  chunks.clear();
+  numEntries = 0;
+  for (int pos = 0; pos < copy.numEntries; pos++) {
+    newEntry();
+    entryAt(pos) = copy.entryAt(pos);
   }
+  freeEntries = copy.freeEntries;
 
   // take the rest of the object (it's all shallow data)
-  currentBucket = copy.currentBucket;
+  currentPos = copy.currentPos;
+  currentSlot = copy.currentSlot;
   numElems = copy.numElems;
   hashfcn = copy.hashfcn;
   maxLoadFactor = copy.maxLoadFactor;
 }
 
+template <class Index, class Value>
+void HashTable<Index,Value>::free_storage() {
+  for (size_t i = 0; i < chunks.size(); i++) {
+    delete [] chunks[i];
+  }
+  chunks.clear();
+  numEntries = 0;
+  freeEntries.clear();
+  delete [] slots;
+  slots = NULL;
+}
+
 // Insert entry into hash table mapping Index to Value.
 // Returns 0 if OK, -1 if update is false (the default)
 // and the item already exists.
@@ -329,42 +394,39 @@ void HashTable<Index,Value>::copy_deep( const HashTable<Index,Value>& copy ) {
 template <class Index, class Value>
 int HashTable<Index,Value>::insert(const Index &index,const  Value &value, bool update)
 {
-  size_t idx = hashfcn(index) % tableSize;
-
-  HashBucket<Index, Value> *bucket;
-
-  bucket = ht[idx];
-  while( bucket ) {
-    if( bucket->index == index ) {
-      // This key is already in the table, decide what to do about that
-      if ( update ) {
-        //  update the value in the table
-        bucket->value = value;
-        return 0;
-      } else {
-        // reject as a duplicate
-        return -1;
+  unsigned int tag = hashTag(hashfcn(index));
+  unsigned int mask = slotMask();
+
+  unsigned int ix = homeSlot(tag);
+  while (slots[ix].entry) {
+    if (slots[ix].tag == tag) {
+      Entry &e = entryAt(slots[ix].entry - 1);
+      if (e.index == index) {
+        // This key is already in the table, decide what to do about that
+        if ( update ) {
+          //  update the value in the table
+          e.value = value;
+          return 0;
+        } else {
+          // reject as a duplicate
+          return -1;
+        }
       }
     }
-    bucket = bucket->next;
+    ix = (ix + 1) & mask;
   }
 
   // This is a new key, add it
-  if (!(bucket = new HashBucket<Index, Value>)) {
-    EXCEPT("Insufficient memory");
-  }
-
-  bucket->index = index;
-  bucket->value = value;
-  bucket->next = ht[idx];
-  ht[idx] = bucket;
-
-#ifdef DEBUGHASH
-  dump();
-#endif
+  int pos = newEntry();
+  Entry &e = entryAt(pos);
+  e.index = index;
+  e.value = value;
+  e.live = true;
+  slots[ix].entry = pos + 1;
+  slots[ix].tag = tag;
 
   numElems++;
-   // bucket successfully added, now check to see if the table is too full
+   // entry successfully added, now check to see if the table is too full
   if(needs_resizing()) {
     resize_hash_table();
   }
@@ -381,26 +443,12 @@ int HashTable<Index,Value>::lookup(const Index &index, Value &value) const
 	return -1;
   }
 
-  size_t idx = hashfcn(index) % tableSize;
-
-  HashBucket<Index, Value> *bucket = ht[idx];
-  while(bucket) {
-#ifdef DEBUGHASH
-    cerr << "%%  Comparing " << *(long *)&bucket->index
-         << " vs. " << *(long *)index << endl;
-#endif
-    if (bucket->index == index) {
-      value = bucket->value;
-      return 0;
-    }
-    bucket = bucket->next;
+  int ix = findSlot(index, hashTag(hashfcn(index)));
+  if (ix < 0) {
+    return -1;
   }
-
-#ifdef DEBUGHASH
-  dump();
-#endif
-
-  return -1;
+  value = entryAt(slots[ix].entry - 1).value;
+  return 0;
 }
 
 // This lookup() is the same as above, but it expects (and returns) a
@@ -413,26 +461,12 @@ int HashTable<Index,Value>::lookup(const Index &index, Value* &value ) const
 	return -1;
   }
 
-  size_t idx = hashfcn(index) % tableSize;
-
-  HashBucket<Index, Value> *bucket = ht[idx];
-  while(bucket) {
-#ifdef DEBUGHASH
-    cerr << "%%  Comparing " << *(long *)&bucket->index
-         << " vs. " << *(long *)index << endl;
-#endif
-    if (bucket->index == index) {
-      value = (Value *) &(bucket->value);
-      return 0;
-    }
-    bucket = bucket->next;
+  int ix = findSlot(index, hashTag(hashfcn(index)));
+  if (ix < 0) {
+    return -1;
   }
-
-#ifdef DEBUGHASH
-  dump();
-#endif
-
-  return -1;
+  value = &(entryAt(slots[ix].entry - 1).value);
+  return 0;
 }
 
 
@@ -445,25 +479,7 @@ int HashTable<Index,Value>::exists(const Index &index) const
 	return -1;
   }
 
-  size_t idx = hashfcn(index) % tableSize;
-
-  HashBucket<Index, Value> *bucket = ht[idx];
-  while(bucket) {
-#ifdef DEBUGHASH
-    cerr << "%%  Comparing " << *(long *)&bucket->index
-         << " vs. " << *(long *)index << endl;
-#endif
-    if (bucket->index == index) {
-      return 0;
-    }
-    bucket = bucket->next;
-  }
-
-#ifdef DEBUGHASH
-  dump();
-#endif
-
-  return -1;
+  return findSlot(index, hashTag(hashfcn(index))) < 0 ? -1 : 0;
 }
 
 // Delete Index entry from hash table. Return OK (0) if index was found.
@@ -472,90 +488,74 @@ int HashTable<Index,Value>::exists(const Index &index) const
 template <class Index, class Value>
 int HashTable<Index,Value>::remove(const Index &index)
 {
-  	size_t idx = hashfcn(index) % tableSize;
+	if ( numElems == 0 ) {
+		return -1;
+	}
 
-  	HashBucket<Index, Value> *bucket = ht[idx];
-  	HashBucket<Index, Value> *prevBuc = ht[idx];
+	int found = findSlot(index, hashTag(hashfcn(index)));
+	if (found < 0) {
+		return -1;
+	}
+	int pos = slots[found].entry - 1;
 
-  	while(bucket) 
+	// Iterators on this entry must move forward!  The current iterator may
+	// be dereferenced before being incremented.  Hence, it must point at a
+	// valid object and it must not return a value already seen
+	for (typename std::vector<iterator*>::iterator it=activeIterators.begin();
+		it != activeIterators.end();
+		it++)
 	{
-    	if (bucket->index == index) 
-		{
-      		if (bucket == ht[idx]) 
-			{
-				// The item we're deleting is the first one for
-				// this index.
-
-				ht[idx] = bucket->next;
-
-				// if the item being deleted is being iterated, ensure that
-				// next iteration returns the object "after" this one
-				if (bucket == currentItem)
-				{
-					currentItem = 0;
-						// -1 means no current bucket.  (Change here
-						// fixes gittrac #6177.  wenger 2017-03-16)
-					if (--currentBucket < 0) currentBucket = -1;
-				}
-			}
-      		else
-			{
-				// The item we're deleting is NOT the first one for
-				// this index.
-
-				prevBuc->next = bucket->next;
-
-				// Again, take care of the iterator
-				if (bucket == currentItem)
-				{
-					currentItem = prevBuc;
-				}
-			}
-
-			// Invalidate all active iterators that point to this object.
-			for (typename std::vector<iterator*>::iterator it=activeIterators.begin();
-				it != activeIterators.end();
-				it++)
-			{
-				if (bucket == (*it)->m_cur)
-				{
-					// These iterators must move forward!  The current iterator may be dereferenced
-					// before being incremented.  Hence, it must point at a valid object and it must
-					// not return a value already seen
-					(*it)->advance();
-				}
-			}
-
-      		delete bucket;
-
-#			ifdef DEBUGHASH
-      		dump();
-#			endif
-
-			numElems--;
-      		return 0;
-    	}
+		if ((*it)->m_idx == pos) {
+			(*it)->advance();
+		}
+	}
 
-    	prevBuc = bucket;
-    	bucket = bucket->next;
-  	}
+	// The entry stays where it is, so an iterate() that is at it will
+	// carry on with the one after it.
+	Entry &e = entryAt(pos);
+	e.index = Index();
+	e.value = Value();
+	e.live = false;
+	freeEntries.push_back(pos);
+
+	// Close the gap in the probe sequence by moving back any later
+	// slots whose home is at or before the emptied one.
+	unsigned int mask = slotMask();
+	unsigned int hole = (unsigned int)found;
+	unsigned int ix = hole;
+	for (;;) {
+		ix = (ix + 1) & mask;
+		if ( ! slots[ix].entry) {
+			break;
+		}
+		unsigned int home = homeSlot(slots[ix].tag);
+		bool stays = (hole <= ix) ? (hole < home && home <= ix)
+		                          : (hole < home || home <= ix);
+		if ( ! stays) {
+			slots[hole] = slots[ix];
+			hole = ix;
+		}
+	}
+	slots[hole].entry = 0;
 
-  	return -1;
+	numElems--;
+	return 0;
 }
 
-// Clear hash table by deallocating hash buckets in table.
+// Clear hash table by deallocating all of its entries.
 
 template <class Index, class Value>
 int HashTable<Index,Value>::clear()
 {
-  for(int i = 0; i < tableSize; i++) {
-    HashBucket<Index, Value> *tmpBuf = ht[i];
-    while(ht[i]) {
-      tmpBuf = ht[i];
-      ht[i] = ht[i]->next;
-      delete tmpBuf;
-    }
+  for (size_t i = 0; i < chunks.size(); i++) {
+    delete [] chunks[i];
   }
+  chunks.clear();
+  numEntries = 0;
+  freeEntries.clear();
+  memset(slots, 0, sizeof(Slot) * (slotMask() + 1));
+  currentPos = -1;
+  currentSlot = -1;
 
 	// Change all existing iterators to point at the end.
 	for (typename std::vector<iterator*>::iterator it=activeIterators.begin();
@@ -563,7 +563,6 @@ int HashTable<Index,Value>::clear()
 		it++)
 	{
 		(*it)->m_idx = -1;
-		(*it)->m_cur = NULL;
 	}
 
   numElems = 0;
@@ -575,10 +574,9 @@ template <class Index, class Value>
 void HashTable<Index,Value>::
 startIterations (void)
 {
-		// No current bucket.
-    currentBucket = -1;
 		// No current item.
-	currentItem = 0;
+	currentPos = -1;
+	currentSlot = -1;
 }
 
 
@@ -586,32 +584,12 @@ template <class Index, class Value>
 int HashTable<Index,Value>::
 iterate (Value &v)
 {
-    	// try to get next item in the current bucket chain ...
-    if (currentItem) {
-        currentItem = currentItem->next;
-    
-        // ... if successful, return OK
-        if (currentItem) {
-            v = currentItem->value;
-            return 1;
-       }
-    }
-
-		// the current bucket chain is expended, so find the next non-NULL
-		// bucket and continue from there
-	do {
-		currentBucket++;
-		if (currentBucket >= tableSize) {
-			// end of hash table ... no more entries
-			currentBucket = -1;
-			currentItem = 0;
-
-			return 0;
-		}
-		currentItem = ht[currentBucket];
-	} while ( !currentItem );
-
-	v = currentItem->value;
+	currentPos = nextLive(currentPos);
+	if (currentPos < 0) {
+		// end of hash table ... no more entries
+		return 0;
+	}
+	v = entryAt(currentPos).value;
 	return 1;
 }
 
@@ -619,8 +597,10 @@ template <class Index, class Value>
 int HashTable<Index,Value>::
 getCurrentKey (Index &index)
 {
-    if (!currentItem) return -1;
-    index = currentItem->index;
+    if (currentPos < 0 || currentPos >= numEntries) return -1;
+    Entry &e = entryAt(currentPos);
+    if ( ! e.live) return -1;
+    index = e.index;
     return 0;
 }
 
@@ -629,34 +609,14 @@ template <class Index, class Value>
 int HashTable<Index,Value>::
 iterate (Index &index, Value &v)
 {
-    	// try to get next item in the current bucket chain ...
-    if (currentItem) {
-        currentItem = currentItem->next;
-    
-        // ... if successful, return OK
-        if (currentItem) {
-			index = currentItem->index;
-            v = currentItem->value;
-            return 1;
-       }
-    }
-
-		// the current bucket chain is expended, so find the next non-NULL
-		// bucket and continue from there
-	do {
-		currentBucket++;
-		if (currentBucket >= tableSize) {
-			// end of hash table ... no more entries
-			currentBucket = -1;
-			currentItem = 0;
-
-			return 0;
-		}
-		currentItem = ht[currentBucket];
-	} while ( !currentItem );
-
-	index = currentItem->index;
-	v = currentItem->value;
+	currentPos = nextLive(currentPos);
+	if (currentPos < 0) {
+		// end of hash table ... no more entries
+		return 0;
+	}
+	Entry &e = entryAt(currentPos);
+	index = e.index;
+	v = e.value;
 	return 1;
 }
 
@@ -665,169 +625,112 @@ template <class Index, class Value>
 int HashTable<Index,Value>::
 iterate_nocopy (const Index **pindex, Value ** pv)
 {
-    // try to get next item in the current bucket chain ...
-    if (currentItem) {
-        currentItem = currentItem->next;
-    
-        // ... if successful, return OK
-        if (currentItem) {
-            *pindex = &currentItem->index;
-            *pv = &currentItem->value;
-            return 1;
-       }
-    }
-
-		// the current bucket chain is expended, so find the next non-NULL
-		// bucket and continue from there
-	do {
-		currentBucket++;
-		if (currentBucket >= tableSize) {
-			// end of hash table ... no more entries
-			currentBucket = -1;
-			currentItem = 0;
-
-			return 0;
-		}
-		currentItem = ht[currentBucket];
-	} while ( !currentItem );
-
-	*pindex = &currentItem->index;
-	*pv = &currentItem->value;
+	currentPos = nextLive(currentPos);
+	if (currentPos < 0) {
+		// end of hash table ... no more entries
+		return 0;
+	}
+	Entry &e = entryAt(currentPos);
+	*pindex = &e.index;
+	*pv = &e.value;
 	return 1;
 }
 
-// this iterator helps to gather statistics about the hashtable fill ratio
+// this iterator helps to gather statistics about the hashtable fill ratio.
+// It walks the slots in order; ix_bucket is the slot an entry hashed to,
+// and ix_item is how many slots past that it had to be put.  At the end
+// ix_item is set to the number of slots.
 template <class Index, class Value>
 int HashTable<Index,Value>::
 iterate_stats (int & ix_bucket, int & ix_item)
 {
-	// try to get next item in the current bucket chain ...
-	if (currentItem) {
-		currentItem = currentItem->next;
-
-		// ... if successful, return OK
-		if (currentItem) {
-			++ix_item;
+	while (++currentSlot <= (int)slotMask()) {
+		if (slots[currentSlot].entry) {
+			currentPos = slots[currentSlot].entry - 1;
+			ix_bucket = (int)homeSlot(slots[currentSlot].tag);
+			ix_item = (currentSlot - ix_bucket) & slotMask();
 			return 1;
 		}
 	}
-
-		// the current bucket chain is expended, so find the next non-NULL
-		// bucket and continue from there
-	do {
-		currentBucket++;
-		if (currentBucket >= tableSize) {
-			// end of hash table ... no more entries
-			currentBucket = -1;
-			currentItem = 0;
-			ix_bucket = -1;
-			ix_item = tableSize;
-			return 0;
-		}
-		currentItem = ht[currentBucket];
-	} while ( !currentItem );
-
-	ix_bucket = currentBucket;
-	ix_item = 0;
-	return 1;
+	// end of hash table ... no more entries
+	currentSlot = -1;
+	currentPos = -1;
+	ix_bucket = -1;
+	ix_item = (int)slotMask() + 1;
+	return 0;
 }
 
 template <class Index, class Value>
 int HashTable<Index,Value>::walk( int (*walkfunc) ( Value value ) )
 {
-	HashBucket<Index,Value> *current;
-	int i;
-
-	for( i=0; i<tableSize; i++ ) {
-		for( current=ht[i]; current; current=current->next ) {
-			if(!walkfunc( current->value )) return 0;
-		}
+	for (int pos = nextLive(-1); pos >= 0; pos = nextLive(pos)) {
+		if(!walkfunc( entryAt(pos).value )) return 0;
 	}
 
 	return 1;
 }
 
 
-// Delete hash table by deallocating hash buckets in table and then
+// Delete hash table by deallocating its entries and then
 // deleting table itself.
 
 template <class Index, class Value>
 HashTable<Index,Value>::~HashTable()
 {
   clear();
-  delete [] ht;
+  free_storage();
 }
 
 // Determine if the hash table should be resized and reindexed
 template <class Index, class Value>
 int HashTable<Index, Value>::needs_resizing() {
-		// Resizing destroys active iterators.
-	if (activeIterators.size()) return 0;
 	if(((double) numElems / (double) tableSize) >= maxLoadFactor) {
 		return 1;
 	}
 	return 0;
 }
 
-// Resize and reindex the hash table
+// Resize and reindex the hash table.  Only the slots are rebuilt, from
+// the hash bits they hold, so entries, iterators and pointers to values
+// are not disturbed.
 template <class Index, class Value>
 void HashTable<Index, Value>::resize_hash_table(int newsize) {
+	int bits = 1;
 	if(newsize <= 0) {
 			// default to next 2^n-1 value
 		newsize = tableSize + 1;
 		newsize *= 2;
 		newsize--;
 	}
-	HashBucket<Index, Value> **htcopy;
-	if (!(htcopy = new HashBucket<Index, Value>* [newsize])) {
-		EXCEPT("Insufficient memory for hash table resizing");
-	}
-	int i;
-	for(i = 0; i < newsize; i++) {
-		htcopy[i] = NULL;
+	while (((1 << bits) - 1) < newsize) {
+		bits++;
 	}
+	newsize = (1 << bits) - 1;
 
-	HashBucket<Index, Value> *temp = NULL;
-	HashBucket<Index, Value> *cur= NULL;
-	for( i=0; i<tableSize; i++ ) {
-		for( cur=ht[i]; cur; cur=temp ) {
-			size_t idx = hashfcn(cur->index) % newsize;
-				// put it at htcopy[idx]
-				// if htcopy[idx] wasn't NULL then put whatever was there as its next value...
-				// if it was NULL then set current->next to NULL, so I guess just copy the value no matter what
-			temp = cur->next;
-			cur->next = htcopy[idx];
-			htcopy[idx] = cur;
+	unsigned int newmask = 2 * (unsigned int)newsize + 1;
+	Slot *newslots;
+	if (!(newslots = new Slot[newmask + 1])) {
+		EXCEPT("Insufficient memory for hash table resizing");
+	}
+	memset(newslots, 0, sizeof(Slot) * (newmask + 1));
+
+	int newshift = 32 - (bits + 1);
+	for (unsigned int i = 0; i <= slotMask(); i++) {
+		if (slots[i].entry) {
+			unsigned int ix = slots[i].tag >> newshift;
+			while (newslots[ix].entry) {
+				ix = (ix + 1) & newmask;
+			}
+			newslots[ix] = slots[i];
 		}
 	}
-	delete[] ht;
-	ht = htcopy;
-	currentItem = 0;
-	currentBucket = -1;
+	delete[] slots;
+	slots = newslots;
+	slotShift = newshift;
+	currentSlot = -1;
 	tableSize = newsize;
 } 
 
-#ifdef DEBUGHASH
-// Dump hash table contents.
-
-template <class Index, class Value>
-void HashTable<Index,Value>::dump()
-{
-  for(int i = 0; i < tableSize; i++) {
-    HashBucket<Index, Value> *tmpBuf = ht[i];
-    int hasStuff = (tmpBuf != NULL);
-    if (hasStuff)
-      cerr << "%%  Hash value " << i << ": ";
-    while(tmpBuf) {
-      cerr << tmpBuf->value << " ";
-      tmpBuf = ht[i]->next;
-    }
-    if (hasStuff)
-      cerr << endl;
-  }
-}
-#endif // DEBUGHASH
-
 /// basic hash function for an unpredictable integer key
 size_t hashFuncInt( const int& n );
 
@@ -53,6 +53,7 @@ KeyCacheEntry::KeyCacheEntry( char const *id_param, const condor_sockaddr * addr
 	_lease_interval = lease_interval;
 	_lease_expiration = 0;
 	_lingering = false;
+	_restored = false;
 	renewLease();
 }
 
@@ -152,6 +153,7 @@ void KeyCacheEntry::copy_storage(const KeyCacheEntry &copy) {
 	_lease_interval = copy._lease_interval;
 	_lease_expiration = copy._lease_expiration;
 	_lingering = copy._lingering;
+	_restored = copy._restored;
 }
 
 
@@ -0,0 +1,754 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "classad_binary.h"
+#include "classad/classadCache.h"
+
+using namespace classad;
+
+// Each expression starts with one of these tags.  The literal tags come
+// first, so that anything below TAG_ATTR is a literal.
+//
+//   TAG_INT        zigzag varint
+//   TAG_REAL       8 bytes of IEEE double, least significant first
+//   TAG_STRING     varint length, bytes
+//   TAG_ABSTIME    zigzag varint seconds, zigzag varint offset
+//   TAG_RELTIME    as TAG_REAL
+//   TAG_ATTR       flags byte (ATTR_ABSOLUTE, ATTR_SCOPED), [scope expr], name as a string
+//   TAG_OP         op kind byte, then 1, 2 or 3 operand exprs as the kind requires
+//   TAG_FUNC       name as a string, varint argument count, argument exprs
+//   TAG_LIST       varint count, exprs
+//   TAG_AD         varint count, then count names as strings, each followed by an expr
+//   TAG_TEXT       old ClassAd text as a string, for anything else
+//   TAG_NONE       a missing operand
+//
+// The others are complete in the tag byte.
+enum {
+	TAG_UNDEFINED = 0,
+	TAG_ERROR,
+	TAG_TRUE,
+	TAG_FALSE,
+	TAG_INT,
+	TAG_REAL,
+	TAG_STRING,
+	TAG_ABSTIME,
+	TAG_RELTIME,
+
+	TAG_ATTR = 0x10,
+	TAG_OP,
+	TAG_FUNC,
+	TAG_LIST,
+	TAG_AD,
+	TAG_TEXT,
+	TAG_NONE,
+};
+
+enum { ATTR_ABSOLUTE = 0x01, ATTR_SCOPED = 0x02 };
+
+// Deeper trees are sent as text, so that the receiver never has to recurse
+// further than this, whatever it is sent.
+static const int MAX_DEPTH = 1000;
+
+static void putVarint(std::string & out, unsigned long long val)
+{
+	while (val >= 0x80) {
+		out += (char)((val & 0x7F) | 0x80);
+		val >>= 7;
+	}
+	out += (char)val;
+}
+
+static void putSigned(std::string & out, long long val)
+{
+	putVarint(out, ((unsigned long long)val << 1) ^ (unsigned long long)(val >> 63));
+}
+
+static void putString(std::string & out, const char * str, size_t len)
+{
+	putVarint(out, len);
+	out.append(str, len);
+}
+
+static void putString(std::string & out, const std::string & str)
+{
+	putString(out, str.data(), str.size());
+}
+
+static void putReal(std::string & out, double val)
+{
+	unsigned long long bits;
+	memcpy(&bits, &val, sizeof(bits));
+	for (int ix = 0; ix < 8; ++ix) {
+		out += (char)(bits & 0xFF);
+		bits >>= 8;
+	}
+}
+
+static bool getVarint(const char * & p, const char * end, unsigned long long & val)
+{
+	val = 0;
+	for (int shift = 0; shift < 64 && p < end; shift += 7) {
+		unsigned char byte = (unsigned char)*p++;
+		val |= (unsigned long long)(byte & 0x7F) << shift;
+		if ( ! (byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool getSigned(const char * & p, const char * end, long long & val)
+{
+	unsigned long long zz;
+	if ( ! getVarint(p, end, zz)) {
+		return false;
+	}
+	val = (long long)(zz >> 1) ^ -(long long)(zz & 1);
+	return true;
+}
+
+static bool getString(const char * & p, const char * end, const char * & str, size_t & len)
+{
+	unsigned long long cb;
+	if ( ! getVarint(p, end, cb) || cb > (unsigned long long)(end - p)) {
+		return false;
+	}
+	str = p;
+	len = (size_t)cb;
+	p += len;
+	return true;
+}
+
+static bool getString(const char * & p, const char * end, std::string & str)
+{
+	const char * s;
+	size_t len;
+	if ( ! getString(p, end, s, len)) {
+		return false;
+	}
+	str.assign(s, len);
+	return true;
+}
+
+static bool getReal(const char * & p, const char * end, double & val)
+{
+	if (end - p < 8) {
+		return false;
+	}
+	unsigned long long bits = 0;
+	for (int ix = 7; ix >= 0; --ix) {
+		bits = (bits << 8) | (unsigned char)p[ix];
+	}
+	p += 8;
+	memcpy(&val, &bits, sizeof(val));
+	return true;
+}
+
+static int operandCount(int kind)
+{
+	switch (kind) {
+	case Operation::PARENTHESES_OP:
+	case Operation::UNARY_PLUS_OP:
+	case Operation::UNARY_MINUS_OP:
+	case Operation::LOGICAL_NOT_OP:
+	case Operation::BITWISE_NOT_OP:
+		return 1;
+	case Operation::TERNARY_OP:
+		return 3;
+	default:
+		return 2;
+	}
+}
+
+static void encodeText(std::string & out, const ExprTree * expr)
+{
+	ClassAdUnParser unp;
+	unp.SetOldClassAd(true, true);
+	std::string text;
+	unp.Unparse(text, expr);
+	out += (char)TAG_TEXT;
+	putString(out, text);
+}
+
+static void encodeLiteral(std::string & out, const Literal * lit)
+{
+	Value::NumberFactor factor;
+	const Value & val = lit->getValue(factor);
+	if (factor != Value::NO_FACTOR) {
+		encodeText(out, lit);
+		return;
+	}
+
+	bool b;
+	long long ll;
+	double dd;
+	const char * str;
+	int len;
+	abstime_t at;
+	switch (val.GetType()) {
+	case Value::UNDEFINED_VALUE:
+		out += (char)TAG_UNDEFINED;
+		break;
+	case Value::ERROR_VALUE:
+		out += (char)TAG_ERROR;
+		break;
+	case Value::BOOLEAN_VALUE:
+		val.IsBooleanValue(b);
+		out += (char)(b ? TAG_TRUE : TAG_FALSE);
+		break;
+	case Value::INTEGER_VALUE:
+		val.IsIntegerValue(ll);
+		out += (char)TAG_INT;
+		putSigned(out, ll);
+		break;
+	case Value::REAL_VALUE:
+		val.IsRealValue(dd);
+		out += (char)TAG_REAL;
+		putReal(out, dd);
+		break;
+	case Value::STRING_VALUE:
+		val.IsStringValue(str);
+		val.IsStringValue(len);
+		out += (char)TAG_STRING;
+		putString(out, str, len);
+		break;
+	case Value::ABSOLUTE_TIME_VALUE:
+		val.IsAbsoluteTimeValue(at);
+		out += (char)TAG_ABSTIME;
+		putSigned(out, at.secs);
+		putSigned(out, at.offset);
+		break;
+	case Value::RELATIVE_TIME_VALUE:
+		val.IsRelativeTimeValue(dd);
+		out += (char)TAG_RELTIME;
+		putReal(out, dd);
+		break;
+	default:
+		encodeText(out, lit);
+		break;
+	}
+}
+
+static void encodeExpr(std::string & out, const ExprTree * expr, int depth)
+{
+	if ( ! expr) {
+		out += (char)TAG_NONE;
+		return;
+	}
+	if (depth >= MAX_DEPTH) {
+		encodeText(out, expr);
+		return;
+	}
+
+	switch (expr->GetKind()) {
+	case ExprTree::LITERAL_NODE:
+		encodeLiteral(out, static_cast<const Literal *>(expr));
+		break;
+
+	case ExprTree::ATTRREF_NODE: {
+		ExprTree * scope = NULL;
+		std::string name;
+		bool absolute = false;
+		static_cast<const AttributeReference *>(expr)->GetComponents(scope, name, absolute);
+		out += (char)TAG_ATTR;
+		out += (char)((absolute ? ATTR_ABSOLUTE : 0) | (scope ? ATTR_SCOPED : 0));
+		if (scope) {
+			encodeExpr(out, scope, depth + 1);
+		}
+		putString(out, name);
+		break;
+	}
+
+	case ExprTree::OP_NODE: {
+		Operation::OpKind kind;
+		ExprTree * operands[3] = { NULL, NULL, NULL };
+		static_cast<const Operation *>(expr)->GetComponents(kind, operands[0], operands[1], operands[2]);
+		out += (char)TAG_OP;
+		out += (char)kind;
+		int count = operandCount(kind);
+		for (int ix = 0; ix < count; ++ix) {
+			encodeExpr(out, operands[ix], depth + 1);
+		}
+		break;
+	}
+
+	case ExprTree::FN_CALL_NODE: {
+		std::string name;
+		std::vector<ExprTree *> args;
+		static_cast<const FunctionCall *>(expr)->GetComponents(name, args);
+		out += (char)TAG_FUNC;
+		putString(out, name);
+		putVarint(out, args.size());
+		for (size_t ix = 0; ix < args.size(); ++ix) {
+			encodeExpr(out, args[ix], depth + 1);
+		}
+		break;
+	}
+
+	case ExprTree::EXPR_LIST_NODE: {
+		std::vector<ExprTree *> items;
+		static_cast<const ExprList *>(expr)->GetComponents(items);
+		out += (char)TAG_LIST;
+		putVarint(out, items.size());
+		for (size_t ix = 0; ix < items.size(); ++ix) {
+			encodeExpr(out, items[ix], depth + 1);
+		}
+		break;
+	}
+
+	case ExprTree::CLASSAD_NODE: {
+		std::vector< std::pair<std::string, ExprTree *> > attrs;
+		static_cast<const ClassAd *>(expr)->GetComponents(attrs);
+		out += (char)TAG_AD;
+		putVarint(out, attrs.size());
+		for (size_t ix = 0; ix < attrs.size(); ++ix) {
+			putString(out, attrs[ix].first);
+			encodeExpr(out, attrs[ix].second, depth + 1);
+		}
+		break;
+	}
+
+	case ExprTree::EXPR_ENVELOPE: {
+		const CachedExprEnvelope * env = static_cast<const CachedExprEnvelope *>(expr);
+		ExprTree * tree = env->get();
+		if (tree) {
+			encodeExpr(out, tree, depth);
+		} else {
+			out += (char)TAG_TEXT;
+			putString(out, env->get_unparsed_str());
+		}
+		break;
+	}
+
+	default:
+		encodeText(out, expr);
+		break;
+	}
+}
+
+void encodeBinaryExpr(std::string & out, const ExprTree * expr)
+{
+	encodeExpr(out, expr, 0);
+}
+
+static ExprTree * decodeExpr(const char * & p, const char * end, int depth, bool & ok);
+
+static Literal * decodeLiteral(int tag, const char * & p, const char * end)
+{
+	long long ll;
+	double dd;
+	const char * str;
+	size_t len;
+	Value val;
+	switch (tag) {
+	case TAG_UNDEFINED:
+		return Literal::MakeUndefined();
+	case TAG_ERROR:
+		return Literal::MakeError();
+	case TAG_TRUE:
+		return Literal::MakeBool(true);
+	case TAG_FALSE:
+		return Literal::MakeBool(false);
+	case TAG_INT:
+		if ( ! getSigned(p, end, ll)) return NULL;
+		return Literal::MakeLong(ll);
+	case TAG_REAL:
+		if ( ! getReal(p, end, dd)) return NULL;
+		return Literal::MakeReal(dd);
+	case TAG_STRING:
+		if ( ! getString(p, end, str, len)) return NULL;
+		return Literal::MakeString(str, len);
+	case TAG_ABSTIME: {
+		long long secs, offset;
+		if ( ! getSigned(p, end, secs) || ! getSigned(p, end, offset)) return NULL;
+		abstime_t at;
+		at.secs = (time_t)secs;
+		at.offset = (int)offset;
+		val.SetAbsoluteTimeValue(at);
+		return Literal::MakeLiteral(val);
+	}
+	case TAG_RELTIME:
+		if ( ! getReal(p, end, dd)) return NULL;
+		val.SetRelativeTimeValue(dd);
+		return Literal::MakeLiteral(val);
+	}
+	return NULL;
+}
+
+// decode the count exprs that follow into items, which the caller owns even on failure
+static bool decodeExprs(const char * & p, const char * end, int depth, size_t count, std::vector<ExprTree *> & items)
+{
+	// don't trust count for the reservation; every expr is at least one byte
+	items.reserve(MIN(count, (size_t)(end - p)));
+	for (size_t ix = 0; ix < count; ++ix) {
+		bool ok = true;
+		ExprTree * item = decodeExpr(p, end, depth + 1, ok);
+		if ( ! ok || ! item) {
+			return false;
+		}
+		items.push_back(item);
+	}
+	return true;
+}
+
+static void deleteExprs(std::vector<ExprTree *> & items)
+{
+	for (size_t ix = 0; ix < items.size(); ++ix) {
+		delete items[ix];
+	}
+	items.clear();
+}
+
+// Returns NULL for TAG_NONE with ok still true; sets ok false if the input is malformed.
+static ExprTree * decodeExpr(const char * & p, const char * end, int depth, bool & ok)
+{
+	if (p >= end || depth > MAX_DEPTH) {
+		ok = false;
+		return NULL;
+	}
+	int tag = (unsigned char)*p++;
+	if (tag < TAG_ATTR) {
+		ExprTree * lit = decodeLiteral(tag, p, end);
+		if ( ! lit) { ok = false; }
+		return lit;
+	}
+
+	switch (tag) {
+	case TAG_NONE:
+		return NULL;
+
+	case TAG_ATTR: {
+		if (p >= end) break;
+		int flags = (unsigned char)*p++;
+		ExprTree * scope = NULL;
+		if (flags & ATTR_SCOPED) {
+			scope = decodeExpr(p, end, depth + 1, ok);
+			if ( ! ok || ! scope) break;
+		}
+		std::string name;
+		if ( ! getString(p, end, name)) {
+			delete scope;
+			break;
+		}
+		return AttributeReference::MakeAttributeReference(scope, name, (flags & ATTR_ABSOLUTE) != 0);
+	}
+
+	case TAG_OP: {
+		if (p >= end) break;
+		int kind = (unsigned char)*p++;
+		if (kind < Operation::__FIRST_OP__ || kind > Operation::__LAST_OP__) break;
+		ExprTree * operands[3] = { NULL, NULL, NULL };
+		int count = operandCount(kind);
+		for (int ix = 0; ok && ix < count; ++ix) {
+			operands[ix] = decodeExpr(p, end, depth + 1, ok);
+		}
+		if ( ! ok) {
+			delete operands[0]; delete operands[1]; delete operands[2];
+			break;
+		}
+		return Operation::MakeOperation((Operation::OpKind)kind, operands[0], operands[1], operands[2]);
+	}
+
+	case TAG_FUNC: {
+		std::string name;
+		unsigned long long count;
+		if ( ! getString(p, end, name) || ! getVarint(p, end, count)) break;
+		std::vector<ExprTree *> args;
+		if ( ! decodeExprs(p, end, depth, (size_t)count, args)) {
+			deleteExprs(args);
+			break;
+		}
+		return FunctionCall::MakeFunctionCall(name, args);
+	}
+
+	case TAG_LIST: {
+		unsigned long long count;
+		if ( ! getVarint(p, end, count)) break;
+		std::vector<ExprTree *> items;
+		if ( ! decodeExprs(p, end, depth, (size_t)count, items)) {
+			deleteExprs(items);
+			break;
+		}
+		return ExprList::MakeExprList(items);
+	}
+
+	case TAG_AD: {
+		unsigned long long count;
+		if ( ! getVarint(p, end, count)) break;
+		ClassAd * ad = new ClassAd();
+		std::string name;
+		for (unsigned long long ix = 0; ok && ix < count; ++ix) {
+			ExprTree * value = NULL;
+			if ( ! getString(p, end, name) || name.empty() ||
+				! (value = decodeExpr(p, end, depth + 1, ok)) || ! ok) {
+				delete value;
+				ok = false;
+			} else if ( ! ad->Insert(name, value)) {
+				ok = false;
+			}
+		}
+		if ( ! ok) {
+			delete ad;
+			break;
+		}
+		return ad;
+	}
+
+	case TAG_TEXT: {
+		std::string text;
+		if ( ! getString(p, end, text)) break;
+		ClassAdParser parser;
+		parser.SetOldClassAd(true);
+		ExprTree * tree = parser.ParseExpression(text);
+		if ( ! tree) break;
+		return tree;
+	}
+	}
+
+	ok = false;
+	return NULL;
+}
+
+ExprTree * decodeBinaryExpr(const char * & p, const char * end)
+{
+	bool ok = true;
+	ExprTree * tree = decodeExpr(p, end, 0, ok);
+	if ( ! ok) {
+		delete tree;
+		return NULL;
+	}
+	return tree;
+}
+
+// Step over one expr without building it, to find the bytes the cache is keyed on.
+static bool skipExpr(const char * & p, const char * end, int depth)
+{
+	if (p >= end || depth > MAX_DEPTH) {
+		return false;
+	}
+	int tag = (unsigned char)*p++;
+	unsigned long long count, skip;
+	const char * str;
+	size_t len;
+	switch (tag) {
+	case TAG_UNDEFINED: case TAG_ERROR: case TAG_TRUE: case TAG_FALSE: case TAG_NONE:
+		return true;
+	case TAG_INT:
+		return getVarint(p, end, skip);
+	case TAG_REAL: case TAG_RELTIME:
+		if (end - p < 8) return false;
+		p += 8;
+		return true;
+	case TAG_STRING: case TAG_TEXT:
+		return getString(p, end, str, len);
+	case TAG_ABSTIME:
+		return getVarint(p, end, skip) && getVarint(p, end, skip);
+	case TAG_ATTR: {
+		if (p >= end) return false;
+		int flags = (unsigned char)*p++;
+		if ((flags & ATTR_SCOPED) && ! skipExpr(p, end, depth + 1)) return false;
+		return getString(p, end, str, len);
+	}
+	case TAG_OP: {
+		if (p >= end) return false;
+		int count = operandCount((unsigned char)*p++);
+		for (int ix = 0; ix < count; ++ix) {
+			if ( ! skipExpr(p, end, depth + 1)) return false;
+		}
+		return true;
+	}
+	case TAG_FUNC:
+		if ( ! getString(p, end, str, len)) return false;
+		// fall through
+	case TAG_LIST:
+		if ( ! getVarint(p, end, count)) return false;
+		for (unsigned long long ix = 0; ix < count; ++ix) {
+			if ( ! skipExpr(p, end, depth + 1)) return false;
+		}
+		return true;
+	case TAG_AD:
+		if ( ! getVarint(p, end, count)) return false;
+		for (unsigned long long ix = 0; ix < count; ++ix) {
+			if ( ! getString(p, end, str, len) || ! skipExpr(p, end, depth + 1)) return false;
+		}
+		return true;
+	}
+	return false;
+}
+
+void BinaryClassAdNames::clear()
+{
+	m_out.clear();
+	m_in.clear();
+	buffer.clear();
+}
+
+unsigned int BinaryClassAdNames::outgoing(const std::string & name)
+{
+	auto it = m_out.find(name);
+	if (it != m_out.end()) {
+		return it->second;
+	}
+	if (m_out.size() < MAX_NAMES) {
+		unsigned int token = (unsigned int)m_out.size() + 1;
+		m_out.insert(std::make_pair(name, token));
+	}
+	return 0;
+}
+
+void BinaryClassAdNames::incoming(const std::string & name)
+{
+	if (m_in.size() < MAX_NAMES) {
+		m_in.push_back(name);
+	}
+}
+
+const std::string * BinaryClassAdNames::lookup(unsigned int token) const
+{
+	if (token < 1 || token > m_in.size()) {
+		return NULL;
+	}
+	return &m_in[token - 1];
+}
+
+void BinaryClassAd::clear()
+{
+	m_names.clear();
+	m_name_ends.clear();
+	m_values.clear();
+	m_value_ends.clear();
+	m_secrets.clear();
+}
+
+void BinaryClassAd::add(const std::string & attr, const ExprTree * expr)
+{
+	m_names += attr;
+	m_name_ends.push_back(m_names.size());
+	m_names += '\0';
+	encodeExpr(m_values, expr, 0);
+	m_value_ends.push_back(m_values.size());
+}
+
+void BinaryClassAd::makeBody(std::string & body, BinaryClassAdNames & names) const
+{
+	body.clear();
+	body += (char)BINARY_CLASSAD_VERSION;
+	body += (char)(names.sentNone() ? BINARY_CLASSAD_NEW_NAMES : 0);
+	putVarint(body, m_name_ends.size());
+	putVarint(body, m_secrets.size());
+
+	std::string name;
+	size_t name_begin = 0, value_begin = 0;
+	for (size_t ix = 0; ix < m_name_ends.size(); ++ix) {
+		name.assign(m_names, name_begin, m_name_ends[ix] - name_begin);
+		unsigned int token = names.outgoing(name);
+		putVarint(body, token);
+		if ( ! token) {
+			putString(body, name);
+		}
+		body.append(m_values, value_begin, m_value_ends[ix] - value_begin);
+		name_begin = m_name_ends[ix] + 1;
+		value_begin = m_value_ends[ix];
+	}
+}
+
+bool decodeBinaryClassAd(const char * body, size_t len, ClassAd & ad,
+	BinaryClassAdNames & names, bool use_cache, int & secrets)
+{
+	const char * p = body;
+	const char * end = body + len;
+	unsigned long long count, num_secrets;
+	if (len < 2 || (unsigned char)p[0] != BINARY_CLASSAD_VERSION) {
+		return false;
+	}
+	int flags = (unsigned char)p[1];
+	p += 2;
+	if ( ! getVarint(p, end, count) || ! getVarint(p, end, num_secrets) || num_secrets > INT_MAX) {
+		return false;
+	}
+	secrets = (int)num_secrets;
+
+	if (flags & BINARY_CLASSAD_NEW_NAMES) {
+		names.resetIncoming();
+	}
+
+	use_cache = use_cache && ClassAdGetExpressionCaching();
+
+	std::string name;
+	std::string key;
+	for (unsigned long long ix = 0; ix < count; ++ix) {
+		unsigned long long token;
+		if ( ! getVarint(p, end, token)) {
+			return false;
+		}
+		if (token) {
+			const std::string * known = names.lookup((unsigned int)MIN(token, (unsigned long long)UINT_MAX));
+			if ( ! known) {
+				dprintf(D_FULLDEBUG, "getClassAd binary ad has unknown attribute token %llu\n", token);
+				return false;
+			}
+			name = *known;
+		} else {
+			if ( ! getString(p, end, name) || name.empty()) {
+				return false;
+			}
+			names.incoming(name);
+		}
+
+		if (p >= end) {
+			return false;
+		}
+		int tag = (unsigned char)*p;
+		bool inserted = false;
+		if (tag < TAG_ATTR) {
+			// literals are as small as envelopes, so there is nothing to gain by caching them
+			++p;
+			Literal * lit = decodeLiteral(tag, p, end);
+			inserted = lit && ad.InsertLiteral(name, lit);
+		} else if (use_cache && tag != TAG_LIST && tag != TAG_AD && name[0] != '\'') {
+			// cached by the encoded form, which a text value can never start like
+			const char * start = p;
+			if ( ! skipExpr(p, end, 0)) {
+				return false;
+			}
+			key.assign(1, '\x01');
+			key.append(start, p - start);
+			CachedExprEnvelope * env = CachedExprEnvelope::check_hit(name, key);
+			if (env) {
+				inserted = ad.Insert(name, env);
+			} else {
+				const char * q = start;
+				ExprTree * tree = decodeBinaryExpr(q, p);
+				if (tree) {
+					inserted = ad.Insert(name, CachedExprEnvelope::cache(name, tree, key));
+				}
+			}
+		} else {
+			ExprTree * tree = decodeBinaryExpr(p, end);
+			inserted = tree && ad.Insert(name, tree);
+		}
+		if ( ! inserted) {
+			dprintf(D_FULLDEBUG, "getClassAd FAILED to insert binary attribute %s\n", name.c_str());
+			return false;
+		}
+	}
+	return p == end;
+}
@@ -0,0 +1,134 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _CLASSAD_BINARY_H_
+#define _CLASSAD_BINARY_H_
+
+/*
+  A binary form of ClassAds for CEDAR.  putClassAd() sends it instead of
+  "Attr = expr" lines when given PUT_CLASSAD_BINARY, which the caller
+  must only give when the peer has said it can read the binary form (a
+  query ad does so with ATTR_ACCEPT_BINARY_CLASSADS).  getClassAd() and
+  friends read either form, so the receiver needs no option.  Values are sent as trees rather than text, so
+  the receiver builds them without lexing or parsing anything.
+
+  Where the text form has its count of expressions, the binary form has
+  BINARY_CLASSAD_MARKER, then an int length and that many bytes of body:
+
+    version   byte, BINARY_CLASSAD_VERSION
+    flags     byte, BINARY_CLASSAD_NEW_NAMES if the sender's name table was empty
+    count     varint, the number of attributes in the body
+    secrets   varint, the number of private attributes that follow the body
+    then count times:
+      name    varint token, or 0 followed by the name as a varint length and bytes
+      value   a tagged expression tree, see classad_binary.cpp
+
+  Names are given tokens from 1 up in the order they are first sent on a
+  connection, so a name is spelled out once per connection rather than once
+  per ad; each Stream keeps a BinaryClassAdNames for each direction.  The
+  private attributes follow the body as text lines, sent the way the text
+  form sends them so that they are encrypted the same way.  There is no
+  MyType/TargetType trailer.
+*/
+
+#include "classad/classad_distribution.h"
+
+#include <unordered_map>
+
+const int BINARY_CLASSAD_MARKER = -0x43414442; // never a count of expressions
+const unsigned char BINARY_CLASSAD_VERSION = 1;
+const unsigned char BINARY_CLASSAD_NEW_NAMES = 0x01;
+
+/** The attribute-name tokens of one connection, see Stream::binary_classad_names().
+	A sender and receiver that start out empty together stay in step as
+	long as every ad sent is read.
+*/
+class BinaryClassAdNames {
+public:
+	BinaryClassAdNames() {}
+
+	void clear();
+
+		/** The token for name on the way out, or 0 if it must be spelled out.
+			A name that is spelled out is given the next token, if there is room.
+		*/
+	unsigned int outgoing(const std::string & name);
+	bool sentNone() const { return m_out.empty(); }
+
+		/// Forget the names that came in, when the sender starts over.
+	void resetIncoming() { m_in.clear(); }
+		/// Remember a name that was spelled out on the way in.
+	void incoming(const std::string & name);
+		/// The name for a token on the way in, or NULL if it was never given.
+	const std::string * lookup(unsigned int token) const;
+
+	std::string buffer; // for the body of the ad being sent or received
+
+private:
+	static const size_t MAX_NAMES = 4096; // per direction; names past this are always spelled out
+	std::unordered_map<std::string, unsigned int> m_out;
+	std::vector<std::string> m_in;
+
+	BinaryClassAdNames(const BinaryClassAdNames &);
+	BinaryClassAdNames & operator=(const BinaryClassAdNames &);
+};
+
+/** The attributes of an ad in binary form, gathered the way putClassAd()
+	gathers them, before the names are turned into tokens for a connection.
+	The values don't depend on the connection, so this can be built ahead of
+	time or on another thread, see PreparedClassAd.
+*/
+class BinaryClassAd {
+public:
+	BinaryClassAd() {}
+
+	void clear();
+	void add(const std::string & attr, const classad::ExprTree * expr);
+		/// A private attribute, as the "Attr = expr" line that follows the body.
+	void addSecret(const std::string & line) { m_secrets.push_back(line); }
+
+	size_t count() const { return m_name_ends.size(); }
+	const std::vector<std::string> & secrets() const { return m_secrets; }
+
+		/// Write the body to send, giving names tokens from names.
+	void makeBody(std::string & body, BinaryClassAdNames & names) const;
+
+private:
+	std::string m_names;              // each name followed by a NUL
+	std::vector<size_t> m_name_ends;  // offset of the NUL after each name
+	std::string m_values;             // the encoded values, back to back
+	std::vector<size_t> m_value_ends; // offset just past each value
+	std::vector<std::string> m_secrets;
+};
+
+/** Insert the attributes of a body written by BinaryClassAd::makeBody() into ad.
+	@param use_cache insert expressions through the ClassAd cache, as getClassAdEx() does
+	@param secrets set to the number of private attributes that follow the body
+	@return false if the body is malformed
+*/
+bool decodeBinaryClassAd(const char * body, size_t len, classad::ClassAd & ad,
+	BinaryClassAdNames & names, bool use_cache, int & secrets);
+
+/// Append the binary form of an expression to out.
+void encodeBinaryExpr(std::string & out, const classad::ExprTree * expr);
+
+/// Decode one expression written by encodeBinaryExpr(), advancing p.  Returns NULL if it is malformed.
+classad::ExprTree * decodeBinaryExpr(const char * & p, const char * end);
+
+#endif
@@ -29,14 +29,20 @@ using namespace std;
 
 #include "classad/classad_distribution.h"
 #include "classad_oldnew.h"
+#include "classad_unparse_pipeline.h"
 #include "compat_classad.h"
 
-// local helper functions, options are one or more of PUT_CLASSAD_* flags
-int _putClassAd(Stream *sock, const classad::ClassAd& ad, int options,
-	const classad::References *encrypted_attrs);
-int _putClassAd(Stream *sock, const classad::ClassAd& ad, int options,
-	const classad::References &whitelist, const classad::References *encrypted_attrs);
+// local helper functions, options are one or more of PUT_CLASSAD_* flags.
+// These format the ad into a Sink, which is either a Stream or a PreparedClassAd.
+template <class Sink> static int _putClassAd(Sink *sock, const classad::ClassAd& ad, int options,
+	const classad::References *encrypted_attrs, ClassAdUnparseCache *cache);
+template <class Sink> static int _putClassAd(Sink *sock, const classad::ClassAd& ad, int options,
+	const classad::References &whitelist, const classad::References *encrypted_attrs, ClassAdUnparseCache *cache);
 int _mergeStringListIntoWhitelist(StringList & list_in, classad::References & whitelist_out);
+static bool _getBinaryClassAd(Stream *sock, classad::ClassAd& ad, bool use_cache);
+static void _gatherBinaryClassAd(BinaryClassAd &bin, const classad::ClassAd& ad, int options,
+	const classad::References *whitelist, const classad::References *encrypted_attrs);
+static int _putBinaryClassAd(Stream *sock, const BinaryClassAd &bin);
 
 
 static bool publish_server_timeMangled = false;
@@ -73,6 +79,9 @@ bool getClassAd( Stream *sock, classad::ClassAd& ad )
 		dprintf(D_FULLDEBUG, "FAILED to get number of expressions.\n");
  		return false;
 	}
+	if (numExprs == BINARY_CLASSAD_MARKER) {
+		return _getBinaryClassAd(sock, ad, true);
+	}
 
 	// at least numExprs are coming, but we may add
 	// my, target, and a couple extra right away
@@ -250,6 +259,9 @@ bool getClassAdEx( Stream *sock, classad::ClassAd& ad, int options)
 	if( !sock->code( numExprs ) ) {
 		return false;
 	}
+	if (numExprs == BINARY_CLASSAD_MARKER) {
+		return _getBinaryClassAd(sock, ad, use_cache);
+	}
 
 	// at least numExprs are coming, but we may add
 	// my, target, and a couple extra right away
@@ -401,6 +413,51 @@ bool getClassAdEx( Stream *sock, classad::ClassAd& ad, int options)
 	return true;
 }
 
+// the rest of an ad that began with BINARY_CLASSAD_MARKER rather than a count of expressions
+static bool _getBinaryClassAd(Stream *sock, classad::ClassAd& ad, bool use_cache)
+{
+	// no ad is this big; don't let a bad length make us try to allocate it
+	const int max_body = 256 * 1024 * 1024;
+
+	int len = 0;
+	if ( ! sock->code(len) || len < 2 || len > max_body) {
+		dprintf(D_FULLDEBUG, "getClassAd FAILED to get binary ad length (%d)\n", len);
+		return false;
+	}
+	BinaryClassAdNames & names = sock->binary_classad_names();
+	names.buffer.resize(len);
+	if (sock->get_bytes(&names.buffer[0], len) != len) {
+		dprintf(D_FULLDEBUG, "getClassAd FAILED to get binary ad\n");
+		return false;
+	}
+
+	int secrets = 0;
+	if ( ! decodeBinaryClassAd(names.buffer.data(), len, ad, names, use_cache, secrets)) {
+		dprintf(D_ALWAYS, "getClassAd FAILED to decode binary ad from %s\n", sock->peer_description());
+		return false;
+	}
+
+	// the private attributes follow as text, as putClassAd() sends them
+	for (int ii = 0; ii < secrets; ++ii) {
+		const char *strptr = NULL;
+		int cb;
+		if ( ! sock->get_string_ptr(strptr, cb) || ! strptr) {
+			return false;
+		}
+		if (strcmp(strptr, SECRET_MARKER) == 0) {
+			if ( ! sock->get_secret(strptr, cb) || ! strptr) {
+				dprintf(D_FULLDEBUG, "getClassAd Failed to read encrypted ClassAd expression.\n");
+				return false;
+			}
+		}
+		if ( ! InsertLongFormAttrValue(ad, strptr, use_cache)) {
+			dprintf(D_FULLDEBUG, "getClassAd FAILED to insert secret\n");
+			return false;
+		}
+	}
+	return true;
+}
+
 
 int getClassAdNonblocking( ReliSock *sock, classad::ClassAd& ad )
 {
@@ -436,6 +493,9 @@ getClassAdNoTypes( Stream *sock, classad::ClassAd& ad )
 	if( !sock->code( numExprs ) ) {
  		return false;
 	}
+	if (numExprs == BINARY_CLASSAD_MARKER) {
+		return _getBinaryClassAd(sock, ad, false);
+	}
 
 		// pack exprs into classad
 	buffer = "[";
@@ -541,7 +601,26 @@ int mergeProjectionFromQueryAd(classad::ClassAd & queryAd, const char * attr_pro
 int putClassAd ( Stream *sock, const classad::ClassAd& ad )
 {
 	int options = 0;
-	return _putClassAd(sock, ad, options, nullptr);
+	return _putClassAd(sock, ad, options, nullptr, nullptr);
+}
+
+// add the attributes in whitelist that ad has, and the attributes they refer to, to expanded_whitelist
+static void _expandWhitelist(const classad::ClassAd& ad, const classad::References &whitelist, classad::References &expanded_whitelist)
+{
+	// Jaime made changes to the core classad lib that make this unneeded...
+	//ad.InsertAttr("MY","SELF");
+	for (classad::References::const_iterator attr = whitelist.begin(); attr != whitelist.end(); ++attr) {
+		ExprTree * tree = ad.Lookup(*attr);
+		if (tree) {
+			expanded_whitelist.insert(*attr); // the node exists, so add it to the final whitelist
+			if (tree->GetKind() != ExprTree::LITERAL_NODE) {
+				ad.GetInternalReferences(tree, expanded_whitelist, false);
+			}
+		}
+	}
+	//ad.Delete("MY");
+	//classad::References::iterator my = expanded_whitelist.find("MY");
+	//if (my != expanded_whitelist.end()) { expanded_whitelist.erase(my); }
 }
 
 int putClassAd (Stream *sock, const classad::ClassAd& ad, int options, const classad::References * whitelist /*=nullptr*/, const classad::References * encrypted_attrs /*=nullptr*/)
@@ -551,49 +630,158 @@ int putClassAd (Stream *sock, const classad::ClassAd& ad, int options, const cla
 
 	bool expand_whitelist = ! (options & PUT_CLASSAD_NO_EXPAND_WHITELIST);
 	if (whitelist && expand_whitelist) {
-		// Jaime made changes to the core classad lib that make this unneeded...
-		//ad.InsertAttr("MY","SELF");
-		for (classad::References::const_iterator attr = whitelist->begin(); attr != whitelist->end(); ++attr) {
-			ExprTree * tree = ad.Lookup(*attr);
-			if (tree) {
-				expanded_whitelist.insert(*attr); // the node exists, so add it to the final whitelist
-				if (tree->GetKind() != ExprTree::LITERAL_NODE) {
-					ad.GetInternalReferences(tree, expanded_whitelist, false);
-				}
-			}
-		}
-		//ad.Delete("MY");
-		//classad::References::iterator my = expanded_whitelist.find("MY");
-		//if (my != expanded_whitelist.end()) { expanded_whitelist.erase(my); }
+		_expandWhitelist(ad, *whitelist, expanded_whitelist);
 		whitelist = &expanded_whitelist;
 	}
 
+	BinaryClassAd bin;
+	bool binary = (options & PUT_CLASSAD_BINARY) && canPutBinaryClassAd(sock);
+	if (binary) {
+		_gatherBinaryClassAd(bin, ad, options, whitelist, encrypted_attrs);
+	}
+
 	bool non_blocking = (options & PUT_CLASSAD_NON_BLOCKING) != 0;
 	ReliSock* rsock = static_cast<ReliSock*>(sock);
 	if (non_blocking && rsock)
 	{
 		BlockingModeGuard guard(rsock, true);
-		if (whitelist) {
-			retval = _putClassAd(sock, ad, options, *whitelist, encrypted_attrs);
+		if (binary) {
+			retval = _putBinaryClassAd(sock, bin);
+		} else if (whitelist) {
+			retval = _putClassAd(sock, ad, options, *whitelist, encrypted_attrs, nullptr);
 		} else {
-			retval = _putClassAd(sock, ad, options, encrypted_attrs);
+			retval = _putClassAd(sock, ad, options, encrypted_attrs, nullptr);
 		}
 		bool backlog = rsock->clear_backlog_flag();
 		if (retval && backlog) { retval = 2; }
 	}
 	else // normal blocking mode put
 	{
-		if (whitelist) {
-			retval = _putClassAd(sock, ad, options, *whitelist, encrypted_attrs);
+		if (binary) {
+			retval = _putBinaryClassAd(sock, bin);
+		} else if (whitelist) {
+			retval = _putClassAd(sock, ad, options, *whitelist, encrypted_attrs, nullptr);
 		} else {
-			retval = _putClassAd(sock, ad, options, encrypted_attrs);
+			retval = _putClassAd(sock, ad, options, encrypted_attrs, nullptr);
 		}
 	}
 	return retval;
 }
 
+bool PreparedClassAd::prepare(const classad::ClassAd& ad, int options, const classad::References * whitelist /*=nullptr*/,
+	const classad::References * encrypted_attrs /*=nullptr*/, ClassAdUnparseCache * cache /*=nullptr*/)
+{
+	clear();
+
+	classad::References expanded_whitelist;
+	if (whitelist && ! (options & PUT_CLASSAD_NO_EXPAND_WHITELIST)) {
+		_expandWhitelist(ad, *whitelist, expanded_whitelist);
+		whitelist = &expanded_whitelist;
+	}
+
+	if (options & PUT_CLASSAD_BINARY) {
+		m_is_binary = true;
+		_gatherBinaryClassAd(m_binary, ad, options, whitelist, encrypted_attrs);
+		return true;
+	}
+	if (whitelist) {
+		return _putClassAd(this, ad, options, *whitelist, encrypted_attrs, cache);
+	}
+	return _putClassAd(this, ad, options, encrypted_attrs, cache);
+}
+
+int PreparedClassAd::send(Stream *sock) const
+{
+	if (m_is_binary) {
+		return _putBinaryClassAd(sock, m_binary);
+	}
+
+	sock->encode();
+	int numExprs = m_numExprs;
+	if ( ! sock->code(numExprs)) {
+		return false;
+	}
+
+	bool crypto_is_noop = sock->prepare_crypto_for_secret_is_noop();
+	size_t next_secret = 0;
+	size_t begin = 0;
+	for (size_t ix = 0; ix < m_ends.size(); ++ix) {
+		const char * line = m_lines.data() + begin;
+		bool secret = next_secret < m_secrets.size() && m_secrets[next_secret] == ix;
+		if (secret) { ++next_secret; }
+
+		if (secret && ! crypto_is_noop) {
+			if ( ! sock->put(SECRET_MARKER) || ! sock->put_secret(line)) {
+				return false;
+			}
+		} else if ( ! sock->put(line, (int)(m_ends[ix] - begin) + 1)) {
+			return false;
+		}
+		begin = m_ends[ix] + 1;
+	}
+	return true;
+}
+
+void PreparedClassAd::clear()
+{
+	m_lines.clear();
+	m_ends.clear();
+	m_secrets.clear();
+	m_numExprs = 0;
+	m_binary.clear();
+	m_is_binary = false;
+}
+
+int PreparedClassAd::put(const char * line)
+{
+	m_lines.append(line ? line : "");
+	m_ends.push_back(m_lines.size());
+	m_lines += '\0';
+	return true;
+}
+
+int PreparedClassAd::put(const std::string & line)
+{
+	m_lines.append(line);
+	m_ends.push_back(m_lines.size());
+	m_lines += '\0';
+	return true;
+}
+
+int PreparedClassAd::put_secret(const char * line)
+{
+	m_secrets.push_back(m_ends.size());
+	return put(line);
+}
+
+// send one private attribute, marked so that the receiver knows to decrypt it
+static int _putSecretLine(Stream *sock, const std::string & line)
+{
+	if ( ! sock->put(SECRET_MARKER)) {
+		return false;
+	}
+	return sock->put_secret(line.c_str());
+}
+
+// a PreparedClassAd adds the marker when it is sent, if the stream encrypts secrets
+static int _putSecretLine(PreparedClassAd *prepared, const std::string & line)
+{
+	return prepared->put_secret(line.c_str());
+}
+
+// unparse the value of an attribute, through the cache if we have one
+static void _unparseAttrValue(classad::ClassAdUnParser & unp, std::string & buf, const classad::ExprTree * expr, ClassAdUnparseCache * cache)
+{
+	if (cache) {
+		cache->Unparse(unp, buf, expr);
+	} else {
+		unp.Unparse(buf, expr);
+	}
+}
+
 // helper function for _putClassAd
-static int _putClassAdTrailingInfo(Stream *sock, const classad::ClassAd& /* ad */, bool send_server_time, bool excludeTypes)
+template <class Sink>
+static int _putClassAdTrailingInfo(Sink *sock, const classad::ClassAd& /* ad */, bool send_server_time, bool excludeTypes)
 {
     if (send_server_time)
     {
@@ -625,8 +813,9 @@ static int _putClassAdTrailingInfo(Stream *sock, const classad::ClassAd& /* ad *
 	return true;
 }
 
-int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options,
-	const classad::References *encrypted_attrs)
+template <class Sink>
+static int _putClassAd( Sink *sock, const classad::ClassAd& ad, int options,
+	const classad::References *encrypted_attrs, ClassAdUnparseCache *cache)
 {
 	bool excludeTypes = (options & PUT_CLASSAD_NO_TYPES) == PUT_CLASSAD_NO_TYPES;
 	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
@@ -729,15 +918,13 @@ int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options,
 
 			buf = attr;
 			buf += " = ";
-			unp.Unparse( buf, expr );
+			_unparseAttrValue( unp, buf, expr, cache );
 
 			if( ! crypto_is_noop && private_count &&
 				(ClassAdAttributeIsPrivate(attr) ||
 				(encrypted_attrs && (encrypted_attrs->find(attr) != encrypted_attrs->end()))) )
 			{
-				sock->put(SECRET_MARKER);
-
-				sock->put_secret(buf.c_str());
+				_putSecretLine(sock, buf);
 			}
 			else if (!sock->put(buf) ){
 				return false;
@@ -748,7 +935,8 @@ int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options,
 	return _putClassAdTrailingInfo(sock, ad, send_server_time, excludeTypes);
 }
 
-int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options, const classad::References &whitelist, const classad::References *encrypted_attrs)
+template <class Sink>
+static int _putClassAd( Sink *sock, const classad::ClassAd& ad, int options, const classad::References &whitelist, const classad::References *encrypted_attrs, ClassAdUnparseCache *cache)
 {
 	bool excludeTypes = (options & PUT_CLASSAD_NO_TYPES) == PUT_CLASSAD_NO_TYPES;
 	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
@@ -798,16 +986,13 @@ int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options, const cl
 		classad::ExprTree const *expr = ad.Lookup(*attr);
 		buf = *attr;
 		buf += " = ";
-		unp.Unparse( buf, expr );
+		_unparseAttrValue( unp, buf, expr, cache );
 
 		if ( ! crypto_is_noop &&
 			(ClassAdAttributeIsPrivate(*attr) ||
 			(encrypted_attrs && (encrypted_attrs->find(*attr) != encrypted_attrs->end())))
 		) {
-			if (!sock->put(SECRET_MARKER)) {
-				return false;
-			}
-			if (!sock->put_secret(buf.c_str())) {
+			if ( ! _putSecretLine(sock, buf)) {
 				return false;
 			}
 		}
@@ -818,3 +1003,97 @@ int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options, const cl
 
 	return _putClassAdTrailingInfo(sock, ad, send_server_time, excludeTypes);
 }
+
+bool canPutBinaryClassAd(Stream *sock)
+{
+	// the name tokens assume that every ad is read, in the order sent, which only a ReliSock promises
+	return sock && sock->type() == Stream::reli_sock;
+}
+
+static bool _isPrivateAttr(const std::string &attr, const classad::References *encrypted_attrs)
+{
+	return ClassAdAttributeIsPrivate(attr) ||
+		(encrypted_attrs && encrypted_attrs->find(attr) != encrypted_attrs->end());
+}
+
+// helper function for _gatherBinaryClassAd
+static void _gatherBinaryAttr(BinaryClassAd &bin, const std::string &attr, const classad::ExprTree *expr,
+	bool exclude_private, const classad::References *encrypted_attrs, classad::ClassAdUnParser &unp)
+{
+	if ( ! _isPrivateAttr(attr, encrypted_attrs)) {
+		bin.add(attr, expr);
+	} else if ( ! exclude_private) {
+		std::string line = attr;
+		line += " = ";
+		unp.Unparse(line, expr);
+		bin.addSecret(line);
+	}
+}
+
+// Gather the attributes that _putClassAd() would send into bin.
+// The whitelist, if any, has already been expanded.
+static void _gatherBinaryClassAd(BinaryClassAd &bin, const classad::ClassAd& ad, int options,
+	const classad::References *whitelist, const classad::References *encrypted_attrs)
+{
+	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
+	bool send_server_time = publish_server_timeMangled;
+
+	classad::ClassAdUnParser unp; // for private attributes, which are sent as text
+	unp.SetOldClassAd( true, true );
+
+	if (whitelist) {
+		for (classad::References::const_iterator attr = whitelist->begin(); attr != whitelist->end(); ++attr) {
+			if (send_server_time && strcasecmp(attr->c_str(), ATTR_SERVER_TIME) == 0) {
+				continue;
+			}
+			classad::ExprTree const *expr = ad.Lookup(*attr);
+			if (expr) {
+				_gatherBinaryAttr(bin, *attr, expr, exclude_private, encrypted_attrs, unp);
+			}
+		}
+	} else {
+		// chained attributes first, so that the ad's own attributes override them
+		const classad::ClassAd *chainedAd = ad.GetChainedParentAd();
+		if (chainedAd) {
+			for (classad::AttrList::const_iterator itor = chainedAd->begin(); itor != chainedAd->end(); ++itor) {
+				_gatherBinaryAttr(bin, itor->first, itor->second, exclude_private, encrypted_attrs, unp);
+			}
+		}
+		for (classad::AttrList::const_iterator itor = ad.begin(); itor != ad.end(); ++itor) {
+			_gatherBinaryAttr(bin, itor->first, itor->second, exclude_private, encrypted_attrs, unp);
+		}
+	}
+
+	if (send_server_time) {
+		classad::Literal *now = classad::Literal::MakeLong(time(NULL));
+		bin.add(ATTR_SERVER_TIME, now);
+		delete now;
+	}
+}
+
+static int _putBinaryClassAd(Stream *sock, const BinaryClassAd &bin)
+{
+	BinaryClassAdNames & names = sock->binary_classad_names();
+	bin.makeBody(names.buffer, names);
+
+	sock->encode();
+	int marker = BINARY_CLASSAD_MARKER;
+	int len = (int)names.buffer.size();
+	if ( ! sock->code(marker) || ! sock->code(len) ||
+		sock->put_bytes(names.buffer.data(), len) != len) {
+		return false;
+	}
+
+	bool crypto_is_noop = sock->prepare_crypto_for_secret_is_noop();
+	const std::vector<std::string> & secrets = bin.secrets();
+	for (size_t ix = 0; ix < secrets.size(); ++ix) {
+		if (crypto_is_noop) {
+			if ( ! sock->put(secrets[ix])) {
+				return false;
+			}
+		} else if ( ! _putSecretLine(sock, secrets[ix])) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -25,6 +25,7 @@
 */
 
 #include "classad/classad_distribution.h"
+#include "classad_binary.h"
 
 // Forward dec'l
 class ReliSock;
@@ -80,6 +81,61 @@ int putClassAd (Stream *sock, const classad::ClassAd& ad, int options,
 #define PUT_CLASSAD_NO_TYPES            0x02 // exclude MyType and TargetType from output.
 #define PUT_CLASSAD_NON_BLOCKING        0x04 // use non-blocking sematics. returns 2 of this would have blocked.
 #define PUT_CLASSAD_NO_EXPAND_WHITELIST 0x08 // use the whitelist argument as-is, (default is to expand internal references before using it)
+#define PUT_CLASSAD_BINARY              0x10 // send the binary form (see classad_binary.h) if canPutBinaryClassAd(sock); the caller must know the peer reads it
+
+/** Returns true if binary ClassAds can be sent on sock, so that putClassAd()
+ *  with PUT_CLASSAD_BINARY will send them.  Whether the peer can read them is
+ *  not something the stream knows; the peer must have said so, for instance
+ *  with ATTR_ACCEPT_BINARY_CLASSADS in its query ad.
+ */
+bool canPutBinaryClassAd(Stream *sock);
+
+class ClassAdUnparseCache;
+
+/** A ClassAd formatted the way putClassAd() would send it, so that the
+ *  unparsing can be done ahead of time - or on another thread - and the
+ *  ad sent later with nothing but socket writes.
+ *  See ClassAdUnparsePipeline in classad_unparse_pipeline.h.
+ */
+class PreparedClassAd {
+public:
+	PreparedClassAd() : m_numExprs(0), m_is_binary(false) {}
+
+	/** Format the ad as putClassAd(sock, ad, options, whitelist, encrypted_attrs) would.
+	 *  With PUT_CLASSAD_BINARY, the ad is always put in binary form, so the caller
+	 *  must check canPutBinaryClassAd() for the stream it will be sent on.
+	 * @param cache if not NULL, expressions shared through the ClassAd cache are unparsed once and remembered there
+	 * @returns false if the ad could not be formatted
+	 */
+	bool prepare(const classad::ClassAd& ad, int options,
+		const classad::References * whitelist = nullptr,
+		const classad::References * encrypted_attrs = nullptr,
+		ClassAdUnparseCache * cache = nullptr);
+
+	/** Send the formatted ad, blocking until it has been written.
+	 *  Private attributes are encrypted if the stream can encrypt them, as with putClassAd().
+	 */
+	int send(Stream *sock) const;
+
+	void clear();
+	size_t size() const { return m_lines.size(); }
+
+	// the Stream methods that putClassAd() formats the ad with
+	void encode() {}
+	int code(int & numExprs) { m_numExprs = numExprs; return true; }
+	bool prepare_crypto_for_secret_is_noop() const { return false; }
+	int put(const char * line);
+	int put(const std::string & line);
+	int put_secret(const char * line);
+
+private:
+	std::string m_lines;           // each line followed by a NUL
+	std::vector<size_t> m_ends;    // offset of the NUL after each line
+	std::vector<size_t> m_secrets; // indexes of the lines to send with put_secret()
+	int m_numExprs;
+	BinaryClassAd m_binary;        // used instead of the above with PUT_CLASSAD_BINARY
+	bool m_is_binary;
+};
 
 // fetch the given attribute from the queryAd and convert it into a set of attributes
 //   the attribute should be a string value containing a comma and/or space separated list of attributes (like StringList)
@@ -0,0 +1,305 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "stream.h"
+#include "classad_unparse_pipeline.h"
+#include "classad/classadCache.h"
+
+#include <system_error>
+
+// Ads per chunk handed to a worker.  Big enough that the handoff is cheap
+// next to the unparsing, small enough that the first ads go out quickly.
+static const size_t CHUNK_SIZE = 64;
+
+void
+ClassAdUnparseCache::Unparse(classad::ClassAdUnParser & unp, std::string & buffer, const classad::ExprTree * expr)
+{
+	if ( ! expr || expr->GetKind() != classad::ExprTree::EXPR_ENVELOPE) {
+		unp.Unparse(buffer, expr);
+		return;
+	}
+
+	// every envelope for the same cache entry returns the same string here,
+	// and it lives exactly as long as the entry does
+	const void * key = &static_cast<const classad::CachedExprEnvelope *>(expr)->get_unparsed_str();
+	Shard & shard = m_shards[(std::hash<const void *>()(key) >> 4) % NUM_SHARDS];
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		auto it = shard.text.find(key);
+		if (it != shard.text.end()) {
+			buffer += it->second;
+			++m_hits;
+			return;
+		}
+	}
+
+	// two threads may both miss on the same entry; they unparse it the same way
+	size_t start = buffer.size();
+	unp.Unparse(buffer, expr);
+	++m_misses;
+	std::lock_guard<std::mutex> guard(shard.lock);
+	shard.text.insert(std::make_pair(key, buffer.substr(start)));
+}
+
+ClassAdUnparsePipeline::ClassAdUnparsePipeline(Stream * sock, int options, int num_threads, bool code_more /*=false*/)
+	: m_sock(sock)
+	, m_options(options & ~PUT_CLASSAD_NON_BLOCKING)
+	, m_num_threads(MAX(num_threads, 0))
+	, m_code_more(code_more)
+	, m_failed(false)
+	, m_shutdown(false)
+{
+	// PreparedClassAd takes PUT_CLASSAD_BINARY as an order, not a request
+	if ( ! canPutBinaryClassAd(sock)) {
+		m_options &= ~PUT_CLASSAD_BINARY;
+	}
+}
+
+ClassAdUnparsePipeline::~ClassAdUnparsePipeline()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_shutdown = true;
+		m_todo.clear();
+	}
+	m_work_ready.notify_all();
+	for (auto it = m_threads.begin(); it != m_threads.end(); ++it) {
+		it->join();
+	}
+
+	// free the temporary ads of anything we didn't get to send
+	m_failed = true;
+	while ( ! m_in_flight.empty()) {
+		sendChunk(*m_in_flight.front());
+		m_in_flight.pop_front();
+	}
+	if (m_filling) {
+		sendChunk(*m_filling);
+	}
+}
+
+bool
+ClassAdUnparsePipeline::put(const classad::ClassAd & ad, const std::shared_ptr<const classad::References> & whitelist)
+{
+	return queue(&ad, whitelist, false);
+}
+
+bool
+ClassAdUnparsePipeline::putTemporary(classad::ClassAd * ad, const std::shared_ptr<const classad::References> & whitelist)
+{
+	return queue(ad, whitelist, true);
+}
+
+bool
+ClassAdUnparsePipeline::queue(const classad::ClassAd * ad, const std::shared_ptr<const classad::References> & whitelist, bool temporary)
+{
+	if (m_num_threads == 0) {
+		int more = 1;
+		if ( ! m_failed) {
+			m_scratch.prepare(*ad, m_options, whitelist.get(), nullptr, &m_cache);
+			if ((m_code_more && ! m_sock->code(more)) || ! m_scratch.send(m_sock)) {
+				m_failed = true;
+			}
+		}
+		if (temporary) {
+			classad::ClassAd * tmp = const_cast<classad::ClassAd *>(ad);
+			tmp->Unchain();
+			delete tmp;
+		}
+		return ! m_failed;
+	}
+
+	if ( ! m_filling) {
+		if ( ! m_spare.empty()) {
+			m_filling = std::move(m_spare.back());
+			m_spare.pop_back();
+		} else {
+			m_filling.reset(new Chunk());
+			m_filling->items.resize(CHUNK_SIZE);
+		}
+	}
+	Item & item = m_filling->items[m_filling->count++];
+	item.ad = ad;
+	item.whitelist = whitelist;
+	item.temporary = temporary;
+
+	if (m_filling->count >= CHUNK_SIZE) {
+		submit();
+		return sendFormatted(false);
+	}
+	return ! m_failed;
+}
+
+// Hand the chunk being filled to the workers, starting them if need be.
+void
+ClassAdUnparsePipeline::submit()
+{
+	if ( ! m_filling || ! m_filling->count) {
+		return;
+	}
+	if (m_threads.empty()) {
+		startThreads();
+	}
+	Chunk * chunk = m_filling.get();
+	bool no_workers = m_threads.empty();
+	if (no_workers) {
+		format(*chunk);
+		chunk->formatted = true;
+	}
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_in_flight.push_back(std::move(m_filling));
+		if ( ! no_workers) {
+			m_todo.push_back(chunk);
+		}
+	}
+	m_work_ready.notify_one();
+}
+
+bool
+ClassAdUnparsePipeline::flush()
+{
+	if (m_num_threads == 0) {
+		return ! m_failed;
+	}
+	if (m_threads.empty() && m_filling && m_filling->count) {
+		// too few ads to be worth starting threads for
+		format(*m_filling);
+		m_filling->formatted = true;
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_in_flight.push_back(std::move(m_filling));
+	} else {
+		submit();
+	}
+	return sendFormatted(true);
+}
+
+// Send the formatted chunks at the head of the line.  If wait is true, send
+// everything in flight, waiting for the workers as needed; otherwise only
+// wait when there are too many chunks in flight, which bounds the memory
+// used by ads that are formatted but not yet sent.
+bool
+ClassAdUnparsePipeline::sendFormatted(bool wait)
+{
+	const size_t max_in_flight = 2 * m_num_threads + 1;
+	for (;;) {
+		std::unique_ptr<Chunk> chunk;
+		{
+			std::unique_lock<std::mutex> guard(m_lock);
+			if (m_in_flight.empty()) {
+				break;
+			}
+			bool must_wait = wait || m_in_flight.size() > max_in_flight;
+			while ( ! m_in_flight.front()->formatted) {
+				if ( ! must_wait) {
+					return ! m_failed;
+				}
+				m_chunk_formatted.wait(guard);
+			}
+			chunk = std::move(m_in_flight.front());
+			m_in_flight.pop_front();
+		}
+		sendChunk(*chunk);
+		m_spare.push_back(std::move(chunk));
+	}
+	return ! m_failed;
+}
+
+// Send the ads in the chunk, unless sending has already failed, and reset
+// it for reuse.  Temporary ads are deleted either way.
+bool
+ClassAdUnparsePipeline::sendChunk(Chunk & chunk)
+{
+	for (size_t ix = 0; ix < chunk.count; ++ix) {
+		Item & item = chunk.items[ix];
+		if ( ! m_failed) {
+			int more = 1;
+			if ((m_code_more && ! m_sock->code(more)) || ! item.prepared.send(m_sock)) {
+				m_failed = true;
+			}
+		}
+		if (item.temporary) {
+			classad::ClassAd * tmp = const_cast<classad::ClassAd *>(item.ad);
+			tmp->Unchain();
+			delete tmp;
+		}
+		item.ad = NULL;
+		item.whitelist.reset();
+		item.temporary = false;
+		item.prepared.clear();
+	}
+	chunk.count = 0;
+	chunk.formatted = false;
+	return ! m_failed;
+}
+
+void
+ClassAdUnparsePipeline::format(Chunk & chunk)
+{
+	for (size_t ix = 0; ix < chunk.count; ++ix) {
+		Item & item = chunk.items[ix];
+		item.prepared.prepare(*item.ad, m_options, item.whitelist.get(), nullptr, &m_cache);
+	}
+}
+
+void
+ClassAdUnparsePipeline::startThreads()
+{
+#ifndef WIN32
+	// signals are for the main thread; the workers inherit this mask
+	sigset_t mask, omask;
+	sigfillset(&mask);
+	pthread_sigmask(SIG_SETMASK, &mask, &omask);
+#endif
+	for (int ix = 0; ix < m_num_threads; ++ix) {
+		try {
+			m_threads.push_back(std::thread(&ClassAdUnparsePipeline::worker, this));
+		} catch (std::system_error &) {
+			// make do with the ones we have; with none, submit() unparses on this thread
+			break;
+		}
+	}
+#ifndef WIN32
+	pthread_sigmask(SIG_SETMASK, &omask, NULL);
+#endif
+}
+
+void
+ClassAdUnparsePipeline::worker()
+{
+	std::unique_lock<std::mutex> guard(m_lock);
+	for (;;) {
+		while ( ! m_shutdown && m_todo.empty()) {
+			m_work_ready.wait(guard);
+		}
+		if (m_shutdown) {
+			return;
+		}
+		Chunk * chunk = m_todo.front();
+		m_todo.pop_front();
+
+		guard.unlock();
+		format(*chunk);
+		guard.lock();
+
+		chunk->formatted = true;
+		m_chunk_formatted.notify_one();
+	}
+}
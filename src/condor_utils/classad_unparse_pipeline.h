@@ -0,0 +1,148 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _CLASSAD_UNPARSE_PIPELINE_H_
+#define _CLASSAD_UNPARSE_PIPELINE_H_
+
+#include "classad/classad_distribution.h"
+#include "classad_oldnew.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+/** The unparsed text of expressions that ads share through the ClassAd
+	expression cache (ENABLE_CLASSAD_CACHING), so that an expression common
+	to many ads - a START expression, say - is unparsed once rather than
+	once per ad.  Entries are keyed by cache entry, which stays put only
+	while the ads that refer to it do, so a cache should not outlive the
+	set of ads it is used on.  It may be used by several threads at once.
+*/
+class ClassAdUnparseCache {
+public:
+	ClassAdUnparseCache() : m_hits(0), m_misses(0) {}
+
+		/// Append the unparsed expr to buffer; unp must be set up as putClassAd() sets it up.
+	void Unparse(classad::ClassAdUnParser & unp, std::string & buffer, const classad::ExprTree * expr);
+
+	long long Hits() const { return m_hits; }
+	long long Misses() const { return m_misses; }
+
+private:
+	static const int NUM_SHARDS = 16; // each with its own lock
+	struct Shard {
+		std::mutex lock;
+		std::unordered_map<const void *, std::string> text;
+	};
+	Shard m_shards[NUM_SHARDS];
+	std::atomic<long long> m_hits;
+	std::atomic<long long> m_misses;
+
+	ClassAdUnparseCache(const ClassAdUnparseCache &);
+	ClassAdUnparseCache & operator=(const ClassAdUnparseCache &);
+};
+
+/** Sends a long run of ads the way putClassAd() would, but unparses them
+	a chunk at a time on worker threads into PreparedClassAds, so that the
+	thread that owns the socket only has to write them, in order.  This is
+	for query replies of many thousands of ads, where unparsing is most of
+	the work.
+
+	The ads (and any ads they are chained to) must not be changed or freed
+	until flush() returns, and nothing else may evaluate or modify them on
+	another thread in the meantime.  Sends always block.
+*/
+class ClassAdUnparsePipeline {
+public:
+		/** @param sock where the ads are sent
+			@param options PUT_CLASSAD_* flags used for every ad, except PUT_CLASSAD_NON_BLOCKING;
+				with PUT_CLASSAD_BINARY, ads are encoded rather than unparsed if canPutBinaryClassAd(sock)
+			@param num_threads number of unparse threads; with 0, ads are unparsed as they are put
+			@param code_more if true, each ad is preceded by an int 1, as the collector's query reply expects
+		*/
+	ClassAdUnparsePipeline(Stream * sock, int options, int num_threads, bool code_more = false);
+	~ClassAdUnparsePipeline();
+
+		/** Queue an ad to be sent, along with the attributes to send
+			(NULL for all of them).  Ads that share a whitelist should share
+			the pointer.  May send earlier ads.
+			@return false if sending has failed
+		*/
+	bool put(const classad::ClassAd & ad, const std::shared_ptr<const classad::References> & whitelist = std::shared_ptr<const classad::References>());
+
+		/// As put(), but ad is a temporary that is unchained and deleted once it has been sent.
+	bool putTemporary(classad::ClassAd * ad, const std::shared_ptr<const classad::References> & whitelist = std::shared_ptr<const classad::References>());
+
+		/// Send everything that has been put.  @return false if sending has failed
+	bool flush();
+
+	int NumThreads() const { return m_num_threads; }
+	const ClassAdUnparseCache & Cache() const { return m_cache; }
+
+private:
+	struct Item {
+		Item() : ad(NULL), temporary(false) {}
+		const classad::ClassAd * ad;
+		std::shared_ptr<const classad::References> whitelist;
+		bool temporary;
+		PreparedClassAd prepared;
+	};
+	struct Chunk {
+		Chunk() : count(0), formatted(false) {}
+		std::vector<Item> items; // the first count are in use
+		size_t count;
+		bool formatted;
+	};
+
+	bool queue(const classad::ClassAd * ad, const std::shared_ptr<const classad::References> & whitelist, bool temporary);
+	void submit();
+	bool sendFormatted(bool wait);
+	bool sendChunk(Chunk & chunk);
+	void format(Chunk & chunk);
+	void startThreads();
+	void worker();
+
+	Stream * m_sock;
+	int m_options;
+	int m_num_threads;
+	bool m_code_more;
+	bool m_failed;
+	ClassAdUnparseCache m_cache;
+	PreparedClassAd m_scratch;            // for unparsing on the calling thread
+
+	std::unique_ptr<Chunk> m_filling;     // being filled by put()
+	std::vector<std::unique_ptr<Chunk>> m_spare;
+
+	std::mutex m_lock;                    // protects everything below
+	std::condition_variable m_work_ready;
+	std::condition_variable m_chunk_formatted;
+	std::deque<std::unique_ptr<Chunk>> m_in_flight; // in the order they are to be sent
+	std::deque<Chunk *> m_todo;           // chunks waiting for a worker
+	bool m_shutdown;
+	std::vector<std::thread> m_threads;
+
+	ClassAdUnparsePipeline(const ClassAdUnparsePipeline &);
+	ClassAdUnparsePipeline & operator=(const ClassAdUnparsePipeline &);
+};
+
+#endif
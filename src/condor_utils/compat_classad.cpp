@@ -32,6 +32,7 @@
 #define CLASSAD_USER_MAP_RETURNS_STRINGLIST 1
 
 #include <sstream>
+#include <memory>
 #include <unordered_set>
 
 class MapFile;
@@ -164,6 +165,161 @@ void releaseTheMatchAd()
 }
 
 
+// Walks the items of a string list the same way StringList does: items
+// are separated by any of the delimiter characters, whitespace around an
+// item is trimmed, and empty items are skipped.  Unlike StringList, it
+// doesn't copy the items, and it classifies each character with a single
+// table lookup instead of searching the delimiter string for it.
+class StringListScanner {
+public:
+	StringListScanner(const char *list, const char *delims) : m_walk((const unsigned char *)list) {
+		memset(m_class, 0, sizeof(m_class));
+		for (int ch = 1; ch < 256; ++ch) {
+			if (isspace(ch)) { m_class[ch] = SKIP | SPACE; }
+		}
+		for (const unsigned char *pd = (const unsigned char *)delims; *pd; ++pd) {
+			m_class[*pd] |= ENDS_ITEM | SKIP;
+		}
+		m_class[0] = ENDS_ITEM;
+	}
+
+	bool next(const char *&item, size_t &len) {
+		while (m_class[*m_walk] & SKIP) {
+			++m_walk;
+		}
+		if ( ! *m_walk) {
+			return false;
+		}
+		const unsigned char *begin = m_walk;
+		while ( ! (m_class[*m_walk] & ENDS_ITEM)) {
+			++m_walk;
+		}
+		const unsigned char *end = m_walk;
+		while (end > begin && (m_class[end[-1]] & SPACE)) {
+			--end;
+		}
+		item = (const char *)begin;
+		len = end - begin;
+		return true;
+	}
+
+	// fetch the next item as a null terminated string
+	bool next(std::string &item) {
+		const char *begin;
+		size_t len;
+		if ( ! next(begin, len)) {
+			return false;
+		}
+		item.assign(begin, len);
+		return true;
+	}
+
+private:
+	enum { ENDS_ITEM = 1, SKIP = 2, SPACE = 4 };
+	const unsigned char *m_walk;
+	unsigned char m_class[256];
+};
+
+// The items of a long string list, hashed so that stringListMember() and
+// stringListIMember() don't have to scan it.  Lists are only hashed the
+// second time they are seen, so a list that is only checked once doesn't
+// pay for the hashing.
+struct HashedStringList {
+	HashedStringList(const std::string &l, const std::string &d) : list(l), delims(d), hashed(false), lower_hashed(false) {}
+
+	std::string list;
+	std::string delims;
+	bool hashed;
+	bool lower_hashed;
+	std::unordered_set<std::string> items;
+	std::unordered_set<std::string> lower_items; // for stringListIMember
+
+	bool contains(const char *item, bool anycase) {
+		if ( ! anycase) {
+			return items.count(item) > 0;
+		}
+		if ( ! lower_hashed) {
+			for (auto it = items.begin(); it != items.end(); ++it) {
+				std::string lower(*it);
+				lower_case(lower);
+				lower_items.insert(lower);
+			}
+			lower_hashed = true;
+		}
+		std::string lower(item);
+		lower_case(lower);
+		return lower_items.count(lower) > 0;
+	}
+};
+
+// Shorter lists are quicker to scan than to look up in the cache.
+static const size_t HASHED_STRING_LIST_MIN_LENGTH = 128;
+static const size_t HASHED_STRING_LIST_CACHE_SIZE = 8;
+
+// Returns the hashed form of a list if it was seen recently, remembering
+// it if not.  Matchmaking evaluates the same few constant lists (from the
+// START expression, or an attribute of the slot ad) against many ads, so
+// a small cache with the most recently used list first catches them.
+// Values hold their own copy of a string, so lists are found by content;
+// comparing the lengths first rules out most of the wrong lists cheaply.
+static HashedStringList *
+find_hashed_string_list(const std::string &list, const std::string &delims)
+{
+	static thread_local std::vector< std::unique_ptr<HashedStringList> > cache;
+
+	for (size_t ix = 0; ix < cache.size(); ++ix) {
+		HashedStringList *entry = cache[ix].get();
+		if (entry->list.size() != list.size() || entry->delims != delims || entry->list != list) {
+			continue;
+		}
+		if (ix > 0) {
+			std::rotate(cache.begin(), cache.begin() + ix, cache.begin() + ix + 1);
+		}
+		if ( ! entry->hashed) {
+			StringListScanner scan(entry->list.c_str(), entry->delims.c_str());
+			const char *item;
+			size_t len;
+			while (scan.next(item, len)) {
+				entry->items.insert(std::string(item, len));
+			}
+			entry->hashed = true;
+		}
+		return entry;
+	}
+
+	if (cache.size() >= HASHED_STRING_LIST_CACHE_SIZE) {
+		cache.pop_back();
+	}
+	cache.insert(cache.begin(), std::unique_ptr<HashedStringList>(new HashedStringList(list, delims)));
+	return NULL;
+}
+
+static bool
+string_list_contains(const std::string &list, const std::string &delims, const std::string &item, bool anycase)
+{
+	if (list.size() >= HASHED_STRING_LIST_MIN_LENGTH) {
+		HashedStringList *hashed = find_hashed_string_list(list, delims);
+		if (hashed) {
+			return hashed->contains(item.c_str(), anycase);
+		}
+	}
+
+	const char *item_str = item.c_str();
+	size_t item_len = strlen(item_str);
+	StringListScanner scan(list.c_str(), delims.c_str());
+	const char *entry;
+	size_t len;
+	while (scan.next(entry, len)) {
+		if (len != item_len) {
+			continue;
+		}
+		if (anycase ? (strncasecmp(entry, item_str, len) == MATCH) : (memcmp(entry, item_str, len) == 0)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 static
 bool stringListSize_func( const char * /*name*/,
 						  const classad::ArgumentList &arg_list,
@@ -194,8 +350,14 @@ bool stringListSize_func( const char * /*name*/,
 		return true;
 	}
 
-	StringList sl( list_str.c_str(), delim_str.c_str() );
-	result.SetIntegerValue( sl.number() );
+	StringListScanner scan( list_str.c_str(), delim_str.c_str() );
+	const char *entry;
+	size_t len;
+	long long count = 0;
+	while ( scan.next( entry, len ) ) {
+		++count;
+	}
+	result.SetIntegerValue( count );
 
 	return true;
 }
@@ -273,33 +435,34 @@ bool stringListSummarize_func( const char *name,
 		return false;
 	}
 
-	StringList sl( list_str.c_str(), delim_str.c_str() );
-	if ( sl.number() == 0 ) {
-		if ( empty_allowed ) {
-			result.SetRealValue( 0.0 );
-		} else {
-			result.SetUndefinedValue();
-		}
-		return true;
-	}
-
-	sl.rewind();
-	const char *entry;
-	while ( (entry = sl.next()) ) {
+	StringListScanner scan( list_str.c_str(), delim_str.c_str() );
+	std::string entry;
+	int count = 0;
+	while ( scan.next( entry ) ) {
 		double temp;
-		int r = sscanf(entry, "%lf", &temp);
+		int r = sscanf(entry.c_str(), "%lf", &temp);
 		if (r != 1) {
 			result.SetErrorValue();
 			return true;
 		}
-		if (strspn(entry, "+-0123456789") != strlen(entry)) {
+		if (strspn(entry.c_str(), "+-0123456789") != entry.size()) {
 			is_real = true;
 		}
 		accumulator = func( temp, accumulator );
+		++count;
+	}
+
+	if ( count == 0 ) {
+		if ( empty_allowed ) {
+			result.SetRealValue( 0.0 );
+		} else {
+			result.SetUndefinedValue();
+		}
+		return true;
 	}
 
 	if ( is_avg ) {
-		accumulator /= sl.number();
+		accumulator /= count;
 	}
 
 	if ( is_real ) {
@@ -344,14 +507,8 @@ bool stringListMember_func( const char *name,
 		return true;
 	}
 
-	StringList sl( list_str.c_str(), delim_str.c_str() );
-	int rc;
-	if ( strcasecmp( name, "stringlistmember" ) == 0 ) {
-		rc = sl.contains( item_str.c_str() );
-	} else {
-		rc = sl.contains_anycase( item_str.c_str() );
-	}
-	result.SetBooleanValue( rc ? true : false );
+	bool anycase = strcasecmp( name, "stringlistmember" ) != 0;
+	result.SetBooleanValue( string_list_contains( list_str, delim_str, item_str, anycase ) );
 
 	return true;
 }
@@ -423,8 +580,9 @@ bool stringListRegexpMember_func( const char * /*name*/,
 		return true;
 	}
 
-	StringList sl( list_str.c_str(), delim_str.c_str() );
-	if ( sl.number() == 0 ) {
+	StringListScanner scan( list_str.c_str(), delim_str.c_str() );
+	std::string entry;
+	if ( ! scan.next( entry ) ) {
 		result.SetUndefinedValue();
 		return true;
 	}
@@ -444,13 +602,11 @@ bool stringListRegexpMember_func( const char * /*name*/,
 
 	result.SetBooleanValue( false );
 
-	sl.rewind();
-	char *entry;
-	while( (entry = sl.next())) {
-		if (r.match(entry)) {
+	do {
+		if (r.match(entry.c_str())) {
 			result.SetBooleanValue( true );
 		}
-	}
+	} while ( scan.next( entry ) );
 
 	return true;
 }
@@ -73,6 +73,7 @@
 #include "condor_environ.h"
 #include "condor_auth_x509.h"
 #include "setenv.h"
+#include "param_cache.h"
 #include "HashTable.h"
 #include "condor_uid.h"
 #include "condor_mkstemp.h"
@@ -892,6 +893,35 @@ condor_auth_config(int is_daemon)
 #endif
 }
 
+// Log the params that were looked up most often since the config was
+// loaded, so they can be considered for the typed param cache.
+static void
+report_param_lookup_counts(int cat_and_flags, int max_params)
+{
+	if ( ! IsDebugCatAndVerbosity(cat_and_flags) || ! ConfigMacroSet.metat) {
+		return;
+	}
+
+	std::vector<std::pair<int, std::string> > counts;
+	HASHITER it = hash_iter_begin(ConfigMacroSet);
+	while ( ! hash_iter_done(it)) {
+		MACRO_META * pmet = hash_iter_meta(it);
+		if (pmet && pmet->use_count > 0) {
+			counts.push_back(std::make_pair(pmet->use_count, std::string(hash_iter_key(it))));
+		}
+		hash_iter_next(it);
+	}
+	hash_iter_delete(&it);
+
+	size_t num = MIN(counts.size(), (size_t)max_params);
+	std::partial_sort(counts.begin(), counts.begin() + num, counts.end(),
+		std::greater<std::pair<int, std::string> >());
+	dprintf(cat_and_flags, "Most frequently looked up config params since last reconfig:\n");
+	for (size_t ii = 0; ii < num; ++ii) {
+		dprintf(cat_and_flags, "    %8d %s\n", counts[ii].first, counts[ii].second.c_str());
+	}
+}
+
 bool
 real_config(const char* host, int wantsQuiet, int config_options, const char * root_config)
 {
@@ -908,6 +938,7 @@ real_config(const char* host, int wantsQuiet, int config_options, const char * r
 		first_time = false;
 		init_global_config_table(config_options);
 	} else {
+		report_param_lookup_counts(D_CONFIG, 20);
 			// Clear out everything in our config hash table so we can
 			// rebuild it from scratch.
 		clear_global_config_table();
@@ -1180,6 +1211,8 @@ real_config(const char* host, int wantsQuiet, int config_options, const char * r
 		// Re-initialize the ClassAd compat data (in case if CLASSAD_USER_LIBS is set).
 	ClassAdReconfig();
 
+	param_cache_invalidate();
+
 	return true;
 }
 
@@ -1950,6 +1983,7 @@ param_insert(const char * name, const char * value)
 	MACRO_EVAL_CONTEXT ctx;
 	init_macro_eval_context(ctx);
 	insert_macro(name, value, ConfigMacroSet, WireMacro, ctx);
+	param_cache_invalidate();
 }
 
 // set the value of a param equal to the given pointer. if the param is
@@ -1976,6 +2010,7 @@ const char * set_live_param_value(const char * name, const char * live_value)
 	} else {
 		pitem->raw_value = live_value;
 	}
+	param_cache_invalidate();
 	return old_value;
 }
 
@@ -3040,6 +3075,7 @@ config_insert( const char* attrName, const char* attrValue )
 	MACRO_EVAL_CONTEXT ctx;
 	init_macro_eval_context(ctx);
 	insert_macro(attrName, attrValue, ConfigMacroSet, WireMacro, ctx);
+	param_cache_invalidate();
 }
 
 int macro_stats(MACRO_SET& set, struct _macro_stats &stats)
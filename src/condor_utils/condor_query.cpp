@@ -425,6 +425,9 @@ processAds (bool (*callback)(void*, ClassAd *), void* pv, const char * poolName,
 	}
 
 
+	// getClassAd() below reads either form, so let the collector send binary ads
+	queryAd.Assign(ATTR_ACCEPT_BINARY_CLASSADS, (int)BINARY_CLASSAD_VERSION);
+
 	int mytimeout = param_integer ("QUERY_TIMEOUT",60); 
 	if (!(sock = my_collector.startCommand(command, Stream::reli_sock, mytimeout, errstack)) ||
 	    !putClassAd (sock, queryAd) || !sock->end_of_message()) {
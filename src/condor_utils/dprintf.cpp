@@ -225,6 +225,9 @@ static	int DprintfBroken = 0;
 static	int DebugUnlockBroken = 0;
 #if !defined(WIN32) && defined(HAVE_PTHREADS)
 #include <pthread.h>
+#include <poll.h>
+#include <atomic>
+#define DPRINTF_ASYNC 1
 static pthread_mutex_t _condor_dprintf_critsec = 
 #if defined(PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP)
 						PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
@@ -441,7 +444,7 @@ const char* _format_global_header(int cat_and_flags, int hdr_flags, DebugHeaderI
 		}
 
 			/* include tid if we are configured to use a thread pool */
-		my_tid = CondorThreads_gettid();
+		my_tid = info.tid ? info.tid : CondorThreads_gettid();
 		if ( my_tid > 0 ) {
 			rc = sprintf_realloc( &buf, &bufpos, &buflen, "(tid:%d) ", my_tid );
 			if( rc < 0 ) {
@@ -824,6 +827,546 @@ bool _condor_dprintf_runtime (
 #endif
 }
 
+/* _condor_dprintf_emit
+ * Write a formatted message to every output that wants it.  When
+ * lock_files is false, file outputs must already be open; this is
+ * how the async writer thread writes, since it can't switch privs.
+ * The caller must hold _condor_dprintf_critsec if there are threads.
+ */
+static void
+_condor_dprintf_emit( int cat_and_flags, int hdr_flags, DebugHeaderInfo &info, const char* message, bool lock_files )
+{
+	std::vector<DebugFileInfo>::iterator it;
+
+		/* print debug message to catch-all debug file plus files */
+		/* registered for other debug levels */
+	if(!DebugLogs->size())
+	{
+		DebugFileInfo backup;
+		backup.outputTarget = STD_ERR;
+		backup.debugFP = stderr;
+		backup.dprintfFunc = _dprintf_global_func;
+		backup.dprintfFunc(cat_and_flags, hdr_flags, info, message, &backup);
+		backup.debugFP = NULL; // don't allow destructor to free stderr
+	}
+
+	unsigned int basic_flag = (cat_and_flags & D_FULLDEBUG) ? 0 : (1<<(cat_and_flags&D_CATEGORY_MASK));
+	unsigned int verbose_flag = 1<<(cat_and_flags&D_CATEGORY_MASK);
+
+	// if the message is tagged as a failure message, then it is always in the D_ERROR category
+	// as well as whatever category it's currently in.
+	if (cat_and_flags & D_FAILURE) { basic_flag |= 1<<D_ERROR; }
+
+	//PRAGMA_REMIND("TJ: fix this to distinguish between verbose:2 and verbose:3")
+	for(it = DebugLogs->begin(); it < DebugLogs->end(); it++)
+	{
+		unsigned int choice = (*it).choice;
+		if (choice && !(choice & basic_flag) && !(choice & verbose_flag))
+			continue;
+
+		/* Open and lock the log file */
+		bool   funlock_it = false;
+		switch ((*it).outputTarget) {
+			case STD_ERR: it->debugFP = stderr; break;
+			case STD_OUT: it->debugFP = stdout; break;
+			case SYSLOG: break;
+			default:
+			case FILE_OUT:
+				if ( ! lock_files) {
+					if ( ! it->debugFP) continue;
+					break;
+				}
+				debug_lock_it(&(*it), NULL, 0, it->dont_panic);
+				funlock_it = true;
+				break;
+			case OUTPUT_DEBUG_STR: // recognise this on linux, it's part of the >BUFFER special case
+				break;
+		}
+
+		it->dprintfFunc(cat_and_flags, hdr_flags, info, message, &(*it));
+		if (funlock_it) {
+			debug_unlock_it(&(*it));
+		}
+	}
+}
+
+#ifdef DPRINTF_ASYNC
+
+/*
+** Asynchronous dprintf.  When enabled, dprintf() formats the message into
+** a per-thread buffer and pushes it onto a bounded, lock-free queue
+** without blocking signals or taking _condor_dprintf_critsec.  A writer
+** thread drains the queue to the log files.  If the queue is full the
+** message is dropped and counted, and the count is written to the log
+** once there is room.  Messages that must not be lost or delayed
+** (D_FAILURE, D_BACKTRACE) take the ordinary synchronous path, which
+** first drains whatever is queued so the log stays in order.
+**
+** The writer thread sleeps on a pipe until a producer wakes it; only the
+** first message after each pass writes to the pipe.
+**
+** The writer thread can't change priv states, because on Unix they are
+** shared by every thread, so it only writes to files that are already
+** open.  Log files are kept open while the writer is running, and when a
+** file is due for rotation the writer asks the next dprintf() caller to
+** rotate it on the synchronous path.
+**
+** Messages still in the queue when the process dies on a signal, or
+** calls abort(), are lost.  EXCEPT() and other D_FAILURE messages are
+** safe, because they drain the queue before they are written.
+**
+** The queue is an array of fixed size slots, each with a sequence number
+** that says whether it is free for the producer of a given position or
+** holds that position's data for the consumer.  A message longer than
+** one slot takes consecutive slots; producers reserve them all with a
+** single compare-and-swap.  There is only ever one consumer: whichever
+** thread holds _condor_dprintf_critsec.
+*/
+
+#define DPRINTF_ASYNC_SLOT_TEXT 200
+
+struct DprintfAsyncSlot {
+	std::atomic<size_t> seq;
+	int cat_and_flags;
+	int tid;
+	int nslots;             // number of slots in this record
+	int len;                // length of the whole message
+	DPF_IDENT ident;
+	struct timeval tv;
+	char text[DPRINTF_ASYNC_SLOT_TEXT];
+};
+
+static DprintfAsyncSlot *AsyncSlots = NULL;
+static size_t AsyncSize = 0;		// number of slots, a power of 2
+static std::atomic<size_t> AsyncEnqueuePos(0);
+static std::atomic<size_t> AsyncDequeuePos(0);
+static std::atomic<bool> AsyncActive(false);
+static std::atomic<bool> AsyncRotatePending(false);
+static std::atomic<bool> AsyncKicked(false);
+static std::atomic<long long> AsyncDropped(0);
+static long long AsyncDroppedReported = 0;
+static std::atomic<bool> AsyncWriterRunning(false);
+static std::atomic<bool> AsyncHold(false);
+static bool AsyncStopping = false;
+static pthread_t AsyncWriter;
+static int AsyncWakePipe[2] = { -1, -1 };
+
+	// per-thread format buffer, and a guard against a signal handler
+	// calling dprintf() while this thread is already in the middle of one
+static __thread char *AsyncBuffer = NULL;
+static __thread int AsyncBufferLen = 0;
+static __thread int AsyncInDprintf = 0;
+
+static void
+_condor_dprintf_async_kick()
+{
+	if ( ! AsyncKicked.exchange(true)) {
+		char c = 0;
+		if (write(AsyncWakePipe[1], &c, 1) < 0) { /* pipe is full, writer is awake anyway */ }
+	}
+}
+
+static bool
+_condor_dprintf_async_push( int cat_and_flags, DPF_IDENT ident, const struct timeval &tv, const char *message, int len )
+{
+	size_t nslots = len ? (len + DPRINTF_ASYNC_SLOT_TEXT - 1) / DPRINTF_ASYNC_SLOT_TEXT : 1;
+	if (nslots > AsyncSize / 2) {
+		return false;
+	}
+
+	size_t pos = AsyncEnqueuePos.load(std::memory_order_relaxed);
+	for (;;) {
+			// slots are freed in order, so if the last one we need is
+			// free for us, they all are
+		size_t last = pos + nslots - 1;
+		size_t seq = AsyncSlots[last & (AsyncSize - 1)].seq.load(std::memory_order_acquire);
+		long long dif = (long long)seq - (long long)last;
+		if (dif == 0) {
+			if (AsyncEnqueuePos.compare_exchange_weak(pos, pos + nslots, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (dif < 0) {
+			return false;	// full
+		} else {
+			pos = AsyncEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	DprintfAsyncSlot &first = AsyncSlots[pos & (AsyncSize - 1)];
+	first.cat_and_flags = cat_and_flags;
+	first.tid = CondorThreads_gettid();
+	first.nslots = (int)nslots;
+	first.len = len;
+	first.ident = ident;
+	first.tv = tv;
+	for (size_t ii = 0; ii < nslots; ++ii) {
+		DprintfAsyncSlot &slot = AsyncSlots[(pos + ii) & (AsyncSize - 1)];
+		int off = (int)ii * DPRINTF_ASYNC_SLOT_TEXT;
+		memcpy(slot.text, message + off, MIN(len - off, DPRINTF_ASYNC_SLOT_TEXT));
+		slot.seq.store(pos + ii + 1, std::memory_order_release);
+	}
+
+	_condor_dprintf_async_kick();
+	return true;
+}
+
+/* _condor_dprintf_async_va
+ * Queue a message for the writer thread.  Returns false if the message
+ * should be written synchronously instead.
+ */
+static bool
+_condor_dprintf_async_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list args )
+{
+	if ((cat_and_flags & (D_FAILURE | D_BACKTRACE)) || AsyncRotatePending.load(std::memory_order_relaxed)) {
+		return false;
+	}
+		/* see the comment about PRIV_USER_FINAL in _condor_dprintf_va */
+	if (get_priv() == PRIV_USER_FINAL) {
+		return true;
+	}
+	if (AsyncInDprintf) {
+		AsyncDropped++;
+		return true;
+	}
+	AsyncInDprintf = 1;
+	int saved_errno = errno;
+
+	struct timeval tv;
+	if (DebugHeaderOptions & D_SUB_SECOND) {
+		condor_gettimestamp(tv);
+	} else {
+		tv.tv_sec = time(NULL);
+		tv.tv_usec = 0;
+	}
+
+	int bufpos = 0;
+	va_list copyargs;
+	va_copy(copyargs, args);
+	int rc = vsprintf_realloc(&AsyncBuffer, &bufpos, &AsyncBufferLen, fmt, copyargs);
+	va_end(copyargs);
+
+	if (rc < 0 || ! _condor_dprintf_async_push(cat_and_flags, ident, tv, AsyncBuffer, bufpos)) {
+		AsyncDropped++;
+	}
+
+	errno = saved_errno;
+	AsyncInDprintf = 0;
+	return true;
+}
+
+/* _condor_dprintf_async_drain
+ * Write out everything in the queue.  The caller must hold
+ * _condor_dprintf_critsec.  If can_rotate is true, the caller is in
+ * PRIV_CONDOR and we rotate any log files the writer thread said were
+ * due; otherwise we check whether any are.
+ */
+static void
+_condor_dprintf_async_drain( bool can_rotate )
+{
+	static char *message = NULL;
+	static int message_len = 0;
+	struct tm tm_buf;
+	DebugHeaderInfo info;
+	std::vector<DebugFileInfo>::iterator it;
+
+	size_t pos = AsyncDequeuePos.load(std::memory_order_relaxed);
+	for (;;) {
+		DprintfAsyncSlot &first = AsyncSlots[pos & (AsyncSize - 1)];
+		if (first.seq.load(std::memory_order_acquire) != pos + 1) {
+			break;
+		}
+			// the rest of the record may still be on its way
+		int nslots = first.nslots;
+		bool complete = true;
+		for (int ii = 1; ii < nslots; ++ii) {
+			if (AsyncSlots[(pos + ii) & (AsyncSize - 1)].seq.load(std::memory_order_acquire) != pos + ii + 1) {
+				complete = false;
+				break;
+			}
+		}
+		if ( ! complete) {
+			break;
+		}
+
+		if (message_len < first.len + 1) {
+			char *grown = (char *)realloc(message, first.len + 1);
+			if ( ! grown) {
+				_condor_dprintf_exit(errno, "Error writing to debug buffer\n");
+			}
+			message = grown;
+			message_len = first.len + 1;
+		}
+		for (int ii = 0; ii < nslots; ++ii) {
+			int off = ii * DPRINTF_ASYNC_SLOT_TEXT;
+			memcpy(message + off, AsyncSlots[(pos + ii) & (AsyncSize - 1)].text, MIN(first.len - off, DPRINTF_ASYNC_SLOT_TEXT));
+		}
+		message[first.len] = 0;
+
+		memset((void*)&info, 0, sizeof(info));
+		info.tv = first.tv;
+		info.ident = first.ident;
+		info.tid = first.tid;
+		time_t then = info.tv.tv_sec;
+		info.tm = localtime_r(&then, &tm_buf);
+		_condor_dprintf_emit(first.cat_and_flags, DebugHeaderOptions, info, message, false);
+		dprintf_count += 1;
+
+		for (int ii = 0; ii < nslots; ++ii) {
+			AsyncSlots[(pos + ii) & (AsyncSize - 1)].seq.store(pos + ii + AsyncSize, std::memory_order_release);
+		}
+		pos += nslots;
+		AsyncDequeuePos.store(pos, std::memory_order_relaxed);
+	}
+
+	long long dropped = AsyncDropped.load();
+	if (dropped != AsyncDroppedReported) {
+		char dropped_msg[100];
+		snprintf(dropped_msg, sizeof(dropped_msg),
+			"dprintf: dropped %lld messages because the log queue was full\n",
+			dropped - AsyncDroppedReported);
+		AsyncDroppedReported = dropped;
+		memset((void*)&info, 0, sizeof(info));
+		_condor_dprintf_gettime(info, DebugHeaderOptions);
+		time_t now = info.tv.tv_sec;
+		info.tm = localtime_r(&now, &tm_buf);
+		_condor_dprintf_emit(D_ALWAYS, DebugHeaderOptions, info, dropped_msg, false);
+	}
+
+	if ( ! DebugRotateLog) {
+		return;
+	}
+	if (can_rotate) {
+		if (AsyncRotatePending.load()) {
+			for (it = DebugLogs->begin(); it < DebugLogs->end(); it++) {
+				if (it->outputTarget == FILE_OUT) {
+					debug_lock_it(&(*it), NULL, 0, it->dont_panic);
+					debug_unlock_it(&(*it));
+				}
+			}
+			AsyncRotatePending = false;
+		}
+		return;
+	}
+	for (it = DebugLogs->begin(); it < DebugLogs->end(); it++) {
+		if (it->outputTarget != FILE_OUT || ! it->maxLog || ! it->debugFP) {
+			continue;
+		}
+		bool due;
+		if (it->rotate_by_time) {
+			due = it->logZero &&
+				quantizeTimestamp(time(NULL), it->maxLog) - quantizeTimestamp((time_t)it->logZero, it->maxLog) >= it->maxLog;
+		} else {
+			due = lseek(fileno(it->debugFP), 0, SEEK_END) >= it->maxLog;
+		}
+		if (due) {
+			AsyncRotatePending = true;
+		}
+	}
+}
+
+static void *
+_condor_dprintf_async_writer( void * )
+{
+	for (;;) {
+		struct pollfd pfd;
+		pfd.fd = AsyncWakePipe[0];
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, -1) > 0) {
+			char buf[64];
+			while (read(AsyncWakePipe[0], buf, sizeof(buf)) > 0) {}
+		}
+			// an exchange rather than a store, so that we see every message
+			// pushed by a producer that saw the flag still set
+		AsyncKicked.exchange(false);
+
+		pthread_mutex_lock(&_condor_dprintf_critsec);
+		bool stopping = AsyncStopping;
+		if (stopping || ! AsyncHold) {
+			_condor_dprintf_async_drain(false);
+		}
+		pthread_mutex_unlock(&_condor_dprintf_critsec);
+		if (stopping) {
+			break;
+		}
+	}
+	return NULL;
+}
+
+	// a forked child doesn't have the writer thread, and may have
+	// inherited _condor_dprintf_critsec locked by it
+static void _condor_dprintf_async_prepare_fork() { pthread_mutex_lock(&_condor_dprintf_critsec); }
+static void _condor_dprintf_async_parent_fork() { pthread_mutex_unlock(&_condor_dprintf_critsec); }
+static void
+_condor_dprintf_async_child_fork()
+{
+	AsyncActive = false;
+	AsyncWriterRunning = false;
+	pthread_mutex_unlock(&_condor_dprintf_critsec);
+}
+
+static void
+_condor_dprintf_async_stop()
+{
+	AsyncActive = false;
+	if ( ! AsyncWriterRunning) {
+		return;
+	}
+
+	pthread_mutex_lock(&_condor_dprintf_critsec);
+	AsyncStopping = true;
+	pthread_mutex_unlock(&_condor_dprintf_critsec);
+	_condor_dprintf_async_kick();
+	if ( ! pthread_equal(pthread_self(), AsyncWriter)) {
+		pthread_join(AsyncWriter, NULL);
+	}
+
+		// pick up anything queued after the writer's last pass, and close
+		// the log files that were only open for the writer
+	pthread_mutex_lock(&_condor_dprintf_critsec);
+	_condor_dprintf_async_drain(false);
+	AsyncWriterRunning = false;
+	AsyncStopping = false;
+	AsyncHold = false;
+	if ( ! log_keep_open) {
+		priv_state priv = _set_priv(PRIV_CONDOR, __FILE__, __LINE__, 0);
+		std::vector<DebugFileInfo>::iterator it;
+		for (it = DebugLogs->begin(); it < DebugLogs->end(); it++) {
+			if (it->outputTarget == FILE_OUT) {
+				debug_unlock_it(&(*it));
+			}
+		}
+		_set_priv(priv, __FILE__, __LINE__, 0);
+	}
+	pthread_mutex_unlock(&_condor_dprintf_critsec);
+}
+
+void
+dprintf_async_hold(bool hold)
+{
+	AsyncHold = hold;
+	if ( ! hold && AsyncWriterRunning) {
+		_condor_dprintf_async_kick();
+	}
+}
+
+static void
+_condor_dprintf_async_atexit()
+{
+	if ( ! DprintfBroken) {
+		_condor_dprintf_async_stop();
+	}
+}
+
+void
+dprintf_set_async(bool enable, long long queue_size)
+{
+	static bool registered = false;
+
+	_condor_dprintf_async_stop();
+	if ( ! enable) {
+		return;
+	}
+
+	const char *reason = NULL;
+	std::vector<DebugFileInfo>::iterator it;
+	for (it = DebugLogs->begin(); it < DebugLogs->end(); it++) {
+		if (it->outputTarget != FILE_OUT && it->outputTarget != STD_ERR && it->outputTarget != STD_OUT) {
+			reason = "only log files can be written asynchronously";
+		}
+	}
+	if (DebugLock || DebugShouldLockToAppend) {
+		reason = "log files are locked to append";
+	}
+	if (DebugHeaderOptions & D_BACKTRACE) {
+		reason = "D_BACKTRACE is enabled";
+	}
+	if (reason) {
+		dprintf(D_ALWAYS, "Not logging asynchronously: %s\n", reason);
+		return;
+	}
+
+	size_t slots = 64;
+	while (slots * 2 * sizeof(DprintfAsyncSlot) <= (size_t)queue_size) {
+		slots *= 2;
+	}
+	if (slots != AsyncSize) {
+		delete [] AsyncSlots;
+		AsyncSlots = new DprintfAsyncSlot[slots];
+		AsyncSize = slots;
+	}
+	size_t pos = AsyncEnqueuePos.load();
+	for (size_t ii = 0; ii < AsyncSize; ++ii) {
+		AsyncSlots[(pos + ii) & (AsyncSize - 1)].seq.store(pos + ii);
+	}
+	AsyncDequeuePos = pos;
+
+	if (AsyncWakePipe[0] < 0) {
+		if (pipe(AsyncWakePipe) < 0) {
+			dprintf(D_ALWAYS, "Not logging asynchronously: pipe() failed, errno %d\n", errno);
+			return;
+		}
+		for (int ii = 0; ii < 2; ++ii) {
+			fcntl(AsyncWakePipe[ii], F_SETFL, fcntl(AsyncWakePipe[ii], F_GETFL) | O_NONBLOCK);
+			fcntl(AsyncWakePipe[ii], F_SETFD, FD_CLOEXEC);
+		}
+	}
+	if ( ! registered) {
+		pthread_atfork(_condor_dprintf_async_prepare_fork, _condor_dprintf_async_parent_fork, _condor_dprintf_async_child_fork);
+		atexit(_condor_dprintf_async_atexit);
+		registered = true;
+	}
+
+		// the writer can't open files, so open them all now.  While the
+		// writer is running, debug_unlock_it() leaves them open and the
+		// synchronous path takes _condor_dprintf_critsec.
+	pthread_mutex_lock(&_condor_dprintf_critsec);
+	priv_state priv = _set_priv(PRIV_CONDOR, __FILE__, __LINE__, 0);
+	for (it = DebugLogs->begin(); it < DebugLogs->end(); it++) {
+		if (it->outputTarget == FILE_OUT) {
+			debug_lock_it(&(*it), NULL, 0, it->dont_panic);
+		}
+	}
+	_set_priv(priv, __FILE__, __LINE__, 0);
+	AsyncRotatePending = false;
+	pthread_mutex_unlock(&_condor_dprintf_critsec);
+
+		// signals should be handled by the threads that call dprintf()
+	sigset_t mask, omask;
+	sigfillset(&mask);
+	pthread_sigmask(SIG_SETMASK, &mask, &omask);
+	int rc = pthread_create(&AsyncWriter, NULL, _condor_dprintf_async_writer, NULL);
+	pthread_sigmask(SIG_SETMASK, &omask, NULL);
+	if (rc != 0) {
+		dprintf(D_ALWAYS, "Not logging asynchronously: pthread_create() failed, error %d\n", rc);
+		return;
+	}
+	pthread_mutex_lock(&_condor_dprintf_critsec);
+	AsyncWriterRunning = true;
+	pthread_mutex_unlock(&_condor_dprintf_critsec);
+	AsyncActive = true;
+	dprintf(D_FULLDEBUG, "Logging asynchronously through a queue of %d messages\n", (int)AsyncSize);
+}
+
+#else
+
+static const bool AsyncWriterRunning = false;
+
+void
+dprintf_set_async(bool enable, long long /*queue_size*/)
+{
+	if (enable) {
+		dprintf(D_ALWAYS, "Not logging asynchronously: not supported on this platform\n");
+	}
+}
+
+void
+dprintf_async_hold(bool /*hold*/)
+{
+}
+
+#endif // DPRINTF_ASYNC
+
 void
 _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list args )
 {
@@ -838,7 +1381,9 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 #endif
 	int saved_errno;
 	priv_state	priv;
-	std::vector<DebugFileInfo>::iterator it;
+#if !defined(WIN32) && defined(HAVE_PTHREADS)
+	bool want_lock;
+#endif
 
 #ifdef ENABLE_DPRINTF_PROFILING
 	_dprintf_va_runtime art;
@@ -868,6 +1413,12 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 	if ( ! IsDebugCatAndVerbosity(cat_and_flags) && ! (cat_and_flags & D_FAILURE))
 		return;
 
+#ifdef DPRINTF_ASYNC
+	if (AsyncActive.load(std::memory_order_relaxed) && _condor_dprintf_async_va(cat_and_flags, ident, fmt, args)) {
+		return;
+	}
+#endif
+
 	// if this dprintf is enabled, switch runtime accumulation into the enabled counters
 #ifdef ENABLE_DPRINTF_PROFILING
 	art.is_enabled = true;
@@ -906,7 +1457,8 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 	 * with mutiple threads.  But on Unix, lets bother w/ mutexes if and only
 	 * if we are running w/ threads.
 	 */
-	if ( _dprintf_expect_threads || CondorThreads_pool_size() ) {  /* will == 0 if no threads running */
+	want_lock = _dprintf_expect_threads || AsyncWriterRunning || CondorThreads_pool_size();  /* will == 0 if no threads running */
+	if ( want_lock ) {
 		pthread_mutex_lock(&_condor_dprintf_critsec);
 	}
 #endif
@@ -964,53 +1516,14 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 			_condor_dprintf_exit(errno, "Error writing to debug buffer\n");	
 		}
 
-			/* print debug message to catch-all debug file plus files */
-			/* registered for other debug levels */
-		if(!DebugLogs->size())
-		{
-			DebugFileInfo backup;
-			backup.outputTarget = STD_ERR;
-			backup.debugFP = stderr;
-			backup.dprintfFunc = _dprintf_global_func;
-			backup.dprintfFunc(cat_and_flags, hdr_flags, info, message_buffer, &backup);
-			backup.debugFP = NULL; // don't allow destructor to free stderr
+#ifdef DPRINTF_ASYNC
+			/* anything still queued for the writer thread goes first */
+		if (AsyncWriterRunning) {
+			_condor_dprintf_async_drain(true);
 		}
+#endif
 
-		unsigned int basic_flag = (cat_and_flags & D_FULLDEBUG) ? 0 : (1<<(cat_and_flags&D_CATEGORY_MASK));
-		unsigned int verbose_flag = 1<<(cat_and_flags&D_CATEGORY_MASK);
-		int ixOutput = 0;
-
-		// if the message is tagged as a failure message, then it is always in the D_ERROR category
-		// as well as whatever category it's currently in.
-		if (cat_and_flags & D_FAILURE) { basic_flag |= 1<<D_ERROR; }
-
-		//PRAGMA_REMIND("TJ: fix this to distinguish between verbose:2 and verbose:3")
-		for(it = DebugLogs->begin(); it < DebugLogs->end(); it++, ++ixOutput)
-		{
-			unsigned int choice = (*it).choice;
-			if (choice && !(choice & basic_flag) && !(choice & verbose_flag))
-				continue;
-
-			/* Open and lock the log file */
-			bool   funlock_it = false;
-			switch ((*it).outputTarget) {
-				case STD_ERR: it->debugFP = stderr; break;
-				case STD_OUT: it->debugFP = stdout; break;
-				case SYSLOG: break;
-				default:
-				case FILE_OUT:
-					debug_lock_it(&(*it), NULL, 0, it->dont_panic);
-					funlock_it = true;
-					break;
-				case OUTPUT_DEBUG_STR: // recognise this on linux, it's part of the >BUFFER special case
-					break;
-			}
-			
-			it->dprintfFunc(cat_and_flags, hdr_flags, info, message_buffer, &(*it));
-			if (funlock_it) {
-				debug_unlock_it(&(*it));
-			}
-		}
+		_condor_dprintf_emit(cat_and_flags, hdr_flags, info, message_buffer, true);
 
 			/* restore privileges */
 		_set_priv(priv, __FILE__, __LINE__, 0);
@@ -1028,7 +1541,7 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 #ifdef WIN32
 	LeaveCriticalSection(_condor_dprintf_critsec);
 #elif defined(HAVE_PTHREADS)
-	if ( _dprintf_expect_threads || CondorThreads_pool_size() ) {  /* will == 0 if no threads running */
+	if ( want_lock ) {
 		pthread_mutex_unlock(&_condor_dprintf_critsec);
 	}
 #endif
@@ -1440,7 +1953,8 @@ debug_unlock_it(struct DebugFileInfo* it)
 
 	FILE *debug_file_ptr = (*it).debugFP;
 
-	if(log_keep_open)
+		// the async writer thread can only write to files that are open
+	if(log_keep_open || AsyncWriterRunning)
 		return;
 
 	if( DebugUnlockBroken ) {
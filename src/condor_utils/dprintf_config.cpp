@@ -568,6 +568,14 @@ dprintf_config( const char *subsys, struct dprintf_output_settings *p_info /* =
 	else
 	{
 		dprintf_set_outputs(&DebugParams[0], (int)DebugParams.size());
+
+		(void)sprintf(pname, "%s_LOG_ASYNC", subsys);
+		bool async = param_boolean(pname, false);
+		if (async) {
+			(void)sprintf(pname, "%s_LOG_ASYNC_QUEUE_SIZE", subsys);
+			long long queue_size = param_integer(pname, 4096, 16) * 1024LL;
+			dprintf_set_async(true, queue_size);
+		}
 	}
 	return 0;
 }
@@ -44,6 +44,9 @@ void dprintf_set_outputs(const struct dprintf_output_settings *p_info, int c_inf
 {
 	static int first_time = 1;
 
+		// the async writer thread uses the outputs we are about to replace
+	dprintf_set_async(false, 0);
+
 	std::vector<DebugFileInfo> *debugLogsOld = DebugLogs;
 	DebugLogs = new std::vector<DebugFileInfo>();
 
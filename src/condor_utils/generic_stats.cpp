@@ -959,6 +959,161 @@ void stats_histogram_int::PrintLimits(MyString & str, const int * pLimits, int c
 }
 */
 
+//----------------------------------------------------------------------------------------------
+// methods for the stats_entry_hdr_histogram class.
+//
+// values below 2*SUB_BUCKETS microseconds each get their own bucket, above that the
+// buckets for [2^n, 2^(n+1)) are SUB_BUCKETS equal steps of 2^(n-4) microseconds.
+//
+int stats_entry_hdr_histogram::BucketOf(uint64_t usec)
+{
+   if (usec < 2*SUB_BUCKETS) {
+      return (int)usec;
+   }
+   if (usec >= ((uint64_t)1 << MAX_BITS)) {
+      usec = ((uint64_t)1 << MAX_BITS) - 1;
+   }
+   int shift = 1;
+   while ((usec >> shift) >= 2*SUB_BUCKETS) {
+      ++shift;
+   }
+   return SUB_BUCKETS * shift + (int)(usec >> shift);
+}
+
+uint64_t stats_entry_hdr_histogram::BucketLimit(int ix)
+{
+   if (ix < 2*SUB_BUCKETS) {
+      return (uint64_t)ix;
+   }
+   int shift = ix / SUB_BUCKETS - 1;
+   uint64_t sub = (uint64_t)(ix % SUB_BUCKETS + SUB_BUCKETS);
+   return ((sub + 1) << shift) - 1;
+}
+
+stats_entry_hdr_histogram::stats_entry_hdr_histogram(const stats_entry_hdr_histogram & that)
+   : counts(NULL), Count(0), Sum(0.0), Max(0.0)
+{
+   *this = that;
+}
+
+stats_entry_hdr_histogram & stats_entry_hdr_histogram::operator=(const stats_entry_hdr_histogram & that)
+{
+   if (this != &that) {
+      Count = that.Count;
+      Sum = that.Sum;
+      Max = that.Max;
+      if (that.counts) {
+         if ( ! counts) counts = new int64_t[NUM_BUCKETS];
+         memcpy(counts, that.counts, sizeof(counts[0]) * NUM_BUCKETS);
+      } else if (counts) {
+         memset(counts, 0, sizeof(counts[0]) * NUM_BUCKETS);
+      }
+   }
+   return *this;
+}
+
+double stats_entry_hdr_histogram::Add(double sec)
+{
+   if ( ! counts) {
+      counts = new int64_t[NUM_BUCKETS];
+      memset(counts, 0, sizeof(counts[0]) * NUM_BUCKETS);
+   }
+   if (sec < 0.0) sec = 0.0;
+   counts[BucketOf((uint64_t)(sec * 1e6))] += 1;
+   if ( ! Count || sec > Max) Max = sec;
+   Count += 1;
+   Sum += sec;
+   return sec;
+}
+
+void stats_entry_hdr_histogram::Clear()
+{
+   if (counts) {
+      memset(counts, 0, sizeof(counts[0]) * NUM_BUCKETS);
+   }
+   Count = 0;
+   Sum = 0.0;
+   Max = 0.0;
+}
+
+double stats_entry_hdr_histogram::Quantile(double fraction) const
+{
+   if ( ! Count || ! counts) {
+      return 0.0;
+   }
+   int64_t rank = (int64_t)ceil(fraction * (double)Count);
+   if (rank < 1) rank = 1;
+   int64_t seen = 0;
+   for (int ix = 0; ix < NUM_BUCKETS; ++ix) {
+      seen += counts[ix];
+      if (seen >= rank) {
+         // report the top of the bucket, but never more than the largest sample
+         double sec = (double)BucketLimit(ix) / 1e6;
+         return (sec < Max) ? sec : Max;
+      }
+   }
+   return Max;
+}
+
+void stats_entry_hdr_histogram::Publish(ClassAd & ad, const char * pattr, int flags) const
+{
+   if ((flags & IF_NONZERO) && ! Count) {
+      return;
+   }
+   std::string attr(pattr);
+   size_t cch = attr.size();
+   attr += "Count"; ad.Assign(attr, (long long)Count); attr.resize(cch);
+   attr += "Max";   ad.Assign(attr, Max); attr.resize(cch);
+   attr += "P50";   ad.Assign(attr, Quantile(0.5)); attr.resize(cch);
+   attr += "P99";   ad.Assign(attr, Quantile(0.99)); attr.resize(cch);
+   attr += "P999";  ad.Assign(attr, Quantile(0.999));
+}
+
+void stats_entry_hdr_histogram::Unpublish(ClassAd & ad, const char * pattr) const
+{
+   std::string attr(pattr);
+   size_t cch = attr.size();
+   attr += "Count"; ad.Delete(attr); attr.resize(cch);
+   attr += "Max";   ad.Delete(attr); attr.resize(cch);
+   attr += "P50";   ad.Delete(attr); attr.resize(cch);
+   attr += "P99";   ad.Delete(attr); attr.resize(cch);
+   attr += "P999";  ad.Delete(attr);
+}
+
+// append one OpenMetrics sample line: name{labels,label} value
+static void append_metric_sample(std::string & out, const char * name, const char * suffix, const char * labels, const char * label, const char * value)
+{
+   out += name;
+   out += suffix;
+   bool has_labels = labels && labels[0];
+   if (has_labels || label) {
+      out += '{';
+      if (has_labels) out += labels;
+      if (has_labels && label) out += ',';
+      if (label) out += label;
+      out += '}';
+   }
+   out += ' ';
+   out += value;
+   out += '\n';
+}
+
+void stats_entry_hdr_histogram::WriteMetric(std::string & out, const char * name, const char * labels) const
+{
+   std::string val;
+   formatstr_cat(out, "# TYPE %s summary\n", name);
+   formatstr(val, "%.9g", Quantile(0.5));
+   append_metric_sample(out, name, "", labels, "quantile=\"0.5\"", val.c_str());
+   formatstr(val, "%.9g", Quantile(0.99));
+   append_metric_sample(out, name, "", labels, "quantile=\"0.99\"", val.c_str());
+   formatstr(val, "%.9g", Quantile(0.999));
+   append_metric_sample(out, name, "", labels, "quantile=\"0.999\"", val.c_str());
+   formatstr(val, "%.9g", Sum);
+   append_metric_sample(out, name, "_sum", labels, NULL, val.c_str());
+   formatstr(val, "%lld", (long long)Count);
+   append_metric_sample(out, name, "_count", labels, NULL, val.c_str());
+}
+
 //----------------------------------------------------------------------------------------------
 // methods for the StatisticsPool class.  StatisticsPool is a collection of statistics that 
 // share a recent time quantum and are intended to be published/Advanced/Cleared
@@ -1233,6 +1388,15 @@ int StatisticsPool::SetVerbosities(classad::References & attrs, int pub_flags, b
 }
 
 
+bool StatisticsPool::WantPublish(int flags, int item_flags)
+{
+   if (!(flags & IF_DEBUGPUB) && (item_flags & IF_DEBUGPUB)) return false;
+   if (!(flags & IF_RECENTPUB) && (item_flags & IF_RECENTPUB)) return false;
+   if ((flags & IF_PUBKIND) && (item_flags & IF_PUBKIND) && !(flags & item_flags & IF_PUBKIND)) return false;
+   if ((item_flags & IF_PUBLEVEL) > (flags & IF_PUBLEVEL)) return false;
+   return true;
+}
+
 void StatisticsPool::Publish(ClassAd & ad, int flags) const
 {
    pubitem item;
@@ -1245,10 +1409,7 @@ void StatisticsPool::Publish(ClassAd & ad, int flags) const
    while (pthis->pub.iterate(name,item)) 
       {
       // check various publishing flags to decide whether to call the Publish method
-      if (!(flags & IF_DEBUGPUB) && (item.flags & IF_DEBUGPUB)) continue;
-      if (!(flags & IF_RECENTPUB) && (item.flags & IF_RECENTPUB)) continue;
-      if ((flags & IF_PUBKIND) && (item.flags & IF_PUBKIND) && !(flags & item.flags & IF_PUBKIND)) continue;
-      if ((item.flags & IF_PUBLEVEL) > (flags & IF_PUBLEVEL)) continue;
+      if ( ! WantPublish(flags, item.flags)) continue;
 
       // don't pass the item's IF_NONZERO flag through unless IF_NONZERO is enabled
       int item_flags = (flags & IF_NONZERO) ? item.flags : (item.flags & ~IF_NONZERO);
@@ -1272,10 +1433,7 @@ void StatisticsPool::Publish(ClassAd & ad, const char * prefix, int flags) const
    while (pthis->pub.iterate(name,item)) 
       {
       // check various publishing flags to decide whether to call the Publish method
-      if (!(flags & IF_DEBUGPUB) && (item.flags & IF_DEBUGPUB)) continue;
-      if (!(flags & IF_RECENTPUB) && (item.flags & IF_RECENTPUB)) continue;
-      if ((flags & IF_PUBKIND) && (item.flags & IF_PUBKIND) && !(flags & item.flags & IF_PUBKIND)) continue;
-      if ((item.flags & IF_PUBLEVEL) > (flags & IF_PUBLEVEL)) continue;
+      if ( ! WantPublish(flags, item.flags)) continue;
 
       // don't pass the item's IF_NONZERO flag through unless IF_NONZERO is enabled
       int item_flags = (flags & IF_NONZERO) ? item.flags : (item.flags & ~IF_NONZERO);
@@ -1289,6 +1447,61 @@ void StatisticsPool::Publish(ClassAd & ad, const char * prefix, int flags) const
       }
 }
 
+void StatisticsPool::WriteMetrics(std::string & out, const char * prefix, const char * labels, int flags) const
+{
+   pubitem item;
+   MyString name;
+   std::string metric;
+
+   // histograms are written directly, everything else is published into
+   // an ad first, and its numeric attributes are written as gauges.
+   ClassAd ad;
+
+   StatisticsPool * pthis = const_cast<StatisticsPool*>(this);
+   pthis->pub.startIterations();
+   while (pthis->pub.iterate(name,item))
+      {
+      if ( ! WantPublish(flags, item.flags)) continue;
+      int item_flags = (flags & IF_NONZERO) ? item.flags : (item.flags & ~IF_NONZERO);
+      if ( ! item.Publish) continue;
+
+      stats_entry_base * probe = (stats_entry_base *)item.pitem;
+      const char * pattr = item.pattr ? item.pattr : name.Value();
+      if ((item.units & IS_CLASS_MASK) == IS_HDR_HISTOGRAM &&
+          item.Publish == (FN_STATS_ENTRY_PUBLISH)&stats_entry_hdr_histogram::Publish) {
+         stats_entry_hdr_histogram * hdr = (stats_entry_hdr_histogram *)probe;
+         if ((item_flags & IF_NONZERO) && ! hdr->Count) continue;
+         metric = prefix;
+         metric += pattr;
+         hdr->WriteMetric(out, metric.c_str(), labels);
+      } else {
+         (probe->*(item.Publish))(ad, pattr, item_flags);
+      }
+      }
+
+   classad::Value val;
+   long long ival;
+   double rval;
+   bool bval;
+   std::string str;
+   for (classad::ClassAd::const_iterator it = ad.begin(); it != ad.end(); ++it) {
+      if ( ! ExprTreeIsLiteral(it->second, val)) continue;
+      if (val.IsIntegerValue(ival)) {
+         formatstr(str, "%lld", ival);
+      } else if (val.IsRealValue(rval)) {
+         formatstr(str, "%.9g", rval);
+      } else if (val.IsBooleanValue(bval)) {
+         str = bval ? "1" : "0";
+      } else {
+         continue;
+      }
+      metric = prefix;
+      metric += it->first;
+      formatstr_cat(out, "# TYPE %s gauge\n", metric.c_str());
+      append_metric_sample(out, metric.c_str(), "", labels, NULL, str.c_str());
+   }
+}
+
 void StatisticsPool::Unpublish(ClassAd & ad) const
 {
    pubitem item;
@@ -143,6 +143,7 @@ enum {
    IS_HISTOGRAM   = 0x0800, // is stats_entry_histgram class
    IS_CLS_EMA     = 0x0900, // is stats_entry_sum_ema_rate class
    IS_CLS_SUM_EMA_RATE = 0x0A00, // is stats_entry_sum_ema_rate class
+   IS_HDR_HISTOGRAM = 0x0B00, // is stats_entry_hdr_histogram class
 
    // values above AS_TYPE_MASK are flags
    //
@@ -1468,6 +1469,55 @@ public:
    static FN_STATS_ENTRY_ADVANCE GetFnAdvance() { return (FN_STATS_ENTRY_ADVANCE)&stats_entry_recent_histogram<T>::AdvanceBy; };
 };
 
+//-----------------------------------------------------------------------------
+// A statistics probe for latencies that span several orders of magnitude, such
+// as command handler runtimes.  Samples are counted in log-linear buckets of
+// microseconds, 16 buckets for each power of 2, so quantiles are accurate to
+// within about 6% from 1 microsecond up to about 12 days.  The bucket array is
+// allocated by the first Add(), so a probe that is never used costs very little.
+// Publishes <attr>Count, <attr>Max and the <attr>P50, P99 and P999 quantiles,
+// all of the times in seconds.
+//
+class stats_entry_hdr_histogram : public stats_entry_base {
+public:
+   stats_entry_hdr_histogram() : counts(NULL), Count(0), Sum(0.0), Max(0.0) {}
+   stats_entry_hdr_histogram(const stats_entry_hdr_histogram & that);
+   ~stats_entry_hdr_histogram() { delete [] counts; }
+   stats_entry_hdr_histogram & operator=(const stats_entry_hdr_histogram & that);
+
+   int64_t * counts;   // NUM_BUCKETS counters, or NULL until something is added
+   int64_t   Count;    // number of samples
+   double    Sum;      // sum of the samples, in seconds
+   double    Max;      // largest sample, in seconds
+
+   double Add(double sec);
+   double operator+=(double sec) { return Add(sec); }
+   void Clear();
+
+   // the value in seconds that the given fraction (0.0 to 1.0) of the samples are at or below
+   double Quantile(double fraction) const;
+
+   static const int PubValue = 1;
+   static const int PubDefault = PubValue;
+   void Publish(ClassAd & ad, const char * pattr, int flags) const;
+   void Unpublish(ClassAd & ad, const char * pattr) const;
+
+   // append this probe to out as an OpenMetrics summary
+   void WriteMetric(std::string & out, const char * name, const char * labels) const;
+
+   // callback methods/fetchers for use by the StatisticsPool class
+   static const int unit = IS_HDR_HISTOGRAM | stats_entry_type<double>::id;
+   static FN_STATS_ENTRY_UNPUBLISH GetFnUnpublish() { return (FN_STATS_ENTRY_UNPUBLISH)&stats_entry_hdr_histogram::Unpublish; };
+   static void Delete(stats_entry_hdr_histogram * probe) { delete probe; }
+
+   // the bucket layout, public for the unit tests
+   static const int SUB_BUCKETS = 16;     // buckets for each power of 2
+   static const int MAX_BITS = 40;        // samples are clamped to 2^40 microseconds
+   static const int NUM_BUCKETS = SUB_BUCKETS * (MAX_BITS - 3);
+   static int BucketOf(uint64_t usec);
+   static uint64_t BucketLimit(int ix);   // largest value counted in bucket ix
+};
+
 //-----------------------------------------------------------------------------
 // A statistics probe designed to keep track of accumulated running time
 // of a data set.  keeps a count of times that time was added and
@@ -1695,7 +1745,15 @@ public:
    void Unpublish(ClassAd & ad) const;
    void Unpublish(ClassAd & ad, const char * prefix) const;
 
+   // append the probes that Publish would publish to out as OpenMetrics text.
+   // each metric is named prefix followed by the attribute name, and labels
+   // (if not empty) is a list like 'daemon="SCHEDD"' added to every sample.
+   // stats_entry_hdr_histogram probes become summaries, everything else a gauge.
+   void WriteMetrics(std::string & out, const char * prefix, const char * labels, int flags) const;
+
 private:
+   static bool WantPublish(int flags, int item_flags);
+
    struct pubitem {
       int    units;    // copied from the class->unit, identifies the class and type of probe
       int    flags;    // passed to Publish
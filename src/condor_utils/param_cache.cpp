@@ -0,0 +1,75 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "param_cache.h"
+
+#include <mutex>
+
+ParamCacheValues param_cache_values;
+std::atomic<bool> param_cache_loaded(false);
+
+static std::mutex param_cache_lock;
+static int param_cache_loads = 0;
+
+// the caller holds param_cache_lock
+static void
+param_cache_load()
+{
+	ParamCacheValues & vals = param_cache_values;
+
+#define PARAM_CACHE_LOAD(name, def) vals.bools[PCB_##name].store(param_boolean(#name, def), std::memory_order_relaxed);
+	PARAM_CACHE_BOOLS(PARAM_CACHE_LOAD)
+#undef PARAM_CACHE_LOAD
+#define PARAM_CACHE_LOAD(name, def) vals.ints[PCI_##name].store(param_integer(#name, def), std::memory_order_relaxed);
+	PARAM_CACHE_INTS(PARAM_CACHE_LOAD)
+#undef PARAM_CACHE_LOAD
+#define PARAM_CACHE_LOAD(name, def) vals.doubles[PCD_##name].store(param_double(#name, def), std::memory_order_relaxed);
+	PARAM_CACHE_DOUBLES(PARAM_CACHE_LOAD)
+#undef PARAM_CACHE_LOAD
+
+	++param_cache_loads;
+}
+
+void
+param_cache_first()
+{
+	std::lock_guard<std::mutex> guard(param_cache_lock);
+	if ( ! param_cache_loaded.load()) {
+		param_cache_load();
+		param_cache_loaded.store(true, std::memory_order_release);
+	}
+}
+
+void
+param_cache_invalidate()
+{
+	std::lock_guard<std::mutex> guard(param_cache_lock);
+	param_cache_load();
+	param_cache_loaded.store(true, std::memory_order_release);
+}
+
+int
+param_cache_reload_count()
+{
+	std::lock_guard<std::mutex> guard(param_cache_lock);
+	return param_cache_loads;
+}
@@ -0,0 +1,109 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2020, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _PARAM_CACHE_H
+#define _PARAM_CACHE_H
+
+#include <atomic>
+
+// A typed cache of configuration values that are read in hot code,
+// once per match or once per job, where going through param() each time
+// shows up in profiles.  The cache is reloaded on the main thread as soon
+// as the configuration changes (a reconfig, param_insert or config_insert),
+// so a read - on any thread - is just an atomic load from an array and
+// never calls param().  The values are updated in place, so a change costs
+// a handful of param() calls and there are no old copies to free.
+//
+// To cache another knob, add it to one of the lists below along with the
+// default to use if it is not in the param table, then read it with
+// param_cached(PCB_<NAME>), param_cached(PCI_<NAME>) or
+// param_cached(PCD_<NAME>).  A D_CONFIG log at reconfig lists the knobs
+// that were looked up most often, which are the candidates.
+
+#define PARAM_CACHE_BOOLS(X) \
+	X(ALLOW_PSLOT_PREEMPTION, false) \
+	X(NEGOTIATOR_DEPTH_FIRST, false) \
+	X(NEGOTIATOR_IGNORE_USER_PRIORITIES, false) \
+	X(CONDOR_Q_ONLY_MY_JOBS, true) \
+	X(GLOBAL_JOB_ID_WITH_TIME, true) \
+	X(SHARE_SPOOLED_EXECUTABLES, true) \
+	X(CLAIM_RECYCLING_CONSIDER_LIMITS, true)
+
+#define PARAM_CACHE_INTS(X) \
+	X(NEGOTIATOR_NUM_THREADS, 1)
+
+#define PARAM_CACHE_DOUBLES(X) \
+	X(CONCURRENCY_LIMIT_DEFAULT, 2308032)
+
+enum ParamCacheBool {
+#define PARAM_CACHE_ID(name, def) PCB_##name,
+	PARAM_CACHE_BOOLS(PARAM_CACHE_ID)
+#undef PARAM_CACHE_ID
+	PCB_COUNT
+};
+
+enum ParamCacheInt {
+#define PARAM_CACHE_ID(name, def) PCI_##name,
+	PARAM_CACHE_INTS(PARAM_CACHE_ID)
+#undef PARAM_CACHE_ID
+	PCI_COUNT
+};
+
+enum ParamCacheDouble {
+#define PARAM_CACHE_ID(name, def) PCD_##name,
+	PARAM_CACHE_DOUBLES(PARAM_CACHE_ID)
+#undef PARAM_CACHE_ID
+	PCD_COUNT
+};
+
+// Each value is loaded and stored on its own; a reader racing a reload
+// may see some knobs before the change and some after, as it could with
+// param().
+struct ParamCacheValues {
+	std::atomic<bool> bools[PCB_COUNT];
+	std::atomic<int> ints[PCI_COUNT];
+	std::atomic<double> doubles[PCD_COUNT];
+};
+
+extern ParamCacheValues param_cache_values;
+extern std::atomic<bool> param_cache_loaded;
+
+// Load the cache for a process that reads it before it has been configured.
+void param_cache_first();
+
+// Called by the config code, on the thread that changed the configuration,
+// to reload the cache.
+void param_cache_invalidate();
+
+// The number of times the cache has been loaded, for tests.
+int param_cache_reload_count();
+
+inline const ParamCacheValues & param_cache_get()
+{
+	if ( ! param_cache_loaded.load(std::memory_order_acquire)) {
+		param_cache_first();
+	}
+	return param_cache_values;
+}
+
+inline bool param_cached(ParamCacheBool id) { return param_cache_get().bools[id].load(std::memory_order_relaxed); }
+inline int param_cached(ParamCacheInt id) { return param_cache_get().ints[id].load(std::memory_order_relaxed); }
+inline double param_cached(ParamCacheDouble id) { return param_cache_get().doubles[id].load(std::memory_order_relaxed); }
+
+#endif
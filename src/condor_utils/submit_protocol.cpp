@@ -133,6 +133,8 @@ int ActualScheddQ::init_capabilities() {
 				late_ver = 1;
 			}
 		}
+		has_set_attrs = false;
+		capabilities.LookupBool("SetAttributes", has_set_attrs);
 	}
 	return rval;
 }
@@ -161,6 +163,20 @@ int ActualScheddQ::set_AttributeInt(int cluster, int proc, const char *attr, int
 	return SetAttributeInt(cluster, proc, attr, value, flags);
 }
 
+int ActualScheddQ::set_Attributes(int cluster, int proc, const std::vector<std::pair<std::string, std::string> > & attrs, SetAttributeFlags_t flags) {
+	// schedds too old for late materialization don't know GetCapabilities either
+	if (has_late) { init_capabilities(); }
+	if (has_set_attrs) {
+		return SetAttributes(cluster, proc, attrs, flags);
+	}
+	// older schedds get one SetAttribute message per attribute
+	for (auto it = attrs.begin(); it != attrs.end(); ++it) {
+		int rval = SetAttribute(cluster, proc, it->first.c_str(), it->second.c_str(), flags);
+		if (rval < 0) return rval;
+	}
+	return 0;
+}
+
 int ActualScheddQ::set_Factory(int cluster, int qnum, const char * filename, const char * text) {
 	return SetJobFactory(cluster, qnum, filename, text);
 }
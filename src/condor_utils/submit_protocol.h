@@ -12,6 +12,8 @@ public:
 	virtual int get_Capabilities(ClassAd& reply) = 0;
 	virtual int set_Attribute(int cluster, int proc, const char *attr, const char *value, SetAttributeFlags_t flags=0 ) = 0;
 	virtual int set_AttributeInt(int cluster, int proc, const char *attr, int value, SetAttributeFlags_t flags = 0 ) = 0;
+	// set a list of (attr, value) pairs, in one message if the schedd supports it.
+	virtual int set_Attributes(int cluster, int proc, const std::vector<std::pair<std::string, std::string> > & attrs, SetAttributeFlags_t flags = 0 ) = 0;
 	virtual int send_SpoolFile(char const *filename) = 0;
 	virtual int send_SpoolFileBytes(char const *filename) = 0;
 	virtual bool disconnect(bool commit_transaction, CondorError & errstack) = 0;
@@ -39,7 +41,7 @@ enum {
 
 class ActualScheddQ : public AbstractScheddQ {
 public:
-	ActualScheddQ() : qmgr(NULL), tried_to_get_capabilities(false), has_late(false), allows_late(false), late_ver(0) {}
+	ActualScheddQ() : qmgr(NULL), tried_to_get_capabilities(false), has_late(false), allows_late(false), has_set_attrs(false), late_ver(0) {}
 	virtual ~ActualScheddQ();
 	virtual int get_NewCluster();
 	virtual int get_NewProc(int cluster_id);
@@ -47,6 +49,7 @@ public:
 	virtual int get_Capabilities(ClassAd& reply);
 	virtual int set_Attribute(int cluster, int proc, const char *attr, const char *value, SetAttributeFlags_t flags=0 );
 	virtual int set_AttributeInt(int cluster, int proc, const char *attr, int value, SetAttributeFlags_t flags = 0 );
+	virtual int set_Attributes(int cluster, int proc, const std::vector<std::pair<std::string, std::string> > & attrs, SetAttributeFlags_t flags = 0 );
 	virtual int send_SpoolFile(char const *filename);
 	virtual int send_SpoolFileBytes(char const *filename);
 	virtual bool disconnect(bool commit_transaction, CondorError & errstack);
@@ -63,6 +66,7 @@ private:
 	bool tried_to_get_capabilities;
 	bool has_late; // set in Connect based on the version in DCSchedd
 	bool allows_late;
+	bool has_set_attrs; // schedd accepts CONDOR_SetAttributes
 	char late_ver;
 	int init_capabilities();
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 # endif
 
 #include "selector.h"
+#include "compat_classad.h"
 
 #include "old_boost.h"
 #include "query_iterator.h"
@@ -160,6 +161,98 @@ private:
 };
 
 
+// from classad.cpp
+extern boost::python::object
+convert_value_to_python(const classad::Value &value);
+
+
+ColumnBuilder::ColumnBuilder(boost::python::list projection)
+  : m_rows(0)
+{
+    int len_attrs = py_len(projection);
+    if (len_attrs <= 0)
+    {
+        THROW_EX(HTCondorValueError, "A non-empty projection is required for a columnar query.");
+    }
+    m_attrs.reserve(len_attrs);
+    m_columns.reserve(len_attrs);
+    for (int idx = 0; idx < len_attrs; idx++)
+    {
+        m_attrs.push_back(boost::python::extract<std::string>(projection[idx]));
+        m_columns.push_back(boost::python::list());
+    }
+}
+
+
+void
+ColumnBuilder::append(const classad::ClassAd &ad)
+{
+    classad::Value val;
+    long long intval;
+    double realval;
+    bool boolval;
+    const char *strval;
+    for (size_t idx = 0; idx < m_attrs.size(); idx++)
+    {
+        PyObject *obj = NULL;
+        classad::ExprTree *expr = ad.Lookup(m_attrs[idx]);
+        if (!expr)
+        {
+            obj = Py_None; Py_INCREF(obj);
+        }
+        else
+        {
+            // Ads straight off the wire are almost entirely literals, so
+            // take their value directly and only evaluate real expressions.
+            if (expr->GetKind() == classad::ExprTree::LITERAL_NODE)
+            {
+                static_cast<classad::Literal*>(expr)->GetValue(val);
+            }
+            else if (!ad.EvaluateExpr(expr, val))
+            {
+                val.SetErrorValue();
+            }
+
+            if (val.IsIntegerValue(intval)) {
+                obj = PyLong_FromLongLong(intval);
+            } else if (val.IsBooleanValue(boolval)) {
+                obj = boolval ? Py_True : Py_False; Py_INCREF(obj);
+            } else if (val.IsRealValue(realval)) {
+                obj = PyFloat_FromDouble(realval);
+            } else if (val.IsStringValue(strval)) {
+#if PY_MAJOR_VERSION >= 3
+                obj = PyUnicode_FromString(strval);
+#else
+                obj = PyString_FromString(strval);
+#endif
+            } else if (val.IsUndefinedValue() || val.IsErrorValue()) {
+                obj = Py_None; Py_INCREF(obj);
+            } else {
+                boost::python::object converted = convert_value_to_python(val);
+                obj = converted.ptr(); Py_INCREF(obj);
+            }
+            if (!obj) { boost::python::throw_error_already_set(); }
+        }
+        int rval = PyList_Append(m_columns[idx].ptr(), obj);
+        Py_DECREF(obj);
+        if (rval < 0) { boost::python::throw_error_already_set(); }
+    }
+    m_rows++;
+}
+
+
+boost::python::dict
+ColumnBuilder::result() const
+{
+    boost::python::dict columns;
+    for (size_t idx = 0; idx < m_attrs.size(); idx++)
+    {
+        columns[m_attrs[idx]] = m_columns[idx];
+    }
+    return columns;
+}
+
+
 boost::shared_ptr<BulkQueryIterator>
 pollAllAds(boost::python::object queries, int timeout_ms)
 {
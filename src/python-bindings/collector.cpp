@@ -15,6 +15,7 @@
 #include "module_lock.h"
 #include "htcondor.h"
 #include "daemon_location.h"
+#include "query_iterator.h"
 
 using namespace boost::python;
 
@@ -73,6 +74,39 @@ AdTypes convert_to_ad_type(daemon_t d_type)
     return ad_type;
 }
 
+struct column_query_helper
+{
+    ColumnBuilder *columns;
+    condor::ModuleLock *ml;
+};
+
+// Decode each ad from the collector straight into the column lists;
+// returning true tells the query code to free the ad for us.
+static bool
+column_query_callback(void *pv, ClassAd *ad)
+{
+    column_query_helper *helper = static_cast<column_query_helper *>(pv);
+    helper->ml->release();
+    if (!PyErr_Occurred())
+    {
+        try
+        {
+            helper->columns->append(*ad);
+        }
+        catch (boost::python::error_already_set &)
+        {
+            // PyErr_Occurred is now set; skip the remaining ads.
+        }
+        catch (...)
+        {
+            PyErr_SetString(PyExc_HTCondorInternalError, "Uncaught C++ exception encountered.");
+        }
+    }
+    helper->ml->acquire();
+    return true;
+}
+
+
 struct Collector {
 
     Collector(boost::python::object pool = boost::python::object())
@@ -174,6 +208,30 @@ struct Collector {
     }
 
 
+    boost::python::dict queryColumns(AdTypes ad_type, boost::python::object constraint_obj, boost::python::list attrs, const std::string &statistics="")
+    {
+        ColumnBuilder columns(attrs);
+        CondorQuery query(ad_type);
+        build_query(query, constraint_obj, attrs, statistics, "");
+
+        column_query_helper helper;
+        helper.columns = &columns;
+        QueryResult result;
+        {
+        condor::ModuleLock ml;
+        helper.ml = &ml;
+        result = m_collectors->query(query, column_query_callback, &helper, NULL);
+        }
+
+        if (PyErr_Occurred())
+        {
+            throw_error_already_set();
+        }
+        check_query_result(result);
+        return columns.result();
+    }
+
+
     object locateAll(daemon_t d_type)
     {
         AdTypes ad_type = convert_to_ad_type(d_type);
@@ -345,14 +403,13 @@ struct Collector {
 
 private:
 
-    object query_internal(AdTypes ad_type, boost::python::object constraint_obj, boost::python::list attrs, const std::string &statistics, std::string locationName)
+    void build_query(CondorQuery &query, boost::python::object constraint_obj, boost::python::list attrs, const std::string &statistics, const std::string &locationName)
     {
         std::string constraint;
         if ( ! convert_python_to_constraint(constraint_obj, constraint, true, NULL)) {
             THROW_EX(HTCondorValueError, "Invalid constraint.");
         }
 
-        CondorQuery query(ad_type);
         if (constraint.length())
         {
             query.addANDConstraint(constraint.c_str());
@@ -380,14 +437,10 @@ private:
             }
             query.setDesiredAttrs(attrs_str);
         }
+    }
 
-        ClassAdList adList;
-        QueryResult result;
-        {
-        condor::ModuleLock ml;
-        result = m_collectors->query(query, adList, NULL);
-        }
-
+    void check_query_result(QueryResult result)
+    {
         switch (result)
         {
         case Q_OK:
@@ -408,6 +461,21 @@ private:
         default:
             THROW_EX(HTCondorInternalError, "Unknown error from collector query.");
         }
+    }
+
+    object query_internal(AdTypes ad_type, boost::python::object constraint_obj, boost::python::list attrs, const std::string &statistics, std::string locationName)
+    {
+        CondorQuery query(ad_type);
+        build_query(query, constraint_obj, attrs, statistics, locationName);
+
+        ClassAdList adList;
+        QueryResult result;
+        {
+        condor::ModuleLock ml;
+        result = m_collectors->query(query, adList, NULL);
+        }
+
+        check_query_result(result);
 
         list retval;
         ClassAd * ad;
@@ -429,6 +497,7 @@ private:
 
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(advertise_overloads, advertise, 1, 3);
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(query_overloads, query, 0, 4);
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(query_columns_overloads, queryColumns, 3, 4);
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(directquery_overloads, directquery, 1, 4);
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(locate_overloads, locate, 1, 2);
 
@@ -480,6 +549,28 @@ void export_collector()
             (boost::python::arg("self"), boost::python::arg("ad_type")=ANY_AD, boost::python::arg("constraint")="", boost::python::arg("projection")=boost::python::list(), boost::python::arg("statistics")="")
 #endif
              ))
+        .def("queryColumns", &Collector::queryColumns, query_columns_overloads(
+            R"C0ND0R(
+            Query the contents of a condor_collector daemon, returning the results in columnar form.
+
+            Rather than building a :class:`~classad.ClassAd` for each matching ad, the attributes in
+            ``projection`` are decoded directly into one Python list per attribute.  Literal values
+            are converted to the matching Python type; missing or undefined attributes are ``None``.
+            This is much cheaper than :meth:`query` when only a few attributes of many ads are needed.
+
+            :param ad_type: The type of ClassAd to return.
+            :type ad_type: :class:`AdTypes`
+            :param constraint: A constraint for the collector query; only ads matching this constraint are returned.
+            :type constraint: str or :class:`~classad.ExprTree`
+            :param projection: The attributes to return; must not be empty.
+            :type projection: list[str]
+            :param list[str] statistics: Statistics attributes to include, if they exist for the specified daemon.
+            :return: A dictionary mapping each attribute name to a list of values;
+                all the lists have the same length.
+            :rtype: dict[str, list]
+            )C0ND0R",
+            (boost::python::arg("self"), boost::python::arg("ad_type"), boost::python::arg("constraint"), boost::python::arg("projection"), boost::python::arg("statistics")="")
+             ))
         .def("directQuery", &Collector::directquery, directquery_overloads(
             R"C0ND0R(
             Query the specified daemon directly for a ClassAd, instead of using the ClassAd from the *condor_collector* daemon.
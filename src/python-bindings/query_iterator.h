@@ -3,6 +3,7 @@
 
 
 class Sock;
+namespace classad { class ClassAd; }
 
 
 enum BlockingMode
@@ -24,14 +25,42 @@ struct QueryIterator
 
     boost::python::list nextAds();
 
+    boost::python::dict nextColumns(boost::python::list projection, int max_ads=1000, BlockingMode mode=Blocking);
+
     int watch();
 
     std::string tag() {return m_tag;}
 
 private:
+    // Returns 1 and fills in ad if an ad was read, 0 if no ad is ready
+    // (non-blocking only) and -1 once the final ad has been consumed.
+    int readAd(classad::ClassAd &ad, BlockingMode mode);
+
     int m_count;
     boost::shared_ptr<Sock> m_sock;
     const std::string m_tag;
 };
 
+
+// Accumulates the projected attributes of a sequence of ads into one
+// Python list per attribute, so that callers which only need a few
+// columns of a large result set do not pay for a ClassAd object per ad.
+// Literal values become native Python int/float/str/bool objects;
+// undefined or missing attributes become None.  The GIL must be held.
+struct ColumnBuilder
+{
+    ColumnBuilder(boost::python::list projection);
+
+    void append(const classad::ClassAd &ad);
+
+    size_t rows() const {return m_rows;}
+
+    boost::python::dict result() const;
+
+private:
+    size_t m_rows;
+    std::vector<std::string> m_attrs;
+    std::vector<boost::python::list> m_columns;
+};
+
 #endif
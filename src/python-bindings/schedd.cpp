@@ -1232,57 +1232,72 @@ QueryIterator::QueryIterator(boost::shared_ptr<Sock> sock, const std::string &ta
 {}
 
 
-boost::python::object
-QueryIterator::next(BlockingMode mode)
+int
+QueryIterator::readAd(classad::ClassAd &ad, BlockingMode mode)
 {
-    if (m_count < 0) { THROW_EX(StopIteration, "All ads processed"); }
+    if (m_count < 0) { return -1; }
 
-    boost::shared_ptr<ClassAdWrapper> ad(new ClassAdWrapper());
     if (mode == Blocking)
     {
-        if (!getClassAdWithoutGIL(*m_sock.get(), *ad.get())) {
+        if (!getClassAdWithoutGIL(*m_sock.get(), ad)) {
             THROW_EX(HTCondorIOError, "Failed to receive remote ad.");
         }
     }
     else if (m_sock->msgReady())
     {
-        if (!getClassAd(m_sock.get(), *ad)) {
+        if (!getClassAd(m_sock.get(), ad)) {
             THROW_EX(HTCondorIOError, "Failed to receive remote ad.");
         }
     }
     else
     {
-        return boost::python::object();
+        return 0;
     }
     if (!m_sock->end_of_message()) {
         THROW_EX(HTCondorIOError, "Failed to get EOM after ad.");
     }
     long long intVal;
-    if (ad->EvaluateAttrInt(ATTR_OWNER, intVal) && (intVal == 0))
+    if (ad.EvaluateAttrInt(ATTR_OWNER, intVal) && (intVal == 0))
     { // Last ad.
         m_sock->close();
         std::string errorMsg;
-        if (ad->EvaluateAttrInt(ATTR_ERROR_CODE, intVal) && intVal && ad->EvaluateAttrString(ATTR_ERROR_STRING, errorMsg))
+        if (ad.EvaluateAttrInt(ATTR_ERROR_CODE, intVal) && intVal && ad.EvaluateAttrString(ATTR_ERROR_STRING, errorMsg))
         {
             THROW_EX(HTCondorIOError, errorMsg.c_str());
         }
-        if (ad->EvaluateAttrInt("MalformedAds", intVal) && intVal) {
+        if (ad.EvaluateAttrInt("MalformedAds", intVal) && intVal) {
             THROW_EX(HTCondorReplyError, "Remote side had parse errors on history file");
         }
-        //if (!ad->EvaluateAttrInt(ATTR_LIMIT_RESULTS, intVal) || (intVal != m_count)) { THROW_EX(HTCondorReplyError, "Incorrect number of ads returned"); }
+        //if (!ad.EvaluateAttrInt(ATTR_LIMIT_RESULTS, intVal) || (intVal != m_count)) { THROW_EX(HTCondorReplyError, "Incorrect number of ads returned"); }
 
         // Everything checks out!
         m_count = -1;
+        return -1;
+    }
+    m_count++;
+    return 1;
+}
+
+
+boost::python::object
+QueryIterator::next(BlockingMode mode)
+{
+    if (m_count < 0) { THROW_EX(StopIteration, "All ads processed"); }
+
+    boost::shared_ptr<ClassAdWrapper> ad(new ClassAdWrapper());
+    int rval = readAd(*ad, mode);
+    if (rval < 0)
+    {
         if (mode == Blocking)
         {
             THROW_EX(StopIteration, "All ads processed");
         }
-        else
-        {
-            return boost::python::object();
-        }
+        return boost::python::object();
+    }
+    if (rval == 0)
+    {
+        return boost::python::object();
     }
-    m_count++;
     boost::python::object result(ad);
     return result;
 }
@@ -1316,6 +1331,32 @@ QueryIterator::nextAds()
 }
 
 
+boost::python::dict
+QueryIterator::nextColumns(boost::python::list projection, int max_ads, BlockingMode mode)
+{
+    if (m_count < 0) { THROW_EX(StopIteration, "All ads processed"); }
+    if (max_ads <= 0) { THROW_EX(HTCondorValueError, "max_ads must be positive"); }
+
+    ColumnBuilder columns(projection);
+    classad::ClassAd ad;
+    while (columns.rows() < (size_t)max_ads)
+    {
+        ad.Clear();
+        // Only block for the first ad of a chunk; once we have rows
+        // to hand back, return them rather than waiting on the wire.
+        BlockingMode this_mode = columns.rows() ? NonBlocking : mode;
+        int rval = readAd(ad, this_mode);
+        if (rval <= 0) { break; }
+        columns.append(ad);
+    }
+    if (!columns.rows() && (m_count < 0) && (mode == Blocking))
+    {
+        THROW_EX(StopIteration, "All ads processed");
+    }
+    return columns.result();
+}
+
+
 int
 QueryIterator::watch()
 {
@@ -4683,6 +4724,36 @@ void export_schedd()
             :rtype: list[:class:`~classad.ClassAd`]
             )C0ND0R",
             boost::python::args("self"))
+        .def("nextColumns", &QueryIterator::nextColumns,
+            R"C0ND0R(
+            Retrieve up to ``max_ads`` job ads in columnar form.
+
+            Rather than building a :class:`~classad.ClassAd` for each ad, the
+            requested attributes are decoded directly into one Python list per
+            attribute.  Literal values are converted to the matching Python type;
+            missing or undefined attributes are ``None``.  This is considerably
+            cheaper than iterating over the ads when only a few attributes of
+            a large result set are needed, and memory use is bounded by ``max_ads``.
+
+            Usually ``projection`` should be the same list passed to :meth:`Schedd.xquery`.
+
+            :param projection: The attributes to return.
+            :type projection: list[str]
+            :param int max_ads: The maximum number of ads to return in this chunk.
+            :param mode: The blocking mode for this call; in :attr:`~BlockingMode.NonBlocking`
+                mode only ads already available are returned.
+            :type mode: :class:`BlockingMode`
+            :return: A dictionary mapping each attribute name to a list of values;
+                all the lists have the same length.
+            :rtype: dict[str, list]
+            :raises StopIteration: when blocking and no additional ads are available.
+            )C0ND0R",
+#if BOOST_VERSION < 103400
+            (boost::python::arg("projection"), boost::python::arg("max_ads")=1000, boost::python::arg("mode")=Blocking)
+#else
+            (boost::python::arg("self"), boost::python::arg("projection"), boost::python::arg("max_ads")=1000, boost::python::arg("mode")=Blocking)
+#endif
+            )
         .def("tag", &QueryIterator::tag,
             R"C0ND0R(
             Retrieve the tag associated with this iterator; when using the :func:`poll` method,